@@ -23,6 +23,12 @@
 
 struct cal_regs_dqe regs_dqe[REGS_DQE_ID_MAX];
 
+/* REGAMMALUT_R, _G and _B are laid out back to back */
+#define DQE_REGAMMALUT_ALL_REG_CNT	(DQE_REGAMMALUT_REG_CNT * 3)
+
+static u32 degamma_lut_regs[REGS_DQE_ID_MAX][DQE_DEGAMMALUT_REG_CNT];
+static u32 regamma_lut_regs[REGS_DQE_ID_MAX][DQE_REGAMMALUT_ALL_REG_CNT];
+
 void dqe_regs_desc_init(void __iomem *regs, phys_addr_t start, const char *name,
 			enum dqe_version ver, unsigned int dqe_id)
 {
@@ -30,6 +36,13 @@ void dqe_regs_desc_init(void __iomem *regs, phys_addr_t start, const char *name,
 	regs_dqe[dqe_id].desc.name = name;
 	regs_dqe[dqe_id].version = ver;
         regs_dqe[dqe_id].desc.start = start;
+
+	cal_batch_init(&regs_dqe[dqe_id].degamma_lut,
+			DQE_DEGAMMALUT(0) + degamma_offset(ver),
+			degamma_lut_regs[dqe_id], DQE_DEGAMMALUT_REG_CNT);
+	cal_batch_init(&regs_dqe[dqe_id].regamma_lut,
+			DQE_REGAMMALUT_R(0) + regamma_offset(ver),
+			regamma_lut_regs[dqe_id], DQE_REGAMMALUT_ALL_REG_CNT);
 }
 
 static void dqe_reg_set_img_size(u32 dqe_id, u32 width, u32 height)
@@ -78,108 +91,264 @@ void dqe_reg_init(u32 dqe_id, u32 width, u32 height)
 	cal_log_debug(0, "size(%ux%u)\n", width, height);
 }
 
-void dqe_reg_set_degamma_lut(u32 dqe_id, const struct drm_color_lut *lut)
+enum dqe_lut_channel {
+	DQE_LUT_RED = 0,
+	DQE_LUT_GREEN,
+	DQE_LUT_BLUE,
+};
+
+static inline u16 dqe_lut_point(const struct drm_color_lut *lut,
+				enum dqe_lut_channel ch)
 {
-	int i, ret = 0;
-	u16 tmp_lut[DEGAMMA_LUT_SIZE] = {0};
-	u32 regs[DQE_DEGAMMALUT_REG_CNT] = {0};
+	return ch == DQE_LUT_RED ? lut->red :
+	       ch == DQE_LUT_GREEN ? lut->green : lut->blue;
+}
 
-	cal_log_debug(0, "%s +\n", __func__);
+/*
+ * Packs one channel of a LUT into registers, two points per register, without
+ * going through an intermediate array.
+ */
+static void dqe_pack_lut(u32 *regs, const struct drm_color_lut *lut, u32 size,
+			 enum dqe_lut_channel ch, u32 l_mask, u32 h_mask)
+{
+	const u8 l_shift = ffs(l_mask) - 1;
+	const u8 h_shift = ffs(h_mask) - 1;
+	u32 i, val;
+
+	for (i = 0; i < size; i += 2) {
+		val = ((u32)dqe_lut_point(&lut[i], ch) << l_shift) & l_mask;
+		if (i + 1 < size)
+			val |= ((u32)dqe_lut_point(&lut[i + 1], ch) << h_shift) & h_mask;
+		regs[i / 2] = val;
+	}
+}
 
-	if (!lut) {
-		degamma_write(dqe_id, DQE_DEGAMMA_CON, 0);
-		return;
+static void dqe_pack_linear_matrix(const struct exynos_matrix *lm, u32 *regs)
+{
+	int i, reg_cnt;
+
+	reg_cnt = DIV_ROUND_UP(LINEAR_MATRIX_COEFFS_CNT , 2);
+	for (i = 0; i < reg_cnt; ++i) {
+		if (i == reg_cnt - 1)
+			regs[i] = LINEAR_MATRIX_COEFF_L(lm->coeffs[i * 2]);
+		else
+			regs[i] = LINEAR_MATRIX_COEFF_H(lm->coeffs[i * 2 + 1]) |
+				LINEAR_MATRIX_COEFF_L(lm->coeffs[i * 2]);
+	}
+
+	/* DQE_LINEAR_MATRIX_OFFSET0/1 follow the coefficients */
+	regs[i++] = LINEAR_MATRIX_OFFSET_1(lm->offsets[1]) |
+			LINEAR_MATRIX_OFFSET_0(lm->offsets[0]);
+	regs[i] = LINEAR_MATRIX_OFFSET_2(lm->offsets[2]);
+}
+
+static void dqe_pack_gamma_matrix(const struct exynos_matrix *matrix, u32 *regs)
+{
+	int i, reg_cnt;
+
+	reg_cnt = DIV_ROUND_UP(GAMMA_MATRIX_COEFFS_CNT , 2);
+	for (i = 0; i < reg_cnt; ++i) {
+		if (i == reg_cnt - 1)
+			regs[i] = GAMMA_MATRIX_COEFF_L(matrix->coeffs[i * 2]);
+		else
+			regs[i] = GAMMA_MATRIX_COEFF_H(matrix->coeffs[i * 2 + 1]) |
+				GAMMA_MATRIX_COEFF_L(matrix->coeffs[i * 2]);
+	}
+
+	/* DQE_GAMMA_MATRIX_OFFSET0/1 follow the coefficients */
+	regs[i++] = GAMMA_MATRIX_OFFSET_1(matrix->offsets[1]) |
+			GAMMA_MATRIX_OFFSET_0(matrix->offsets[0]);
+	regs[i] = GAMMA_MATRIX_OFFSET_2(matrix->offsets[2]);
+}
+
+static const u32 dqe_reg_img_cnt[DQE_REG_IMG_MAX] = {
+	[DQE_REG_IMG_DEGAMMA]		= DQE_DEGAMMALUT_REG_CNT,
+	[DQE_REG_IMG_REGAMMA]		= DQE_REGAMMALUT_ALL_REG_CNT,
+	[DQE_REG_IMG_LINEAR_MATRIX]	= DIV_ROUND_UP(LINEAR_MATRIX_COEFFS_CNT, 2) + 2,
+	[DQE_REG_IMG_GAMMA_MATRIX]	= DIV_ROUND_UP(GAMMA_MATRIX_COEFFS_CNT, 2) + 2,
+};
+
+/*
+ * Packs the content of a DRM property blob into the register values of the
+ * corresponding DQE block. The result only depends on @data, so it can be
+ * kept and programmed later with dqe_reg_set_img().
+ */
+int dqe_reg_pack_img(enum dqe_reg_img_type type, const void *data,
+		     struct dqe_reg_img *img)
+{
+	const struct drm_color_lut *lut = data;
+
+	if (!data || type >= DQE_REG_IMG_MAX)
+		return -EINVAL;
+
+	switch (type) {
+	case DQE_REG_IMG_DEGAMMA:
+		dqe_pack_lut(img->regs, lut, DEGAMMA_LUT_SIZE, DQE_LUT_RED,
+				DEGAMMA_LUT_L_MASK, DEGAMMA_LUT_H_MASK);
+		break;
+	case DQE_REG_IMG_REGAMMA:
+		dqe_pack_lut(img->regs, lut, REGAMMA_LUT_SIZE, DQE_LUT_RED,
+				REGAMMA_LUT_L_MASK, REGAMMA_LUT_H_MASK);
+		dqe_pack_lut(&img->regs[DQE_REGAMMALUT_REG_CNT], lut,
+				REGAMMA_LUT_SIZE, DQE_LUT_GREEN,
+				REGAMMA_LUT_L_MASK, REGAMMA_LUT_H_MASK);
+		dqe_pack_lut(&img->regs[DQE_REGAMMALUT_REG_CNT * 2], lut,
+				REGAMMA_LUT_SIZE, DQE_LUT_BLUE,
+				REGAMMA_LUT_L_MASK, REGAMMA_LUT_H_MASK);
+		break;
+	case DQE_REG_IMG_LINEAR_MATRIX:
+		dqe_pack_linear_matrix(data, img->regs);
+		break;
+	case DQE_REG_IMG_GAMMA_MATRIX:
+		dqe_pack_gamma_matrix(data, img->regs);
+		break;
+	default:
+		return -EINVAL;
 	}
 
-	for (i = 0; i < DEGAMMA_LUT_SIZE; i++)
-		tmp_lut[i] = lut[i].red;
+	img->cnt = dqe_reg_img_cnt[type];
+
+	return 0;
+}
+
+static void dqe_reg_flush_lut_img(u32 dqe_id, struct cal_regs_batch *batch,
+				  const struct dqe_reg_img *img)
+{
+	u32 i, cnt;
+
+	for (i = 0; i < img->cnt; i++)
+		cal_batch_set(batch, i, img->regs[i]);
+
+	cnt = cal_batch_flush(dqe_regs_desc(dqe_id), batch);
+	cal_log_debug(0, "%u/%u regs written\n", cnt, batch->cnt);
+}
 
-	ret = cal_pack_lut_into_reg_pairs(tmp_lut, DEGAMMA_LUT_SIZE,
-		DEGAMMA_LUT_L_MASK, DEGAMMA_LUT_H_MASK, regs,
-		DQE_DEGAMMALUT_REG_CNT);
-	if(ret) {
-		cal_log_err(0, "Failed to pack degamma lut\n");
+/* programs a packed image, or disables the block if @img is NULL */
+void dqe_reg_set_img(u32 dqe_id, enum dqe_reg_img_type type,
+		     const struct dqe_reg_img *img)
+{
+	const enum dqe_version ver = regs_dqe[dqe_id].version;
+
+	cal_log_debug(0, "%s: type(%d) +\n", __func__, type);
+
+	if (type >= DQE_REG_IMG_MAX)
+		return;
+
+	if (img && img->cnt != dqe_reg_img_cnt[type]) {
+		cal_log_err(0, "invalid register image type(%d) cnt(%u)\n",
+				type, img->cnt);
 		return;
 	}
 
-	for (i = 0; i < DQE_DEGAMMALUT_REG_CNT; i++) {
-		degamma_write_relaxed(dqe_id, DQE_DEGAMMALUT(i), regs[i]);
-		cal_log_debug(0, "[%d]: 0x%x\n", i, regs[i]);
+	switch (type) {
+	case DQE_REG_IMG_DEGAMMA:
+		if (!img) {
+			degamma_write(dqe_id, DQE_DEGAMMA_CON, 0);
+			break;
+		}
+		dqe_reg_flush_lut_img(dqe_id, &regs_dqe[dqe_id].degamma_lut, img);
+		degamma_write(dqe_id, DQE_DEGAMMA_CON, DEGAMMA_EN);
+		break;
+	case DQE_REG_IMG_REGAMMA:
+		if (!img) {
+			regamma_write(dqe_id, DQE_REGAMMA_CON, 0);
+			break;
+		}
+		dqe_reg_flush_lut_img(dqe_id, &regs_dqe[dqe_id].regamma_lut, img);
+		regamma_write(dqe_id, DQE_REGAMMA_CON, REGAMMA_EN);
+		break;
+	case DQE_REG_IMG_LINEAR_MATRIX:
+		if (!img) {
+			matrix_write(dqe_id, DQE_LINEAR_MATRIX_CON, 0);
+			break;
+		}
+		cal_write_burst_relaxed(dqe_regs_desc(dqe_id),
+				DQE_LINEAR_MATRIX_COEFF(0) + matrix_offset(ver),
+				img->regs, img->cnt);
+		matrix_write(dqe_id, DQE_LINEAR_MATRIX_CON, LINEAR_MATRIX_EN);
+		break;
+	case DQE_REG_IMG_GAMMA_MATRIX:
+		if (!img) {
+			matrix_write(dqe_id, DQE_GAMMA_MATRIX_CON, 0);
+			break;
+		}
+		cal_write_burst_relaxed(dqe_regs_desc(dqe_id),
+				DQE_GAMMA_MATRIX_COEFF(0) + matrix_offset(ver),
+				img->regs, img->cnt);
+		matrix_write(dqe_id, DQE_GAMMA_MATRIX_CON, GAMMA_MATRIX_EN);
+		break;
+	default:
+		break;
 	}
-	degamma_write(dqe_id, DQE_DEGAMMA_CON, DEGAMMA_EN);
 
 	cal_log_debug(0, "%s -\n", __func__);
 }
 
-void dqe_reg_set_cgc_lut(u32 dqe_id, const struct cgc_lut *lut)
+static void dqe_reg_pack_and_set_img(u32 dqe_id, enum dqe_reg_img_type type,
+				     const void *data)
 {
-	int i;
+	struct dqe_reg_img img;
 
-	cal_log_debug(0, "%s +\n", __func__);
-
-	if (!lut) {
-		cgc_write_mask(dqe_id, DQE_CGC_CON, 0, CGC_EN_MASK);
+	if (!data) {
+		dqe_reg_set_img(dqe_id, type, NULL);
 		return;
 	}
-	for (i = 0; i < DRM_SAMSUNG_CGC_LUT_REG_CNT; ++i) {
-		dqe_write_relaxed(dqe_id, DQE_CGC_LUT_R(i), lut->r_values[i]);
-		dqe_write_relaxed(dqe_id, DQE_CGC_LUT_G(i), lut->g_values[i]);
-		dqe_write_relaxed(dqe_id, DQE_CGC_LUT_B(i), lut->b_values[i]);
+
+	if (dqe_reg_pack_img(type, data, &img)) {
+		cal_log_err(0, "failed to pack register image type(%d)\n", type);
+		return;
 	}
 
-	cgc_write_mask(dqe_id, DQE_CGC_CON, ~0, CGC_EN_MASK);
+	dqe_reg_set_img(dqe_id, type, &img);
+}
 
-	cal_log_debug(0, "%s -\n", __func__);
+void dqe_reg_set_degamma_lut(u32 dqe_id, const struct drm_color_lut *lut)
+{
+	dqe_reg_pack_and_set_img(dqe_id, DQE_REG_IMG_DEGAMMA, lut);
 }
 
-void dqe_reg_set_regamma_lut(u32 dqe_id, const struct drm_color_lut *lut)
+void dqe_reg_set_cgc_lut(u32 dqe_id, const struct cgc_lut *lut)
 {
-	enum dqe_regamma_elements {
-		REGAMMA_RED = 0,
-		REGAMMA_GREEN = 1,
-		REGAMMA_BLUE = 2,
-		REGAMMA_MAX = 3
-	};
-	int i, ret = 0;
-	u16 tmp_lut[REGAMMA_MAX][REGAMMA_LUT_SIZE] = {0};
-	u32 regs[REGAMMA_MAX][DQE_REGAMMALUT_REG_CNT] = {0};
+	struct cal_regs_desc *desc = dqe_regs_desc(dqe_id);
 
 	cal_log_debug(0, "%s +\n", __func__);
 
 	if (!lut) {
-		regamma_write(dqe_id, DQE_REGAMMA_CON, 0);
+		cgc_write_mask(dqe_id, DQE_CGC_CON, 0, CGC_EN_MASK);
 		return;
 	}
 
-	for (i = 0; i < REGAMMA_LUT_SIZE; i++) {
-		tmp_lut[REGAMMA_RED][i] = lut[i].red;
-		tmp_lut[REGAMMA_GREEN][i] = lut[i].green;
-		tmp_lut[REGAMMA_BLUE][i] = lut[i].blue;
-	}
-
-	for (i = 0; i < REGAMMA_MAX; i++) {
-		ret = cal_pack_lut_into_reg_pairs(tmp_lut[i], REGAMMA_LUT_SIZE,
-			REGAMMA_LUT_L_MASK, REGAMMA_LUT_H_MASK, regs[i],
-			DQE_REGAMMALUT_REG_CNT);
-		if(ret) {
-			cal_log_err(0, "Failed to pack regamma %d element\n", i);
-			return;
-		}
-	}
+	/*
+	 * CGC LUT is double buffered and has to be written twice with the same
+	 * values, so every register is written, one channel at a time.
+	 */
+	cal_write_burst_relaxed(desc, DQE_CGC_LUT_R(0), lut->r_values,
+			DRM_SAMSUNG_CGC_LUT_REG_CNT);
+	cal_write_burst_relaxed(desc, DQE_CGC_LUT_G(0), lut->g_values,
+			DRM_SAMSUNG_CGC_LUT_REG_CNT);
+	cal_write_burst_relaxed(desc, DQE_CGC_LUT_B(0), lut->b_values,
+			DRM_SAMSUNG_CGC_LUT_REG_CNT);
 
-	for (i = 0; i < DQE_REGAMMALUT_REG_CNT; i++) {
-		regamma_write_relaxed(dqe_id, DQE_REGAMMALUT_R(i), regs[REGAMMA_RED][i]);
-		regamma_write_relaxed(dqe_id, DQE_REGAMMALUT_G(i), regs[REGAMMA_GREEN][i]);
-		regamma_write_relaxed(dqe_id, DQE_REGAMMALUT_B(i), regs[REGAMMA_BLUE][i]);
-		cal_log_debug(0, "[%d]  red: 0x%x\n", i, regs[REGAMMA_RED][i]);
-		cal_log_debug(0, "[%d]  green: 0x%x\n", i, regs[REGAMMA_GREEN][i]);
-		cal_log_debug(0, "[%d]  blue: 0x%x\n", i, regs[REGAMMA_BLUE][i]);
-	}
-	regamma_write(dqe_id, DQE_REGAMMA_CON, REGAMMA_EN);
+	cgc_write_mask(dqe_id, DQE_CGC_CON, ~0, CGC_EN_MASK);
 
 	cal_log_debug(0, "%s -\n", __func__);
 }
 
+void dqe_reg_set_regamma_lut(u32 dqe_id, const struct drm_color_lut *lut)
+{
+	dqe_reg_pack_and_set_img(dqe_id, DQE_REG_IMG_REGAMMA, lut);
+}
+
+/*
+ * LUT registers don't keep their contents over a DQE reset or power off, so
+ * the next update of each LUT has to write all of its registers.
+ */
+void dqe_reg_invalidate_lut(u32 dqe_id)
+{
+	cal_batch_invalidate(&regs_dqe[dqe_id].degamma_lut);
+	cal_batch_invalidate(&regs_dqe[dqe_id].regamma_lut);
+}
+
 static void dqe_reg_print_lut(u32 dqe_id, u32 start, u32 count, const u32 offset,
 						struct drm_printer *pr)
 {
@@ -374,68 +543,12 @@ void dqe_reg_print_regamma_lut(u32 dqe_id, struct drm_printer *p)
 
 void dqe_reg_set_linear_matrix(u32 dqe_id, const struct exynos_matrix *lm)
 {
-	int i, reg_cnt;
-	u32 val;
-
-	cal_log_debug(0, "%s +\n", __func__);
-
-	if (!lm) {
-		matrix_write(dqe_id, DQE_LINEAR_MATRIX_CON, 0);
-		return;
-	}
-
-	reg_cnt = DIV_ROUND_UP(LINEAR_MATRIX_COEFFS_CNT , 2);
-	for (i = 0; i < reg_cnt; ++i) {
-		if (i == reg_cnt - 1)
-			val = LINEAR_MATRIX_COEFF_L(lm->coeffs[i * 2]);
-		else
-			val = LINEAR_MATRIX_COEFF_H(lm->coeffs[i * 2 + 1]) |
-				LINEAR_MATRIX_COEFF_L(lm->coeffs[i * 2]);
-		matrix_write_relaxed(dqe_id, DQE_LINEAR_MATRIX_COEFF(i), val);
-	}
-
-	matrix_write_relaxed(dqe_id, DQE_LINEAR_MATRIX_OFFSET0,
-			LINEAR_MATRIX_OFFSET_1(lm->offsets[1]) |
-			LINEAR_MATRIX_OFFSET_0(lm->offsets[0]));
-	matrix_write_relaxed(dqe_id, DQE_LINEAR_MATRIX_OFFSET1,
-			LINEAR_MATRIX_OFFSET_2(lm->offsets[2]));
-
-	matrix_write(dqe_id, DQE_LINEAR_MATRIX_CON, LINEAR_MATRIX_EN);
-
-	cal_log_debug(0, "%s -\n", __func__);
+	dqe_reg_pack_and_set_img(dqe_id, DQE_REG_IMG_LINEAR_MATRIX, lm);
 }
 
 void dqe_reg_set_gamma_matrix(u32 dqe_id, const struct exynos_matrix *matrix)
 {
-	int i, reg_cnt;
-	u32 val;
-
-	cal_log_debug(0, "%s +\n", __func__);
-
-	if (!matrix) {
-		matrix_write(dqe_id, DQE_GAMMA_MATRIX_CON, 0);
-		return;
-	}
-
-	reg_cnt = DIV_ROUND_UP(GAMMA_MATRIX_COEFFS_CNT , 2);
-	for (i = 0; i < reg_cnt; ++i) {
-		if (i == reg_cnt - 1)
-			val = GAMMA_MATRIX_COEFF_L(matrix->coeffs[i * 2]);
-		else
-			val = GAMMA_MATRIX_COEFF_H(matrix->coeffs[i * 2 + 1]) |
-				GAMMA_MATRIX_COEFF_L(matrix->coeffs[i * 2]);
-		matrix_write_relaxed(dqe_id, DQE_GAMMA_MATRIX_COEFF(i), val);
-	}
-
-	matrix_write_relaxed(dqe_id, DQE_GAMMA_MATRIX_OFFSET0,
-			GAMMA_MATRIX_OFFSET_1(matrix->offsets[1]) |
-			GAMMA_MATRIX_OFFSET_0(matrix->offsets[0]));
-	matrix_write_relaxed(dqe_id, DQE_GAMMA_MATRIX_OFFSET1,
-			GAMMA_MATRIX_OFFSET_2(matrix->offsets[2]));
-
-	matrix_write(dqe_id, DQE_GAMMA_MATRIX_CON, GAMMA_MATRIX_EN);
-
-	cal_log_debug(0, "%s -\n", __func__);
+	dqe_reg_pack_and_set_img(dqe_id, DQE_REG_IMG_GAMMA_MATRIX, matrix);
 }
 
 void dqe_reg_set_atc(u32 dqe_id, const struct exynos_atc *atc)
@@ -17,6 +17,7 @@
 
 #include "regs-dsim.h"
 #include <dsim_cal.h>
+#include <dsim_payload.h>
 #include <cal_config.h>
 #include <soc/google/debug-snapshot.h>
 
@@ -2264,6 +2265,29 @@ void dsim_reg_wr_tx_payload(u32 id, u32 payload)
 	dsim_write(id, DSIM_PAYLOAD, payload);
 }
 
+/*
+ * Payload writes below are relaxed. The packet header, which is written with a
+ * regular write after the payload, orders them against the transfer start.
+ */
+void dsim_reg_wr_tx_payload_words(u32 id, const u32 *words, u32 cnt)
+{
+	struct cal_regs_desc *desc = dsim_regs_desc(id);
+	u32 i;
+
+	for (i = 0; i < cnt; i++)
+		cal_write_relaxed(desc, DSIM_PAYLOAD, words[i]);
+}
+
+static inline void dsim_reg_wr_tx_payload_word(void *desc, u32 word)
+{
+	cal_write_relaxed(desc, DSIM_PAYLOAD, word);
+}
+
+void dsim_reg_wr_tx_payload_buf(u32 id, const u8 *buf, u32 len)
+{
+	dsim_payload_write(buf, len, dsim_reg_wr_tx_payload_word, dsim_regs_desc(id));
+}
+
 u32 dsim_reg_header_fifo_is_empty(u32 id)
 {
 	return dsim_read_mask(id, DSIM_FIFOCTRL, DSIM_FIFOCTRL_EMPTY_PH_SFR);
@@ -188,6 +188,100 @@ static inline int cal_pack_lut_into_reg_pairs(const uint16_t *lut,
 	return 0;
 }
 
+/*
+ * Writes an array of values to a block of consecutive registers as one burst of
+ * relaxed writes. The caller is responsible for ordering the burst against the
+ * following accesses, normally by a non-relaxed write enabling the block.
+ */
+static inline void cal_write_burst_relaxed(struct cal_regs_desc *regs_desc,
+		uint32_t offset, const uint32_t *vals, uint32_t cnt)
+{
+	uint32_t i;
+
+	for (i = 0; i < cnt; i++)
+		cal_write_relaxed(regs_desc, offset + i * 4, vals[i]);
+}
+
+/*
+ * Register batch keeps a shadow copy of a block of consecutive registers.
+ * Values are staged with cal_batch_set() and written by cal_batch_flush() as a
+ * single burst. While the shadow is known to match the hardware, only the
+ * range between the first and the last changed register is written out.
+ *
+ * @offset: Offset of the first register of the block
+ * @cnt: Number of registers in the block
+ * @vals: Shadow copy of the register values, @cnt entries
+ * @dirty_start: First register changed since the last flush
+ * @dirty_end: One past the last register changed since the last flush
+ * @synced: Shadow copy matches the hardware
+ */
+struct cal_regs_batch {
+	uint32_t offset;
+	uint32_t cnt;
+	uint32_t *vals;
+	uint32_t dirty_start;
+	uint32_t dirty_end;
+	bool synced;
+};
+
+static inline void cal_batch_init(struct cal_regs_batch *batch,
+		uint32_t offset, uint32_t *vals, uint32_t cnt)
+{
+	batch->offset = offset;
+	batch->cnt = cnt;
+	batch->vals = vals;
+	batch->dirty_start = 0;
+	batch->dirty_end = 0;
+	batch->synced = false;
+}
+
+/* registers lost their contents, next flush writes the whole block */
+static inline void cal_batch_invalidate(struct cal_regs_batch *batch)
+{
+	batch->synced = false;
+}
+
+static inline void cal_batch_set(struct cal_regs_batch *batch, uint32_t idx,
+		uint32_t val)
+{
+	if (batch->synced && batch->vals[idx] == val)
+		return;
+
+	batch->vals[idx] = val;
+
+	if (batch->dirty_start >= batch->dirty_end) {
+		batch->dirty_start = idx;
+		batch->dirty_end = idx + 1;
+	} else if (idx < batch->dirty_start) {
+		batch->dirty_start = idx;
+	} else if (idx >= batch->dirty_end) {
+		batch->dirty_end = idx + 1;
+	}
+}
+
+/* returns the number of registers written */
+static inline uint32_t cal_batch_flush(struct cal_regs_desc *regs_desc,
+		struct cal_regs_batch *batch)
+{
+	uint32_t start = batch->dirty_start;
+	uint32_t end = batch->dirty_end;
+
+	if (!batch->synced) {
+		start = 0;
+		end = batch->cnt;
+	}
+
+	if (start < end)
+		cal_write_burst_relaxed(regs_desc, batch->offset + start * 4,
+				&batch->vals[start], end - start);
+
+	batch->dirty_start = 0;
+	batch->dirty_end = 0;
+	batch->synced = true;
+
+	return start < end ? end - start : 0;
+}
+
 static inline void cal_set_write_protected(struct cal_regs_desc *regs_desc,
 				     bool protected)
 {
@@ -36,9 +36,29 @@ enum dqe_version {
 	DQE_VERSION_MAX,
 };
 
+/* DQE blocks whose register values can be packed ahead of programming */
+enum dqe_reg_img_type {
+	DQE_REG_IMG_DEGAMMA = 0,
+	DQE_REG_IMG_REGAMMA,
+	DQE_REG_IMG_LINEAR_MATRIX,
+	DQE_REG_IMG_GAMMA_MATRIX,
+	DQE_REG_IMG_MAX,
+};
+
+/* regamma is the largest one: 65 points of R, G and B, two points per register */
+#define DQE_REG_IMG_MAX_CNT		(DIV_ROUND_UP(REGAMMA_LUT_SIZE, 2) * 3)
+
+/* register values of a DQE block, in the order they are laid out in SFR */
+struct dqe_reg_img {
+	u32 cnt;
+	u32 regs[DQE_REG_IMG_MAX_CNT];
+};
+
 struct cal_regs_dqe {
 	struct cal_regs_desc desc;
 	enum dqe_version version;
+	struct cal_regs_batch degamma_lut;
+	struct cal_regs_batch regamma_lut;
 };
 
 enum dqe_regs_id {
@@ -176,6 +196,11 @@ void dqe_reg_init(u32 dqe_id, u32 width, u32 height);
 void dqe_reg_set_degamma_lut(u32 dqe_id, const struct drm_color_lut *lut);
 void dqe_reg_set_cgc_lut(u32 dqe_id, const struct cgc_lut *lut);
 void dqe_reg_set_regamma_lut(u32 dqe_id, const struct drm_color_lut *lut);
+void dqe_reg_invalidate_lut(u32 dqe_id);
+int dqe_reg_pack_img(enum dqe_reg_img_type type, const void *data,
+		     struct dqe_reg_img *img);
+void dqe_reg_set_img(u32 dqe_id, enum dqe_reg_img_type type,
+		     const struct dqe_reg_img *img);
 void dqe_reg_set_cgc_dither(u32 dqe_id, struct dither_config *config);
 void dqe_reg_set_disp_dither(u32 dqe_id, struct dither_config *config);
 void dqe_reg_set_linear_matrix(u32 dqe_id, const struct exynos_matrix *lm);
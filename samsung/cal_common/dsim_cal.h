@@ -217,6 +217,8 @@ void dsim_reg_clear_int(u32 id, u32 int_src);
 /* DSIM read/write command control */
 void dsim_reg_wr_tx_header(u32 id, u8 di, u8 d0, u8 d1, bool bta);
 void dsim_reg_wr_tx_payload(u32 id, u32 payload);
+void dsim_reg_wr_tx_payload_words(u32 id, const u32 *words, u32 cnt);
+void dsim_reg_wr_tx_payload_buf(u32 id, const u8 *buf, u32 len);
 u32 dsim_reg_header_fifo_is_empty(u32 id);
 u32 dsim_reg_payload_fifo_is_empty(u32 id);
 u32 dsim_reg_get_rx_fifo(u32 id);
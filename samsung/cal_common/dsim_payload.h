@@ -0,0 +1,105 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ *
+ * Copyright (C) 2023 Google LLC
+ *
+ * Packing of DSI packet payloads into the words of the DSIM TX payload FIFO.
+ *
+ * The FIFO takes the payload as little-endian 32-bit words, the last one
+ * holding the 1 to 3 remaining bytes if the length isn't a multiple of 4. The
+ * word writer is passed in and inlined, so that it's the only place touching
+ * the registers, and this can be built outside of the kernel as well, in that
+ * case the few kernel helpers it depends on are provided below.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef __DSIM_PAYLOAD_H__
+#define __DSIM_PAYLOAD_H__
+
+#ifdef __KERNEL__
+#include <linux/compiler.h>
+#include <linux/kernel.h>
+#include <linux/types.h>
+#include <asm/byteorder.h>
+#include <asm/unaligned.h>
+#else
+#include <linux/types.h>
+#include <stdint.h>
+#include <string.h>
+
+typedef uint8_t u8;
+typedef uint32_t u32;
+
+#ifndef __always_inline
+#define __always_inline		inline __attribute__((__always_inline__))
+#endif
+#define fallthrough		__attribute__((__fallthrough__))
+
+#define IS_ALIGNED(x, a)	(((x) & ((__typeof__(x))(a) - 1)) == 0)
+
+static inline u32 le32_to_cpu(__le32 val)
+{
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	return __builtin_bswap32(val);
+#else
+	return val;
+#endif
+}
+
+static inline u32 get_unaligned_le32(const void *p)
+{
+	__le32 val;
+
+	memcpy(&val, p, sizeof(val));
+
+	return le32_to_cpu(val);
+}
+#endif
+
+/*
+ * dsim_payload_write() - write a payload to the TX payload FIFO
+ * @buf: payload, doesn't need to be aligned
+ * @len: payload length in bytes
+ * @write: writes one FIFO word
+ * @ctx: passed to @write
+ *
+ * Whole words are loaded straight from @buf, the tail is assembled from the
+ * remaining bytes.
+ */
+static __always_inline void dsim_payload_write(const u8 *buf, u32 len,
+					       void (*write)(void *ctx, u32 word), void *ctx)
+{
+	const u32 cnt = len / 4;
+	const u8 *tail = buf + cnt * 4;
+	u32 val = 0;
+	u32 i;
+
+	if (IS_ALIGNED((uintptr_t)buf, 4)) {
+		const __le32 *words = (const __le32 *)buf;
+
+		for (i = 0; i < cnt; i++)
+			write(ctx, le32_to_cpu(words[i]));
+	} else {
+		for (i = 0; i < cnt; i++)
+			write(ctx, get_unaligned_le32(buf + i * 4));
+	}
+
+	switch (len % 4) {
+	case 3:
+		val |= tail[2] << 16;
+		fallthrough;
+	case 2:
+		val |= tail[1] << 8;
+		fallthrough;
+	case 1:
+		val |= tail[0];
+		write(ctx, val);
+		break;
+	default:
+		break;
+	}
+}
+
+#endif /* __DSIM_PAYLOAD_H__ */
@@ -33,6 +33,7 @@
 #include <dt-bindings/clock/exynos9820.h>
 #endif
 
+#include <linux/jhash.h>
 #include <linux/kernel.h>
 #include <trace/dpu_trace.h>
 #include "exynos_drm_decon.h"
@@ -41,378 +42,46 @@
 
 #define DISP_FACTOR_PCT		100UL
 #define MULTI_FACTOR		(1UL << 10)
-#define ROT_READ_BYTE		(32) /* unit : BYTE(= pixel, based on NV12) */
-
-#define ACLK_100MHZ_PERIOD	10000UL
-#define FRAME_TIME_NSEC		1000000000UL	/* 1sec */
 
 /* TODO: remove it after we move logic into bts driver */
 #define NUM_INTERCONNECT_CH		4
 
-#define DPU_DEBUG_BTS(fmt, args...)	pr_debug("[BTS] "fmt,  ##args)
-#define DPU_INFO_BTS(fmt, args...)	pr_info("[BTS] "fmt,  ##args)
-#define DPU_ERR_BTS(fmt, args...)	pr_err("[BTS] "fmt, ##args)
-
-/*
- * 1. function clock
- *    panel_clk = panel_w * panel_h * fps * margin / ppc
- *    vertical scale-down case (src_h > dst_h)
- *     clk[i] = (line_a * ratio_a + line_b * (1 - ratio_a)) *
- *                  panel_h * fps * margin / ppc
- *        - line_a = max((ratio_v - 2) * src_w + max(src_w, dst_w), panel_w + diff_w)
- *        - line_b = max((ratio_v - 1) * src_w + max(src_w, dst_w), panel_w + diff_w)
- *        - ratio_v = ceiling(src_h / dst_h)
- *        - ratio_a = ratio_v - (src_h / dst_h)
- *        - diff_w = (src_w <= dst_w) ? 0 : src_w - dst_w
- *    non-vertical scale-down case
- *     clk[i] = ((panel_w + diff_w) * ratio_v + panel_w * (1 - ratio_v)) *
- *                  panel_h * fps * margin / ppc
- *        - ratio_v = (src_h >= dst_h) ? 1 : src_h / dst_h
- *        - diff_w = (src_w <= dst_w) ? 0 : src_w - dst_w
- *    margin = 1.1 + HW bubble cycles
- *    aclk1 = max(panel_clk, clk[i])
- * 2. AXI throughput clock
- *    1) fps based
- *       clk_bw[i] = src_w * src_h * fps * (bpp / 8) * (panel_h / dst_h) * 1.1
- *                       / (bus_width * bus_util_pct)
- *    2) rotation throughput for initial latency
- *       clk_r[i] = src_h * 32 * (bpp / 8) / (bus_width * rot_util_pct) / (v_blank)
- *       # v_blank : command - TE_hi_pulse
- *                   video - (vbp) @initial-frame, (vbp+vfp) @inter-frame
- *    if (clk_bw[i] < clk_r[i])
- *       clk_bw[i] = clk_r[i]
- *    aclk2 = max(clk for sum(same axi overlap bw[i]))
- *
- * => aclk_dpu = max(aclk1, aclk2)
- */
-
-/* unit : usec x 1000 -> 5592 (5.592us) for WQHD+ case */
-static inline u32 dpu_bts_get_one_line_time(u32 lcd_height, u32 vbp, u32 vfp,
-		u32 vsa, u32 fps)
-{
-	u32 tot_v;
-	int tmp;
-
-	tot_v = lcd_height + vfp + vsa + vbp;
-	tmp = DIV_ROUND_UP(FRAME_TIME_NSEC, fps);
-
-	return (tmp / tot_v);
-}
-
-/* framebuffer compressor(AFBC, SBWC) line delay is usually 4 */
-static inline u32 dpu_bts_comp_latency(u32 src_w, u32 ppc, u32 line_delay)
-{
-	return mult_frac(src_w, line_delay, ppc);
-}
-
-/* scaler line delay is usually 3
- * scaling order : horizontal -> vertical scale
- * -> need to reflect scale-ratio
- */
-static inline u32 dpu_bts_scale_latency(u32 src_w, u32 dst_w, u32 ppc,
-				u32 line_delay)
-{
-	if (src_w > dst_w)
-		return mult_frac(src_w * line_delay, src_w, dst_w * ppc);
-	else
-		return DIV_ROUND_CLOSEST(src_w * line_delay, ppc);
-}
-
-/* rotator ppc is usually 4 or 8
- * 1-read : 32BYTE (pixel)
- */
-static inline u32 dpu_bts_rotate_latency(u32 src_w, u32 r_ppc)
-{
-	return (src_w * (ROT_READ_BYTE / r_ppc));
-}
-
-/*
- * [DSC]
- * Line memory is necessary like following.
- *  1EA(1ppc) : 2-line for 2-slice, 1-line for 1-slice
- *  2EA(2ppc) : 3.5-line for 4-slice (DSCC 0.5-line + DSC 3-line)
- *        2.5-line for 2-slice (DSCC 0.5-line + DSC 2-line)
- *
- * [DECON] none
- * When 1H is filled at OUT_FIFO, it immediately transfers to DSIM.
- */
-static inline u32 dpu_bts_dsc_latency(u32 slice_num, u32 dsc_cnt,
-		u32 dst_w, u32 ppc)
+static void dpu_bts_get_params(const struct decon_device *decon, struct dpu_bts_params *p)
 {
-	u32 lat_dsc = dst_w;
-
-	switch (slice_num) {
-	case 1:
-		/* DSC: 1EA */
-		lat_dsc = dst_w * 1;
-		break;
-	case 2:
-		if (dsc_cnt == 1)
-			lat_dsc = dst_w * 2;
-		else
-			lat_dsc = (dst_w * 25) / (10 * ppc);
-		break;
-	case 4:
-		/* DSC: 2EA */
-		lat_dsc = (dst_w * 35) / (10 * ppc);
-		break;
-	default:
-		break;
-	}
-
-	return lat_dsc;
-}
-
-/*
- * unit : nsec x 1000
- * reference aclk : 100MHz (-> 10ns x 1000)
- * # cycles = usec * aclk_mhz
- */
-static inline u32 dpu_bts_convert_aclk_to_ns(u32 aclk_mhz)
-{
-	return ((ACLK_100MHZ_PERIOD * 100) / aclk_mhz);
-}
-
-/*
- * return : kHz value based on 1-pixel processing pipe-line
- */
-static u64 dpu_bts_get_resol_clock(u32 xres, u32 yres, u32 fps)
-{
-	u64 margin;
-	u64 resol_khz;
-
-	/*
-	 * aclk_khz = vclk_1pix * ( 1.1 + (48+20)/WIDTH ) : x1000
-	 * @ (1.1)   : BUS Latency Considerable Margin (10%)
-	 * @ (48+20) : HW bubble cycles
-	 *      - 48 : 12 cycles per slice, total 4 slice
-	 *      - 20 : hblank cycles for other HW module
-	 */
-	margin = 1100 + ((48000 + 20000) / xres);
-	/* convert to kHz unit */
-	resol_khz = (xres * yres * fps * margin / 1000) / 1000;
-
-	return resol_khz;
-}
-
-static u32 dpu_bts_get_vblank_time_ns(struct decon_device *decon)
-{
-	u32 line_t_ns, v_blank_t_ns;
-
-	line_t_ns = dpu_bts_get_one_line_time(decon->config.image_height,
-		decon->bts.vbp, decon->bts.vfp, decon->bts.vsa, decon->bts.fps);
-	if (decon->config.mode.op_mode == DECON_VIDEO_MODE)
-		v_blank_t_ns = (decon->bts.vbp + decon->bts.vfp) * line_t_ns;
-	else
-		v_blank_t_ns = decon->bts.vblank_usec * 1000U;
-
-	DPU_DEBUG_BTS("  -line_t_ns(%u) v_blank_t_ns(%u)\n",
-			line_t_ns, v_blank_t_ns);
-
-	return v_blank_t_ns;
-}
-
-static u32 dpu_bts_find_nearest_high_freq(struct decon_device *decon, u32 aclk_base)
-{
-	int i;
-
-	if (aclk_base > decon->bts.dfs_lv_khz[0]) {
-		DPU_DEBUG_BTS("  aclk_base is greater than L0 frequency!");
-		i = 0;
-	} else {
-		/* search from low frequency level */
-		for (i = (decon->bts.dfs_lv_cnt - 1); i >= 0; i--) {
-			if (aclk_base <= decon->bts.dfs_lv_khz[i])
-				break;
-		}
-	}
-	DPU_DEBUG_BTS("  Nearest DFS: %u KHz @L%d\n", decon->bts.dfs_lv_khz[i], i);
-
-	return i;
+	p->lcd_w = decon->config.image_width;
+	p->lcd_h = decon->config.image_height;
+	p->fps = decon->bts.fps;
+	p->vbp = decon->bts.vbp;
+	p->vfp = decon->bts.vfp;
+	p->vsa = decon->bts.vsa;
+	p->vblank_usec = decon->bts.vblank_usec;
+	p->video_mode = decon->config.mode.op_mode == DECON_VIDEO_MODE;
+
+	p->dsc_enabled = decon->config.dsc.enabled;
+	p->dsc_count = decon->config.dsc.dsc_count;
+	p->dsc_slice_count = decon->config.dsc.slice_count;
+
+	p->ppc = decon->bts.ppc;
+	p->ppc_rotator = decon->bts.ppc_rotator;
+	p->ppc_scaler = decon->bts.ppc_scaler;
+	p->delay_comp = decon->bts.delay_comp;
+	p->delay_scaler = decon->bts.delay_scaler;
+	p->bus_width = decon->bts.bus_width;
+	p->bus_util_pct = decon->bts.bus_util_pct;
+	p->rot_util_pct = decon->bts.rot_util_pct;
+	p->afbc_rgb_util_pct = decon->bts.afbc_rgb_util_pct;
+	p->afbc_yuv_util_pct = decon->bts.afbc_yuv_util_pct;
+	p->afbc_rgb_rt_util_pct = decon->bts.afbc_rgb_rt_util_pct;
+	p->afbc_yuv_rt_util_pct = decon->bts.afbc_yuv_rt_util_pct;
+
+	p->dfs_lv_cnt = decon->bts.dfs_lv_cnt;
+	p->dfs_lv_khz = decon->bts.dfs_lv_khz;
 }
 
 /*
- * [caution] src_w/h is rotated size info
- * - src_w : src_h @original input image
- * - src_h : src_w @original input image
+ * DECONs scan out with independent timing, so the peaks of different DECONs
+ * can line up at any time. Sum of the per DECON peaks is the tight bound then.
  */
-static u64 dpu_bts_calc_rotate_aclk(struct decon_device *decon, u32 aclk_base,
-		u32 ppc, u32 src_w, u32 dst_w,
-		bool is_comp, bool is_downscale, bool is_dsc)
-{
-	u32 dfs_idx = 0;
-	u32 dpu_cycle, basic_cycle, dsi_cycle, module_cycle = 0;
-	u32 comp_cycle = 0, rot_cycle = 0, scale_cycle = 0, dsc_cycle = 0;
-	u32 rot_init_bw = 0; /* KB/s */
-	u64 rot_clk, rot_need_clk;
-	u32 aclk_x_1k_ns, dpu_lat_t_ns, max_lat_t_ns, tx_allow_t_ns;
-	u32 bus_perf;
-	u32 temp_clk;
-	bool retry_flag = false;
-
-	DPU_DEBUG_BTS("[ROT+] BEFORE latency check: %u KHz\n", aclk_base);
-
-	dfs_idx = dpu_bts_find_nearest_high_freq(decon, aclk_base);
-	rot_clk = decon->bts.dfs_lv_khz[dfs_idx];
-
-	/* post DECON OUTFIFO based on 1H transfer */
-	dsi_cycle = decon->config.image_width;
-
-	/* get additional pipeline latency */
-	if (is_comp) {
-		comp_cycle = dpu_bts_comp_latency(src_w, ppc,
-			decon->bts.delay_comp);
-		DPU_DEBUG_BTS("  COMP: lat_cycle(%u)\n", comp_cycle);
-		module_cycle += comp_cycle;
-	} else {
-		rot_cycle = dpu_bts_rotate_latency(src_w,
-			decon->bts.ppc_rotator);
-		DPU_DEBUG_BTS("  ROT: lat_cycle(%u)\n", rot_cycle);
-		module_cycle += rot_cycle;
-	}
-	if (is_downscale) {
-		scale_cycle = dpu_bts_scale_latency(src_w, dst_w,
-			decon->bts.ppc_scaler, decon->bts.delay_scaler);
-		DPU_DEBUG_BTS("  SCALE: lat_cycle(%u)\n", scale_cycle);
-		module_cycle += scale_cycle;
-	}
-	if (is_dsc) {
-		dsc_cycle = dpu_bts_dsc_latency(decon->config.dsc.slice_count,
-			decon->config.dsc.dsc_count, dst_w, ppc);
-		DPU_DEBUG_BTS("  DSC: lat_cycle(%u)\n", dsc_cycle);
-		module_cycle += dsc_cycle;
-		dsi_cycle = (dsi_cycle + 2) / 3;
-	}
-
-	/*
-	 * basic cycle(+ bubble: 10%) + additional cycle based on function
-	 * cycle count increases when ACLK goes up due to other conditions
-	 * At latency monitor experiment using unit test,
-	 *  cycles at 400Mhz were increased by about 800 compared to 200Mhz.
-	 * Here, (aclk_mhz * 2) cycles are reflected referring to the result
-	 *  because the exact value is unknown.
-	 */
-	basic_cycle = (decon->config.image_width * 11 / 10 + dsi_cycle) / ppc;
-
-retry_hi_freq:
-	dpu_cycle = (basic_cycle + module_cycle) + rot_clk * 2 / 1000U;
-	aclk_x_1k_ns = dpu_bts_convert_aclk_to_ns(rot_clk / 1000U);
-	dpu_lat_t_ns = mult_frac(aclk_x_1k_ns, dpu_cycle, 1000);
-	max_lat_t_ns = dpu_bts_get_vblank_time_ns(decon);
-	if (max_lat_t_ns > dpu_lat_t_ns) {
-		tx_allow_t_ns = max_lat_t_ns - dpu_lat_t_ns;
-	} else {
-		/* abnormal case : apply bus_util_pct of v_blank */
-		tx_allow_t_ns = (max_lat_t_ns * decon->bts.bus_util_pct) / 100;
-		DPU_DEBUG_BTS("  WARN: latency calc is abnormal!(-> %u%%)\n",
-				decon->bts.bus_util_pct);
-	}
-
-	bus_perf = decon->bts.bus_width * decon->bts.rot_util_pct;
-	/* apply as worst(P010: 3) case to simplify */
-	rot_init_bw = mult_frac(NSEC_PER_SEC, src_w * ROT_READ_BYTE * 3, tx_allow_t_ns) / 1000;
-	rot_need_clk = rot_init_bw * 100 / bus_perf;
-
-	if (rot_need_clk > rot_clk) {
-		/* not max level */
-		if (dfs_idx) {
-			/* check if calc_clk is greater than 1-step */
-			dfs_idx--;
-			temp_clk = decon->bts.dfs_lv_khz[dfs_idx];
-			if ((rot_need_clk > temp_clk) && (!retry_flag)) {
-				DPU_DEBUG_BTS("  -allow_ns(%u) dpu_ns(%u)\n",
-					tx_allow_t_ns, dpu_lat_t_ns);
-				rot_clk = temp_clk;
-				retry_flag = true;
-				goto retry_hi_freq;
-			}
-		}
-		rot_clk = rot_need_clk;
-	}
-
-	DPU_DEBUG_BTS("  -dpu_cycle(%u) aclk_x_1k_ns(%u) dpu_lat_t_ns(%u)\n",
-			dpu_cycle, aclk_x_1k_ns, dpu_lat_t_ns);
-	DPU_DEBUG_BTS("  -tx_allow_t_ns(%u) rot_init_bw(%u) rot_need_clk(%llu)\n",
-			tx_allow_t_ns, rot_init_bw, rot_need_clk);
-	DPU_DEBUG_BTS("[ROT-] AFTER latency check: %llu KHz\n", rot_clk);
-
-	return rot_clk;
-}
-
-static u64 dpu_bts_calc_aclk_disp(struct decon_device *decon,
-				  const struct dpu_bts_win_config *config, u64 resol_clk,
-				  u32 max_clk)
-{
-	u64 aclk_disp, aclk_base, aclk_panel_khz, aclk_disp_khz;
-	u32 ppc;
-	u32 src_w, src_h;
-	u32 diff_w, ratio_v;
-	u32 is_downscale = false;
-	u32 is_dsc = false;
-	u64 margin;
-
-	if (config->is_rot) {
-		src_w = config->src_h;
-		src_h = config->src_w;
-	} else {
-		src_w = config->src_w;
-		src_h = config->src_h;
-	}
-
-	if (src_w > config->dst_w || src_h > config->dst_h)
-		is_downscale = true;
-
-	/* when calculating aclk for panel, if DSC is enabled, consider DSC encoder
-	 * count as its ppc.
-	 */
-	if (decon->config.dsc.enabled) {
-		ppc = min(decon->bts.ppc, decon->config.dsc.dsc_count);
-		is_dsc = true;
-	} else {
-		ppc = decon->bts.ppc;
-	}
-	aclk_panel_khz = resol_clk / ppc;
-
-	margin = 1100 + ((48000 + 20000) / decon->config.image_width);
-	diff_w = (src_w <= config->dst_w) ? 0 : src_w - config->dst_w;
-
-	if (src_h > config->dst_h) {
-		u32 ratio_a, line_a, line_b;
-
-		ratio_v = DIV_ROUND_UP(src_h, config->dst_h);
-		ratio_a = (ratio_v * 1000) - mult_frac(src_h, 1000, config->dst_h);
-		line_a = max((ratio_v - 2) * src_w + max(src_w, config->dst_w),
-				decon->config.image_width + diff_w);
-		line_b = max((ratio_v - 1) * src_w + max(src_w, config->dst_w),
-				decon->config.image_width + diff_w);
-		aclk_disp = (u64)(line_a * ratio_a + line_b * (1000 - ratio_a));
-	} else {
-		ratio_v = (src_h >= config->dst_h) ? 1000 : mult_frac(src_h, 1000, config->dst_h);
-		aclk_disp = (u64)((decon->config.image_width + diff_w) *
-			ratio_v + decon->config.image_width * (1000 - ratio_v));
-	}
-	aclk_disp = mult_frac(aclk_disp, decon->config.image_height * decon->bts.fps, 1000);
-	aclk_disp_khz = (aclk_disp * margin / 1000) / 1000;
-	aclk_disp_khz /= decon->bts.ppc;
-
-	if (aclk_disp_khz < aclk_panel_khz)
-		aclk_disp_khz = aclk_panel_khz;
-
-	if (!config->is_rot)
-		return aclk_disp_khz;
-
-	/* rotation case: check if latency conditions are met */
-	if (aclk_disp_khz > max_clk)
-		aclk_base = aclk_disp_khz;
-	else
-		aclk_base = max_clk;
-
-	aclk_disp_khz = dpu_bts_calc_rotate_aclk(decon, (u32)aclk_base, ppc,
-			src_w, config->dst_w, config->is_comp, is_downscale, is_dsc);
-
-	return aclk_disp_khz;
-}
-
 static void dpu_bts_sum_all_decon_bw(u32 id, u32 *max_overlap_bw, u32 *max_disp_ch_bw)
 {
 	int i, j;
@@ -457,178 +126,67 @@ static void dpu_bts_sum_all_decon_bw(u32 id, u32 *max_overlap_bw, u32 *max_disp_
 		*max_overlap_bw, *max_disp_ch_bw);
 }
 
-static u32 dpu_bts_calc_disp_with_full_size(struct decon_device *decon)
+static u32 dpu_bts_get_disp_with_full_size(struct decon_device *decon,
+					   const struct dpu_bts_params *p)
 {
-	struct dpu_bts_win_config config;
+	decon->bts.resol_clk = dpu_bts_calc_resol_clock(p->lcd_w, p->lcd_h, p->fps);
 
-	memset(&config, 0, sizeof(struct dpu_bts_win_config));
-	config.src_w = config.dst_w = decon->config.image_width;
-	config.src_h = config.dst_h = decon->config.image_height;
-	config.format = DRM_FORMAT_ARGB8888;
-
-	decon->bts.resol_clk = dpu_bts_get_resol_clock(
-			decon->config.image_width,
-			decon->config.image_height, decon->bts.fps);
-
-	return dpu_bts_calc_aclk_disp(decon, &config, decon->bts.resol_clk,
-		decon->bts.resol_clk);
+	return dpu_bts_calc_disp_with_full_size(p, decon->bts.resol_clk);
 }
 
-static bool is_win_half_covered(const struct dpu_bts_win_config *config0,
-				const struct dpu_bts_win_config *config1)
+static bool dpu_bts_get_layer(const struct decon_device *decon,
+			      const struct dpu_bts_win_config *config,
+			      struct dpu_bts_layer *layer)
 {
-	u32 start_y0;
-	u32 start_y1, end_y1;
+	const u32 plane_id = DPPCH2PLANE(config->dpp_id);
 
-	if (unlikely(!config0) || unlikely(!config1)) {
-		pr_err("win config is invalid\n");
+	if (config->state != DPU_WIN_STATE_BUFFER)
 		return false;
-	}
-
-	if (config0 == config1)
-		return true;
 
-	start_y0 = config0->dst_y;
-	start_y1 = config1->dst_y;
-	end_y1 = config1->dst_y + config1->dst_h;
+	layer->y1 = config->dst_y;
+	layer->y2 = config->dst_y + config->dst_h;
+	layer->rt_bw = decon->bts.rt_bw[plane_id].val;
+	layer->ch_num = decon->bts.rt_bw[plane_id].ch_num;
 
-	if (start_y0 >= start_y1 && start_y0 < end_y1)
-		return true;
-
-	return false;
+	return true;
 }
 
-static u32 dpu_bts_get_rt_bw(struct decon_device *decon,
-				const struct dpu_bts_win_config *win_config)
+static void dpu_bts_update_overlap_bw(struct decon_device *decon)
 {
-	const u32 plane_id = DPPCH2PLANE(win_config->dpp_id);
-
-	return decon->bts.rt_bw[plane_id].val;
-}
-
-static void dpu_bts_update_overlap_bw(struct decon_device *decon,
-				       const struct dpu_bts_win_config *win_config,
-				       const struct dpu_bts_win_config *rcd_config)
-{
-	int i, j;
-	u32 win_max_overlap_bw = 0, rcd_max_overlap_bw = 0;
-
-	/* overlap rt bandwidth requirement */
-	/* TODO: take write rt bandwidth into account */
-	for (i = 0; i < decon->win_cnt; i++) {
-		u32 overlap_bw;
-
-		if (win_config[i].state != DPU_WIN_STATE_BUFFER)
-			continue;
-
-		overlap_bw = 0;
-		for (j = 0; j < decon->win_cnt; j++) {
-			if (win_config[j].state != DPU_WIN_STATE_BUFFER)
-				continue;
-
-			if (is_win_half_covered(&win_config[i], &win_config[j]))
-				overlap_bw += dpu_bts_get_rt_bw(decon, &win_config[j]);
-		}
-
-		if (rcd_config->state == DPU_WIN_STATE_BUFFER) {
-			if (is_win_half_covered(&win_config[i], rcd_config))
-				overlap_bw += dpu_bts_get_rt_bw(decon, rcd_config);
-
-			if (is_win_half_covered(rcd_config, &win_config[i]))
-				rcd_max_overlap_bw += dpu_bts_get_rt_bw(decon, &win_config[i]);
-		}
-
-		DPU_DEBUG_BTS("  Overlap BW%d = %u\n", i, overlap_bw);
-		win_max_overlap_bw = max(win_max_overlap_bw, overlap_bw);
-	}
-
-	if (rcd_config->state == DPU_WIN_STATE_BUFFER)
-		rcd_max_overlap_bw += dpu_bts_get_rt_bw(decon, rcd_config);
-
-	decon->bts.rt_avg_bw = max(win_max_overlap_bw, rcd_max_overlap_bw);
-}
+	struct dpu_bts_layer layers[MAX_WIN_PER_DECON + 1];
+	u32 layer_cnt = 0;
+	int i;
 
-static void dpu_bts_update_disp_ch_bw(struct decon_device *decon,
-				       const struct dpu_bts_win_config *win_config,
-				       const struct dpu_bts_win_config *rcd_config)
-{
-	int i, j;
-	u32 disp_ch_bw[MAX_AXI_PORT];
-	u32 rcd_overlap_ch_bw = 0;
+	BUILD_BUG_ON(ARRAY_SIZE(layers) > DPU_BTS_MAX_LAYERS);
+	BUILD_BUG_ON(MAX_AXI_PORT > DPU_BTS_MAX_AXI_PORT);
 
-	/* DPU AXI bandwidth requirement */
 	/* TODO: take write rt bandwidth into account */
-	memset(disp_ch_bw, 0, sizeof(disp_ch_bw));
 	for (i = 0; i < decon->win_cnt; i++) {
-		u32 dpp_id = win_config[i].dpp_id;
-		u32 ch_num = decon->bts.rt_bw[DPPCH2PLANE(dpp_id)].ch_num;
-		u32 overlap_ch_bw;
-
-		if (win_config[i].state != DPU_WIN_STATE_BUFFER)
-			continue;
-
-		if (ch_num >= MAX_AXI_PORT) {
-			pr_err("invalid DPU AXI channel number %u\n", ch_num);
-			continue;
-		}
-
-		overlap_ch_bw = 0;
-		for (j = 0; j < decon->win_cnt; j++) {
-			int dpp_id = win_config[j].dpp_id;
-
-			if (win_config[j].state != DPU_WIN_STATE_BUFFER)
-				continue;
-
-			if (ch_num == decon->bts.rt_bw[DPPCH2PLANE(dpp_id)].ch_num &&
-				(is_win_half_covered(&win_config[i], &win_config[j])))
-				overlap_ch_bw += dpu_bts_get_rt_bw(decon, &win_config[j]);
-		}
-
-		if (rcd_config->state == DPU_WIN_STATE_BUFFER) {
-			u32 rcd_dpp_id = rcd_config->dpp_id;
-
-			if (ch_num == decon->bts.rt_bw[DPPCH2PLANE(rcd_dpp_id)].ch_num) {
-				if (is_win_half_covered(&win_config[i], rcd_config))
-					overlap_ch_bw += dpu_bts_get_rt_bw(decon, rcd_config);
-
-				if (is_win_half_covered(rcd_config, &win_config[i]))
-					rcd_overlap_ch_bw +=
-						dpu_bts_get_rt_bw(decon, &win_config[i]);
-			}
-		}
-		disp_ch_bw[ch_num] = max(disp_ch_bw[ch_num], overlap_ch_bw);
+		if (dpu_bts_get_layer(decon, &decon->bts.win_config[i], &layers[layer_cnt]))
+			layer_cnt++;
 	}
+	if (dpu_bts_get_layer(decon, &decon->bts.rcd_win_config.win, &layers[layer_cnt]))
+		layer_cnt++;
 
-	if (rcd_config->state == DPU_WIN_STATE_BUFFER) {
-		u32 rcd_dpp_id = rcd_config->dpp_id;
-		u32 rcd_ch_num = decon->bts.rt_bw[DPPCH2PLANE(rcd_dpp_id)].ch_num;
-
-		if (rcd_ch_num >= MAX_AXI_PORT) {
-			pr_err("invalid RCD AXI channel number %u\n", rcd_ch_num);
-		} else {
-			rcd_overlap_ch_bw += dpu_bts_get_rt_bw(decon, rcd_config);
-			disp_ch_bw[rcd_ch_num] = max(disp_ch_bw[rcd_ch_num], rcd_overlap_ch_bw);
-		}
-	}
+	dpu_bts_calc_overlap_bw(layers, layer_cnt, &decon->bts.rt_avg_bw,
+				decon->bts.ch_bw, MAX_AXI_PORT);
 
 	for (i = 0; i < MAX_AXI_PORT; ++i) {
-		decon->bts.ch_bw[i] = disp_ch_bw[i];
 		if (decon->bts.ch_bw[i])
 			DPU_DEBUG_BTS("  AXI_DPU%d = %u\n", i, decon->bts.ch_bw[i]);
 	}
 }
 
-static void dpu_bts_find_max_disp_freq(struct decon_device *decon)
+static void dpu_bts_find_max_disp_freq(struct decon_device *decon,
+				       const struct dpu_bts_params *p, bool layers_changed)
 {
-	int i;
 	u32 max_overlap_bw;
 	u32 max_disp_ch_bw;
-	u32 disp_op_freq = 0;
-	const struct dpu_bts_win_config *win_config = decon->bts.win_config;
-	const struct dpu_bts_win_config *rcd_config = &decon->bts.rcd_win_config.win;
+	u32 disp_op_freq;
 
-	dpu_bts_update_overlap_bw(decon, win_config, rcd_config);
-	dpu_bts_update_disp_ch_bw(decon, win_config, rcd_config);
+	/* overlap of this DECON only depends on its own layers */
+	if (layers_changed)
+		dpu_bts_update_overlap_bw(decon);
 	dpu_bts_sum_all_decon_bw(decon->id, &max_overlap_bw, &max_disp_ch_bw);
 
 	decon->bts.max_disp_freq = max_disp_ch_bw * 100 /
@@ -642,25 +200,8 @@ static void dpu_bts_find_max_disp_freq(struct decon_device *decon)
 	decon->bts.peak = max3(max_disp_ch_bw, max_overlap_bw / NUM_INTERCONNECT_CH,
 				decon->bts.write_bw);
 
-	for (i = 0; i < decon->win_cnt; ++i) {
-		u32 freq;
-
-		if ((win_config[i].state != DPU_WIN_STATE_BUFFER) &&
-				(win_config[i].state != DPU_WIN_STATE_COLOR))
-			continue;
-
-		freq = dpu_bts_calc_aclk_disp(decon, &win_config[i],
-				(u64)decon->bts.resol_clk, decon->bts.max_disp_freq);
-		disp_op_freq = max(disp_op_freq, freq);
-	}
-
-	/*
-	 * At least one window is used for colormap if there is a request of
-	 * disabling all windows. So, disp frequency for a window of LCD full
-	 * size is necessary.
-	 */
-	if (disp_op_freq == 0)
-		disp_op_freq = dpu_bts_calc_disp_with_full_size(decon);
+	disp_op_freq = dpu_bts_calc_disp_op_freq(p, decon->bts.win_config, decon->win_cnt,
+			(u64)decon->bts.resol_clk, decon->bts.max_disp_freq);
 
 	DPU_DEBUG_BTS("  DISP bus freq(%u), operating freq(%u)\n",
 			decon->bts.max_disp_freq, disp_op_freq);
@@ -670,52 +211,6 @@ static void dpu_bts_find_max_disp_freq(struct decon_device *decon)
 	DPU_DEBUG_BTS("  MAX DISP CH FREQ = %u\n", decon->bts.max_disp_freq);
 }
 
-static void
-dpu_bts_calc_dpp_bw(struct bts_dpp_info *dpp, u32 fps, u32 lcd_h, u32 vblank_us, u32 dpp_id,
-		const struct dpu_bts *bts)
-{
-	u32 avg_bw, rt_bw, rot_bw = 0;
-	u32 src_w = dpp->src_w;
-	u32 src_h = dpp->src_h;
-	u32 dst_h = dpp->dst.y2 - dpp->dst.y1;
-	u32 bpp = dpp->bpp;
-
-	/* Bandwidth requirement for layer
-	 * - AVG BW (KB) : sw * sh * fps * (bpp / 8) / 1000
-	 * - RT BW (KB) : AVG_BW * panel_h / dh * 1.1
-	 */
-	avg_bw = src_w * src_h * bpp / 8 * fps / 1000;
-	rt_bw = mult_frac(avg_bw, lcd_h * 11, dst_h * 10);
-
-	if (dpp->rotation) {
-		/* ROT BW(KB) : sh * 32B * (bpp / 8) / v_blank */
-		rot_bw = mult_frac(src_h * ROT_READ_BYTE * bpp / 8,
-				USEC_PER_SEC, vblank_us) / 1000;
-	}
-
-	DPU_DEBUG_BTS("  DPP%d bandwidth: avg %u, rt %u, rot %u\n", dpp_id, avg_bw, rt_bw, rot_bw);
-
-	rt_bw = max(rt_bw, rot_bw);
-	if (dpp->is_afbc) {
-		u32 afbc_util_pct, afbc_rt_util_pct;
-
-		if (dpp->is_yuv) {
-			afbc_util_pct = bts->afbc_yuv_util_pct;
-			afbc_rt_util_pct = bts->afbc_yuv_rt_util_pct;
-		} else {
-			afbc_util_pct = bts->afbc_rgb_util_pct;
-			afbc_rt_util_pct = bts->afbc_rgb_rt_util_pct;
-		}
-
-		avg_bw = mult_frac(avg_bw, afbc_util_pct, 100);
-		rt_bw = mult_frac(rt_bw, afbc_rt_util_pct, 100);
-	}
-
-	dpp->bw = avg_bw;
-	dpp->rt_bw = rt_bw;
-	DPU_DEBUG_BTS("           final: avg %u, rt %u\n", dpp->bw, dpp->rt_bw);
-}
-
 static void dpu_bts_convert_config_to_info(struct bts_dpp_info *dpp,
 				const struct dpu_bts_win_config *config)
 {
@@ -740,56 +235,75 @@ static void dpu_bts_convert_config_to_info(struct bts_dpp_info *dpp,
 			dpp->dst.x1, dpp->dst.x2, dpp->dst.y1, dpp->dst.y2);
 }
 
+static void dpu_bts_update_dpp_bw(struct bts_dpp_info *dpp,
+				  const struct dpu_bts_win_config *config,
+				  const struct dpu_bts_params *params, u32 vblank_us)
+{
+	if (config->state != DPU_WIN_STATE_BUFFER) {
+		memset(dpp, 0, sizeof(*dpp));
+		return;
+	}
+
+	dpu_bts_convert_config_to_info(dpp, config);
+	dpu_bts_calc_dpp_bw(dpp, params, vblank_us, config->dpp_id);
+}
+
 static void dpu_bts_calc_bw(struct decon_device *decon)
 {
 	struct dpu_bts_win_config *config;
 	struct bts_decon_info bts_info;
+	struct dpu_bts_params params;
 	int idx, i, wb_idx = -1, rcd_idx = -1;
 	u32 read_bw = 0, write_bw;
 	u64 resol_clock;
 	u32 vblank_us;
+	unsigned long dirty;
 
 	if (!decon->bts.enabled)
 		return;
 
 	DPU_DEBUG_BTS("%s + : DECON%u\n", __func__, decon->id);
 
+	dirty = decon->bts.dirty;
+	decon->bts.dirty = 0;
+
 	memset(&bts_info, 0, sizeof(struct bts_decon_info));
+	dpu_bts_get_params(decon, &params);
 
-	resol_clock = dpu_bts_get_resol_clock(decon->config.image_width,
-				decon->config.image_height, decon->bts.fps);
+	resol_clock = dpu_bts_calc_resol_clock(params.lcd_w, params.lcd_h, params.fps);
 	decon->bts.resol_clk = (u32)resol_clock;
-	DPU_DEBUG_BTS("[Run: D%u] resol clock = %u Khz @%u fps\n",
-		decon->id, decon->bts.resol_clk, decon->bts.fps);
+	DPU_DEBUG_BTS("[Run: D%u] resol clock = %u Khz @%u fps, dirty(%#lx)\n",
+		decon->id, decon->bts.resol_clk, decon->bts.fps, dirty);
 
 	bts_info.vclk = decon->bts.resol_clk;
 	bts_info.lcd_w = decon->config.image_width;
 	bts_info.lcd_h = decon->config.image_height;
-	vblank_us = dpu_bts_get_vblank_time_ns(decon) / 1000U;
+	vblank_us = dpu_bts_calc_vblank_time_ns(&params) / 1000U;
 	/* reflect bus_util_pct for dpu processing latency when rotation */
 	vblank_us = (vblank_us * decon->bts.rot_util_pct) / 100;
 
 	/* read bw calculation */
 	config = decon->bts.win_config;
 	for (i = 0; i < decon->win_cnt; ++i) {
+		if (test_bit(i, &dirty))
+			dpu_bts_update_dpp_bw(&decon->bts.win_info[i], &config[i], &params,
+					vblank_us);
+
 		if (config[i].state != DPU_WIN_STATE_BUFFER)
 			continue;
 
 		idx = DPPCH2PLANE(config[i].dpp_id);
-		dpu_bts_convert_config_to_info(&bts_info.rdma[idx], &config[i]);
-		dpu_bts_calc_dpp_bw(&bts_info.rdma[idx], decon->bts.fps,
-				decon->config.image_height, vblank_us,
-				config[i].dpp_id, &decon->bts);
+		bts_info.rdma[idx] = decon->bts.win_info[i];
 		read_bw += bts_info.rdma[idx].bw;
 	}
 
 	/* write bw calculation */
 	config = &decon->bts.wb_config;
+	if (test_bit(DPU_BTS_DIRTY_WB, &dirty))
+		dpu_bts_update_dpp_bw(&decon->bts.wb_info, config, &params, vblank_us);
 	if (config->state == DPU_WIN_STATE_BUFFER) {
 		wb_idx = DPPCH2PLANE(config->dpp_id);
-		dpu_bts_convert_config_to_info(&bts_info.odma, config);
-		dpu_bts_calc_dpp_bw(&bts_info.odma, decon->bts.fps, bts_info.lcd_h,
-				vblank_us, config->dpp_id, &decon->bts);
+		bts_info.odma = decon->bts.wb_info;
 		write_bw = bts_info.odma.bw;
 	} else {
 		wb_idx = -1;
@@ -798,11 +312,11 @@ static void dpu_bts_calc_bw(struct decon_device *decon)
 
 	/* rcd bw calculation */
 	config = &decon->bts.rcd_win_config.win;
+	if (test_bit(DPU_BTS_DIRTY_RCD, &dirty))
+		dpu_bts_update_dpp_bw(&decon->bts.rcd_info, config, &params, vblank_us);
 	if (config->state == DPU_WIN_STATE_BUFFER) {
 		rcd_idx = DPPCH2PLANE(config->dpp_id);
-		dpu_bts_convert_config_to_info(&bts_info.rcddma, config);
-		dpu_bts_calc_dpp_bw(&bts_info.rcddma, decon->bts.fps, bts_info.lcd_h,
-				vblank_us, config->dpp_id, &decon->bts);
+		bts_info.rcddma = decon->bts.rcd_info;
 		read_bw += bts_info.rcddma.bw;
 	} else {
 		rcd_idx = -1;
@@ -829,12 +343,12 @@ static void dpu_bts_calc_bw(struct decon_device *decon)
 			decon->bts.write_bw);
 
 	if (decon->bts.total_bw) {
-		dpu_bts_find_max_disp_freq(decon);
+		dpu_bts_find_max_disp_freq(decon, &params, dirty != 0);
 	} else {
 		/* no bw requirement */
 		decon->bts.peak = 0;
 		decon->bts.rt_avg_bw = 0;
-		decon->bts.max_disp_freq = dpu_bts_calc_disp_with_full_size(decon);
+		decon->bts.max_disp_freq = dpu_bts_get_disp_with_full_size(decon, &params);
 	}
 
 	DPU_EVENT_LOG(DPU_EVT_BTS_CALC_BW, decon->id, NULL);
@@ -866,9 +380,134 @@ static inline void dpu_bts_update_disp(struct decon_device *decon, u32 disp_freq
 	DPU_ATRACE_END("dpu_bts_update_disp");
 }
 
+static u32 dpu_bts_get_layer_signature(const struct decon_device *decon)
+{
+	u32 sig;
+
+	sig = jhash(decon->bts.win_config, sizeof(decon->bts.win_config), decon->bts.fps);
+	sig = jhash(&decon->bts.wb_config, sizeof(decon->bts.wb_config), sig);
+
+	return jhash(&decon->bts.rcd_win_config.win, sizeof(decon->bts.rcd_win_config.win),
+			sig);
+}
+
+/* true if every vote of @a is at least as high as the one of @b */
+static bool dpu_bts_vote_covers(const struct dpu_bts_vote *a, const struct dpu_bts_vote *b)
+{
+	return a->bw.peak >= b->bw.peak && a->bw.rt >= b->bw.rt &&
+		a->bw.read >= b->bw.read && a->bw.write >= b->bw.write &&
+		a->disp_freq >= b->disp_freq;
+}
+
+/* the signature isn't compared, votes of different layer patterns may be the same */
+static bool dpu_bts_vote_equal(const struct dpu_bts_vote *a, const struct dpu_bts_vote *b)
+{
+	return dpu_bts_vote_covers(a, b) && dpu_bts_vote_covers(b, a);
+}
+
+static void dpu_bts_vote_max(struct dpu_bts_vote *vote, const struct dpu_bts_vote *other)
+{
+	vote->bw.peak = max(vote->bw.peak, other->bw.peak);
+	vote->bw.rt = max(vote->bw.rt, other->bw.rt);
+	vote->bw.read = max(vote->bw.read, other->bw.read);
+	vote->bw.write = max(vote->bw.write, other->bw.write);
+	vote->disp_freq = max(vote->disp_freq, other->disp_freq);
+}
+
+static void dpu_bts_prefetch_reset(struct dpu_bts_prefetch *pf)
+{
+	pf->hist_idx = 0;
+	pf->hist_cnt = 0;
+	pf->low_frames = 0;
+	pf->predicted = false;
+}
+
+/*
+ * Scores the prediction made for this frame, records the demand of this frame
+ * and votes for the max of it and the demand which followed the same layer
+ * pattern last time. The vote is only logged if it changed or replays the
+ * demand of an earlier frame, a steady screen doesn't fill the event log.
+ */
+static void dpu_bts_prefetch_update(struct decon_device *decon, const struct bts_bw *bw,
+				    u32 disp_freq)
+{
+	struct dpu_bts_prefetch *pf = &decon->bts.prefetch;
+	const struct dpu_bts_vote cur = {
+		.sig = dpu_bts_get_layer_signature(decon),
+		.bw = *bw,
+		.disp_freq = disp_freq,
+	};
+	const struct dpu_bts_vote prev = pf->vote;
+	const bool first = !pf->hist_cnt;
+	const struct dpu_bts_vote *next = NULL;
+	u32 i;
+
+	if (pf->predicted) {
+		if (!dpu_bts_vote_covers(&pf->vote, &cur)) {
+			pf->miss_cnt++;
+		} else {
+			pf->hit_cnt++;
+			if (!dpu_bts_vote_covers(&cur, &pf->next))
+				pf->over_cnt++;
+		}
+	}
+
+	for (i = 1; i <= pf->hist_cnt; i++) {
+		const u32 idx = (pf->hist_idx + DPU_BTS_HIST_LEN - i) % DPU_BTS_HIST_LEN;
+
+		if (pf->hist[idx].sig != cur.sig)
+			continue;
+
+		next = (i == 1) ? &cur : &pf->hist[(idx + 1) % DPU_BTS_HIST_LEN];
+		break;
+	}
+
+	pf->hist[pf->hist_idx] = cur;
+	pf->hist_idx = (pf->hist_idx + 1) % DPU_BTS_HIST_LEN;
+	if (pf->hist_cnt < DPU_BTS_HIST_LEN)
+		pf->hist_cnt++;
+
+	pf->vote = cur;
+	pf->predicted = next != NULL;
+	if (pf->predicted) {
+		pf->next = *next;
+		dpu_bts_vote_max(&pf->vote, next);
+	}
+
+	/* next is cur if the layer pattern didn't change since the last frame */
+	if (first || (next && next != &cur) || !dpu_bts_vote_equal(&prev, &pf->vote))
+		DPU_EVENT_LOG(DPU_EVT_BTS_PREFETCH, decon->id, NULL);
+}
+
+/*
+ * Returns true if lowering the votes must wait for more frames of lower
+ * demand. Votes raised in this frame are still accounted as applied.
+ */
+static bool dpu_bts_prefetch_hold(struct decon_device *decon, const struct bts_bw *bw,
+				  u32 disp_freq, u32 idle_frames)
+{
+	struct dpu_bts_prefetch *pf = &decon->bts.prefetch;
+
+	if (++pf->low_frames >= idle_frames) {
+		pf->low_frames = 0;
+		return false;
+	}
+
+	decon->bts.prev_total_bw = max(decon->bts.prev_total_bw, bw->read + bw->write);
+	decon->bts.prev_peak = max(decon->bts.prev_peak, bw->peak);
+	decon->bts.prev_rt_avg_bw = max(decon->bts.prev_rt_avg_bw, bw->rt);
+	decon->bts.prev_max_disp_freq = max(decon->bts.prev_max_disp_freq, disp_freq);
+
+	return true;
+}
+
 static void dpu_bts_update_resources(struct decon_device *decon, bool shadow_updated)
 {
+	struct dpu_bts_prefetch *pf = &decon->bts.prefetch;
+	const u32 idle_frames = READ_ONCE(pf->idle_frames);
 	struct bts_bw bw = { 0 };
+	u32 total_bw, disp_freq;
+	bool wb_limited;
 
 	DPU_DEBUG_BTS("%s +\n", __func__);
 
@@ -888,35 +527,65 @@ static void dpu_bts_update_resources(struct decon_device *decon, bool shadow_upd
 	 * We can limit max_disp_freq to avoid it when concurrent writeback is enabled.
 	 * Currently, the issue only occurs when all layers are solid color layers (read = 0).
 	 */
-	if ((decon->bts.max_dfs_lv_for_wb > 0) && (bw.read == 0) && (bw.write > 0)) {
+	wb_limited = (decon->bts.max_dfs_lv_for_wb > 0) && (bw.read == 0) && (bw.write > 0);
+	if (wb_limited) {
 		decon->bts.max_disp_freq =
 			min(decon->bts.max_disp_freq, decon->bts.max_dfs_lv_for_wb);
 	}
+	disp_freq = decon->bts.max_disp_freq;
+
+	/* a replayed frame isn't new demand, it would skew the history */
+	if (idle_frames && !shadow_updated && !pf->replay)
+		dpu_bts_prefetch_update(decon, &bw, disp_freq);
+	else if (!idle_frames && pf->hist_cnt)
+		dpu_bts_prefetch_reset(pf);
+
+	/* history is empty until the first commit after prefetch is enabled */
+	if (idle_frames && pf->hist_cnt) {
+		bw = pf->vote.bw;
+		disp_freq = pf->vote.disp_freq;
+		/* the predicted frames may read, this one still has to be limited */
+		if (wb_limited)
+			disp_freq = min(disp_freq, decon->bts.max_dfs_lv_for_wb);
+	}
+	total_bw = bw.read + bw.write;
 
 	if (shadow_updated) {
 		/* after DECON h/w configs are updated to shadow SFR */
-		if (decon->bts.total_bw < decon->bts.prev_total_bw ||
-				decon->bts.peak < decon->bts.prev_peak ||
-				decon->bts.rt_avg_bw < decon->bts.prev_rt_avg_bw)
+		const bool lower = total_bw < decon->bts.prev_total_bw ||
+				bw.peak < decon->bts.prev_peak ||
+				bw.rt < decon->bts.prev_rt_avg_bw ||
+				disp_freq < decon->bts.prev_max_disp_freq;
+
+		if (!lower)
+			pf->low_frames = 0;
+		else if (idle_frames && dpu_bts_prefetch_hold(decon, &bw, disp_freq,
+							      idle_frames))
+			goto out;
+
+		if (total_bw < decon->bts.prev_total_bw ||
+				bw.peak < decon->bts.prev_peak ||
+				bw.rt < decon->bts.prev_rt_avg_bw)
 			dpu_bts_update_bw(decon, bw);
 
-		if (decon->bts.max_disp_freq < decon->bts.prev_max_disp_freq)
-			dpu_bts_update_disp(decon, decon->bts.max_disp_freq);
+		if (disp_freq < decon->bts.prev_max_disp_freq)
+			dpu_bts_update_disp(decon, disp_freq);
 
-		decon->bts.prev_total_bw = decon->bts.total_bw;
-		decon->bts.prev_peak = decon->bts.peak;
-		decon->bts.prev_rt_avg_bw = decon->bts.rt_avg_bw;
-		decon->bts.prev_max_disp_freq = decon->bts.max_disp_freq;
+		decon->bts.prev_total_bw = total_bw;
+		decon->bts.prev_peak = bw.peak;
+		decon->bts.prev_rt_avg_bw = bw.rt;
+		decon->bts.prev_max_disp_freq = disp_freq;
 	} else {
-		if (decon->bts.total_bw > decon->bts.prev_total_bw ||
-				decon->bts.peak > decon->bts.prev_peak ||
-				decon->bts.rt_avg_bw > decon->bts.prev_rt_avg_bw)
+		if (total_bw > decon->bts.prev_total_bw ||
+				bw.peak > decon->bts.prev_peak ||
+				bw.rt > decon->bts.prev_rt_avg_bw)
 			dpu_bts_update_bw(decon, bw);
 
-		if (decon->bts.max_disp_freq > decon->bts.prev_max_disp_freq)
-			dpu_bts_update_disp(decon, decon->bts.max_disp_freq);
+		if (disp_freq > decon->bts.prev_max_disp_freq)
+			dpu_bts_update_disp(decon, disp_freq);
 	}
 
+out:
 	DPU_EVENT_LOG(DPU_EVT_BTS_UPDATE_BW, decon->id, NULL);
 
 	DPU_DEBUG_BTS("%s -\n", __func__);
@@ -941,6 +610,8 @@ static void dpu_bts_release_resources(struct decon_device *decon)
 	// clear shared decon resources
 	decon->bts.rt_avg_bw = 0;
 	memset(decon->bts.ch_bw, 0, sizeof(decon->bts.ch_bw));
+	decon->bts.dirty = DPU_BTS_DIRTY_ALL;
+	dpu_bts_prefetch_reset(&decon->bts.prefetch);
 
 	DPU_EVENT_LOG(DPU_EVT_BTS_RELEASE_BW, decon->id, NULL);
 	DPU_DEBUG_BTS("%s -\n", __func__);
@@ -975,6 +646,7 @@ static void dpu_bts_init(struct decon_device *decon)
 	decon->bts.rt_avg_bw = 0;
 	for (i = 0; i < MAX_AXI_PORT; i++)
 		decon->bts.ch_bw[i] = 0;
+	decon->bts.dirty = DPU_BTS_DIRTY_ALL;
 
 	DPU_DEBUG_BTS("BTS_BW_TYPE(%d)\n", decon->bts.bw_idx);
 	exynos_pm_qos_add_request(&decon->bts.mif_qos,
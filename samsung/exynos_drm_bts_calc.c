@@ -0,0 +1,572 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Copyright (c) 2016 Samsung Electronics Co., Ltd.
+ *		http://www.samsung.com
+ *
+ * Bandwidth and clock model for Samsung EXYNOS DPU BTS
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include "exynos_drm_bts_calc.h"
+
+#define ROT_READ_BYTE		(32) /* unit : BYTE(= pixel, based on NV12) */
+
+#define ACLK_100MHZ_PERIOD	10000UL
+#define FRAME_TIME_NSEC		1000000000UL	/* 1sec */
+
+/*
+ * 1. function clock
+ *    panel_clk = panel_w * panel_h * fps * margin / ppc
+ *    vertical scale-down case (src_h > dst_h)
+ *     clk[i] = (line_a * ratio_a + line_b * (1 - ratio_a)) *
+ *                  panel_h * fps * margin / ppc
+ *        - line_a = max((ratio_v - 2) * src_w + max(src_w, dst_w), panel_w + diff_w)
+ *        - line_b = max((ratio_v - 1) * src_w + max(src_w, dst_w), panel_w + diff_w)
+ *        - ratio_v = ceiling(src_h / dst_h)
+ *        - ratio_a = ratio_v - (src_h / dst_h)
+ *        - diff_w = (src_w <= dst_w) ? 0 : src_w - dst_w
+ *    non-vertical scale-down case
+ *     clk[i] = ((panel_w + diff_w) * ratio_v + panel_w * (1 - ratio_v)) *
+ *                  panel_h * fps * margin / ppc
+ *        - ratio_v = (src_h >= dst_h) ? 1 : src_h / dst_h
+ *        - diff_w = (src_w <= dst_w) ? 0 : src_w - dst_w
+ *    margin = 1.1 + HW bubble cycles
+ *    aclk1 = max(panel_clk, clk[i])
+ * 2. AXI throughput clock
+ *    1) fps based
+ *       clk_bw[i] = src_w * src_h * fps * (bpp / 8) * (panel_h / dst_h) * 1.1
+ *                       / (bus_width * bus_util_pct)
+ *    2) rotation throughput for initial latency
+ *       clk_r[i] = src_h * 32 * (bpp / 8) / (bus_width * rot_util_pct) / (v_blank)
+ *       # v_blank : command - TE_hi_pulse
+ *                   video - (vbp) @initial-frame, (vbp+vfp) @inter-frame
+ *    if (clk_bw[i] < clk_r[i])
+ *       clk_bw[i] = clk_r[i]
+ *    aclk2 = max(clk for sum(same axi overlap bw[i]))
+ *
+ * => aclk_dpu = max(aclk1, aclk2)
+ */
+
+/* unit : usec x 1000 -> 5592 (5.592us) for WQHD+ case */
+static inline u32 dpu_bts_get_one_line_time(u32 lcd_height, u32 vbp, u32 vfp,
+		u32 vsa, u32 fps)
+{
+	u32 tot_v;
+	int tmp;
+
+	tot_v = lcd_height + vfp + vsa + vbp;
+	tmp = DIV_ROUND_UP(FRAME_TIME_NSEC, fps);
+
+	return (tmp / tot_v);
+}
+
+/* framebuffer compressor(AFBC, SBWC) line delay is usually 4 */
+static inline u32 dpu_bts_comp_latency(u32 src_w, u32 ppc, u32 line_delay)
+{
+	return mult_frac(src_w, line_delay, ppc);
+}
+
+/* scaler line delay is usually 3
+ * scaling order : horizontal -> vertical scale
+ * -> need to reflect scale-ratio
+ */
+static inline u32 dpu_bts_scale_latency(u32 src_w, u32 dst_w, u32 ppc,
+				u32 line_delay)
+{
+	if (src_w > dst_w)
+		return mult_frac(src_w * line_delay, src_w, dst_w * ppc);
+	else
+		return DIV_ROUND_CLOSEST(src_w * line_delay, ppc);
+}
+
+/* rotator ppc is usually 4 or 8
+ * 1-read : 32BYTE (pixel)
+ */
+static inline u32 dpu_bts_rotate_latency(u32 src_w, u32 r_ppc)
+{
+	return (src_w * (ROT_READ_BYTE / r_ppc));
+}
+
+/*
+ * [DSC]
+ * Line memory is necessary like following.
+ *  1EA(1ppc) : 2-line for 2-slice, 1-line for 1-slice
+ *  2EA(2ppc) : 3.5-line for 4-slice (DSCC 0.5-line + DSC 3-line)
+ *        2.5-line for 2-slice (DSCC 0.5-line + DSC 2-line)
+ *
+ * [DECON] none
+ * When 1H is filled at OUT_FIFO, it immediately transfers to DSIM.
+ */
+static inline u32 dpu_bts_dsc_latency(u32 slice_num, u32 dsc_cnt,
+		u32 dst_w, u32 ppc)
+{
+	u32 lat_dsc = dst_w;
+
+	switch (slice_num) {
+	case 1:
+		/* DSC: 1EA */
+		lat_dsc = dst_w * 1;
+		break;
+	case 2:
+		if (dsc_cnt == 1)
+			lat_dsc = dst_w * 2;
+		else
+			lat_dsc = (dst_w * 25) / (10 * ppc);
+		break;
+	case 4:
+		/* DSC: 2EA */
+		lat_dsc = (dst_w * 35) / (10 * ppc);
+		break;
+	default:
+		break;
+	}
+
+	return lat_dsc;
+}
+
+/*
+ * unit : nsec x 1000
+ * reference aclk : 100MHz (-> 10ns x 1000)
+ * # cycles = usec * aclk_mhz
+ */
+static inline u32 dpu_bts_convert_aclk_to_ns(u32 aclk_mhz)
+{
+	return ((ACLK_100MHZ_PERIOD * 100) / aclk_mhz);
+}
+
+/*
+ * return : kHz value based on 1-pixel processing pipe-line
+ */
+u64 dpu_bts_calc_resol_clock(u32 xres, u32 yres, u32 fps)
+{
+	u64 margin;
+	u64 resol_khz;
+
+	/*
+	 * aclk_khz = vclk_1pix * ( 1.1 + (48+20)/WIDTH ) : x1000
+	 * @ (1.1)   : BUS Latency Considerable Margin (10%)
+	 * @ (48+20) : HW bubble cycles
+	 *      - 48 : 12 cycles per slice, total 4 slice
+	 *      - 20 : hblank cycles for other HW module
+	 */
+	margin = 1100 + ((48000 + 20000) / xres);
+	/* convert to kHz unit */
+	resol_khz = (xres * yres * fps * margin / 1000) / 1000;
+
+	return resol_khz;
+}
+
+u32 dpu_bts_calc_vblank_time_ns(const struct dpu_bts_params *p)
+{
+	u32 line_t_ns, v_blank_t_ns;
+
+	line_t_ns = dpu_bts_get_one_line_time(p->lcd_h, p->vbp, p->vfp, p->vsa, p->fps);
+	if (p->video_mode)
+		v_blank_t_ns = (p->vbp + p->vfp) * line_t_ns;
+	else
+		v_blank_t_ns = p->vblank_usec * 1000U;
+
+	DPU_DEBUG_BTS("  -line_t_ns(%u) v_blank_t_ns(%u)\n",
+			line_t_ns, v_blank_t_ns);
+
+	return v_blank_t_ns;
+}
+
+static u32 dpu_bts_find_nearest_high_freq(const struct dpu_bts_params *p, u32 aclk_base)
+{
+	int i;
+
+	if (aclk_base > p->dfs_lv_khz[0]) {
+		DPU_DEBUG_BTS("  aclk_base is greater than L0 frequency!");
+		i = 0;
+	} else {
+		/* search from low frequency level */
+		for (i = (p->dfs_lv_cnt - 1); i >= 0; i--) {
+			if (aclk_base <= p->dfs_lv_khz[i])
+				break;
+		}
+	}
+	DPU_DEBUG_BTS("  Nearest DFS: %u KHz @L%d\n", p->dfs_lv_khz[i], i);
+
+	return i;
+}
+
+/*
+ * [caution] src_w/h is rotated size info
+ * - src_w : src_h @original input image
+ * - src_h : src_w @original input image
+ */
+static u64 dpu_bts_calc_rotate_aclk(const struct dpu_bts_params *p, u32 aclk_base,
+		u32 ppc, u32 src_w, u32 dst_w,
+		bool is_comp, bool is_downscale, bool is_dsc)
+{
+	u32 dfs_idx = 0;
+	u32 dpu_cycle, basic_cycle, dsi_cycle, module_cycle = 0;
+	u32 comp_cycle = 0, rot_cycle = 0, scale_cycle = 0, dsc_cycle = 0;
+	u32 rot_init_bw = 0; /* KB/s */
+	u64 rot_clk, rot_need_clk;
+	u32 aclk_x_1k_ns, dpu_lat_t_ns, max_lat_t_ns, tx_allow_t_ns;
+	u32 bus_perf;
+	u32 temp_clk;
+	bool retry_flag = false;
+
+	DPU_DEBUG_BTS("[ROT+] BEFORE latency check: %u KHz\n", aclk_base);
+
+	dfs_idx = dpu_bts_find_nearest_high_freq(p, aclk_base);
+	rot_clk = p->dfs_lv_khz[dfs_idx];
+
+	/* post DECON OUTFIFO based on 1H transfer */
+	dsi_cycle = p->lcd_w;
+
+	/* get additional pipeline latency */
+	if (is_comp) {
+		comp_cycle = dpu_bts_comp_latency(src_w, ppc, p->delay_comp);
+		DPU_DEBUG_BTS("  COMP: lat_cycle(%u)\n", comp_cycle);
+		module_cycle += comp_cycle;
+	} else {
+		rot_cycle = dpu_bts_rotate_latency(src_w, p->ppc_rotator);
+		DPU_DEBUG_BTS("  ROT: lat_cycle(%u)\n", rot_cycle);
+		module_cycle += rot_cycle;
+	}
+	if (is_downscale) {
+		scale_cycle = dpu_bts_scale_latency(src_w, dst_w, p->ppc_scaler,
+				p->delay_scaler);
+		DPU_DEBUG_BTS("  SCALE: lat_cycle(%u)\n", scale_cycle);
+		module_cycle += scale_cycle;
+	}
+	if (is_dsc) {
+		dsc_cycle = dpu_bts_dsc_latency(p->dsc_slice_count, p->dsc_count, dst_w, ppc);
+		DPU_DEBUG_BTS("  DSC: lat_cycle(%u)\n", dsc_cycle);
+		module_cycle += dsc_cycle;
+		dsi_cycle = (dsi_cycle + 2) / 3;
+	}
+
+	/*
+	 * basic cycle(+ bubble: 10%) + additional cycle based on function
+	 * cycle count increases when ACLK goes up due to other conditions
+	 * At latency monitor experiment using unit test,
+	 *  cycles at 400Mhz were increased by about 800 compared to 200Mhz.
+	 * Here, (aclk_mhz * 2) cycles are reflected referring to the result
+	 *  because the exact value is unknown.
+	 */
+	basic_cycle = (p->lcd_w * 11 / 10 + dsi_cycle) / ppc;
+
+retry_hi_freq:
+	dpu_cycle = (basic_cycle + module_cycle) + rot_clk * 2 / 1000U;
+	aclk_x_1k_ns = dpu_bts_convert_aclk_to_ns(rot_clk / 1000U);
+	dpu_lat_t_ns = mult_frac(aclk_x_1k_ns, dpu_cycle, 1000);
+	max_lat_t_ns = dpu_bts_calc_vblank_time_ns(p);
+	if (max_lat_t_ns > dpu_lat_t_ns) {
+		tx_allow_t_ns = max_lat_t_ns - dpu_lat_t_ns;
+	} else {
+		/* abnormal case : apply bus_util_pct of v_blank */
+		tx_allow_t_ns = (max_lat_t_ns * p->bus_util_pct) / 100;
+		DPU_DEBUG_BTS("  WARN: latency calc is abnormal!(-> %u%%)\n",
+				p->bus_util_pct);
+	}
+
+	bus_perf = p->bus_width * p->rot_util_pct;
+	/* apply as worst(P010: 3) case to simplify */
+	rot_init_bw = mult_frac(NSEC_PER_SEC, src_w * ROT_READ_BYTE * 3, tx_allow_t_ns) / 1000;
+	rot_need_clk = rot_init_bw * 100 / bus_perf;
+
+	if (rot_need_clk > rot_clk) {
+		/* not max level */
+		if (dfs_idx) {
+			/* check if calc_clk is greater than 1-step */
+			dfs_idx--;
+			temp_clk = p->dfs_lv_khz[dfs_idx];
+			if ((rot_need_clk > temp_clk) && (!retry_flag)) {
+				DPU_DEBUG_BTS("  -allow_ns(%u) dpu_ns(%u)\n",
+					tx_allow_t_ns, dpu_lat_t_ns);
+				rot_clk = temp_clk;
+				retry_flag = true;
+				goto retry_hi_freq;
+			}
+		}
+		rot_clk = rot_need_clk;
+	}
+
+	DPU_DEBUG_BTS("  -dpu_cycle(%u) aclk_x_1k_ns(%u) dpu_lat_t_ns(%u)\n",
+			dpu_cycle, aclk_x_1k_ns, dpu_lat_t_ns);
+	DPU_DEBUG_BTS("  -tx_allow_t_ns(%u) rot_init_bw(%u) rot_need_clk(%llu)\n",
+			tx_allow_t_ns, rot_init_bw, rot_need_clk);
+	DPU_DEBUG_BTS("[ROT-] AFTER latency check: %llu KHz\n", rot_clk);
+
+	return rot_clk;
+}
+
+u64 dpu_bts_calc_aclk_disp(const struct dpu_bts_params *p,
+			   const struct dpu_bts_win_config *config, u64 resol_clk,
+			   u32 max_clk)
+{
+	u64 aclk_disp, aclk_base, aclk_panel_khz, aclk_disp_khz;
+	u32 ppc;
+	u32 src_w, src_h;
+	u32 diff_w, ratio_v;
+	u32 is_downscale = false;
+	u32 is_dsc = false;
+	u64 margin;
+
+	if (config->is_rot) {
+		src_w = config->src_h;
+		src_h = config->src_w;
+	} else {
+		src_w = config->src_w;
+		src_h = config->src_h;
+	}
+
+	if (src_w > config->dst_w || src_h > config->dst_h)
+		is_downscale = true;
+
+	/* when calculating aclk for panel, if DSC is enabled, consider DSC encoder
+	 * count as its ppc.
+	 */
+	if (p->dsc_enabled) {
+		ppc = min(p->ppc, p->dsc_count);
+		is_dsc = true;
+	} else {
+		ppc = p->ppc;
+	}
+	aclk_panel_khz = resol_clk / ppc;
+
+	margin = 1100 + ((48000 + 20000) / p->lcd_w);
+	diff_w = (src_w <= config->dst_w) ? 0 : src_w - config->dst_w;
+
+	if (src_h > config->dst_h) {
+		u32 ratio_a, line_a, line_b;
+
+		ratio_v = DIV_ROUND_UP(src_h, config->dst_h);
+		ratio_a = (ratio_v * 1000) - mult_frac(src_h, 1000, config->dst_h);
+		line_a = max((ratio_v - 2) * src_w + max(src_w, config->dst_w),
+				p->lcd_w + diff_w);
+		line_b = max((ratio_v - 1) * src_w + max(src_w, config->dst_w),
+				p->lcd_w + diff_w);
+		aclk_disp = (u64)(line_a * ratio_a + line_b * (1000 - ratio_a));
+	} else {
+		ratio_v = (src_h >= config->dst_h) ? 1000 : mult_frac(src_h, 1000, config->dst_h);
+		aclk_disp = (u64)((p->lcd_w + diff_w) * ratio_v + p->lcd_w * (1000 - ratio_v));
+	}
+	aclk_disp = mult_frac(aclk_disp, p->lcd_h * p->fps, 1000);
+	aclk_disp_khz = (aclk_disp * margin / 1000) / 1000;
+	aclk_disp_khz /= p->ppc;
+
+	if (aclk_disp_khz < aclk_panel_khz)
+		aclk_disp_khz = aclk_panel_khz;
+
+	if (!config->is_rot)
+		return aclk_disp_khz;
+
+	/* rotation case: check if latency conditions are met */
+	if (aclk_disp_khz > max_clk)
+		aclk_base = aclk_disp_khz;
+	else
+		aclk_base = max_clk;
+
+	aclk_disp_khz = dpu_bts_calc_rotate_aclk(p, (u32)aclk_base, ppc,
+			src_w, config->dst_w, config->is_comp, is_downscale, is_dsc);
+
+	return aclk_disp_khz;
+}
+
+u32 dpu_bts_calc_disp_with_full_size(const struct dpu_bts_params *p, u64 resol_clk)
+{
+	struct dpu_bts_win_config config = { 0 };
+
+	config.src_w = config.dst_w = p->lcd_w;
+	config.src_h = config.dst_h = p->lcd_h;
+
+	return dpu_bts_calc_aclk_disp(p, &config, resol_clk, resol_clk);
+}
+
+/*
+ * dpu_bts_calc_disp_op_freq() - operating DISP frequency for a window stack
+ * @bus_freq: DISP frequency required by AXI throughput, used as the base of
+ *            rotation latency check
+ *
+ * Returns the highest function clock required by any window, or the clock
+ * for a full size window if no window is enabled since colormap is used in
+ * that case.
+ */
+u32 dpu_bts_calc_disp_op_freq(const struct dpu_bts_params *p,
+			      const struct dpu_bts_win_config *win_config, u32 win_cnt,
+			      u64 resol_clk, u32 bus_freq)
+{
+	u32 disp_op_freq = 0;
+	u32 i;
+
+	for (i = 0; i < win_cnt; ++i) {
+		u32 freq;
+
+		if ((win_config[i].state != DPU_WIN_STATE_BUFFER) &&
+				(win_config[i].state != DPU_WIN_STATE_COLOR))
+			continue;
+
+		freq = dpu_bts_calc_aclk_disp(p, &win_config[i], resol_clk, bus_freq);
+		disp_op_freq = max(disp_op_freq, freq);
+	}
+
+	/*
+	 * At least one window is used for colormap if there is a request of
+	 * disabling all windows. So, disp frequency for a window of LCD full
+	 * size is necessary.
+	 */
+	if (disp_op_freq == 0)
+		disp_op_freq = dpu_bts_calc_disp_with_full_size(p, resol_clk);
+
+	return disp_op_freq;
+}
+
+/* layer top or bottom line, sorted by line with bottoms first */
+struct dpu_bts_edge {
+	u32 y;
+	bool start;
+	u32 rt_bw;
+	u32 ch_num;
+};
+
+static inline bool dpu_bts_edge_before(const struct dpu_bts_edge *a,
+				       const struct dpu_bts_edge *b)
+{
+	if (a->y != b->y)
+		return a->y < b->y;
+
+	/* layer covers [y1, y2), so it is gone before the next one starts at y2 */
+	return !a->start && b->start;
+}
+
+/* a handful of edges, insertion sort is cheaper than anything else here */
+static void dpu_bts_sort_edges(struct dpu_bts_edge *edges, u32 cnt)
+{
+	u32 i, j;
+
+	for (i = 1; i < cnt; i++) {
+		struct dpu_bts_edge edge = edges[i];
+
+		for (j = i; j > 0 && dpu_bts_edge_before(&edge, &edges[j - 1]); j--)
+			edges[j] = edges[j - 1];
+		edges[j] = edge;
+	}
+}
+
+/*
+ * dpu_bts_calc_overlap_bw() - peak real-time read bandwidth of a layer stack
+ * @layers: layers fetched by this DECON, including RCD
+ * @max_overlap_bw: highest sum of rt bandwidth of layers fetched at the same line
+ * @ch_bw: same as @max_overlap_bw per AXI port, indexed by dpu_bts_layer.ch_num
+ *
+ * Sweeps the sorted top and bottom lines of all layers while keeping the sum
+ * of bandwidth of the layers covering the current line, which gives the exact
+ * peak in O(n log n) instead of checking every pair of layers.
+ */
+void dpu_bts_calc_overlap_bw(const struct dpu_bts_layer *layers, u32 layer_cnt,
+			     u32 *max_overlap_bw, u32 *ch_bw, u32 ch_cnt)
+{
+	struct dpu_bts_edge edges[DPU_BTS_MAX_LAYERS * 2];
+	u32 cur_ch_bw[DPU_BTS_MAX_AXI_PORT] = { 0 };
+	u32 cur_bw = 0, edge_cnt = 0;
+	u32 i;
+
+	*max_overlap_bw = 0;
+	for (i = 0; i < ch_cnt; ++i)
+		ch_bw[i] = 0;
+
+	if (layer_cnt > DPU_BTS_MAX_LAYERS) {
+		DPU_ERR_BTS("too many layers %u, only %u are counted\n", layer_cnt,
+				DPU_BTS_MAX_LAYERS);
+		layer_cnt = DPU_BTS_MAX_LAYERS;
+	}
+	if (ch_cnt > DPU_BTS_MAX_AXI_PORT)
+		ch_cnt = DPU_BTS_MAX_AXI_PORT;
+
+	for (i = 0; i < layer_cnt; i++) {
+		const struct dpu_bts_layer *layer = &layers[i];
+
+		if (layer->ch_num >= ch_cnt)
+			DPU_ERR_BTS("invalid DPU AXI channel number %u\n", layer->ch_num);
+
+		if (layer->y2 <= layer->y1)
+			continue;
+
+		edges[edge_cnt++] = (struct dpu_bts_edge) {
+			.y = layer->y1, .start = true,
+			.rt_bw = layer->rt_bw, .ch_num = layer->ch_num,
+		};
+		edges[edge_cnt++] = (struct dpu_bts_edge) {
+			.y = layer->y2, .start = false,
+			.rt_bw = layer->rt_bw, .ch_num = layer->ch_num,
+		};
+	}
+
+	dpu_bts_sort_edges(edges, edge_cnt);
+
+	for (i = 0; i < edge_cnt; i++) {
+		const struct dpu_bts_edge *edge = &edges[i];
+		const bool valid_ch = edge->ch_num < ch_cnt;
+
+		if (!edge->start) {
+			cur_bw -= edge->rt_bw;
+			if (valid_ch)
+				cur_ch_bw[edge->ch_num] -= edge->rt_bw;
+			continue;
+		}
+
+		/* sums only grow until the next bottom, so check peak on tops */
+		cur_bw += edge->rt_bw;
+		*max_overlap_bw = max(*max_overlap_bw, cur_bw);
+		if (valid_ch) {
+			cur_ch_bw[edge->ch_num] += edge->rt_bw;
+			ch_bw[edge->ch_num] = max(ch_bw[edge->ch_num],
+						  cur_ch_bw[edge->ch_num]);
+		}
+		DPU_DEBUG_BTS("  Overlap BW @line %u = %u\n", edge->y, cur_bw);
+	}
+}
+
+void dpu_bts_calc_dpp_bw(struct bts_dpp_info *dpp, const struct dpu_bts_params *p,
+			 u32 vblank_us, u32 dpp_id)
+{
+	u32 avg_bw, rt_bw, rot_bw = 0;
+	u32 src_w = dpp->src_w;
+	u32 src_h = dpp->src_h;
+	u32 dst_h = dpp->dst.y2 - dpp->dst.y1;
+	u32 bpp = dpp->bpp;
+
+	/* Bandwidth requirement for layer
+	 * - AVG BW (KB) : sw * sh * fps * (bpp / 8) / 1000
+	 * - RT BW (KB) : AVG_BW * panel_h / dh * 1.1
+	 */
+	avg_bw = src_w * src_h * bpp / 8 * p->fps / 1000;
+	rt_bw = mult_frac(avg_bw, p->lcd_h * 11, dst_h * 10);
+
+	if (dpp->rotation) {
+		/* ROT BW(KB) : sh * 32B * (bpp / 8) / v_blank */
+		rot_bw = mult_frac(src_h * ROT_READ_BYTE * bpp / 8,
+				USEC_PER_SEC, vblank_us) / 1000;
+	}
+
+	DPU_DEBUG_BTS("  DPP%d bandwidth: avg %u, rt %u, rot %u\n", dpp_id, avg_bw, rt_bw, rot_bw);
+
+	rt_bw = max(rt_bw, rot_bw);
+	if (dpp->is_afbc) {
+		u32 afbc_util_pct, afbc_rt_util_pct;
+
+		if (dpp->is_yuv) {
+			afbc_util_pct = p->afbc_yuv_util_pct;
+			afbc_rt_util_pct = p->afbc_yuv_rt_util_pct;
+		} else {
+			afbc_util_pct = p->afbc_rgb_util_pct;
+			afbc_rt_util_pct = p->afbc_rgb_rt_util_pct;
+		}
+
+		avg_bw = mult_frac(avg_bw, afbc_util_pct, 100);
+		rt_bw = mult_frac(rt_bw, afbc_rt_util_pct, 100);
+	}
+
+	dpp->bw = avg_bw;
+	dpp->rt_bw = rt_bw;
+	DPU_DEBUG_BTS("           final: avg %u, rt %u\n", dpp->bw, dpp->rt_bw);
+}
@@ -0,0 +1,160 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ *
+ * Copyright (c) 2016 Samsung Electronics Co., Ltd.
+ *		http://www.samsung.com
+ *
+ * Header file for DPU bandwidth and clock model.
+ *
+ * The model doesn't access any hardware or driver state, all inputs are
+ * passed explicitly. It can be built outside of the kernel as well, in
+ * that case the few kernel helpers it depends on are provided below.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef __EXYNOS_DRM_BTS_CALC_H__
+#define __EXYNOS_DRM_BTS_CALC_H__
+
+#ifdef __KERNEL__
+#include <linux/kernel.h>
+#include <linux/types.h>
+#else
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+typedef uint32_t u32;
+typedef unsigned long long u64;
+
+#define NSEC_PER_SEC		1000000000L
+#define USEC_PER_SEC		1000000L
+
+#define DIV_ROUND_UP(n, d)	(((n) + (d) - 1) / (d))
+#define DIV_ROUND_CLOSEST(x, d)	(((x) + ((d) / 2)) / (d))
+#define mult_frac(x, n, d)						\
+({									\
+	typeof(x) __q = (x) / (d);					\
+	typeof(x) __r = (x) % (d);					\
+	(__q * (n)) + ((__r * (n)) / (d));				\
+})
+#define min(x, y)		((x) < (y) ? (x) : (y))
+#define max(x, y)		((x) > (y) ? (x) : (y))
+#define max3(x, y, z)		max(max(x, y), z)
+
+/* arguments are still checked and used, as with no_printk() */
+#define pr_debug(fmt, ...)	do { if (0) printf(fmt, ##__VA_ARGS__); } while (0)
+#define pr_info(fmt, ...)	printf(fmt, ##__VA_ARGS__)
+#define pr_err(fmt, ...)	fprintf(stderr, fmt, ##__VA_ARGS__)
+#endif
+
+#define DPU_DEBUG_BTS(fmt, args...)	pr_debug("[BTS] "fmt,  ##args)
+#define DPU_INFO_BTS(fmt, args...)	pr_info("[BTS] "fmt,  ##args)
+#define DPU_ERR_BTS(fmt, args...)	pr_err("[BTS] "fmt, ##args)
+
+enum dpu_win_state {
+	DPU_WIN_STATE_DISABLED = 0,
+	DPU_WIN_STATE_COLOR,
+	DPU_WIN_STATE_BUFFER,
+};
+
+struct dpu_bts_win_config {
+	enum dpu_win_state state;
+	u32 src_x;
+	u32 src_y;
+	u32 src_w;
+	u32 src_h;
+	int dst_x;
+	int dst_y;
+	u32 dst_w;
+	u32 dst_h;
+	bool is_rot;
+	bool is_comp;
+	bool is_secure;
+	u32 dpp_id;
+	u32 zpos;
+	u32 format;
+	u64 comp_src;
+};
+
+struct bts_layer_position {
+	u32 x1;
+	u32 x2; /* x2 = x1 + width */
+	u32 y1;
+	u32 y2; /* y2 = y1 + height */
+};
+
+struct bts_dpp_info {
+	u32 bpp;
+	u32 src_h;
+	u32 src_w;
+	struct bts_layer_position dst;
+	u32 bw;
+	u32 rt_bw;
+	bool rotation;
+	bool is_afbc;
+	bool is_yuv;
+};
+
+/* upper bounds of dpu_bts_calc_overlap_bw() inputs */
+#define DPU_BTS_MAX_LAYERS	16
+#define DPU_BTS_MAX_AXI_PORT	4
+
+/* vertical extent and real-time read bandwidth of a layer fetched by a DMA */
+struct dpu_bts_layer {
+	u32 y1;
+	u32 y2;
+	u32 rt_bw;
+	/* AXI port of the DMA */
+	u32 ch_num;
+};
+
+/* display timing and DPU tunables the model depends on */
+struct dpu_bts_params {
+	u32 lcd_w;
+	u32 lcd_h;
+	u32 fps;
+	u32 vbp;
+	u32 vfp;
+	u32 vsa;
+	u32 vblank_usec;
+	bool video_mode;
+
+	bool dsc_enabled;
+	u32 dsc_count;
+	u32 dsc_slice_count;
+
+	u32 ppc;
+	u32 ppc_rotator;
+	u32 ppc_scaler;
+	u32 delay_comp;
+	u32 delay_scaler;
+	u32 bus_width;
+	u32 bus_util_pct;
+	u32 rot_util_pct;
+	u32 afbc_rgb_util_pct;
+	u32 afbc_yuv_util_pct;
+	u32 afbc_rgb_rt_util_pct;
+	u32 afbc_yuv_rt_util_pct;
+
+	/* DISP DVFS levels, sorted from the highest frequency */
+	u32 dfs_lv_cnt;
+	const u32 *dfs_lv_khz;
+};
+
+u64 dpu_bts_calc_resol_clock(u32 xres, u32 yres, u32 fps);
+u32 dpu_bts_calc_vblank_time_ns(const struct dpu_bts_params *p);
+void dpu_bts_calc_dpp_bw(struct bts_dpp_info *dpp, const struct dpu_bts_params *p,
+			 u32 vblank_us, u32 dpp_id);
+u64 dpu_bts_calc_aclk_disp(const struct dpu_bts_params *p,
+			   const struct dpu_bts_win_config *config, u64 resol_clk,
+			   u32 max_clk);
+u32 dpu_bts_calc_disp_with_full_size(const struct dpu_bts_params *p, u64 resol_clk);
+u32 dpu_bts_calc_disp_op_freq(const struct dpu_bts_params *p,
+			      const struct dpu_bts_win_config *win_config, u32 win_cnt,
+			      u64 resol_clk, u32 bus_freq);
+void dpu_bts_calc_overlap_bw(const struct dpu_bts_layer *layers, u32 layer_cnt,
+			     u32 *max_overlap_bw, u32 *ch_bw, u32 ch_cnt);
+
+#endif /* __EXYNOS_DRM_BTS_CALC_H__ */
@@ -14,6 +14,7 @@
 #include <drm/drm_connector.h>
 #include <drm/samsung_drm.h>
 #include <drm/drm_dsc.h>
+#include <drm/drm_mipi_dsi.h>
 
 #define MIN_WIN_BLOCK_WIDTH	8
 #define MIN_WIN_BLOCK_HEIGHT	1
@@ -45,6 +46,42 @@ struct exynos_drm_connector;
 #define EXYNOS_DSI_MSG_FORCE_BATCH BIT(13)
 /* Mark the end of mipi commands transaction */
 #define EXYNOS_DSI_MSG_FORCE_FLUSH  BIT(12)
+/*
+ * Return once the transfer is started instead of waiting for the command fifos
+ * to drain. The next msg on the host is ordered after it, a msg without this
+ * flag (including an empty one) waits for the earlier transfer to finish.
+ */
+#define EXYNOS_DSI_MSG_ASYNC  BIT(10)
+/* send out when requested even if the commit commands are being merged */
+#define EXYNOS_DSI_MSG_NO_MERGE  BIT(9)
+/* msg is embedded in struct exynos_dsi_msg and carries a pre-built packet */
+#define EXYNOS_DSI_MSG_PACKED  BIT(11)
+
+/**
+ * struct exynos_dsi_packet - DSI packet built ahead of the transfer
+ * @header: packet header bytes as created by mipi_dsi_create_packet()
+ * @payload_len: payload length in bytes
+ * @payload: payload packed into little-endian TX FIFO words, zero padded to a
+ *	     multiple of 4 bytes
+ */
+struct exynos_dsi_packet {
+	u8 header[4];
+	u32 payload_len;
+	const u32 *payload;
+};
+
+/**
+ * struct exynos_dsi_msg - DSI msg with a pre-built packet
+ * @msg: regular msg, still describing the original command for logging and
+ *	 for hosts which build the packet on their own
+ * @packet: packet to write, used when @msg.flags has EXYNOS_DSI_MSG_PACKED
+ */
+struct exynos_dsi_msg {
+	struct mipi_dsi_msg msg;
+	const struct exynos_dsi_packet *packet;
+};
+
+#define to_exynos_dsi_msg(m)	container_of(m, struct exynos_dsi_msg, msg)
 
 struct exynos_drm_connector_properties {
 	struct drm_property *max_luminance;
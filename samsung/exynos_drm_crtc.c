@@ -23,6 +23,7 @@
 #include <drm/drm_ioctl.h>
 #include <drm/drm_vblank.h>
 #include <drm/drm.h>
+#include <linux/jhash.h>
 
 #include <dqe_cal.h>
 
@@ -82,6 +83,23 @@ static void exynos_drm_crtc_atomic_disable(struct drm_crtc *crtc,
 	exynos_crtc->active_state = active_state;
 }
 
+/*
+ * Returns the hash of @blob contents. @data and @hash are those of the blob
+ * in the state this one was duplicated from, which still holds a reference
+ * to it, so the blob is the same one if the data pointer matches.
+ */
+static u32 exynos_crtc_blob_hash(const struct drm_property_blob *blob,
+				 const void *data, u32 hash)
+{
+	if (!blob)
+		return 0;
+
+	if (blob->data == data)
+		return hash;
+
+	return jhash(blob->data, blob->length, 0);
+}
+
 static void exynos_crtc_update_lut(struct drm_crtc *crtc,
 					struct drm_crtc_state *state)
 {
@@ -101,8 +119,10 @@ static void exynos_crtc_update_lut(struct drm_crtc *crtc,
 	if (exynos_state->cgc_lut) {
 		cgc_lut = exynos_state->cgc_lut->data;
 		dqe_state->cgc_lut = cgc_lut;
+		dqe_state->cgc_lut_id = exynos_state->cgc_lut->base.id;
 	} else {
 		dqe_state->cgc_lut = NULL;
+		dqe_state->cgc_lut_id = 0;
 	}
 
 	if (exynos_state->disp_dither)
@@ -120,31 +140,50 @@ static void exynos_crtc_update_lut(struct drm_crtc *crtc,
 	dqe_state->weights = exynos_state->histogram_weights ?
 		exynos_state->histogram_weights->data : NULL;
 
-	if (exynos_state->linear_matrix)
+	dqe_state->linear_matrix_hash = exynos_crtc_blob_hash(exynos_state->linear_matrix,
+			dqe_state->linear_matrix, dqe_state->linear_matrix_hash);
+	if (exynos_state->linear_matrix) {
 		dqe_state->linear_matrix = exynos_state->linear_matrix->data;
-	else
+		dqe_state->linear_matrix_id = exynos_state->linear_matrix->base.id;
+	} else {
 		dqe_state->linear_matrix = NULL;
+		dqe_state->linear_matrix_id = 0;
+	}
 
-	if (exynos_state->gamma_matrix)
+	dqe_state->gamma_matrix_hash = exynos_crtc_blob_hash(exynos_state->gamma_matrix,
+			dqe_state->gamma_matrix, dqe_state->gamma_matrix_hash);
+	if (exynos_state->gamma_matrix) {
 		dqe_state->gamma_matrix = exynos_state->gamma_matrix->data;
-	else
+		dqe_state->gamma_matrix_id = exynos_state->gamma_matrix->base.id;
+	} else {
 		dqe_state->gamma_matrix = NULL;
+		dqe_state->gamma_matrix_id = 0;
+	}
 
+	dqe_state->degamma_lut_hash = exynos_crtc_blob_hash(state->degamma_lut,
+			dqe_state->degamma_lut, dqe_state->degamma_lut_hash);
 	if (state->degamma_lut) {
 		degamma_lut = state->degamma_lut->data;
 		dqe_state->degamma_lut = degamma_lut;
+		dqe_state->degamma_lut_id = state->degamma_lut->base.id;
 	} else {
 		dqe_state->degamma_lut = NULL;
+		dqe_state->degamma_lut_id = 0;
 	}
 
+	dqe_state->regamma_lut_hash = exynos_crtc_blob_hash(state->gamma_lut,
+			dqe_state->regamma_lut, dqe_state->regamma_lut_hash);
 	if (state->gamma_lut) {
 		gamma_lut = state->gamma_lut->data;
 		dqe_state->regamma_lut = gamma_lut;
+		dqe_state->regamma_lut_id = state->gamma_lut->base.id;
 	} else {
 		dqe_state->regamma_lut = NULL;
+		dqe_state->regamma_lut_id = 0;
 	}
 
 	dqe_state->cgc_gem = exynos_state->cgc_gem;
+	dqe_state->cgc_gem_changed = exynos_state->cgc_gem_changed;
 }
 
 static int exynos_crtc_atomic_check(struct drm_crtc *crtc,
@@ -441,9 +480,14 @@ exynos_drm_crtc_duplicate_state(struct drm_crtc *crtc)
 	__drm_atomic_helper_crtc_duplicate_state(crtc, &copy->base);
 
 	copy->seamless_mode_changed = false;
+	copy->cgc_gem_changed = false;
 	copy->skip_update = false;
 	copy->planes_updated = false;
 	copy->hibernation_exit = false;
+	copy->fences_deferred = false;
+	atomic_set(&copy->fences_pending, 0);
+	copy->fences_ready_ts = 0;
+	copy->commit_sync = NULL;
 
 	return &copy->base;
 }
@@ -559,6 +603,7 @@ static int exynos_drm_crtc_set_property(struct drm_crtc *crtc,
 			drm_gem_object_put(exynos_crtc_state->cgc_gem);
 		exynos_crtc_state->cgc_gem = (U642I64(val) >= 0) ?
 			exynos_drm_gem_fd_to_obj(crtc->dev, U642I64(val)) : NULL;
+		exynos_crtc_state->cgc_gem_changed = true;
 		replaced = true;
 	} else if (property == exynos_crtc->props.expected_present_time) {
 		exynos_crtc_state->expected_present_time = val;
@@ -920,6 +965,10 @@ struct exynos_drm_crtc *exynos_drm_crtc_create(struct drm_device *drm_dev,
 	exynos_crtc->ops = ops;
 	exynos_crtc->ctx = ctx;
 	exynos_crtc->active_state = CRTC_STATE_INACTIVE;
+	spin_lock_init(&exynos_crtc->te_model_lock);
+	te_model_reset(&exynos_crtc->te_model);
+	exynos_crtc->defer_fences = true;
+	init_waitqueue_head(&exynos_crtc->fence_wq);
 
 	crtc = &exynos_crtc->base;
 
@@ -981,13 +1030,14 @@ struct exynos_drm_crtc *exynos_drm_crtc_create(struct drm_device *drm_dev,
 			goto err_crtc;
 
 		if (decon->cgc_dma) {
-			if (exynos_drm_crtc_create_signed_range(crtc, "cgc_lut_fd",
-						&exynos_crtc->props.cgc_lut_fd, INT_MIN, INT_MAX))
+			ret = exynos_drm_crtc_create_signed_range(crtc, "cgc_lut_fd",
+					&exynos_crtc->props.cgc_lut_fd, INT_MIN, INT_MAX);
+			if (ret)
 				goto err_crtc;
-		} else {
-			ret = exynos_drm_crtc_create_blob(crtc, "cgc_lut",
-					&exynos_crtc->props.cgc_lut);
 		}
+
+		ret = exynos_drm_crtc_create_blob(crtc, "cgc_lut",
+				&exynos_crtc->props.cgc_lut);
 		if (ret)
 			goto err_crtc;
 	}
@@ -1037,6 +1087,51 @@ void exynos_drm_crtc_te_handler(struct drm_crtc *crtc)
 		exynos_crtc->ops->te_handler(exynos_crtc);
 }
 
+/* called from the TE interrupt with the timestamp of the TE */
+void exynos_drm_crtc_te_model_update(struct exynos_drm_crtc *exynos_crtc, ktime_t ts)
+{
+	spin_lock(&exynos_crtc->te_model_lock);
+	te_model_update(&exynos_crtc->te_model, ktime_to_ns(ts));
+	spin_unlock(&exynos_crtc->te_model_lock);
+}
+
+/*
+ * Predicts the most recent TE at or before @now from the TE model, and returns
+ * the measured TE period. Returns false if the model isn't locked to the panel
+ * TE, callers should fall back to the vblank timestamp and nominal period then.
+ */
+bool exynos_drm_crtc_te_predict(struct drm_crtc *crtc, ktime_t now, ktime_t *last_te,
+				u32 *period_ns)
+{
+	struct exynos_drm_crtc *exynos_crtc = to_exynos_crtc(crtc);
+	unsigned long flags;
+	u64 last_te_ns;
+	bool ret;
+
+	spin_lock_irqsave(&exynos_crtc->te_model_lock, flags);
+	ret = te_model_predict(&exynos_crtc->te_model, ktime_to_ns(now), &last_te_ns,
+			       period_ns);
+	spin_unlock_irqrestore(&exynos_crtc->te_model_lock, flags);
+
+	if (ret)
+		*last_te = ns_to_ktime(last_te_ns);
+
+	return ret;
+}
+EXPORT_SYMBOL(exynos_drm_crtc_te_predict);
+
+/* forget the learned TE periods, e.g. when the panel oscillator changes */
+void exynos_drm_crtc_te_model_reset(struct drm_crtc *crtc)
+{
+	struct exynos_drm_crtc *exynos_crtc = to_exynos_crtc(crtc);
+	unsigned long flags;
+
+	spin_lock_irqsave(&exynos_crtc->te_model_lock, flags);
+	te_model_reset(&exynos_crtc->te_model);
+	spin_unlock_irqrestore(&exynos_crtc->te_model_lock, flags);
+}
+EXPORT_SYMBOL(exynos_drm_crtc_te_model_reset);
+
 void exynos_crtc_wait_for_flip_done(struct drm_atomic_state *old_state)
 {
 	struct drm_crtc *crtc;
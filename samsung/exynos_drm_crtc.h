@@ -56,6 +56,11 @@ uint32_t exynos_drm_get_possible_crtcs(const struct drm_encoder *encoder,
  */
 void exynos_drm_crtc_te_handler(struct drm_crtc *crtc);
 
+void exynos_drm_crtc_te_model_update(struct exynos_drm_crtc *exynos_crtc, ktime_t ts);
+bool exynos_drm_crtc_te_predict(struct drm_crtc *crtc, ktime_t now, ktime_t *last_te,
+				u32 *period_ns);
+void exynos_drm_crtc_te_model_reset(struct drm_crtc *crtc);
+
 void exynos_crtc_handle_event(struct exynos_drm_crtc *exynos_crtc);
 
 void exynos_crtc_wait_for_flip_done(struct drm_atomic_state *old_state);
@@ -13,11 +13,14 @@
 #include <linux/kernel.h>
 #include <linux/console.h>
 #include <linux/debugfs.h>
+#include <linux/jump_label.h>
 #include <linux/moduleparam.h>
+#include <linux/mutex.h>
 #include <linux/pm_runtime.h>
 #include <linux/sched/clock.h>
 #include <linux/sysfs.h>
 #include <linux/time.h>
+#include <linux/vmalloc.h>
 #include <video/mipi_display.h>
 #include <drm/drm_print.h>
 #include <drm/drm_managed.h>
@@ -40,6 +43,7 @@
 
 #include "exynos_drm_decon.h"
 #include "exynos_drm_dsim.h"
+#include "exynos_drm_event_ring.h"
 #include "exynos_drm_writeback.h"
 
 /* Default is 1024 entries array for event log buffer */
@@ -71,13 +75,58 @@ static bool dpu_event_ignore
 
 	for (offset = 0; offset < DPU_EVENT_KEEP_CNT; ++offset) {
 		idx = (latest + dpu_event_log_max - offset) % dpu_event_log_max;
-		if (type != decon->d.event_log[idx].type)
+		if (type != READ_ONCE(decon->d.event_log[idx].type))
 			return false;
 	}
 
 	return true;
 }
 
+/* enabled while any decon has an event mask or a rate limit configured */
+static DEFINE_STATIC_KEY_FALSE(dpu_event_filter_key);
+static DEFINE_MUTEX(dpu_event_filter_lock);
+
+static bool dpu_event_ratelimited(struct dpu_event_ratelimit *rl)
+{
+	const u32 rate = READ_ONCE(rl->rate);
+	s64 interval, tolerance, now, tat, next;
+
+	if (!rate)
+		return false;
+
+	interval = NSEC_PER_SEC / rate;
+	tolerance = interval * max_t(u32, READ_ONCE(rl->burst), 1);
+	now = local_clock();
+
+	tat = atomic64_read(&rl->tat);
+	do {
+		next = max(tat, now) + interval;
+		if (next - now > tolerance)
+			return true;
+	} while (!atomic64_try_cmpxchg(&rl->tat, &tat, next));
+
+	return false;
+}
+
+/* Returns true if the event should not be stored in the event log */
+static inline bool dpu_event_filtered(struct decon_device *decon,
+				      enum dpu_event_type type)
+{
+	struct dpu_event_filter *filter;
+
+	if (!static_branch_unlikely(&dpu_event_filter_key))
+		return false;
+
+	filter = &decon->d.filter;
+	if (test_bit(type, filter->disabled) ||
+	    dpu_event_ratelimited(&filter->ratelimit[type])) {
+		atomic_inc(&filter->dropped[type]);
+		return true;
+	}
+
+	return false;
+}
+
 #if IS_ENABLED(CONFIG_ARM_EXYNOS_DEVFREQ)
 static void dpu_event_save_freqs(struct dpu_log_freqs *freqs)
 {
@@ -92,8 +141,6 @@ static void dpu_event_save_freqs(struct dpu_log_freqs *freqs) { }
 static struct dpu_log *dpu_event_get_next(struct decon_device *decon)
 {
 	struct dpu_log *log;
-	unsigned long flags;
-	int idx;
 
 	if (!decon) {
 		pr_err("%s: invalid decon\n", __func__);
@@ -103,12 +150,8 @@ static struct dpu_log *dpu_event_get_next(struct decon_device *decon)
 	if (IS_ERR_OR_NULL(decon->d.event_log))
 		return NULL;
 
-	spin_lock_irqsave(&decon->d.event_lock, flags);
-	idx = atomic_inc_return(&decon->d.event_log_idx) % dpu_event_log_max;
-	log = &decon->d.event_log[idx];
-	log->type = DPU_EVT_NONE;
-	spin_unlock_irqrestore(&decon->d.event_lock, flags);
-
+	log = dpu_event_reserve(decon->d.event_log, dpu_event_log_max,
+				&decon->d.event_log_idx);
 	log->ts_nsec = local_clock();
 
 	return log;
@@ -180,6 +223,10 @@ void DPU_EVENT_LOG(enum dpu_event_type type, int index, void *priv)
 		break;
 	}
 
+	/* counters above keep counting, the rest is skipped for filtered events */
+	if (dpu_event_filtered(decon, type))
+		return;
+
 	/*
 	 * If the same event occurs DPU_EVENT_KEEP_CNT times
 	 * continuously, it will be skipped.
@@ -246,6 +293,12 @@ void DPU_EVENT_LOG(enum dpu_event_type type, int index, void *priv)
 		log->data.decon_cfg.mode.dsi_mode = decon->config.mode.dsi_mode;
 		log->data.decon_cfg.mode.trig_mode = decon->config.mode.trig_mode;
 		break;
+	case DPU_EVT_DSIM_CMD_BATCH:
+		dsim = (struct dsim_device *)priv;
+		log->data.dsim_batch.merged = dsim->commit_batch.merged_cnt;
+		log->data.dsim_batch.ph = dsim->total_pend_ph;
+		log->data.dsim_batch.pl = dsim->total_pend_pl;
+		break;
 	case DPU_EVT_DSIM_RUNTIME_SUSPEND:
 	case DPU_EVT_DSIM_RUNTIME_RESUME:
 	case DPU_EVT_DSIM_SUSPEND:
@@ -274,6 +327,9 @@ void DPU_EVENT_LOG(enum dpu_event_type type, int index, void *priv)
 		log->data.win.plane_idx = dpp->id;
 		log->data.win.secure = dpp->protection;
 		break;
+	case DPU_EVT_PLANE_FENCE:
+		log->data.plane_fence = *(struct dpu_log_plane_fence *)priv;
+		break;
 	case DPU_EVT_REQ_CRTC_INFO_OLD:
 	case DPU_EVT_REQ_CRTC_INFO_NEW:
 		crtc_state = (struct drm_crtc_state *)priv;
@@ -304,6 +360,14 @@ void DPU_EVENT_LOG(enum dpu_event_type type, int index, void *priv)
 		log->data.bts_cal.write_bw = decon->bts.write_bw;
 		log->data.bts_cal.fps = decon->bts.fps;
 		break;
+	case DPU_EVT_BTS_PREFETCH:
+		log->data.bts_prefetch.peak = decon->bts.prefetch.vote.bw.peak;
+		log->data.bts_prefetch.rt = decon->bts.prefetch.vote.bw.rt;
+		log->data.bts_prefetch.disp_freq = decon->bts.prefetch.vote.disp_freq;
+		log->data.bts_prefetch.hit_cnt = decon->bts.prefetch.hit_cnt;
+		log->data.bts_prefetch.miss_cnt = decon->bts.prefetch.miss_cnt;
+		log->data.bts_prefetch.over_cnt = decon->bts.prefetch.over_cnt;
+		break;
 	case DPU_EVT_DSIM_UNDERRUN:
 		dpu_event_save_freqs(&log->data.bts_event.freqs);
 		log->data.bts_event.value = decon->d.underrun_cnt;
@@ -335,7 +399,7 @@ void DPU_EVENT_LOG(enum dpu_event_type type, int index, void *priv)
 		break;
 	}
 
-	log->type = type;
+	dpu_event_commit(log, type);
 }
 
 /*
@@ -357,12 +421,18 @@ void DPU_EVENT_LOG_ATOMIC_COMMIT(int index)
 	}
 
 	decon = get_decon_drvdata(index);
-	log = dpu_event_get_next(decon);
-	if (!log)
+	if (!decon)
 		return;
 
 	decon->d.auto_refresh_frames = 0;
 
+	if (dpu_event_filtered(decon, DPU_EVT_ATOMIC_COMMIT))
+		return;
+
+	log = dpu_event_get_next(decon);
+	if (!log)
+		return;
+
 	for (i = 0; i < MAX_WIN_PER_DECON; ++i) {
 		memcpy(&log->data.atomic.win_config[i].win,
 				&decon->bts.win_config[i],
@@ -379,7 +449,7 @@ void DPU_EVENT_LOG_ATOMIC_COMMIT(int index)
 	memcpy(&log->data.atomic.rcd_win_config, &decon->bts.rcd_win_config,
 	       sizeof(log->data.atomic.rcd_win_config));
 
-	log->type = DPU_EVT_ATOMIC_COMMIT;
+	dpu_event_commit(log, DPU_EVT_ATOMIC_COMMIT);
 }
 
 extern void *return_address(unsigned int);
@@ -400,8 +470,12 @@ DPU_EVENT_LOG_CMD(struct dsim_device *dsim, u8 type, u8 d0, u16 len)
 {
 	int i;
 	struct decon_device *decon = (struct decon_device *)dsim_get_decon(dsim);
-	struct dpu_log *log = dpu_event_get_next(decon);
+	struct dpu_log *log;
 
+	if (!decon || dpu_event_filtered(decon, DPU_EVT_DSIM_COMMAND))
+		return;
+
+	log = dpu_event_get_next(decon);
 	if (!log)
 		return;
 
@@ -413,7 +487,7 @@ DPU_EVENT_LOG_CMD(struct dsim_device *dsim, u8 type, u8 d0, u16 len)
 		log->data.cmd.caller[i] =
 			(void *)((size_t)return_address(i + 1));
 
-	log->type = DPU_EVT_DSIM_COMMAND;
+	dpu_event_commit(log, DPU_EVT_DSIM_COMMAND);
 }
 
 static void dpu_print_log_win_config(const struct decon_win_config *const win_config,
@@ -584,8 +658,13 @@ static const char *get_event_name(enum dpu_event_type type)
 		"CGC_FRAMEDONE",
 		"ITMON_ERROR",
 		"SYSMMU_FAULT",
+		"BTS_PREFETCH",
+		"DSIM_CMD_BATCH",
+		"PLANE_FENCE",
 	};
 
+	BUILD_BUG_ON(ARRAY_SIZE(events) != DPU_EVT_MAX);
+
 	if (type >= DPU_EVT_MAX)
 		return NULL;
 
@@ -602,6 +681,7 @@ static bool is_skip_dpu_event_dump(enum dpu_event_type type, enum dpu_event_cond
 		case DPU_EVT_DECON_FRAMEDONE:
 		case DPU_EVT_DECON_FRAMESTART:
 		case DPU_EVT_DSIM_COMMAND:
+		case DPU_EVT_DSIM_CMD_BATCH:
 		case DPU_EVT_DSIM_ULPS_ENTER:
 		case DPU_EVT_DSIM_ULPS_EXIT:
 		case DPU_EVT_DSIM_RUNTIME_SUSPEND:
@@ -626,9 +706,11 @@ static bool is_skip_dpu_event_dump(enum dpu_event_type type, enum dpu_event_cond
 		case DPU_EVT_PLANE_CLEANUP_FB:
 		case DPU_EVT_PLANE_UPDATE:
 		case DPU_EVT_PLANE_DISABLE:
+		case DPU_EVT_PLANE_FENCE:
 		case DPU_EVT_BTS_RELEASE_BW:
 		case DPU_EVT_BTS_CALC_BW:
 		case DPU_EVT_BTS_UPDATE_BW:
+		case DPU_EVT_BTS_PREFETCH:
 		case DPU_EVT_DECON_RSC_OCCUPANCY:
 			return false;
 		default:
@@ -642,6 +724,7 @@ static bool is_skip_dpu_event_dump(enum dpu_event_type type, enum dpu_event_cond
 		case DPU_EVT_BTS_RELEASE_BW:
 		case DPU_EVT_BTS_CALC_BW:
 		case DPU_EVT_BTS_UPDATE_BW:
+		case DPU_EVT_BTS_PREFETCH:
 			return false;
 		default:
 			return true;
@@ -653,6 +736,7 @@ static bool is_skip_dpu_event_dump(enum dpu_event_type type, enum dpu_event_cond
 		case DPU_EVT_DECON_FRAMEDONE:
 		case DPU_EVT_DECON_FRAMESTART:
 		case DPU_EVT_DSIM_COMMAND:
+		case DPU_EVT_DSIM_CMD_BATCH:
 		case DPU_EVT_DSIM_ULPS_ENTER:
 		case DPU_EVT_DSIM_ULPS_EXIT:
 		case DPU_EVT_DSIM_RUNTIME_SUSPEND:
@@ -718,6 +802,7 @@ static bool is_skip_dpu_event_dump(enum dpu_event_type type, enum dpu_event_cond
 	return false;
 }
 
+/* tests/event_log_decode.c prints event_raw snapshots the same way, keep it in sync */
 static void dpu_event_log_print(const struct decon_device *decon, struct drm_printer *p,
 				size_t max_logs, enum dpu_event_condition condition)
 {
@@ -732,7 +817,6 @@ static void dpu_event_log_print(const struct decon_device *decon, struct drm_pri
 	char buf[LOG_BUF_SIZE];
 	const struct dpu_fmt *fmt;
 	int len;
-	unsigned long flags;
 
 	if (IS_ERR_OR_NULL(decon_dev->d.event_log))
 		return;
@@ -754,10 +838,9 @@ static void dpu_event_log_print(const struct decon_device *decon, struct drm_pri
 		if (++idx >= dpu_event_log_max)
 			idx = 0;
 
-		/* Seek a index and copy log for dump */
-		spin_lock_irqsave(&decon_dev->d.event_lock, flags);
-		memcpy(&dump_log, &decon_dev->d.event_log[idx], sizeof(dump_log));
-		spin_unlock_irqrestore(&decon_dev->d.event_lock, flags);
+		/* Seek a index and copy log for dump, skip entries being written */
+		if (!dpu_event_read(&decon_dev->d.event_log[idx], &dump_log))
+			continue;
 
 		if (is_skip_dpu_event_dump(log->type, condition))
 			continue;
@@ -781,6 +864,12 @@ static void dpu_event_log_print(const struct decon_device *decon, struct drm_pri
 					log->data.cmd.id, log->data.cmd.d0,
 					log->data.cmd.len);
 			break;
+		case DPU_EVT_DSIM_CMD_BATCH:
+			scnprintf(buf + len, sizeof(buf) - len,
+					"\tmerged flushes(%u) ph(%u) pl(%u)",
+					log->data.dsim_batch.merged, log->data.dsim_batch.ph,
+					log->data.dsim_batch.pl);
+			break;
 		case DPU_EVT_DPP_FRAMEDONE:
 			scnprintf(buf + len, sizeof(buf) - len,
 					"\tCH:%u WIN:%u", log->data.dpp.id, log->data.dpp.win_id);
@@ -857,6 +946,15 @@ static void dpu_event_log_print(const struct decon_device *decon, struct drm_pri
 					log->data.win.win_idx,
 					log->data.win.secure ? "SECURE" : "");
 			break;
+		case DPU_EVT_PLANE_FENCE:
+			scnprintf(buf + len, sizeof(buf) - len,
+					"\tCH:%u ready:%uus wait:%uus %s status:%d",
+					PLANE2DPPCH(log->data.plane_fence.index),
+					log->data.plane_fence.ready_us,
+					log->data.plane_fence.wait_us,
+					log->data.plane_fence.deferred ? "DEFERRED" : "BLOCKING",
+					log->data.plane_fence.status);
+			break;
 		case DPU_EVT_REQ_CRTC_INFO_OLD:
 		case DPU_EVT_REQ_CRTC_INFO_NEW:
 			scnprintf(buf + len, sizeof(buf) - len,
@@ -880,6 +978,15 @@ static void dpu_event_log_print(const struct decon_device *decon, struct drm_pri
 					log->data.bts_cal.rt_avg_bw, log->data.bts_cal.read_bw,
 					log->data.bts_cal.write_bw, log->data.bts_cal.fps);
 			break;
+		case DPU_EVT_BTS_PREFETCH:
+			scnprintf(buf + len, sizeof(buf) - len,
+					"\tvote peak(%u) rt(%u) disp(%u) hit(%u) miss(%u) over(%u)",
+					log->data.bts_prefetch.peak, log->data.bts_prefetch.rt,
+					log->data.bts_prefetch.disp_freq,
+					log->data.bts_prefetch.hit_cnt,
+					log->data.bts_prefetch.miss_cnt,
+					log->data.bts_prefetch.over_cnt);
+			break;
 		case DPU_EVT_DSIM_UNDERRUN:
 			scnprintf(buf + len, sizeof(buf) - len,
 					"\tunderrun count(%u)",
@@ -958,6 +1065,444 @@ static const struct file_operations dpu_event_fops = {
 	.release = seq_release,
 };
 
+struct dpu_event_raw {
+	void *buf;
+	size_t size;
+};
+
+static void dpu_event_raw_freqs(const struct dpu_log_freqs *freqs,
+				struct dpu_log_raw_freqs *raw)
+{
+	raw->mif_freq = freqs->mif_freq;
+	raw->int_freq = freqs->int_freq;
+	raw->disp_freq = freqs->disp_freq;
+}
+
+static void dpu_event_raw_rect(const struct drm_rect *rect, struct dpu_log_raw_rect *raw)
+{
+	raw->x1 = rect->x1;
+	raw->y1 = rect->y1;
+	raw->x2 = rect->x2;
+	raw->y2 = rect->y2;
+}
+
+static void dpu_event_raw_win_config(const struct decon_win_config *win_config,
+				     struct dpu_log_raw_win_config *raw)
+{
+	const struct dpu_bts_win_config *win = &win_config->win;
+
+	raw->state = win->state;
+	raw->src_x = win->src_x;
+	raw->src_y = win->src_y;
+	raw->src_w = win->src_w;
+	raw->src_h = win->src_h;
+	raw->dst_x = win->dst_x;
+	raw->dst_y = win->dst_y;
+	raw->dst_w = win->dst_w;
+	raw->dst_h = win->dst_h;
+	raw->is_rot = win->is_rot;
+	raw->is_comp = win->is_comp;
+	raw->is_secure = win->is_secure;
+	raw->dpp_id = win->dpp_id;
+	raw->zpos = win->zpos;
+	raw->format = win->format;
+	raw->comp_src = win->comp_src;
+}
+
+/* converts an entry to the export layout, @raw is expected to be zeroed */
+static void dpu_event_log_to_raw(const struct dpu_log *log, struct dpu_log_raw *raw)
+{
+	void *data = raw->data;
+	int i;
+
+	BUILD_BUG_ON(sizeof(struct dpu_log_raw_atomic) > sizeof(raw->data));
+	BUILD_BUG_ON(MAX_WIN_PER_DECON > DPU_LOG_RAW_MAX_WIN);
+
+	raw->ts_nsec = log->ts_nsec;
+	raw->type = log->type;
+
+	switch (log->type) {
+	case DPU_EVT_DECON_RSC_OCCUPANCY: {
+		struct dpu_log_raw_rsc_occupancy *rsc = data;
+
+		rsc->rsc_ch = log->data.rsc.rsc_ch;
+		rsc->rsc_win = log->data.rsc.rsc_win;
+		break;
+	}
+	case DPU_EVT_DSIM_COMMAND: {
+		struct dpu_log_raw_dsim_cmd *cmd = data;
+
+		/* the callers are kernel addresses, they are left out */
+		cmd->id = log->data.cmd.id;
+		cmd->d0 = log->data.cmd.d0;
+		cmd->len = log->data.cmd.len;
+		break;
+	}
+	case DPU_EVT_DSIM_CMD_BATCH: {
+		struct dpu_log_raw_dsim_batch *batch = data;
+
+		batch->merged = log->data.dsim_batch.merged;
+		batch->ph = log->data.dsim_batch.ph;
+		batch->pl = log->data.dsim_batch.pl;
+		break;
+	}
+	case DPU_EVT_DPP_FRAMEDONE:
+	case DPU_EVT_DPP_SET_PROTECTION:
+	case DPU_EVT_DMA_RECOVERY:
+	case DPU_EVT_IDMA_AFBC_CONFLICT:
+	case DPU_EVT_IDMA_FBC_ERROR:
+	case DPU_EVT_IDMA_READ_SLAVE_ERROR:
+	case DPU_EVT_IDMA_DEADLOCK:
+	case DPU_EVT_IDMA_CFG_ERROR: {
+		struct dpu_log_raw_dpp *dpp = data;
+
+		dpp->id = log->data.dpp.id;
+		dpp->win_id = log->data.dpp.win_id;
+		dpp->comp_src = log->data.dpp.comp_src;
+		dpp->recovery_cnt = log->data.dpp.recovery_cnt;
+		dpp->last_secure_pid = log->data.dpp.last_secure_pid;
+		dpp->mst_security = log->data.dpp.mst_security;
+		break;
+	}
+	case DPU_EVT_DECON_RUNTIME_SUSPEND:
+	case DPU_EVT_DECON_RUNTIME_RESUME:
+	case DPU_EVT_DECON_SUSPEND:
+	case DPU_EVT_DECON_RESUME:
+	case DPU_EVT_ENTER_HIBERNATION_IN:
+	case DPU_EVT_ENTER_HIBERNATION_OUT:
+	case DPU_EVT_EXIT_HIBERNATION_IN:
+	case DPU_EVT_EXIT_HIBERNATION_OUT:
+	case DPU_EVT_DSIM_RUNTIME_SUSPEND:
+	case DPU_EVT_DSIM_RUNTIME_RESUME:
+	case DPU_EVT_DSIM_SUSPEND:
+	case DPU_EVT_DSIM_RESUME: {
+		struct dpu_log_raw_pd *pd = data;
+
+		pd->decon_state = log->data.pd.decon_state;
+		pd->rpm_active = log->data.pd.rpm_active;
+		pd->dsim_state = log->data.pd.dsim_state;
+		pd->dsim_rpm_active = log->data.pd.dsim_rpm_active;
+		break;
+	}
+	case DPU_EVT_DECON_UPDATE_CONFIG: {
+		struct dpu_log_raw_decon_cfg *cfg = data;
+
+		cfg->fps = log->data.decon_cfg.fps;
+		cfg->image_width = log->data.decon_cfg.image_width;
+		cfg->image_height = log->data.decon_cfg.image_height;
+		cfg->out_type = log->data.decon_cfg.out_type;
+		cfg->op_mode = log->data.decon_cfg.mode.op_mode;
+		cfg->dsi_mode = log->data.decon_cfg.mode.dsi_mode;
+		cfg->trig_mode = log->data.decon_cfg.mode.trig_mode;
+		break;
+	}
+	case DPU_EVT_PLANE_PREPARE_FB:
+	case DPU_EVT_PLANE_CLEANUP_FB: {
+		struct dpu_log_raw_plane_info *info = data;
+
+		/* the buffer DMA address is left out */
+		info->index = log->data.plane_info.index;
+		info->width = log->data.plane_info.width;
+		info->height = log->data.plane_info.height;
+		info->zpos = log->data.plane_info.zpos;
+		info->format = log->data.plane_info.format;
+		break;
+	}
+	case DPU_EVT_PLANE_UPDATE:
+	case DPU_EVT_PLANE_DISABLE: {
+		struct dpu_log_raw_win *win = data;
+
+		win->win_idx = log->data.win.win_idx;
+		win->plane_idx = log->data.win.plane_idx;
+		win->secure = log->data.win.secure;
+		break;
+	}
+	case DPU_EVT_PLANE_FENCE: {
+		struct dpu_log_raw_plane_fence *fence = data;
+
+		fence->index = log->data.plane_fence.index;
+		fence->ready_us = log->data.plane_fence.ready_us;
+		fence->wait_us = log->data.plane_fence.wait_us;
+		fence->deferred = log->data.plane_fence.deferred;
+		fence->status = log->data.plane_fence.status;
+		break;
+	}
+	case DPU_EVT_REQ_CRTC_INFO_OLD:
+	case DPU_EVT_REQ_CRTC_INFO_NEW: {
+		struct dpu_log_raw_crtc_info *info = data;
+
+		info->enable = log->data.crtc_info.enable;
+		info->active = log->data.crtc_info.active;
+		info->planes_changed = log->data.crtc_info.planes_changed;
+		info->mode_changed = log->data.crtc_info.mode_changed;
+		info->active_changed = log->data.crtc_info.active_changed;
+		info->self_refresh = log->data.crtc_info.self_refresh;
+		info->connectors_changed = log->data.crtc_info.connectors_changed;
+		break;
+	}
+	case DPU_EVT_BTS_RELEASE_BW:
+	case DPU_EVT_BTS_UPDATE_BW: {
+		struct dpu_log_raw_bts_update *update = data;
+
+		dpu_event_raw_freqs(&log->data.bts_update.freqs, &update->freqs);
+		update->peak = log->data.bts_update.peak;
+		update->prev_peak = log->data.bts_update.prev_peak;
+		update->rt_avg_bw = log->data.bts_update.rt_avg_bw;
+		update->prev_rt_avg_bw = log->data.bts_update.prev_rt_avg_bw;
+		update->total_bw = log->data.bts_update.total_bw;
+		update->prev_total_bw = log->data.bts_update.prev_total_bw;
+		break;
+	}
+	case DPU_EVT_BTS_CALC_BW: {
+		struct dpu_log_raw_bts_cal *cal = data;
+
+		dpu_event_raw_freqs(&log->data.bts_cal.freqs, &cal->freqs);
+		cal->disp_freq = log->data.bts_cal.disp_freq;
+		cal->peak = log->data.bts_cal.peak;
+		cal->rt_avg_bw = log->data.bts_cal.rt_avg_bw;
+		cal->read_bw = log->data.bts_cal.read_bw;
+		cal->write_bw = log->data.bts_cal.write_bw;
+		cal->fps = log->data.bts_cal.fps;
+		break;
+	}
+	case DPU_EVT_BTS_PREFETCH: {
+		struct dpu_log_raw_bts_prefetch *pf = data;
+
+		pf->peak = log->data.bts_prefetch.peak;
+		pf->rt = log->data.bts_prefetch.rt;
+		pf->disp_freq = log->data.bts_prefetch.disp_freq;
+		pf->hit_cnt = log->data.bts_prefetch.hit_cnt;
+		pf->miss_cnt = log->data.bts_prefetch.miss_cnt;
+		pf->over_cnt = log->data.bts_prefetch.over_cnt;
+		break;
+	}
+	case DPU_EVT_DSIM_UNDERRUN: {
+		struct dpu_log_raw_bts_event *event = data;
+
+		dpu_event_raw_freqs(&log->data.bts_event.freqs, &event->freqs);
+		event->value = log->data.bts_event.value;
+		break;
+	}
+	case DPU_EVT_PARTIAL_INIT:
+	case DPU_EVT_PARTIAL_PREPARE:
+	case DPU_EVT_PARTIAL_UPDATE:
+	case DPU_EVT_PARTIAL_RESTORE: {
+		struct dpu_log_raw_partial *partial = data;
+
+		partial->min_w = log->data.partial.min_w;
+		partial->min_h = log->data.partial.min_h;
+		dpu_event_raw_rect(&log->data.partial.prev, &partial->prev);
+		dpu_event_raw_rect(&log->data.partial.req, &partial->req);
+		dpu_event_raw_rect(&log->data.partial.adj, &partial->adj);
+		partial->reconfigure = log->data.partial.reconfigure;
+		break;
+	}
+	case DPU_EVT_ATOMIC_COMMIT: {
+		struct dpu_log_raw_atomic *atomic = data;
+
+		/* the buffer DMA addresses are left out */
+		for (i = 0; i < MAX_WIN_PER_DECON; ++i)
+			dpu_event_raw_win_config(&log->data.atomic.win_config[i],
+						 &atomic->win_config[i]);
+		dpu_event_raw_win_config(&log->data.atomic.rcd_win_config,
+					 &atomic->rcd_win_config);
+		break;
+	}
+	case DPU_EVT_DSIM_CRC:
+	case DPU_EVT_DSIM_ECC:
+	case DPU_EVT_TE_INTERRUPT:
+		*(__u32 *)data = log->data.value;
+		break;
+	default:
+		break;
+	}
+}
+
+static void dpu_event_log_snapshot(const struct decon_device *decon,
+				   struct dpu_log_raw_header *hdr)
+{
+	struct dpu_log_raw *records = (struct dpu_log_raw *)(hdr + 1);
+	const u32 latest = atomic_read(&decon->d.event_log_idx);
+	struct dpu_log log;
+	u32 i, idx;
+
+	hdr->magic = DPU_EVENT_LOG_RAW_MAGIC;
+	hdr->version = DPU_EVENT_LOG_RAW_VERSION;
+	hdr->header_size = sizeof(*hdr);
+	hdr->record_size = sizeof(struct dpu_log_raw);
+	hdr->record_cnt = dpu_event_log_max;
+	hdr->decon_id = decon->id;
+	hdr->ts_nsec = local_clock();
+
+	/* the buffer comes zeroed, entries caught mid-write are left that way */
+	for (i = 0; i < dpu_event_log_max; ++i) {
+		idx = (latest + 1 + i) % dpu_event_log_max;
+		if (dpu_event_read(&decon->d.event_log[idx], &log))
+			dpu_event_log_to_raw(&log, &records[i]);
+	}
+}
+
+static int dpu_event_raw_open(struct inode *inode, struct file *file)
+{
+	const struct decon_device *decon = inode->i_private;
+	struct dpu_event_raw *raw;
+
+	if (IS_ERR_OR_NULL(decon->d.event_log))
+		return -ENOENT;
+
+	raw = kzalloc(sizeof(*raw), GFP_KERNEL);
+	if (!raw)
+		return -ENOMEM;
+
+	raw->size = sizeof(struct dpu_log_raw_header) +
+			sizeof(struct dpu_log_raw) * dpu_event_log_max;
+	/* allocated with VM_USERMAP so that the snapshot can be mmap'ed */
+	raw->buf = vmalloc_user(raw->size);
+	if (!raw->buf) {
+		kfree(raw);
+		return -ENOMEM;
+	}
+
+	dpu_event_log_snapshot(decon, raw->buf);
+	file->private_data = raw;
+
+	return 0;
+}
+
+static ssize_t dpu_event_raw_read(struct file *file, char __user *buf,
+				  size_t len, loff_t *ppos)
+{
+	const struct dpu_event_raw *raw = file->private_data;
+
+	return simple_read_from_buffer(buf, len, ppos, raw->buf, raw->size);
+}
+
+static int dpu_event_raw_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	const struct dpu_event_raw *raw = file->private_data;
+
+	if (vma->vm_flags & VM_WRITE)
+		return -EPERM;
+
+	return remap_vmalloc_range(vma, raw->buf, vma->vm_pgoff);
+}
+
+static int dpu_event_raw_release(struct inode *inode, struct file *file)
+{
+	struct dpu_event_raw *raw = file->private_data;
+
+	vfree(raw->buf);
+	kfree(raw);
+
+	return 0;
+}
+
+static const struct file_operations dpu_event_raw_fops = {
+	.open = dpu_event_raw_open,
+	.read = dpu_event_raw_read,
+	.mmap = dpu_event_raw_mmap,
+	.llseek = default_llseek,
+	.release = dpu_event_raw_release,
+};
+
+static int dpu_event_filter_show(struct seq_file *s, void *unused)
+{
+	struct decon_device *decon = s->private;
+	const struct dpu_event_filter *filter = &decon->d.filter;
+	int i;
+
+	seq_printf(s, "%24s  %6s  %6s  %6s  %8s\n", "Event ID", "enable", "rate", "burst",
+		   "dropped");
+	for (i = DPU_EVT_NONE + 1; i < DPU_EVT_MAX; ++i)
+		seq_printf(s, "%24s  %6d  %6u  %6u  %8d\n", get_event_name(i),
+			   !test_bit(i, filter->disabled), filter->ratelimit[i].rate,
+			   filter->ratelimit[i].burst, atomic_read(&filter->dropped[i]));
+
+	return 0;
+}
+
+static int dpu_event_filter_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, dpu_event_filter_show, inode->i_private);
+}
+
+static int dpu_event_find_type(const char *name)
+{
+	int i;
+
+	for (i = DPU_EVT_NONE + 1; i < DPU_EVT_MAX; ++i)
+		if (!strcmp(name, get_event_name(i)))
+			return i;
+
+	return -EINVAL;
+}
+
+/*
+ * Input format is "<event id> <enable> [<rate per second> [<burst>]]",
+ * e.g. "TE_INTERRUPT 1 30 4" keeps at most 4 back to back TE events and 30
+ * events per second on average. A rate of 0 removes the limit.
+ */
+static ssize_t dpu_event_filter_write(struct file *file, const char __user *buffer,
+				      size_t len, loff_t *ppos)
+{
+	struct seq_file *s = file->private_data;
+	struct decon_device *decon = s->private;
+	struct dpu_event_filter *filter = &decon->d.filter;
+	struct dpu_event_ratelimit *rl;
+	char name[32];
+	char *tmpbuf;
+	u32 enable, rate = 0, burst = 0;
+	bool active;
+	int ret, type, i;
+
+	tmpbuf = memdup_user_nul(buffer, len);
+	if (IS_ERR(tmpbuf))
+		return PTR_ERR(tmpbuf);
+
+	ret = sscanf(tmpbuf, "%31s %u %u %u", name, &enable, &rate, &burst);
+	kfree(tmpbuf);
+	if (ret < 2)
+		return -EINVAL;
+
+	type = dpu_event_find_type(name);
+	if (type < 0)
+		return type;
+
+	mutex_lock(&dpu_event_filter_lock);
+
+	if (enable)
+		clear_bit(type, filter->disabled);
+	else
+		set_bit(type, filter->disabled);
+
+	rl = &filter->ratelimit[type];
+	WRITE_ONCE(rl->burst, burst ? : 1);
+	WRITE_ONCE(rl->rate, rate);
+	atomic64_set(&rl->tat, 0);
+
+	active = !bitmap_empty(filter->disabled, DPU_EVT_MAX);
+	for (i = 0; i < DPU_EVT_MAX && !active; ++i)
+		active = filter->ratelimit[i].rate != 0;
+
+	if (active && !filter->active)
+		static_branch_inc(&dpu_event_filter_key);
+	else if (!active && filter->active)
+		static_branch_dec(&dpu_event_filter_key);
+	filter->active = active;
+
+	mutex_unlock(&dpu_event_filter_lock);
+
+	return len;
+}
+
+static const struct file_operations dpu_event_filter_fops = {
+	.open = dpu_event_filter_open,
+	.read = seq_read,
+	.write = dpu_event_filter_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
 static bool is_dqe_supported(struct drm_device *drm_dev, u32 dqe_id)
 {
 	struct drm_crtc *crtc;
@@ -1349,6 +1894,53 @@ static struct dentry *exynos_debugfs_add_atc(struct exynos_dqe *dqe,
 	return dent;
 }
 
+static int dqe_img_cache_show(struct seq_file *s, void *unused)
+{
+	static const char * const names[DQE_REG_IMG_MAX] = {
+		[DQE_REG_IMG_DEGAMMA]		= "degamma",
+		[DQE_REG_IMG_REGAMMA]		= "regamma",
+		[DQE_REG_IMG_LINEAR_MATRIX]	= "linear_matrix",
+		[DQE_REG_IMG_GAMMA_MATRIX]	= "gamma_matrix",
+	};
+	struct exynos_dqe *dqe = s->private;
+	const struct dqe_img_cache *cache = &dqe->img_cache;
+	int i;
+
+	seq_printf(s, "%-14s %10s %10s\n", "block", "hit", "miss");
+	for (i = 0; i < DQE_REG_IMG_MAX; i++)
+		seq_printf(s, "%-14s %10u %10u\n", names[i],
+				cache->hit_cnt[i], cache->miss_cnt[i]);
+
+	return 0;
+}
+
+static int dqe_img_cache_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, dqe_img_cache_show, inode->i_private);
+}
+
+/* writing anything resets the statistics, cached images are kept */
+static ssize_t dqe_img_cache_write(struct file *file, const char __user *buffer,
+				   size_t len, loff_t *ppos)
+{
+	struct seq_file *s = file->private_data;
+	struct exynos_dqe *dqe = s->private;
+	struct dqe_img_cache *cache = &dqe->img_cache;
+
+	memset(cache->hit_cnt, 0, sizeof(cache->hit_cnt));
+	memset(cache->miss_cnt, 0, sizeof(cache->miss_cnt));
+
+	return len;
+}
+
+static const struct file_operations dqe_img_cache_fops = {
+	.open = dqe_img_cache_open,
+	.read = seq_read,
+	.write = dqe_img_cache_write,
+	.llseek = seq_lseek,
+	.release = seq_release,
+};
+
 static struct dentry *
 exynos_debugfs_add_matrix(struct matrix_debug_override *matrix,
 				const char *name, struct dentry *parent,
@@ -1432,6 +2024,8 @@ exynos_debugfs_add_dqe(struct exynos_dqe *dqe, struct dentry *parent)
 
 	debugfs_create_bool("force_disabled", 0664, dent_dir,
 			&dqe->force_disabled);
+	debugfs_create_file("img_cache", 0664, dent_dir, dqe,
+			&dqe_img_cache_fops);
 
 	return;
 
@@ -1441,8 +2035,9 @@ err:
 
 static ssize_t counters_show(struct device *dev, struct device_attribute *attr, char *buf)
 {
-	uint32_t underrun_cnt, crc_cnt, ecc_cnt, idma_err_cnt;
+	uint32_t underrun_cnt, crc_cnt, ecc_cnt, idma_err_cnt, dropped;
 	const struct decon_device *decon = to_decon_device(dev);
+	int i, len;
 
 	if (!decon)
 		return -ENODEV;
@@ -1452,12 +2047,23 @@ static ssize_t counters_show(struct device *dev, struct device_attribute *attr,
 	ecc_cnt = decon->d.ecc_cnt;
 	idma_err_cnt = decon->d.idma_err_cnt;
 
-	return snprintf(buf, PAGE_SIZE,
+	len = scnprintf(buf, PAGE_SIZE,
 			"underrun: %u\n"
 			"crc: %u\n"
 			"ecc: %u\n"
 			"idma_error: %u\n",
 			underrun_cnt, crc_cnt, ecc_cnt, idma_err_cnt);
+
+	for (i = DPU_EVT_NONE + 1; i < DPU_EVT_MAX; ++i) {
+		dropped = atomic_read(&decon->d.filter.dropped[i]);
+		if (!dropped)
+			continue;
+
+		len += scnprintf(buf + len, PAGE_SIZE - len, "event_dropped(%s): %u\n",
+				 get_event_name(i), dropped);
+	}
+
+	return len;
 }
 
 static DEVICE_ATTR_RO(counters);
@@ -1471,10 +2077,49 @@ static int hibernation_show(struct seq_file *s, void *unused)
 {
 	struct decon_device *decon = s->private;
 	struct exynos_hibernation *hiber = decon->hibernation;
+	static const char * const path_names[HIBERNATION_PATH_MAX] = {
+		[HIBERNATION_PATH_COMMIT] = "commit",
+		[HIBERNATION_PATH_FAST] = "fast",
+	};
+	static const char * const wake_names[HIBERNATION_WAKE_MAX] = {
+		[HIBERNATION_WAKE_COMMIT] = "commit",
+		[HIBERNATION_WAKE_EARLY] = "early",
+	};
+	int i, j;
 
 	seq_printf(s, "%s, block_cnt(%d)\n",
 			hiber->enabled ? "enabled" : "disabled",
 			atomic_read(&hiber->block_cnt));
+	seq_printf(s, "fast path %s, active(%d) entries(%u) fallbacks(%u)\n",
+			hiber->fast_enabled ? "enabled" : "disabled",
+			hiber->fast_active, hiber->fast_enter_cnt,
+			hiber->fast_fallback_cnt);
+	seq_printf(s, "policy %s, interval(%uus) dev(%uus) enter(%uus) exit(%uus)\n",
+			hiber->policy.enabled ? "enabled" : "disabled",
+			hiber->policy.interval_us, hiber->policy.dev_us,
+			hiber->policy.enter_us, hiber->policy.exit_us);
+	seq_printf(s, "entered(%u) deferred(%u) hits(%u) false_entries(%u)\n",
+			hiber->policy.entered, hiber->policy.deferred,
+			hiber->policy.hits, hiber->policy.false_entries);
+
+	seq_printf(s, "exit latency: %8s%8s%8s%8s%8s%8s%8s%8s\n", "<250us", "<500us",
+			"<1ms", "<2ms", "<4ms", "<8ms", "<16ms", ">=16ms");
+	for (i = 0; i < HIBERNATION_PATH_MAX; i++) {
+		seq_printf(s, "%12s:", path_names[i]);
+		for (j = 0; j < HIBERNATION_EXIT_HIST_BUCKETS; j++)
+			seq_printf(s, " %7u", hiber->exit_hist[i][j]);
+		seq_puts(s, "\n");
+	}
+
+	seq_printf(s, "first frame:  %8s%8s%8s%8s%8s%8s%8s%8s (early wake %s)\n", "<1ms",
+			"<2ms", "<4ms", "<8ms", "<16ms", "<32ms", "<64ms", ">=64ms",
+			hiber->early_wake_enabled ? "enabled" : "disabled");
+	for (i = 0; i < HIBERNATION_WAKE_MAX; i++) {
+		seq_printf(s, "%12s:", wake_names[i]);
+		for (j = 0; j < HIBERNATION_WAKE_HIST_BUCKETS; j++)
+			seq_printf(s, " %7u", hiber->wake_hist[i][j]);
+		seq_puts(s, "\n");
+	}
 
 	return 0;
 }
@@ -1616,6 +2261,108 @@ static const struct file_operations force_te_fops = {
 	.release = seq_release,
 };
 
+/* writing enables or disables frame pacing, and resets the statistics */
+static ssize_t frame_pacing_write(struct file *file, const char __user *buffer,
+				  size_t len, loff_t *ppos)
+{
+	struct seq_file *s = file->private_data;
+	struct decon_device *decon = s->private;
+	struct decon_pacing *pacing = &decon->pacing;
+	unsigned long flags;
+	int ret;
+	bool en;
+
+	ret = kstrtobool_from_user(buffer, len, &en);
+	if (ret)
+		return ret;
+
+	spin_lock_irqsave(&decon->slock, flags);
+	if (en && !pacing->enabled)
+		pacing->setup_ns = DECON_PACING_SETUP_INIT_NS;
+	pacing->enabled = en;
+	pacing->target_te = 0;
+	pacing->margin_us = 0;
+	pacing->min_margin_us = 0;
+	pacing->frame_cnt = 0;
+	pacing->slip_cnt = 0;
+	spin_unlock_irqrestore(&decon->slock, flags);
+
+	return len;
+}
+
+static int frame_pacing_show(struct seq_file *s, void *unused)
+{
+	struct decon_device *decon = s->private;
+	struct decon_pacing pacing;
+	unsigned long flags;
+
+	spin_lock_irqsave(&decon->slock, flags);
+	pacing = decon->pacing;
+	spin_unlock_irqrestore(&decon->slock, flags);
+
+	seq_printf(s, "enabled: %d\n", pacing.enabled);
+	seq_printf(s, "setup: %u us\n", pacing.setup_ns / NSEC_PER_USEC);
+	seq_printf(s, "margin: %d us (min %d us)\n", pacing.margin_us, pacing.min_margin_us);
+	seq_printf(s, "frames: %u slipped: %u\n", pacing.frame_cnt, pacing.slip_cnt);
+
+	return 0;
+}
+
+static int frame_pacing_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, frame_pacing_show, inode->i_private);
+}
+
+static const struct file_operations frame_pacing_fops = {
+	.owner = THIS_MODULE,
+	.open = frame_pacing_open,
+	.write = frame_pacing_write,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static int fence_latency_show(struct seq_file *s, void *unused)
+{
+	struct decon_device *decon = s->private;
+	const struct fence_latency *fl = &decon->crtc->fence_latency;
+	static const char * const path_names[FENCE_LATENCY_PATH_MAX] = {
+		[FENCE_LATENCY_BLOCKING] = "blocking",
+		[FENCE_LATENCY_DEFERRED] = "deferred",
+	};
+	int i, j;
+
+	seq_printf(s, "defer fences %s\n", decon->crtc->defer_fences ? "enabled" : "disabled");
+	for (i = 0; i < FENCE_LATENCY_PATH_MAX; i++)
+		seq_printf(s, "%s: frames(%u) avg(%uus) max(%uus)\n", path_names[i],
+			   fl->cnt[i], fence_latency_avg_us(fl, i), fl->max_us[i]);
+
+	seq_printf(s, "fence to trigger: %7s%7s%7s%7s%7s%7s%7s%7s%7s%7s\n", "<125us",
+			"<250us", "<500us", "<1ms", "<2ms", "<4ms", "<8ms", "<16ms",
+			"<32ms", ">=32ms");
+	for (i = 0; i < FENCE_LATENCY_PATH_MAX; i++) {
+		seq_printf(s, "%16s:", path_names[i]);
+		for (j = 0; j < FENCE_LATENCY_HIST_BUCKETS; j++)
+			seq_printf(s, " %6u", fl->hist[i][j]);
+		seq_puts(s, "\n");
+	}
+
+	return 0;
+}
+
+static int fence_latency_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, fence_latency_show, inode->i_private);
+}
+
+static const struct file_operations fence_latency_fops = {
+	.owner = THIS_MODULE,
+	.open = fence_latency_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
 int dpu_init_debug(struct decon_device *decon)
 {
 	int i;
@@ -1642,7 +2389,6 @@ int dpu_init_debug(struct decon_device *decon)
 		DRM_INFO("#%d event log buffers are allocated\n", event_cnt);
 		break;
 	}
-	spin_lock_init(&decon->d.event_lock);
 	decon->d.event_log_cnt = event_cnt;
 	atomic_set(&decon->d.event_log_idx, -1);
 
@@ -1660,9 +2406,21 @@ int dpu_init_debug(struct decon_device *decon)
 		goto err_event_log;
 	}
 
-	if (decon->hibernation)
+	debugfs_create_file("event_raw", 0400, crtc->debugfs_entry, decon,
+			&dpu_event_raw_fops);
+	debugfs_create_file("event_filter", 0664, crtc->debugfs_entry, decon,
+			&dpu_event_filter_fops);
+
+	if (decon->hibernation) {
 		debugfs_create_file("hibernation", 0664, crtc->debugfs_entry, decon,
 				&hibernation_fops);
+		debugfs_create_bool("fast_hibernation", 0664, crtc->debugfs_entry,
+				&decon->hibernation->fast_enabled);
+		debugfs_create_bool("adaptive_hibernation", 0664, crtc->debugfs_entry,
+				&decon->hibernation->policy.enabled);
+		debugfs_create_bool("early_wake", 0664, crtc->debugfs_entry,
+				&decon->hibernation->early_wake_enabled);
+	}
 
 	if (!debugfs_create_file("recovery", 0644, crtc->debugfs_entry, decon,
 				&recovery_fops)) {
@@ -1676,6 +2434,12 @@ int dpu_init_debug(struct decon_device *decon)
 		pr_warn("unable to add decon_debug sysfs files (%d)\n", ret);
 
 	debugfs_create_file("force_te_on", 0664, crtc->debugfs_entry, decon, &force_te_fops);
+	debugfs_create_file("frame_pacing", 0664, crtc->debugfs_entry, decon,
+			    &frame_pacing_fops);
+	debugfs_create_bool("defer_fences", 0664, crtc->debugfs_entry,
+			    &decon->crtc->defer_fences);
+	debugfs_create_file("fence_latency", 0444, crtc->debugfs_entry, decon,
+			    &fence_latency_fops);
 	debugfs_create_u32("underrun_cnt", 0664, crtc->debugfs_entry, &decon->d.underrun_cnt);
 	debugfs_create_u32("crc_cnt", 0444, crtc->debugfs_entry, &decon->d.crc_cnt);
 	debugfs_create_u32("ecc_cnt", 0444, crtc->debugfs_entry, &decon->d.ecc_cnt);
@@ -2082,6 +2846,127 @@ static const struct file_operations dphy_diag_reg_fops = {
 	.release = single_release,
 };
 
+static int dsim_cmd_prof_show(struct seq_file *m, void *data)
+{
+	static const char * const stages[DSIM_CMD_PROF_STAGE_MAX] = {
+		[DSIM_CMD_PROF_QUEUE]	= "queue",
+		[DSIM_CMD_PROF_VBLANK]	= "vblank",
+		[DSIM_CMD_PROF_FIFO]	= "fifo",
+	};
+	struct dsim_device *dsim = m->private;
+	const struct dsim_cmd_prof *prof = dsim->cmd_prof;
+	int i, j, k;
+
+	mutex_lock(&dsim->cmd_lock);
+
+	seq_printf(m, "dropped: %u\n", prof->dropped);
+	seq_puts(m, "type opcode   count  stage    avg(us)    max(us)  log2(us) histogram\n");
+
+	for (i = 0; i < DSIM_CMD_PROF_SLOTS; i++) {
+		const struct dsim_cmd_prof_entry *e = &prof->entries[i];
+
+		if (!e->used || !e->cnt)
+			continue;
+
+		for (j = 0; j < DSIM_CMD_PROF_STAGE_MAX; j++) {
+			seq_printf(m, "0x%02x   0x%02x %7u %6s %10llu %10llu ",
+				   e->type, e->opcode, e->cnt, stages[j],
+				   div_u64(div_u64(e->total_ns[j], e->cnt), NSEC_PER_USEC),
+				   div_u64(e->max_ns[j], NSEC_PER_USEC));
+			for (k = 0; k < DSIM_CMD_PROF_BUCKETS; k++)
+				seq_printf(m, " %u", e->hist[j][k]);
+			seq_puts(m, "\n");
+		}
+	}
+
+	mutex_unlock(&dsim->cmd_lock);
+
+	return 0;
+}
+
+static int dsim_cmd_prof_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, dsim_cmd_prof_show, inode->i_private);
+}
+
+/* writing anything clears the histograms */
+static ssize_t dsim_cmd_prof_write(struct file *file, const char __user *user_buf,
+				   size_t count, loff_t *f_pos)
+{
+	struct seq_file *m = file->private_data;
+	struct dsim_device *dsim = m->private;
+	struct dsim_cmd_prof *prof = dsim->cmd_prof;
+
+	mutex_lock(&dsim->cmd_lock);
+	memset(prof->entries, 0, sizeof(prof->entries));
+	prof->dropped = 0;
+	mutex_unlock(&dsim->cmd_lock);
+
+	return count;
+}
+
+static const struct file_operations dsim_cmd_prof_fops = {
+	.owner = THIS_MODULE,
+	.open = dsim_cmd_prof_open,
+	.write = dsim_cmd_prof_write,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static int dsim_pll_table_show(struct seq_file *m, void *data)
+{
+	struct dsim_device *dsim = m->private;
+	const struct dsim_pll_params *pll_params = dsim->pll_params;
+	const struct dsim_pll_features *f = pll_params->features;
+	const struct dsim_pll_table *table = &pll_params->table;
+	const struct dsim_pll_cand *c;
+	u32 i;
+
+	seq_printf(m, "fin %llu fopt %llu fout %llu-%llu fvco %llu-%llu k_bits %u\n",
+		   f->finput, f->foptimum, f->fout_min, f->fout_max,
+		   f->fvco_min, f->fvco_max, f->k_bits);
+
+	/* panel modes come with their own PMSK, show how they compare to the solver */
+	seq_puts(m, "mode                    hs(MHz)    p    m  s      k | p    m  s      k\n");
+	for (i = 0; i < pll_params->num_modes; i++) {
+		const struct dsim_pll_param *p = pll_params->params[i];
+
+		seq_printf(m, "%-22s %8u %4u %4u %2u %6u |", p->name, p->pll_freq,
+			   p->p, p->m, p->s, p->k);
+		c = dsim_pll_table_lookup(table, p->pll_freq);
+		if (c)
+			seq_printf(m, " %u %4u %2u %6u\n", c->p, c->m, c->s, c->k);
+		else
+			seq_puts(m, " -\n");
+	}
+
+	seq_puts(m, "hs(MHz)    p    m  s      k  cands  err(Hz)     cost\n");
+	for (i = 0; i < table->num; i++) {
+		c = &table->cands[i];
+		if (!c->cand_cnt)
+			continue;
+
+		seq_printf(m, "%7u %4u %4u %2u %6u %6u %8u %8u\n", table->min_mhz + i,
+			   c->p, c->m, c->s, c->k, c->cand_cnt, c->err_hz, c->cost);
+	}
+
+	return 0;
+}
+
+static int dsim_pll_table_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, dsim_pll_table_show, inode->i_private);
+}
+
+static const struct file_operations dsim_pll_table_fops = {
+	.owner = THIS_MODULE,
+	.open = dsim_pll_table_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
 void dsim_diag_create_debugfs(struct dsim_device *dsim) {
 	struct dentry *dent_dphy;
 	struct dentry *dent_diag;
@@ -2098,6 +2983,22 @@ void dsim_diag_create_debugfs(struct dsim_device *dsim) {
 	}
 
 	debugfs_create_u32("state", 0400, dsim->debugfs_entry, &dsim->state);
+	debugfs_create_u32("cmd_batch_flush_cnt", 0444, dsim->debugfs_entry,
+			   &dsim->commit_batch.flush_cnt);
+	debugfs_create_u32("cmd_batch_merged", 0444, dsim->debugfs_entry,
+			   &dsim->commit_batch.merged_total);
+	debugfs_create_u32("cmd_batch_other_cnt", 0444, dsim->debugfs_entry,
+			   &dsim->commit_batch.other_cnt);
+
+	if (!dsim->cmd_prof)
+		dsim->cmd_prof = devm_kzalloc(dsim->dev, sizeof(*dsim->cmd_prof), GFP_KERNEL);
+	if (dsim->cmd_prof)
+		debugfs_create_file("cmd_prof", 0664, dsim->debugfs_entry, dsim,
+				    &dsim_cmd_prof_fops);
+
+	if (dsim->pll_params && dsim->pll_params->features)
+		debugfs_create_file("pll_table", 0444, dsim->debugfs_entry, dsim,
+				    &dsim_pll_table_fops);
 
 	if (dsim->config.num_dphy_diags == 0)
 		return;
@@ -77,7 +77,7 @@ static void decon_seamless_mode_set(struct exynos_drm_crtc *exynos_crtc,
 				    struct drm_crtc_state *old_crtc_state);
 static int decon_request_te_irq(struct exynos_drm_crtc *exynos_crtc,
 				const struct exynos_drm_connector_state *exynos_conn_state);
-static bool decon_check_fs_pending_locked(struct decon_device *decon);
+static bool decon_check_fs_pending(struct decon_device *decon);
 
 #define FRAME_TIMEOUT msecs_to_jiffies(100)
 
@@ -536,6 +536,7 @@ static int decon_atomic_check(struct exynos_drm_crtc *exynos_crtc,
 	 * is pushed out (if needed) ahead of commit
 	 */
 	if (crtc_state->active) {
+		hibernation_early_wake(decon->hibernation);
 		hibernation_block(decon->hibernation);
 		hibernation_unblock_enter(decon->hibernation);
 
@@ -712,33 +713,33 @@ static void decon_disable_plane(struct exynos_drm_crtc *exynos_crtc,
 	decon_debug(decon, "%s -\n", __func__);
 }
 
-static void decon_send_vblank_event_locked(struct decon_device *decon)
+static void decon_signal_vblank_event(struct decon_device *decon,
+				      struct drm_pending_vblank_event *event)
 {
 	struct drm_crtc *crtc = &decon->crtc->base;
 	struct drm_device *dev = crtc->dev;
+	unsigned long flags;
 
-	if (!decon->event)
-		return;
-
-	spin_lock(&dev->event_lock);
-	drm_send_event_locked(dev, &decon->event->base);
-	spin_unlock(&dev->event_lock);
+	spin_lock_irqsave(&dev->event_lock, flags);
+	drm_send_event_locked(dev, &event->base);
+	spin_unlock_irqrestore(&dev->event_lock, flags);
 
 	drm_crtc_vblank_put(crtc);
-
-	decon->event = NULL;
 }
 
+/*
+ * The armed vblank event is handed over through decon->event with xchg, whoever
+ * takes it out is the only one to signal it.
+ */
 void decon_force_vblank_event(struct decon_device *decon)
 {
-	unsigned long flags;
+	struct drm_pending_vblank_event *event = xchg(&decon->event, NULL);
 
-	spin_lock_irqsave(&decon->slock, flags);
-	decon_send_vblank_event_locked(decon);
-	spin_unlock_irqrestore(&decon->slock, flags);
+	if (event)
+		decon_signal_vblank_event(decon, event);
 }
 
-static void decon_arm_event_locked(struct exynos_drm_crtc *exynos_crtc)
+static void decon_arm_event(struct exynos_drm_crtc *exynos_crtc)
 {
 	struct drm_crtc *crtc = &exynos_crtc->base;
 	struct decon_device *decon = exynos_crtc->ctx;
@@ -749,12 +750,12 @@ static void decon_arm_event_locked(struct exynos_drm_crtc *exynos_crtc)
 
 	crtc->state->event = NULL;
 
-	/* in the rare case that event wasn't signaled before, signal it now */
-	if (WARN_ON(decon->event))
-		decon_send_vblank_event_locked(decon);
-
 	WARN_ON(drm_crtc_vblank_get(crtc) != 0);
-	decon->event = event;
+	event = xchg(&decon->event, event);
+
+	/* in the rare case that event wasn't signaled before, signal it now */
+	if (WARN_ON(event))
+		decon_signal_vblank_event(decon, event);
 }
 
 #define VSYNC_PERIOD_VARIANCE_NS		2000000
@@ -800,6 +801,126 @@ static void decon_wait_earliest_process_time(
 	}
 }
 
+#define PACING_GUARD_NS		500000
+#define PACING_SLACK_NS		1000000
+#define PACING_SETUP_MIN_NS	100000
+#define PACING_SETUP_MAX_NS	4000000
+#define PACING_SETUP_STEP_NS	100000
+#define PACING_MAX_PERIODS	10
+
+static inline bool decon_pacing_supported(const struct decon_device *decon)
+{
+	return decon->pacing.enabled &&
+		decon->config.mode.op_mode == DECON_COMMAND_MODE &&
+		decon->config.mode.trig_mode == DECON_HW_TRIG;
+}
+
+/*
+ * Delays the trigger until the latest safe point before the TE the frame is
+ * expected to be presented on. Returns false if the TE timing isn't known,
+ * the caller falls back to the nominal refresh period then.
+ */
+static bool decon_pace_frame(struct decon_device *decon,
+			     const struct exynos_drm_crtc_state *new_exynos_crtc_state)
+{
+	const struct decon_pacing *pacing = &decon->pacing;
+	const ktime_t expected_present_time = new_exynos_crtc_state->expected_present_time;
+	ktime_t now, last_te, target_te, trig_time;
+	s64 delay_us;
+	u32 period_ns;
+	u64 cnt;
+
+	if (!decon_pacing_supported(decon))
+		return false;
+
+	now = ktime_get();
+	if (!exynos_drm_crtc_te_predict(&decon->crtc->base, now, &last_te, &period_ns))
+		return false;
+
+	/* no target, or already late for it: trigger right away */
+	if (!expected_present_time || ktime_before(expected_present_time, last_te))
+		return true;
+
+	cnt = DIV_ROUND_CLOSEST_ULL(ktime_to_ns(ktime_sub(expected_present_time, last_te)),
+				    period_ns);
+	if (cnt <= 1)
+		return true;
+
+	if (cnt > PACING_MAX_PERIODS) {
+		pr_warn("expected present time seems incorrect(now %llu, expected %llu)\n",
+			now, expected_present_time);
+		cnt = PACING_MAX_PERIODS;
+	}
+
+	/* latest safe point, but never before the TE preceding the target */
+	target_te = ktime_add_ns(last_te, cnt * period_ns);
+	trig_time = ktime_sub_ns(target_te, pacing->setup_ns + PACING_SLACK_NS);
+	trig_time = max(trig_time, ktime_sub_ns(target_te, period_ns - PACING_GUARD_NS));
+
+	delay_us = ktime_us_delta(trig_time, now);
+	if (delay_us > 0) {
+		DPU_ATRACE_BEGIN("wait for paced trigger");
+		usleep_range(delay_us, delay_us + 10);
+		DPU_ATRACE_END("wait for paced trigger");
+	}
+
+	return true;
+}
+
+/* records the deadline of the frame just triggered */
+static void decon_pacing_trigger_locked(struct decon_device *decon)
+{
+	struct decon_pacing *pacing = &decon->pacing;
+	ktime_t now, last_te;
+	u32 period_ns;
+	s64 margin_ns;
+
+	pacing->target_te = 0;
+	if (!decon_pacing_supported(decon))
+		return;
+
+	now = ktime_get();
+	if (!exynos_drm_crtc_te_predict(&decon->crtc->base, now, &last_te, &period_ns))
+		return;
+
+	pacing->trig_ts = now;
+	pacing->target_te = ktime_add_ns(last_te, period_ns);
+	pacing->period_ns = period_ns;
+
+	margin_ns = ktime_to_ns(ktime_sub(pacing->target_te, now)) - pacing->setup_ns;
+	pacing->margin_us = div_s64(margin_ns, NSEC_PER_USEC);
+	if (!pacing->frame_cnt || pacing->margin_us < pacing->min_margin_us)
+		pacing->min_margin_us = pacing->margin_us;
+	pacing->frame_cnt++;
+
+	DPU_ATRACE_INT_PID("frame_pacing_margin_us", pacing->margin_us, decon->thread->pid);
+}
+
+/* checks the frame started on the TE it was meant for, and adjusts setup time */
+static void decon_pacing_frame_start_locked(struct decon_device *decon)
+{
+	struct decon_pacing *pacing = &decon->pacing;
+	s64 lead_ns, late_ns;
+
+	if (!pacing->target_te)
+		return;
+
+	lead_ns = ktime_to_ns(ktime_sub(pacing->target_te, pacing->trig_ts));
+	late_ns = ktime_to_ns(ktime_sub(ktime_get(), pacing->target_te));
+	if (late_ns > pacing->period_ns / 2) {
+		/* the frame needed more than @lead_ns to catch the TE */
+		pacing->slip_cnt++;
+		pacing->setup_ns = clamp_t(s64, lead_ns + PACING_SETUP_STEP_NS,
+					   pacing->setup_ns, PACING_SETUP_MAX_NS);
+		DPU_ATRACE_INT_PID("frame_pacing_slip", pacing->slip_cnt & 1, decon->thread->pid);
+	} else if (lead_ns < pacing->setup_ns) {
+		/* made it with less lead time than required so far */
+		pacing->setup_ns = max_t(s64, lead_ns, PACING_SETUP_MIN_NS);
+	}
+
+	pacing->target_te = 0;
+}
+
 static void decon_atomic_flush(struct exynos_drm_crtc *exynos_crtc,
 		struct drm_crtc_state *old_crtc_state)
 {
@@ -813,6 +934,7 @@ static void decon_atomic_flush(struct exynos_drm_crtc *exynos_crtc,
 	struct exynos_partial *partial = decon->partial;
 	u32 width, height;
 	unsigned long flags;
+	ktime_t trigger_ts;
 
 	decon_debug(decon, "%s +\n", __func__);
 
@@ -820,6 +942,17 @@ static void decon_atomic_flush(struct exynos_drm_crtc *exynos_crtc,
 			decon->config.out_type == DECON_OUT_WB)
 		return;
 
+	/*
+	 * planes were programmed before their fences signaled, nothing is latched
+	 * until the update below, so drop the frame if a fence didn't signal
+	 */
+	if (exynos_atomic_wait_for_deferred_fences(old_crtc_state->state,
+						   &exynos_crtc->base) == -ETIMEDOUT &&
+	    !new_exynos_crtc_state->skip_update) {
+		new_exynos_crtc_state->skip_update = true;
+		decon_warn(decon, "skip frame update, fences timed out\n");
+	}
+
 	if (new_exynos_crtc_state->skip_update) {
 		/* for seamless mode change, change pipeline but skip update from decon */
 		if (new_exynos_crtc_state->seamless_mode_changed)
@@ -894,15 +1027,29 @@ static void decon_atomic_flush(struct exynos_drm_crtc *exynos_crtc,
 	if (new_exynos_crtc_state->seamless_mode_changed)
 		decon_seamless_mode_set(exynos_crtc, old_crtc_state);
 
-	decon_wait_earliest_process_time(old_exynos_crtc_state, new_exynos_crtc_state);
+	if (!decon_pace_frame(decon, new_exynos_crtc_state))
+		decon_wait_earliest_process_time(old_exynos_crtc_state, new_exynos_crtc_state);
 
 	spin_lock_irqsave(&decon->slock, flags);
 	decon_reg_start(decon->id, &decon->config);
+	trigger_ts = ktime_get();
+	decon_pacing_trigger_locked(decon);
 	atomic_inc(&decon->frames_pending);
+	/*
+	 * frame start irq takes the event under slock as well, so a frame start of
+	 * the previous frame can't take the event armed here
+	 */
 	if (!new_crtc_state->no_vblank)
-		decon_arm_event_locked(exynos_crtc);
+		decon_arm_event(exynos_crtc);
 	spin_unlock_irqrestore(&decon->slock, flags);
 
+	if (new_exynos_crtc_state->fences_ready_ts)
+		fence_latency_record(&exynos_crtc->fence_latency,
+				new_exynos_crtc_state->fences_deferred ?
+				FENCE_LATENCY_DEFERRED : FENCE_LATENCY_BLOCKING,
+				ktime_to_ns(new_exynos_crtc_state->fences_ready_ts),
+				ktime_to_ns(trigger_ts));
+
 	DPU_EVENT_LOG(DPU_EVT_ATOMIC_FLUSH, decon->id, NULL);
 
 	decon_debug(decon, "%s -\n", __func__);
@@ -1015,6 +1162,7 @@ static void decon_mode_update_bts(struct decon_device *decon,
 		    mode->hdisplay, mode->vdisplay, decon->bts.fps);
 
 	atomic_set(&decon->bts.delayed_update, 0);
+	decon->bts.dirty = DPU_BTS_DIRTY_ALL;
 
 	if (decon->state == DECON_STATE_HANDOVER)
 		_decon_mode_update_bts_handover(decon, mode);
@@ -1169,6 +1317,7 @@ static void _decon_stop_locked(struct decon_device *decon, bool reset, u32 vrefr
 
 	decon->bts.rcd_win_config.win.state = DPU_WIN_STATE_DISABLED;
 	decon->bts.rcd_win_config.dma_addr = 0;
+	decon->bts.dirty = DPU_BTS_DIRTY_ALL;
 
 	_decon_reinit_locked(decon);
 
@@ -1336,6 +1485,14 @@ static u32 _decon_get_current_fps(struct decon_device *decon)
 	return min_t(u32, decon->bts.fps, drm_mode_vrefresh(&crtc_state->mode)) ?: 60;
 }
 
+/* wait for the frame being transferred, if any, returns false on timeout */
+bool decon_wait_for_frame_idle(struct decon_device *decon)
+{
+	return wait_event_timeout(decon->framedone_wait,
+				  !atomic_read(&decon->frames_pending),
+				  fps_timeout(_decon_get_current_fps(decon))) > 0;
+}
+
 static bool _decon_wait_for_framedone(struct decon_device *decon)
 {
 	const u32 fps = _decon_get_current_fps(decon);
@@ -1346,6 +1503,9 @@ static bool _decon_wait_for_framedone(struct decon_device *decon)
 				 atomic_read(&decon->frames_pending) == 0 ||
 				 decon_reg_is_idle(decon->id),
 				 timeout);
+	/* frame done irq thread may still be reading the DQE registers */
+	synchronize_irq(decon->irq_fd);
+
 	if (!ret) {
 		WARN(1, "decon%d: wait for frame done timed out (%dhz)", decon->id, fps);
 		return true;
@@ -1442,6 +1602,87 @@ static void decon_disable(struct exynos_drm_crtc *crtc)
 	decon_info(decon, "%s -\n", __func__);
 }
 
+/*
+ * Fast path hibernation powers DECON and DSIM down while the CRTC stays active
+ * in DRM state, so it doesn't need an atomic commit. It's only used from the
+ * hibernation worker with the CRTC lock held, see exynos_hibernation_enter().
+ */
+int decon_fast_hibernation_enter(struct decon_device *decon)
+{
+	const struct drm_crtc_state *crtc_state = decon->crtc->base.state;
+	struct decon_fast_hibernation *fast = &decon->fast_hiber;
+	struct drm_encoder *encoder;
+
+	if (decon->state != DECON_STATE_ON)
+		return -EINVAL;
+
+	/* DSIM is about to go into ULPS, don't wait for the last frame here */
+	if (atomic_read(&decon->frames_pending))
+		return -EBUSY;
+
+	DPU_ATRACE_BEGIN(__func__);
+
+	fast->encoder_mask = crtc_state->encoder_mask;
+	memcpy(fast->win_config, decon->bts.win_config, sizeof(fast->win_config));
+	fast->rcd_win_config = decon->bts.rcd_win_config;
+
+	/* same order as a self refresh commit, DSIM enters ULPS on runtime suspend */
+	drm_for_each_encoder_mask(encoder, decon->drm_dev, fast->encoder_mask) {
+		if (encoder->encoder_type == DRM_MODE_ENCODER_DSI)
+			pm_runtime_put_sync(encoder_to_dsim(encoder)->dev);
+	}
+
+	decon_enter_hibernation(decon);
+
+	if (IS_ENABLED(CONFIG_EXYNOS_BTS))
+		decon->bts.ops->release_bw(decon);
+
+	DPU_ATRACE_END(__func__);
+
+	return 0;
+}
+
+void decon_fast_hibernation_exit(struct decon_device *decon)
+{
+	struct exynos_drm_crtc *exynos_crtc = decon->crtc;
+	const struct drm_crtc_state *crtc_state = exynos_crtc->base.state;
+	struct decon_fast_hibernation *fast = &decon->fast_hiber;
+	struct drm_encoder *encoder;
+	struct drm_plane *plane;
+
+	if (decon->state != DECON_STATE_HIBERNATION)
+		return;
+
+	DPU_ATRACE_BEGIN(__func__);
+
+	if (IS_ENABLED(CONFIG_EXYNOS_BTS)) {
+		memcpy(decon->bts.win_config, fast->win_config, sizeof(fast->win_config));
+		decon->bts.rcd_win_config = fast->rcd_win_config;
+		decon->bts.ops->calc_bw(decon);
+		decon->bts.prefetch.replay = true;
+		decon->bts.ops->update_bw(decon, false);
+		decon->bts.prefetch.replay = false;
+	}
+
+	decon_exit_hibernation(decon);
+
+	drm_for_each_encoder_mask(encoder, decon->drm_dev, fast->encoder_mask) {
+		if (encoder->encoder_type == DRM_MODE_ENCODER_DSI)
+			pm_runtime_get_sync(encoder_to_dsim(encoder)->dev);
+	}
+
+	/*
+	 * windows and DPPs were reset on entry, program them again from the current
+	 * plane states, they are latched with the next frame
+	 */
+	drm_for_each_plane_mask(plane, decon->drm_dev, crtc_state->plane_mask) {
+		if (plane->state->visible)
+			decon_update_plane(exynos_crtc, to_exynos_plane(plane));
+	}
+
+	DPU_ATRACE_END(__func__);
+}
+
 static void decon_wait_for_flip_done(struct exynos_drm_crtc *crtc,
 				const struct drm_crtc_state *old_crtc_state,
 				const struct drm_crtc_state *new_crtc_state)
@@ -1464,14 +1705,7 @@ static void decon_wait_for_flip_done(struct exynos_drm_crtc *crtc,
 		fps = min(fps, drm_mode_vrefresh(&old_crtc_state->mode));
 
 	if (!wait_for_completion_timeout(&commit->flip_done, fps_timeout(fps))) {
-		unsigned long flags;
-		bool fs_irq_pending;
-
-		spin_lock_irqsave(&decon->slock, flags);
-		fs_irq_pending = decon_check_fs_pending_locked(decon);
-		spin_unlock_irqrestore(&decon->slock, flags);
-
-		if (!fs_irq_pending) {
+		if (!decon_check_fs_pending(decon)) {
 			DPU_EVENT_LOG(DPU_EVT_FRAMESTART_TIMEOUT, decon->id, NULL);
 			recovering = atomic_read(&decon->recovery.recovering);
 			decon_err(decon, "framestart timeout (%dhz), recovering: %d, pending: %d\n",
@@ -1561,6 +1795,32 @@ static ssize_t early_wakeup_store(struct device *dev,
 }
 static DEVICE_ATTR_RW(early_wakeup);
 
+static ssize_t bts_prefetch_show(struct device *dev,
+			struct device_attribute *attr, char *buf)
+{
+	const struct decon_device *decon = dev_get_drvdata(dev);
+
+	return scnprintf(buf, PAGE_SIZE, "%u\n", READ_ONCE(decon->bts.prefetch.idle_frames));
+}
+
+/* frames of lower demand before votes are lowered, 0 disables prefetch */
+static ssize_t bts_prefetch_store(struct device *dev,
+			struct device_attribute *attr, const char *buf, size_t len)
+{
+	struct decon_device *decon = dev_get_drvdata(dev);
+	u32 idle_frames;
+	int ret;
+
+	ret = kstrtou32(buf, 0, &idle_frames);
+	if (ret)
+		return ret;
+
+	WRITE_ONCE(decon->bts.prefetch.idle_frames, idle_frames);
+
+	return len;
+}
+static DEVICE_ATTR_RW(bts_prefetch);
+
 static int decon_bind(struct device *dev, struct device *master, void *data)
 {
 	struct decon_device *decon = dev_get_drvdata(dev);
@@ -1619,6 +1879,8 @@ static int decon_bind(struct device *dev, struct device *master, void *data)
 			  (const char *) symlink_name_buffer);
 
 	device_create_file(dev, &dev_attr_early_wakeup);
+	if (IS_ENABLED(CONFIG_EXYNOS_BTS))
+		device_create_file(dev, &dev_attr_bts_prefetch);
 	decon_debug(decon, "%s -\n", __func__);
 	return 0;
 }
@@ -1636,6 +1898,8 @@ static void decon_unbind(struct device *dev, struct device *master,
 			  (const char *) symlink_name_buffer);
 
 	device_remove_file(dev, &dev_attr_early_wakeup);
+	if (IS_ENABLED(CONFIG_EXYNOS_BTS))
+		device_remove_file(dev, &dev_attr_bts_prefetch);
 	if (IS_ENABLED(CONFIG_EXYNOS_BTS))
 		decon->bts.ops->deinit(decon);
 
@@ -1648,9 +1912,49 @@ static const struct component_ops decon_component_ops = {
 	.unbind = decon_unbind,
 };
 
+/*
+ * Frame done work which doesn't need to run in the hard irq. It runs in the
+ * frame done irq thread, frames_pending is only released here so that the
+ * waiters for frame done don't power off while the DQE registers are read.
+ *
+ * A waiter may still see DECON idle and power it off before a late frame done
+ * gets here, the DQE registers are only read if DECON is still on. The state
+ * changes with slock held, in the same section that drops the power vote.
+ */
+static void decon_handle_framedone(struct decon_device *decon)
+{
+	int cnt = atomic_xchg(&decon->framedone_cnt, 0);
+	unsigned long flags;
+
+	if (!cnt)
+		return;
+
+	hibernation_frame_done(decon->hibernation);
+
+	spin_lock_irqsave(&decon->slock, flags);
+	if (decon->state == DECON_STATE_ON)
+		exynos_dqe_save_lpd_data(decon->dqe);
+	while (cnt--)
+		atomic_dec_if_positive(&decon->frames_pending);
+	if (decon->dqe && decon->state == DECON_STATE_ON)
+		handle_histogram_event(decon->dqe);
+	spin_unlock_irqrestore(&decon->slock, flags);
+
+	wake_up_all(&decon->framedone_wait);
+	decon_debug(decon, "%s: frame done\n", __func__);
+}
+
+static irqreturn_t decon_irq_thread(int irq, void *dev_data)
+{
+	decon_handle_framedone(dev_data);
+
+	return IRQ_HANDLED;
+}
+
 static irqreturn_t decon_irq_handler(int irq, void *dev_data)
 {
 	struct decon_device *decon = dev_data;
+	irqreturn_t ret = IRQ_HANDLED;
 	u32 irq_sts_reg;
 	u32 ext_irq = 0;
 
@@ -1667,12 +1971,8 @@ static irqreturn_t decon_irq_handler(int irq, void *dev_data)
 	if (irq_sts_reg & DPU_FRAME_DONE_INT_PEND) {
 		DPU_ATRACE_INT_PID("frame_transfer", 0, decon->thread->pid);
 		DPU_EVENT_LOG(DPU_EVT_DECON_FRAMEDONE, decon->id, decon);
-		exynos_dqe_save_lpd_data(decon->dqe);
-		atomic_dec_if_positive(&decon->frames_pending);
-		if (decon->dqe)
-			handle_histogram_event(decon->dqe);
-		wake_up_all(&decon->framedone_wait);
-		decon_debug(decon, "%s: frame done\n", __func__);
+		atomic_inc(&decon->framedone_cnt);
+		ret = IRQ_WAKE_THREAD;
 	}
 
 	if (irq_sts_reg & INT_PEND_DQE_DIMMING_START) {
@@ -1686,7 +1986,7 @@ static irqreturn_t decon_irq_handler(int irq, void *dev_data)
 
 	if (irq_sts_reg & INT_PEND_DQE_DIMMING_END) {
 		decon->keep_unmask = false;
-		if (!decon->event && decon->config.mode.op_mode == DECON_COMMAND_MODE)
+		if (!READ_ONCE(decon->event) && decon->config.mode.op_mode == DECON_COMMAND_MODE)
 			decon_reg_set_trigger(decon->id, &decon->config.mode,
 					DECON_TRIG_MASK);
 
@@ -1704,42 +2004,51 @@ static irqreturn_t decon_irq_handler(int irq, void *dev_data)
 
 irq_end:
 	spin_unlock(&decon->slock);
-	return IRQ_HANDLED;
-}
 
-static bool decon_check_fs_pending_locked(struct decon_device *decon)
-{
-	u32 pending_irq;
+	/* frame done status may be reported with the other decon interrupts too */
+	if (ret == IRQ_WAKE_THREAD && irq != decon->irq_fd) {
+		decon_handle_framedone(decon);
+		ret = IRQ_HANDLED;
+	}
 
-	if (decon->state != DECON_STATE_ON)
-		return false;
+	return ret;
+}
 
-	pending_irq = decon_reg_get_fs_interrupt_and_clear(decon->id);
+static bool decon_check_fs_pending(struct decon_device *decon)
+{
+	struct drm_pending_vblank_event *event = NULL;
+	unsigned long flags;
+	u32 pending_irq = 0;
 
+	spin_lock_irqsave(&decon->slock, flags);
+	if (decon->state == DECON_STATE_ON)
+		pending_irq = decon_reg_get_fs_interrupt_and_clear(decon->id);
 	if (pending_irq & DPU_FRAME_START_INT_PEND) {
-		DPU_ATRACE_INT_PID("frame_transfer", 1, decon->thread->pid);
-		DPU_EVENT_LOG(DPU_EVT_DECON_FRAMESTART, decon->id, decon);
-		decon_send_vblank_event_locked(decon);
-		if (decon->config.mode.op_mode == DECON_VIDEO_MODE)
-			drm_crtc_handle_vblank(&decon->crtc->base);
-
-		return true;
+		decon_pacing_frame_start_locked(decon);
+		event = xchg(&decon->event, NULL);
 	}
+	spin_unlock_irqrestore(&decon->slock, flags);
 
-	return false;
-}
+	if (!(pending_irq & DPU_FRAME_START_INT_PEND))
+		return false;
 
+	DPU_ATRACE_INT_PID("frame_transfer", 1, decon->thread->pid);
+	DPU_EVENT_LOG(DPU_EVT_DECON_FRAMESTART, decon->id, decon);
+	if (event)
+		decon_signal_vblank_event(decon, event);
+	if (decon->config.mode.op_mode == DECON_VIDEO_MODE)
+		drm_crtc_handle_vblank(&decon->crtc->base);
+
+	return true;
+}
 
 static irqreturn_t decon_fs_irq_handler(int irq, void *dev_data)
 {
 	struct decon_device *decon = dev_data;
 
-	spin_lock(&decon->slock);
-
-	if (decon_check_fs_pending_locked(decon))
+	if (decon_check_fs_pending(decon))
 		decon_debug(decon, "%s: frame start\n", __func__);
 
-	spin_unlock(&decon->slock);
 	return IRQ_HANDLED;
 }
 
@@ -2008,6 +2317,7 @@ err:
 static irqreturn_t decon_te_irq_handler(int irq, void *dev_id)
 {
 	struct decon_device *decon = dev_id;
+	const ktime_t ts = ktime_get();
 
 	if (!decon)
 		goto end;
@@ -2028,6 +2338,7 @@ static irqreturn_t decon_te_irq_handler(int irq, void *dev_id)
 		DPU_ATRACE_INT_PID("TE", decon->d.te_cnt++ & 1, decon->thread->pid);
 	}
 	DPU_EVENT_LOG(DPU_EVT_TE_INTERRUPT, decon->id, NULL);
+	exynos_drm_crtc_te_model_update(decon->crtc, ts);
 
 	if (decon->config.dsc.delay_reg_init_us)
 		complete_all(&decon->te_rising);
@@ -2091,8 +2402,8 @@ static int decon_register_irqs(struct decon_device *decon)
 
 	/* 2: FRAME DONE */
 	decon->irq_fd = of_irq_get_byname(np, "frame_done");
-	ret = devm_request_irq(dev, decon->irq_fd, decon_irq_handler,
-			0, pdev->name, decon);
+	ret = devm_request_threaded_irq(dev, decon->irq_fd, decon_irq_handler,
+			decon_irq_thread, 0, pdev->name, decon);
 	if (ret) {
 		decon_err(decon, "failed to install FRAME DONE irq\n");
 		return ret;
@@ -2206,6 +2517,10 @@ static int decon_probe(struct platform_device *pdev)
 	init_waitqueue_head(&decon->framedone_wait);
 	init_completion(&decon->te_rising);
 
+	/* opt-in through debugfs until the setup time is characterized */
+	decon->pacing.enabled = false;
+	decon->pacing.setup_ns = DECON_PACING_SETUP_INIT_NS;
+
 	ret = decon_init_resources(decon);
 	if (ret)
 		goto err;
@@ -2226,9 +2541,10 @@ static int decon_probe(struct platform_device *pdev)
 	decon->hibernation = exynos_hibernation_register(decon);
 	exynos_recovery_register(decon);
 
+	/* DQE allocates its DMA buffers if CGC DMA is present */
+	decon->cgc_dma = exynos_cgc_dma_register(decon);
 	decon->dqe = exynos_dqe_register(decon);
 
-	decon->cgc_dma = exynos_cgc_dma_register(decon);
 	exynos_rmem_register(decon);
 
 	decon->state = decon->fb_handover.rmem ? DECON_STATE_HANDOVER : DECON_STATE_INIT;
@@ -33,10 +33,12 @@
 
 #include <decon_cal.h>
 
+#include "exynos_drm_bts_calc.h"
 #include "exynos_drm_dpp.h"
 #include "exynos_drm_dqe.h"
 #include "exynos_drm_drv.h"
 #include "exynos_drm_dsim.h"
+#include "exynos_drm_event_log_raw.h"
 
 #include "exynos_drm_fb.h"
 #include "exynos_drm_hibernation.h"
@@ -52,12 +54,6 @@ enum decon_state {
 	DECON_STATE_HANDOVER,
 };
 
-enum dpu_win_state {
-	DPU_WIN_STATE_DISABLED = 0,
-	DPU_WIN_STATE_COLOR,
-	DPU_WIN_STATE_BUFFER,
-};
-
 struct decon_resources {
 	struct clk *aclk;
 	struct clk *aclk_disp;
@@ -76,44 +72,6 @@ struct dpu_bts_bw {
 	u32 ch_num;
 };
 
-struct dpu_bts_win_config {
-	enum dpu_win_state state;
-	u32 src_x;
-	u32 src_y;
-	u32 src_w;
-	u32 src_h;
-	int dst_x;
-	int dst_y;
-	u32 dst_w;
-	u32 dst_h;
-	bool is_rot;
-	bool is_comp;
-	bool is_secure;
-	u32 dpp_id;
-	u32 zpos;
-	u32 format;
-	u64 comp_src;
-};
-
-struct bts_layer_position {
-	u32 x1;
-	u32 x2; /* x2 = x1 + width */
-	u32 y1;
-	u32 y2; /* y2 = y1 + height */
-};
-
-struct bts_dpp_info {
-	u32 bpp;
-	u32 src_h;
-	u32 src_w;
-	struct bts_layer_position dst;
-	u32 bw;
-	u32 rt_bw;
-	bool rotation;
-	bool is_afbc;
-	bool is_yuv;
-};
-
 struct bts_decon_info {
 	struct bts_dpp_info rdma[MAX_WIN_PER_DECON];
 	struct bts_dpp_info odma;
@@ -128,6 +86,47 @@ struct decon_win_config {
 	dma_addr_t dma_addr;
 };
 
+/* dpu_bts.dirty: one bit per window, followed by writeback and RCD */
+#define DPU_BTS_DIRTY_WB	MAX_WIN_PER_DECON
+#define DPU_BTS_DIRTY_RCD	(MAX_WIN_PER_DECON + 1)
+#define DPU_BTS_DIRTY_ALL	GENMASK(DPU_BTS_DIRTY_RCD, 0)
+
+#define DPU_BTS_HIST_LEN	8
+
+struct dpu_bts_vote {
+	/* hash of the layer configs the vote was calculated for */
+	u32 sig;
+	struct bts_bw bw;
+	u32 disp_freq;
+};
+
+/*
+ * Votes of the next frame are predicted from the last time the current
+ * layer pattern was seen, and raised one frame ahead. Lowering is delayed
+ * until demand stays lower for idle_frames.
+ */
+struct dpu_bts_prefetch {
+	/* 0 means prefetch is disabled */
+	u32 idle_frames;
+	u32 low_frames;
+	/* set while the votes of a frame already accounted are applied again */
+	bool replay;
+
+	struct dpu_bts_vote hist[DPU_BTS_HIST_LEN];
+	u32 hist_idx;
+	u32 hist_cnt;
+
+	bool predicted;
+	struct dpu_bts_vote next;
+	struct dpu_bts_vote vote;
+
+	/* prediction covered the demand of the frame */
+	u32 hit_cnt;
+	u32 miss_cnt;
+	/* prediction covered the demand, but voted more than needed */
+	u32 over_cnt;
+};
+
 struct dpu_bts {
 	bool enabled;
 	u32 resol_clk;
@@ -179,6 +178,17 @@ struct dpu_bts {
 	struct dpu_bts_win_config wb_config;
 	struct decon_win_config rcd_win_config;
 	atomic_t delayed_update;
+
+	/*
+	 * configs changed since the last calc_bw, only those are reprocessed.
+	 * Bandwidth of the others and the overlap are taken from the cache
+	 * below, which is valid as long as timing and tunables don't change.
+	 */
+	unsigned long dirty;
+	struct bts_dpp_info win_info[MAX_WIN_PER_DECON];
+	struct bts_dpp_info wb_info;
+	struct bts_dpp_info rcd_info;
+	struct dpu_bts_prefetch prefetch;
 };
 
 /**
@@ -187,98 +197,6 @@ struct dpu_bts {
  * These status labels are used internally by the DECON to indicate the
  * current status of a device with operations.
  */
-enum dpu_event_type {
-	DPU_EVT_NONE = 0,
-
-	DPU_EVT_DECON_ENABLED,
-	DPU_EVT_DECON_DISABLED,
-	DPU_EVT_DECON_FRAMEDONE,
-	DPU_EVT_DECON_FRAMESTART,
-	DPU_EVT_DECON_RSC_OCCUPANCY,
-	DPU_EVT_DECON_TRIG_MASK,
-	DPU_EVT_DECON_UPDATE_CONFIG,
-
-	DPU_EVT_DSIM_ENABLED,
-	DPU_EVT_DSIM_DISABLED,
-	DPU_EVT_DSIM_COMMAND,
-	DPU_EVT_DSIM_ULPS_ENTER,
-	DPU_EVT_DSIM_ULPS_EXIT,
-	DPU_EVT_DSIM_UNDERRUN,
-	DPU_EVT_DSIM_FRAMEDONE,
-	DPU_EVT_DSIM_PH_FIFO_TIMEOUT,
-	DPU_EVT_DSIM_PL_FIFO_TIMEOUT,
-
-	DPU_EVT_DPP_FRAMEDONE,
-	DPU_EVT_DPP_SET_PROTECTION,
-	DPU_EVT_DMA_RECOVERY,
-
-	DPU_EVT_IDMA_AFBC_CONFLICT,
-	DPU_EVT_IDMA_FBC_ERROR,
-	DPU_EVT_IDMA_READ_SLAVE_ERROR,
-	DPU_EVT_IDMA_DEADLOCK,
-	DPU_EVT_IDMA_CFG_ERROR,
-
-	DPU_EVT_ATOMIC_COMMIT,
-	DPU_EVT_TE_INTERRUPT,
-
-	DPU_EVT_DECON_RUNTIME_SUSPEND,
-	DPU_EVT_DECON_RUNTIME_RESUME,
-	DPU_EVT_DECON_SUSPEND,
-	DPU_EVT_DECON_RESUME,
-	DPU_EVT_DSIM_RUNTIME_SUSPEND,
-	DPU_EVT_DSIM_RUNTIME_RESUME,
-	DPU_EVT_DSIM_SUSPEND,
-	DPU_EVT_DSIM_RESUME,
-	DPU_EVT_ENTER_HIBERNATION_IN,
-	DPU_EVT_ENTER_HIBERNATION_OUT,
-	DPU_EVT_EXIT_HIBERNATION_IN,
-	DPU_EVT_EXIT_HIBERNATION_OUT,
-
-	DPU_EVT_ATOMIC_BEGIN,
-	DPU_EVT_ATOMIC_FLUSH,
-
-	DPU_EVT_WB_ENABLE,
-	DPU_EVT_WB_DISABLE,
-	DPU_EVT_WB_ATOMIC_COMMIT,
-	DPU_EVT_WB_FRAMEDONE,
-	DPU_EVT_WB_ENTER_HIBERNATION,
-	DPU_EVT_WB_EXIT_HIBERNATION,
-
-	DPU_EVT_PLANE_PREPARE_FB,
-	DPU_EVT_PLANE_CLEANUP_FB,
-	DPU_EVT_PLANE_UPDATE,
-	DPU_EVT_PLANE_DISABLE,
-
-	DPU_EVT_REQ_CRTC_INFO_OLD,
-	DPU_EVT_REQ_CRTC_INFO_NEW,
-
-	DPU_EVT_FRAMESTART_TIMEOUT,
-
-	DPU_EVT_BTS_RELEASE_BW,
-	DPU_EVT_BTS_CALC_BW,
-	DPU_EVT_BTS_UPDATE_BW,
-
-	DPU_EVT_PARTIAL_INIT,
-	DPU_EVT_PARTIAL_PREPARE,
-	DPU_EVT_PARTIAL_UPDATE,
-	DPU_EVT_PARTIAL_RESTORE,
-
-	DPU_EVT_DSIM_CRC,
-	DPU_EVT_DSIM_ECC,
-
-	DPU_EVT_VBLANK_ENABLE,
-	DPU_EVT_VBLANK_DISABLE,
-
-	DPU_EVT_DIMMING_START,
-	DPU_EVT_DIMMING_END,
-
-	DPU_EVT_CGC_FRAMEDONE,
-	DPU_EVT_ITMON_ERROR,
-	DPU_EVT_SYSMMU_FAULT,
-
-	DPU_EVT_MAX, /* End of EVENT */
-};
-
 enum dpu_event_condition {
 	DPU_EVT_CONDITION_DEFAULT		= 1U << 0,
 	DPU_EVT_CONDITION_UNDERRUN		= 1U << 1,
@@ -296,6 +214,13 @@ struct dpu_log_dsim_cmd {
 	void *caller[DPU_CALLSTACK_MAX];
 };
 
+struct dpu_log_dsim_batch {
+	/* flushes requested by the commands which were merged into this one */
+	u32 merged;
+	u8 ph;
+	u16 pl;
+};
+
 struct dpu_log_dpp {
 	u32 id;
 	u32 win_id;
@@ -370,6 +295,15 @@ struct dpu_log_bts_event {
 	u32 value;
 };
 
+struct dpu_log_bts_prefetch {
+	u32 peak;
+	u32 rt;
+	u32 disp_freq;
+	u32 hit_cnt;
+	u32 miss_cnt;
+	u32 over_cnt;
+};
+
 struct dpu_log_partial {
 	u32 min_w;
 	u32 min_h;
@@ -388,6 +322,20 @@ struct dpu_log_plane_info {
 	u32 format;
 };
 
+/*
+ * @ready_us: time from the start of the commit until the fence signaled
+ * @wait_us: time the commit or the trigger was blocked on the fence
+ * @deferred: fence was waited for by the DECON trigger
+ * @status: 0, or the error of the fence or of the wait
+ */
+struct dpu_log_plane_fence {
+	u32 index;
+	u32 ready_us;
+	u32 wait_us;
+	bool deferred;
+	int status;
+};
+
 struct dpu_log_decon_cfg {
 	u32 fps;
 	u32 image_width;
@@ -398,12 +346,16 @@ struct dpu_log_decon_cfg {
 
 struct dpu_log {
 	u64 ts_nsec;
+	/* reservation sequence of the writer that last claimed this entry */
+	u32 seq;
+	/* DPU_EVT_NONE while the entry is being filled, set last on commit */
 	enum dpu_event_type type;
 
 	union {
 		struct dpu_log_dpp dpp;
 		struct dpu_log_atomic atomic;
 		struct dpu_log_dsim_cmd cmd;
+		struct dpu_log_dsim_batch dsim_batch;
 		struct dpu_log_rsc_occupancy rsc;
 		struct dpu_log_pd pd;
 		struct dpu_log_win win;
@@ -412,8 +364,10 @@ struct dpu_log {
 		struct dpu_log_bts_update bts_update;
 		struct dpu_log_bts_cal bts_cal;
 		struct dpu_log_bts_event bts_event;
+		struct dpu_log_bts_prefetch bts_prefetch;
 		struct dpu_log_partial partial;
 		struct dpu_log_plane_info plane_info;
+		struct dpu_log_plane_fence plane_fence;
 		struct dpu_log_decon_cfg decon_cfg;
 		unsigned int value;
 	} data;
@@ -423,6 +377,62 @@ struct dpu_log {
 #define DPU_EVENT_LOG_RETRY	3
 #define DPU_EVENT_KEEP_CNT	3
 
+/* token bucket, kept as the theoretical arrival time of the next event */
+struct dpu_event_ratelimit {
+	/* events per second, 0 means no limit */
+	u32 rate;
+	/* events allowed back to back */
+	u32 burst;
+	atomic64_t tat;
+};
+
+struct dpu_event_filter {
+	/* event types which are not stored in event log */
+	DECLARE_BITMAP(disabled, DPU_EVT_MAX);
+	struct dpu_event_ratelimit ratelimit[DPU_EVT_MAX];
+	/* count of events dropped by mask or rate limit */
+	atomic_t dropped[DPU_EVT_MAX];
+	bool active;
+};
+
+/*
+ * Command mode frame pacing. Triggers are timed against the TE predicted by
+ * the TE model, a frame has to be triggered at least @setup_ns before the TE
+ * it is meant for. @setup_ns is learned from the frames that slipped to a later
+ * TE and the ones that made it with less lead time.
+ *
+ * Pacing is opt-in through debugfs. @setup_ns starts from a conservative value
+ * and is lowered as frames make it with less lead time, so that frames aren't
+ * delayed past their TE while it is being learned.
+ */
+#define DECON_PACING_SETUP_INIT_NS	2000000
+
+struct decon_pacing {
+	bool enabled;
+	/* time the last frame was triggered, and the TE it was meant for */
+	ktime_t trig_ts;
+	ktime_t target_te;
+	u32 period_ns;
+	u32 setup_ns;
+
+	/* margin of the last frame to its deadline, negative if it was late */
+	s32 margin_us;
+	s32 min_margin_us;
+	u32 frame_cnt;
+	/* frames which started on a later TE than the one they were meant for */
+	u32 slip_cnt;
+};
+
+/*
+ * Hardware state which isn't rebuilt from the DRM state when hibernation is
+ * left through the fast path, saved on entry.
+ */
+struct decon_fast_hibernation {
+	u32 encoder_mask;
+	struct dpu_bts_win_config win_config[MAX_WIN_PER_DECON];
+	struct decon_win_config rcd_win_config;
+};
+
 struct decon_debug {
 	/* ring buffer of event log */
 	struct dpu_log *event_log;
@@ -436,12 +446,15 @@ struct decon_debug {
 	u32 ecc_cnt;
 	/* count of idma error interrupt */
 	u32 idma_err_cnt;
-	/* array index of log buffer in event log */
+	/*
+	 * array index of log buffer in event log, writers reserve entries by
+	 * incrementing it and publish them through dpu_log.type
+	 */
 	atomic_t event_log_idx;
-	/* lock for saving log to event log buffer */
-	spinlock_t event_lock;
 
 	u32 auto_refresh_frames;
+	/* per event type mask and rate limit */
+	struct dpu_event_filter filter;
 
 	u32 te_cnt;
 	bool force_te_on;
@@ -492,10 +505,14 @@ struct decon_device {
 #endif
 
 	atomic_t frames_pending;
+	/* frame done interrupts not handled by the irq thread yet */
+	atomic_t framedone_cnt;
 	wait_queue_head_t framedone_wait;
 
 	bool keep_unmask;
 	struct exynos_partial *partial;
+	struct decon_pacing pacing;
+	struct decon_fast_hibernation fast_hiber;
 };
 
 static inline struct decon_device *to_decon_device(const struct device *dev)
@@ -523,6 +540,9 @@ void decon_dump(const struct decon_device *decon);
 void decon_dump_all(struct decon_device *decon,
 		enum dpu_event_condition cond, bool async_buf_dump);
 void decon_enable_te_irq(struct decon_device *decon, bool enable);
+bool decon_wait_for_frame_idle(struct decon_device *decon);
+int decon_fast_hibernation_enter(struct decon_device *decon);
+void decon_fast_hibernation_exit(struct decon_device *decon);
 void decon_dump_event_condition(const struct decon_device *decon,
 		enum dpu_event_condition condition);
 int dpu_init_debug(struct decon_device *decon);
@@ -13,6 +13,7 @@
 
 #include <linux/of_address.h>
 #include <linux/device.h>
+#include <linux/dma-mapping.h>
 #include <drm/drm_drv.h>
 #include <drm/drm_modeset_lock.h>
 #include <drm/drm_atomic_helper.h>
@@ -238,14 +239,16 @@ int histogram_cancel_ioctl(struct drm_device *dev, void *data,
 	return 0;
 }
 
-/* This function runs in interrupt context */
+/* This function runs in the frame done irq thread */
 void handle_histogram_event(struct exynos_dqe *dqe)
 {
-	spin_lock(&dqe->state.histogram_slock);
+	unsigned long flags;
+
+	spin_lock_irqsave(&dqe->state.histogram_slock, flags);
 
 	/* return immediately if histogram disabled */
 	if (dqe->state.hist_run_state == HSTATE_DISABLED) {
-		spin_unlock(&dqe->state.histogram_slock);
+		spin_unlock_irqrestore(&dqe->state.histogram_slock, flags);
 		return;
 	}
 
@@ -265,7 +268,83 @@ void handle_histogram_event(struct exynos_dqe *dqe)
 	else
 		histogram_set_run_state(dqe, HSTATE_PENDING_FRAMEDONE);
 
-	spin_unlock(&dqe->state.histogram_slock);
+	spin_unlock_irqrestore(&dqe->state.histogram_slock, flags);
+}
+
+/*
+ * Returns the packed register image of @data. Images of property blobs are
+ * cached by blob id and the content hash taken when the blob was set, so
+ * switching back to a recent blob or restoring the state after hibernation
+ * doesn't need to pack it again. Debug overrides aren't backed by a blob
+ * (@blob_id is 0) and are packed into @tmp.
+ */
+static const struct dqe_reg_img *
+exynos_dqe_get_reg_img(struct exynos_dqe *dqe, enum dqe_reg_img_type type,
+		       const void *data, u32 blob_id, u32 hash, struct dqe_reg_img *tmp)
+{
+	struct dqe_img_cache *cache = &dqe->img_cache;
+	struct dqe_img_cache_entry *entry, *victim;
+	int i;
+
+	if (!data)
+		return NULL;
+
+	if (!blob_id)
+		return dqe_reg_pack_img(type, data, tmp) ? NULL : tmp;
+
+	victim = &cache->entries[type][0];
+	for (i = 0; i < DQE_IMG_CACHE_WAYS; i++) {
+		entry = &cache->entries[type][i];
+		if (entry->blob_id == blob_id && entry->hash == hash) {
+			entry->last_used = ++cache->seq;
+			cache->hit_cnt[type]++;
+			return &entry->img;
+		}
+		if (entry->last_used < victim->last_used)
+			victim = entry;
+	}
+
+	cache->miss_cnt[type]++;
+	if (dqe_reg_pack_img(type, data, &victim->img)) {
+		victim->blob_id = 0;
+		victim->last_used = 0;
+		return NULL;
+	}
+	victim->blob_id = blob_id;
+	victim->hash = hash;
+	victim->last_used = ++cache->seq;
+
+	return &victim->img;
+}
+
+static void exynos_dqe_set_reg_img(struct exynos_dqe *dqe,
+		enum dqe_reg_img_type type, const void *data, u32 blob_id, u32 hash)
+{
+	struct dqe_reg_img tmp;
+	const struct dqe_reg_img *img;
+
+	img = exynos_dqe_get_reg_img(dqe, type, data, blob_id, hash, &tmp);
+	if (data && !img) {
+		pr_err("failed to pack dqe register image type(%d)\n", type);
+		return;
+	}
+
+	dqe_reg_set_img(dqe->decon->id, type, img);
+}
+
+/*
+ * Returns true if the LUT or matrix to load differs from the loaded one. Blobs
+ * are compared by content hash, so a new blob with the same content isn't
+ * loaded again. Debug overrides and NULL have no blob id, they are compared by
+ * pointer.
+ */
+static bool exynos_dqe_blob_changed(const void *cur, u32 cur_id, u32 cur_hash,
+				    const void *next, u32 next_id, u32 next_hash)
+{
+	if (!cur_id || !next_id)
+		return cur != next;
+
+	return cur_hash != next_hash;
 }
 
 static void
@@ -279,12 +358,20 @@ exynos_degamma_update(struct exynos_dqe *dqe, struct exynos_dqe_state *state)
 
 	pr_debug("en(%d) dirty(%d)\n", info->force_en, info->dirty);
 
-	if (info->force_en)
+	if (info->force_en) {
 		state->degamma_lut = degamma->force_lut;
+		state->degamma_lut_id = 0;
+	}
 
-	if (dqe->state.degamma_lut != state->degamma_lut || info->dirty) {
-		dqe_reg_set_degamma_lut(id, state->degamma_lut);
+	if (exynos_dqe_blob_changed(dqe->state.degamma_lut, dqe->state.degamma_lut_id,
+			dqe->state.degamma_lut_hash, state->degamma_lut, state->degamma_lut_id,
+			state->degamma_lut_hash) || info->dirty) {
+		exynos_dqe_set_reg_img(dqe, DQE_REG_IMG_DEGAMMA,
+				state->degamma_lut, state->degamma_lut_id,
+				state->degamma_lut_hash);
 		dqe->state.degamma_lut = state->degamma_lut;
+		dqe->state.degamma_lut_id = state->degamma_lut_id;
+		dqe->state.degamma_lut_hash = state->degamma_lut_hash;
 		info->dirty = false;
 	}
 
@@ -292,7 +379,64 @@ exynos_degamma_update(struct exynos_dqe *dqe, struct exynos_dqe_state *state)
 		dqe_reg_print_degamma_lut(id, &p);
 }
 
-static void
+#define CGC_DMA_REQ_TIMEOUT_US 300
+static void exynos_cgc_dma_request(struct exynos_dqe *dqe, dma_addr_t addr)
+{
+	struct decon_device *decon = dqe->decon;
+	u32 cgc_dma_id = decon->cgc_dma->id;
+
+	dqe_reg_set_cgc_en(decon->id, 1);
+	cgc_reg_set_config(cgc_dma_id, 1, addr);
+	dqe_reg_set_cgc_coef_dma_req(decon->id);
+	cgc_reg_set_cgc_start(cgc_dma_id);
+	dqe->dma.pending = true;
+}
+
+/*
+ * The LUT has to be loaded before CGC update is requested. Waiting is deferred
+ * up to that point, so the DMA runs while the other DQE blocks are programmed.
+ */
+static void exynos_cgc_dma_wait(struct exynos_dqe *dqe)
+{
+	if (!dqe->dma.pending)
+		return;
+
+	dqe_reg_wait_cgc_dma_done(dqe->decon->id, CGC_DMA_REQ_TIMEOUT_US);
+	dqe->dma.pending = false;
+}
+
+/*
+ * Loads a CGC LUT blob. If the DQE has coefficient DMA, the LUT is staged into
+ * the next buffer of the pool and loaded by DMA, otherwise it is written by the
+ * CPU. @restage is false when loading the same LUT again into the second bank.
+ */
+static void exynos_cgc_set_lut(struct exynos_dqe *dqe,
+			       const struct cgc_lut *lut, bool restage)
+{
+	struct decon_device *decon = dqe->decon;
+	struct exynos_dqe_dma *dma = &dqe->dma;
+
+	if (!decon->cgc_dma || !dma->size) {
+		dqe_reg_set_cgc_lut(decon->id, lut);
+		return;
+	}
+
+	if (!lut) {
+		dqe_reg_set_cgc_en(decon->id, 0);
+		cgc_reg_set_config(decon->cgc_dma->id, 0, 0);
+		return;
+	}
+
+	if (restage) {
+		dma->cur = (dma->cur + 1) % DQE_DMA_BUF_CNT;
+		memcpy(dma->bufs[dma->cur].vaddr, lut, dma->size);
+	}
+
+	exynos_cgc_dma_request(dqe, dma->bufs[dma->cur].dma_addr);
+}
+
+/* returns true if CGC update has to be requested */
+static bool
 exynos_cgc_update(struct exynos_dqe *dqe, struct exynos_dqe_state *state)
 {
 	struct cgc_debug_override *cgc = &dqe->cgc;
@@ -303,20 +447,43 @@ exynos_cgc_update(struct exynos_dqe *dqe, struct exynos_dqe_state *state)
 	bool updated = false;
 
 	pr_debug("en(%d) dirty(%d)\n", info->force_en, info->dirty);
-	if (decon->cgc_dma && !info->force_en)
-		return;
 
-	if (info->force_en)
+	if (info->force_en) {
 		state->cgc_lut = &cgc->force_lut;
+		state->cgc_lut_id = 0;
+		state->cgc_gem = NULL;
+	}
 
-	if (dqe->state.cgc_lut != state->cgc_lut || info->dirty) {
-		dqe_reg_set_cgc_lut(id, state->cgc_lut);
+	if (state->cgc_gem) {
+		/*
+		 * LUT buffer passed by userspace may have been rewritten in
+		 * place, it is loaded again whenever cgc_lut_fd is set.
+		 */
+		if (dqe->state.cgc_gem != state->cgc_gem || state->cgc_gem_changed) {
+			exynos_cgc_dma_request(dqe,
+					to_exynos_gem(state->cgc_gem)->dma_addr);
+			dqe->state.cgc_gem = state->cgc_gem;
+			dqe->state.cgc_lut = NULL;
+			dqe->state.cgc_lut_id = 0;
+			cgc->first_write = true;
+			updated = true;
+		} else if (cgc->first_write) {
+			exynos_cgc_dma_request(dqe,
+					to_exynos_gem(state->cgc_gem)->dma_addr);
+			cgc->first_write = false;
+			updated = true;
+		}
+	} else if (dqe->state.cgc_gem || dqe->state.cgc_lut != state->cgc_lut ||
+		   dqe->state.cgc_lut_id != state->cgc_lut_id || info->dirty) {
+		exynos_cgc_set_lut(dqe, state->cgc_lut, true);
+		dqe->state.cgc_gem = NULL;
 		dqe->state.cgc_lut = state->cgc_lut;
+		dqe->state.cgc_lut_id = state->cgc_lut_id;
 		cgc->first_write = true;
 		info->dirty = false;
 		updated = true;
 	} else if (cgc->first_write) {
-		dqe_reg_set_cgc_lut(id, dqe->state.cgc_lut);
+		exynos_cgc_set_lut(dqe, dqe->state.cgc_lut, false);
 		cgc->first_write = false;
 		updated = true;
 	}
@@ -324,8 +491,7 @@ exynos_cgc_update(struct exynos_dqe *dqe, struct exynos_dqe_state *state)
 	if (info->verbose)
 		dqe_reg_print_cgc_lut(id, cgc->verbose_cnt, &p);
 
-	if (updated)
-		decon_reg_update_req_cgc(id);
+	return updated;
 }
 
 static void
@@ -339,12 +505,20 @@ exynos_regamma_update(struct exynos_dqe *dqe, struct exynos_dqe_state *state)
 
 	pr_debug("en(%d) dirty(%d)\n", info->force_en, info->dirty);
 
-	if (info->force_en)
+	if (info->force_en) {
 		state->regamma_lut = regamma->force_lut;
+		state->regamma_lut_id = 0;
+	}
 
-	if (dqe->state.regamma_lut != state->regamma_lut || info->dirty) {
-		dqe_reg_set_regamma_lut(id, state->regamma_lut);
+	if (exynos_dqe_blob_changed(dqe->state.regamma_lut, dqe->state.regamma_lut_id,
+			dqe->state.regamma_lut_hash, state->regamma_lut, state->regamma_lut_id,
+			state->regamma_lut_hash) || info->dirty) {
+		exynos_dqe_set_reg_img(dqe, DQE_REG_IMG_REGAMMA,
+				state->regamma_lut, state->regamma_lut_id,
+				state->regamma_lut_hash);
 		dqe->state.regamma_lut = state->regamma_lut;
+		dqe->state.regamma_lut_id = state->regamma_lut_id;
+		dqe->state.regamma_lut_hash = state->regamma_lut_hash;
 		info->dirty = false;
 	}
 
@@ -363,12 +537,20 @@ static void exynos_gamma_matrix_update(struct exynos_dqe *dqe,
 
 	pr_debug("en(%d) dirty(%d)\n", info->force_en, info->dirty);
 
-	if (info->force_en)
+	if (info->force_en) {
 		state->gamma_matrix = &gamma->force_matrix;
+		state->gamma_matrix_id = 0;
+	}
 
-	if (dqe->state.gamma_matrix != state->gamma_matrix || info->dirty) {
-		dqe_reg_set_gamma_matrix(id, state->gamma_matrix);
+	if (exynos_dqe_blob_changed(dqe->state.gamma_matrix, dqe->state.gamma_matrix_id,
+			dqe->state.gamma_matrix_hash, state->gamma_matrix, state->gamma_matrix_id,
+			state->gamma_matrix_hash) || info->dirty) {
+		exynos_dqe_set_reg_img(dqe, DQE_REG_IMG_GAMMA_MATRIX,
+				state->gamma_matrix, state->gamma_matrix_id,
+				state->gamma_matrix_hash);
 		dqe->state.gamma_matrix = state->gamma_matrix;
+		dqe->state.gamma_matrix_id = state->gamma_matrix_id;
+		dqe->state.gamma_matrix_hash = state->gamma_matrix_hash;
 		info->dirty = false;
 	}
 
@@ -387,12 +569,20 @@ static void exynos_linear_matrix_update(struct exynos_dqe *dqe,
 
 	pr_debug("en(%d) dirty(%d)\n", info->force_en, info->dirty);
 
-	if (info->force_en)
+	if (info->force_en) {
 		state->linear_matrix = &linear->force_matrix;
+		state->linear_matrix_id = 0;
+	}
 
-	if (dqe->state.linear_matrix != state->linear_matrix || info->dirty) {
-		dqe_reg_set_linear_matrix(id, state->linear_matrix);
+	if (exynos_dqe_blob_changed(dqe->state.linear_matrix, dqe->state.linear_matrix_id,
+			dqe->state.linear_matrix_hash, state->linear_matrix, state->linear_matrix_id,
+			state->linear_matrix_hash) || info->dirty) {
+		exynos_dqe_set_reg_img(dqe, DQE_REG_IMG_LINEAR_MATRIX,
+				state->linear_matrix, state->linear_matrix_id,
+				state->linear_matrix_hash);
 		dqe->state.linear_matrix = state->linear_matrix;
+		dqe->state.linear_matrix_id = state->linear_matrix_id;
+		dqe->state.linear_matrix_hash = state->linear_matrix_hash;
 		info->dirty = false;
 	}
 
@@ -508,61 +698,12 @@ static void exynos_rcd_update(struct exynos_dqe *dqe, struct exynos_dqe_state *s
 	}
 }
 
-#define CGC_DMA_REQ_TIMEOUT_US 300
-static void exynos_set_cgc_dma(struct decon_device *decon, struct exynos_dqe_state *state)
-{
-	struct exynos_drm_gem *exynos_cgc_gem;
-	u32 id = decon->id;
-	u32 cgc_dma_id = decon->cgc_dma->id;
-
-	if (!state->cgc_gem) {
-		dqe_reg_set_cgc_en(id, 0);
-		cgc_reg_set_config(cgc_dma_id, 0, 0);
-	} else {
-		dqe_reg_set_cgc_en(id, 1);
-		exynos_cgc_gem = to_exynos_gem(state->cgc_gem);
-		cgc_reg_set_config(cgc_dma_id, 1, exynos_cgc_gem->dma_addr);
-		dqe_reg_set_cgc_coef_dma_req(id);
-		cgc_reg_set_cgc_start(cgc_dma_id);
-		dqe_reg_wait_cgc_dma_done(id, CGC_DMA_REQ_TIMEOUT_US);
-	}
-}
-
-static void exynos_cgc_dma_update(struct exynos_dqe *dqe,
-					struct exynos_dqe_state *state)
-{
-	struct decon_device *decon = dqe->decon;
-	struct cgc_debug_override *cgc = &dqe->cgc;
-	struct exynos_debug_info *info = &cgc->info;
-	struct drm_printer p = drm_info_printer(decon->dev);
-	u32 id = decon->id;
-	bool updated = false;
-
-	if (!decon->cgc_dma || info->force_en)
-		return;
-
-	if (dqe->state.cgc_gem != state->cgc_gem) {
-		exynos_set_cgc_dma(decon, state);
-		cgc->first_write = true;
-		updated = true;
-	} else if (cgc->first_write) {
-		exynos_set_cgc_dma(decon, state);
-		cgc->first_write = false;
-		updated = true;
-	}
-
-	if (info->verbose)
-		dqe_reg_print_cgc_lut(id, cgc->verbose_cnt, &p);
-
-	if (updated)
-		decon_reg_update_req_cgc(id);
-}
-
 static void __exynos_dqe_update(struct exynos_dqe *dqe,
 		struct exynos_dqe_state *state, u32 width, u32 height)
 {
 	const struct decon_device *decon = dqe->decon;
 	u32 id = decon->id;
+	bool cgc_updated;
 
 	pr_debug("enabled(%d) +\n", state->enabled);
 
@@ -582,12 +723,16 @@ static void __exynos_dqe_update(struct exynos_dqe *dqe,
 	exynos_gamma_matrix_update(dqe, state);
 	exynos_degamma_update(dqe, state);
 	exynos_linear_matrix_update(dqe, state);
-	exynos_cgc_update(dqe, state);
+	cgc_updated = exynos_cgc_update(dqe, state);
 	exynos_regamma_update(dqe, state);
 	exynos_dither_update(dqe, state);
 	exynos_histogram_update(dqe, state);
 	exynos_rcd_update(dqe, state);
-	exynos_cgc_dma_update(dqe, state);
+
+	if (cgc_updated) {
+		exynos_cgc_dma_wait(dqe);
+		decon_reg_update_req_cgc(id);
+	}
 
 	decon_reg_update_req_dqe(id);
 
@@ -630,11 +775,17 @@ void exynos_dqe_reset(struct exynos_dqe *dqe)
 	unsigned long flags;
 
 	dqe->initialized = false;
+	dqe_reg_invalidate_lut(dqe->decon->id);
 	dqe->state.gamma_matrix = NULL;
+	dqe->state.gamma_matrix_id = 0;
 	dqe->state.degamma_lut = NULL;
+	dqe->state.degamma_lut_id = 0;
 	dqe->state.linear_matrix = NULL;
+	dqe->state.linear_matrix_id = 0;
 	dqe->state.cgc_lut = NULL;
+	dqe->state.cgc_lut_id = 0;
 	dqe->state.regamma_lut = NULL;
+	dqe->state.regamma_lut_id = 0;
 	dqe->state.disp_dither_config = NULL;
 	dqe->state.cgc_dither_config = NULL;
 	dqe->cgc.first_write = false;
@@ -889,6 +1040,29 @@ static enum dqe_version exynos_get_dqe_version(void)
 	return dqe_ver;
 }
 
+/*
+ * Only CGC has a coefficient DMA among the DQE blocks so far, the pool is sized
+ * for its LUT, which is loaded in the same layout as struct cgc_lut.
+ */
+static void exynos_dqe_dma_init(struct exynos_dqe *dqe, struct device *dev)
+{
+	struct exynos_dqe_dma *dma = &dqe->dma;
+	int i;
+
+	for (i = 0; i < DQE_DMA_BUF_CNT; i++) {
+		dma->bufs[i].vaddr = dmam_alloc_coherent(dev,
+				sizeof(struct cgc_lut), &dma->bufs[i].dma_addr,
+				GFP_KERNEL);
+		if (!dma->bufs[i].vaddr) {
+			pr_warn("failed to allocate dqe dma buffers, use cpu writes\n");
+			return;
+		}
+	}
+
+	dma->size = sizeof(struct cgc_lut);
+	dma->cur = DQE_DMA_BUF_CNT - 1;
+}
+
 #define MAX_DQE_NAME_SIZE 10
 struct exynos_dqe *exynos_dqe_register(struct decon_device *decon)
 {
@@ -921,6 +1095,9 @@ struct exynos_dqe *exynos_dqe_register(struct decon_device *decon)
 		return NULL;
 	}
 
+	if (decon->cgc_dma)
+		exynos_dqe_dma_init(dqe, dev);
+
 	dqe_version = exynos_get_dqe_version();
 	dqe_regs_desc_init(dqe->regs, res.start, "dqe", dqe_version, decon->id);
 	dqe->funcs = &dqe_funcs;
@@ -39,11 +39,27 @@ struct exynos_dqe_state {
 	const struct exynos_matrix *gamma_matrix;
 	const struct cgc_lut *cgc_lut;
 	struct drm_color_lut *regamma_lut;
+	/* ids of the property blobs backing the LUTs and matrices, 0 if none */
+	u32 degamma_lut_id;
+	u32 linear_matrix_id;
+	u32 gamma_matrix_id;
+	u32 regamma_lut_id;
+	u32 cgc_lut_id;
+	/*
+	 * jhash of the blob contents, ids get reused once a blob is freed. Blobs
+	 * never change, so it is only computed when a new blob is set.
+	 */
+	u32 degamma_lut_hash;
+	u32 linear_matrix_hash;
+	u32 gamma_matrix_hash;
+	u32 regamma_lut_hash;
 	struct dither_config *disp_dither_config;
 	struct dither_config *cgc_dither_config;
 	bool enabled;
 	bool rcd_enabled;
 	struct drm_gem_object *cgc_gem;
+	/* cgc_lut_fd was set in this commit, the buffer may have been rewritten */
+	bool cgc_gem_changed;
 	spinlock_t histogram_slock;
 	struct exynos_drm_pending_histogram_event *event;
 	struct histogram_roi *roi;
@@ -125,6 +141,42 @@ struct debugfs_dump {
 	void *priv;
 };
 
+#define DQE_DMA_BUF_CNT		2
+
+struct dqe_dma_buf {
+	void *vaddr;
+	dma_addr_t dma_addr;
+};
+
+/*
+ * Coherent buffers LUTs are staged into for the DQE coefficient DMA. A new LUT
+ * goes to the buffer after the one used by the last request, so staging it
+ * can't corrupt a load still in flight after a timeout.
+ */
+struct exynos_dqe_dma {
+	struct dqe_dma_buf bufs[DQE_DMA_BUF_CNT];
+	size_t size;		/* 0 if there is no pool, LUTs are written by CPU */
+	u32 cur;		/* buffer holding the last staged LUT */
+	bool pending;		/* load requested but not waited for yet */
+};
+
+#define DQE_IMG_CACHE_WAYS	4
+
+struct dqe_img_cache_entry {
+	u32 blob_id;		/* 0 if the entry is unused */
+	u32 hash;		/* jhash of the blob content, blob ids get reused */
+	u64 last_used;
+	struct dqe_reg_img img;
+};
+
+/* packed register images of recently used blobs, per DQE block */
+struct dqe_img_cache {
+	struct dqe_img_cache_entry entries[DQE_REG_IMG_MAX][DQE_IMG_CACHE_WAYS];
+	u64 seq;
+	u32 hit_cnt[DQE_REG_IMG_MAX];
+	u32 miss_cnt[DQE_REG_IMG_MAX];
+};
+
 struct exynos_dqe {
 	void __iomem *regs;
 	bool initialized;
@@ -151,6 +203,9 @@ struct exynos_dqe {
 	bool dstep_changed;
 	struct exynos_atc force_atc_config;
 	u32 lpd_atc_regs[LPD_ATC_REG_CNT];
+
+	struct dqe_img_cache img_cache;
+	struct exynos_dqe_dma dma;
 };
 
 int histogram_request_ioctl(struct drm_device *drm_dev, void *data,
@@ -397,6 +397,57 @@ static void print_drm_plane_state_info(struct drm_printer *p,
 	drm_printf(p, "plane: fb allocated by = %s\n", state->fb->comm);
 }
 
+static void print_dma_fence_info(struct drm_printer *p, struct dma_fence *fence)
+{
+	spin_lock_irq(fence->lock);
+	drm_printf(p, "fence: %s-%s %llu-%llu status:%s\n",
+		fence->ops ? fence->ops->get_driver_name(fence) : "none",
+		fence->ops ? fence->ops->get_timeline_name(fence) : "none",
+		fence->context, fence->seqno,
+		dma_fence_get_status_locked(fence) < 0 ? "error" : "active");
+	if (test_bit(DMA_FENCE_FLAG_TIMESTAMP_BIT, &fence->flags)) {
+		struct timespec64 ts64 = ktime_to_timespec64(fence->timestamp);
+		drm_printf(p, "fence: timestamp:%lld.%09ld\n",
+			(s64)ts64.tv_sec, ts64.tv_nsec);
+	}
+	if (fence->error)
+		drm_printf(p, "fence: err=%d\n", fence->error);
+	spin_unlock_irq(fence->lock);
+}
+
+/*
+ * @ready_ts: time the fence signaled, or the wait for it gave up
+ * @blocked_ts: time the commit started to be blocked on the fence
+ */
+static void exynos_atomic_log_fence(const struct drm_plane_state *plane_state,
+				    ktime_t ready_ts, ktime_t blocked_ts, int status)
+{
+	const struct exynos_drm_plane_state *exynos_plane_state =
+		to_exynos_plane_state(plane_state);
+	const ktime_t wait_ts = exynos_plane_state->fence_wait_ts;
+	struct dpu_log_plane_fence fence_log;
+
+	if (!plane_state->crtc)
+		return;
+
+	fence_log.index = plane_state->plane->index;
+	fence_log.deferred = exynos_plane_state->fence_deferred;
+	fence_log.status = status;
+	fence_log.ready_us = ktime_after(ready_ts, wait_ts) ?
+			ktime_us_delta(ready_ts, wait_ts) : 0;
+	fence_log.wait_us = ktime_after(ready_ts, blocked_ts) ?
+			ktime_us_delta(ready_ts, blocked_ts) : 0;
+
+	DPU_EVENT_LOG(DPU_EVT_PLANE_FENCE, crtc_to_decon(plane_state->crtc)->id, &fence_log);
+}
+
+/* time the GPU finished with @fence, if the fence driver recorded it */
+static ktime_t exynos_atomic_fence_ready_ts(struct dma_fence *fence, ktime_t fallback)
+{
+	return test_bit(DMA_FENCE_FLAG_TIMESTAMP_BIT, &fence->flags) ?
+		fence->timestamp : fallback;
+}
+
 static int exynos_atomic_helper_wait_for_fences(struct drm_device *dev,
 				      struct drm_atomic_state *state,
 				      bool pre_swap)
@@ -406,20 +457,28 @@ static int exynos_atomic_helper_wait_for_fences(struct drm_device *dev,
 	int i, ret, err = 0;
 	struct drm_printer p = drm_info_printer(dev->dev);
 	long tmo = msecs_to_jiffies(EXYNOS_DRM_WAIT_FENCE_TIMEOUT_MS);
+	const ktime_t wait_ts = ktime_get();
 
 	for_each_new_plane_in_state(state, plane, new_plane_state, i) {
+		struct exynos_drm_plane_state *exynos_plane_state =
+			to_exynos_plane_state(new_plane_state);
 		struct dma_fence *fence = new_plane_state->fence;
+		ktime_t blocked_ts, done_ts;
 
-		if (!fence)
+		if (!fence || exynos_plane_state->fence_deferred)
 			continue;
 
 		WARN_ON(!new_plane_state->fb);
+		exynos_plane_state->fence_wait_ts = wait_ts;
+		blocked_ts = ktime_get();
 		ret = dma_fence_wait_timeout(fence, pre_swap, tmo);
+		done_ts = ktime_get();
 		if (ret == 0) {
 			struct drm_crtc *crtc = new_plane_state->crtc;
 
 			pr_err("%s: timeout of waiting for fence, name:%s idx:%d\n",
 				__func__, plane->name ? : "NA", plane->index);
+			exynos_atomic_log_fence(new_plane_state, done_ts, blocked_ts, -ETIMEDOUT);
 			if (crtc) {
 				const struct decon_device *decon = crtc_to_decon(crtc);
 				const struct decon_config *cfg = &decon->config;
@@ -439,28 +498,29 @@ static int exynos_atomic_helper_wait_for_fences(struct drm_device *dev,
 				}
 			}
 			print_drm_plane_state_info(&p, new_plane_state);
-
-			spin_lock_irq(fence->lock);
-			drm_printf(&p, "fence: %s-%s %llu-%llu status:%s\n",
-				fence->ops ? fence->ops->get_driver_name(fence) : "none",
-				fence->ops ? fence->ops->get_timeline_name(fence) : "none",
-				fence->context, fence->seqno,
-				dma_fence_get_status_locked(fence) < 0 ? "error" : "active");
-			if (test_bit(DMA_FENCE_FLAG_TIMESTAMP_BIT, &fence->flags)) {
-				struct timespec64 ts64 = ktime_to_timespec64(fence->timestamp);
-				drm_printf(&p, "fence: timestamp:%lld.%09ld\n",
-					(s64)ts64.tv_sec, ts64.tv_nsec);
-			}
-			if (fence->error)
-				drm_printf(&p, "fence: err=%d\n", fence->error);
-			spin_unlock_irq(fence->lock);
+			print_dma_fence_info(&p, fence);
 
 			tmo = 0;
 			err = -ETIMEDOUT;
 		} else if (ret < 0) {
 			pr_warn("%s: error of waiting for dma fence, ret=%d\n", __func__, ret);
 			print_drm_plane_state_info(&p, new_plane_state);
+			exynos_atomic_log_fence(new_plane_state, done_ts, blocked_ts, ret);
 			return ret;
+		} else {
+			struct drm_crtc_state *new_crtc_state = new_plane_state->crtc ?
+				drm_atomic_get_new_crtc_state(state, new_plane_state->crtc) : NULL;
+
+			exynos_atomic_log_fence(new_plane_state, done_ts, blocked_ts, 0);
+			if (new_crtc_state) {
+				struct exynos_drm_crtc_state *new_exynos_crtc_state =
+					to_exynos_crtc_state(new_crtc_state);
+				const ktime_t ready_ts =
+					exynos_atomic_fence_ready_ts(fence, done_ts);
+
+				if (ktime_after(ready_ts, new_exynos_crtc_state->fences_ready_ts))
+					new_exynos_crtc_state->fences_ready_ts = ready_ts;
+			}
 		}
 		dma_fence_put(fence);
 		new_plane_state->fence = NULL;
@@ -469,6 +529,172 @@ static int exynos_atomic_helper_wait_for_fences(struct drm_device *dev,
 	return err;
 }
 
+static bool exynos_atomic_can_defer_fence(struct drm_atomic_state *state,
+					  const struct drm_plane_state *new_plane_state)
+{
+	struct drm_crtc *crtc = new_plane_state->crtc;
+	const struct drm_crtc_state *new_crtc_state;
+	const struct decon_device *decon;
+
+	if (!crtc || !READ_ONCE(to_exynos_crtc(crtc)->defer_fences))
+		return false;
+
+	new_crtc_state = drm_atomic_get_new_crtc_state(state, crtc);
+	if (!new_crtc_state || !new_crtc_state->active ||
+	    drm_atomic_crtc_needs_modeset(new_crtc_state) ||
+	    to_exynos_crtc_state(new_crtc_state)->skip_update)
+		return false;
+
+	/*
+	 * in command mode nothing programmed for the planes is latched before
+	 * the trigger, video mode could pick the new buffers up at any vsync
+	 */
+	decon = crtc_to_decon(crtc);
+	return decon->config.mode.op_mode == DECON_COMMAND_MODE &&
+		decon->config.out_type != DECON_OUT_WB;
+}
+
+static void exynos_atomic_fence_cb(struct dma_fence *fence, struct dma_fence_cb *cb)
+{
+	struct exynos_drm_plane_state *exynos_plane_state =
+		container_of(cb, struct exynos_drm_plane_state, fence_cb);
+	struct exynos_drm_crtc_state *exynos_crtc_state = exynos_plane_state->fence_crtc_state;
+
+	exynos_plane_state->fence_ready_ts = exynos_atomic_fence_ready_ts(fence, ktime_get());
+	if (atomic_dec_and_test(&exynos_crtc_state->fences_pending))
+		wake_up_all(&to_exynos_crtc(exynos_crtc_state->base.crtc)->fence_wq);
+}
+
+/*
+ * Instead of blocking the commit on each plane fence in turn, planes of active
+ * command mode displays are programmed right away and only the DECON trigger
+ * waits for their fences, see exynos_atomic_wait_for_deferred_fences(). The
+ * fences signal in parallel with the rest of the commit, and the trigger is
+ * held back only by the slowest one. The fences still pending are counted in
+ * the new CRTC state, so they can be deferred before the previous commit on
+ * the CRTC is done.
+ */
+static void exynos_atomic_defer_fences(struct drm_atomic_state *state)
+{
+	struct drm_plane *plane;
+	struct drm_plane_state *new_plane_state;
+	const ktime_t wait_ts = ktime_get();
+	int i;
+
+	for_each_new_plane_in_state(state, plane, new_plane_state, i) {
+		struct exynos_drm_plane_state *exynos_plane_state =
+			to_exynos_plane_state(new_plane_state);
+		struct dma_fence *fence = new_plane_state->fence;
+		struct exynos_drm_crtc_state *new_exynos_crtc_state;
+
+		if (!fence || !exynos_atomic_can_defer_fence(state, new_plane_state))
+			continue;
+
+		new_exynos_crtc_state = to_exynos_crtc_state(
+			drm_atomic_get_new_crtc_state(state, new_plane_state->crtc));
+		new_exynos_crtc_state->fences_deferred = true;
+		exynos_plane_state->fence_crtc_state = new_exynos_crtc_state;
+		exynos_plane_state->fence_deferred = true;
+		exynos_plane_state->fence_wait_ts = wait_ts;
+		exynos_plane_state->fence_ready_ts = exynos_atomic_fence_ready_ts(fence, wait_ts);
+
+		atomic_inc(&new_exynos_crtc_state->fences_pending);
+		if (dma_fence_add_callback(fence, &exynos_plane_state->fence_cb,
+					   exynos_atomic_fence_cb))
+			atomic_dec(&new_exynos_crtc_state->fences_pending);
+	}
+}
+
+/**
+ * exynos_atomic_wait_for_deferred_fences - wait for the plane fences of @crtc
+ * which were deferred to the trigger
+ * @state: atomic state of the commit in flight
+ * @crtc: CRTC about to be triggered
+ *
+ * Releases the deferred fences of the planes on @crtc, and logs when each of
+ * them signaled. Returns -ETIMEDOUT if any of them didn't signal in time.
+ */
+int exynos_atomic_wait_for_deferred_fences(struct drm_atomic_state *state,
+					   struct drm_crtc *crtc)
+{
+	struct exynos_drm_crtc *exynos_crtc = to_exynos_crtc(crtc);
+	struct exynos_drm_crtc_state *new_exynos_crtc_state =
+		to_exynos_crtc_state(drm_atomic_get_new_crtc_state(state, crtc));
+	struct drm_printer p = drm_info_printer(crtc->dev->dev);
+	struct drm_plane *plane;
+	struct drm_plane_state *new_plane_state;
+	ktime_t start_ts, done_ts;
+	int i, err = 0;
+
+	start_ts = ktime_get();
+	if (atomic_read(&new_exynos_crtc_state->fences_pending)) {
+		DPU_ATRACE_BEGIN("wait_for_deferred_fences");
+		if (!wait_event_timeout(exynos_crtc->fence_wq,
+				!atomic_read(&new_exynos_crtc_state->fences_pending),
+				msecs_to_jiffies(EXYNOS_DRM_WAIT_FENCE_TIMEOUT_MS)))
+			err = -ETIMEDOUT;
+		DPU_ATRACE_END("wait_for_deferred_fences");
+	}
+	done_ts = ktime_get();
+
+	for_each_new_plane_in_state(state, plane, new_plane_state, i) {
+		struct exynos_drm_plane_state *exynos_plane_state =
+			to_exynos_plane_state(new_plane_state);
+		struct dma_fence *fence = new_plane_state->fence;
+
+		if (new_plane_state->crtc != crtc || !exynos_plane_state->fence_deferred)
+			continue;
+
+		/* callback runs under the fence lock, it's done once it can't be removed */
+		if (dma_fence_remove_callback(fence, &exynos_plane_state->fence_cb)) {
+			pr_err("%s: timeout of waiting for fence, name:%s idx:%d\n",
+				__func__, plane->name ? : "NA", plane->index);
+			print_drm_plane_state_info(&p, new_plane_state);
+			print_dma_fence_info(&p, fence);
+			exynos_atomic_log_fence(new_plane_state, done_ts, start_ts, -ETIMEDOUT);
+		} else {
+			/* the trigger is only blocked once it starts waiting */
+			exynos_atomic_log_fence(new_plane_state,
+				exynos_plane_state->fence_ready_ts, start_ts,
+				min(dma_fence_get_status(fence), 0));
+			if (ktime_after(exynos_plane_state->fence_ready_ts,
+					new_exynos_crtc_state->fences_ready_ts))
+				new_exynos_crtc_state->fences_ready_ts =
+					exynos_plane_state->fence_ready_ts;
+		}
+
+		exynos_plane_state->fence_deferred = false;
+		dma_fence_put(fence);
+		new_plane_state->fence = NULL;
+	}
+
+	return err;
+}
+
+/*
+ * Releases the deferred fences no trigger waited for, e.g. when the update of
+ * their CRTC was skipped, while the CRTC state they are counted in is alive.
+ */
+static void exynos_atomic_release_deferred_fences(struct drm_atomic_state *state)
+{
+	struct drm_plane *plane;
+	struct drm_plane_state *new_plane_state;
+	int i;
+
+	for_each_new_plane_in_state(state, plane, new_plane_state, i) {
+		struct exynos_drm_plane_state *exynos_plane_state =
+			to_exynos_plane_state(new_plane_state);
+
+		if (!exynos_plane_state->fence_deferred)
+			continue;
+
+		dma_fence_remove_callback(new_plane_state->fence, &exynos_plane_state->fence_cb);
+		exynos_plane_state->fence_deferred = false;
+		dma_fence_put(new_plane_state->fence);
+		new_plane_state->fence = NULL;
+	}
+}
+
 static void commit_tail(struct drm_atomic_state *old_state)
 {
 	int i;
@@ -486,11 +712,18 @@ static void commit_tail(struct drm_atomic_state *old_state)
 		decon = crtc_to_decon(crtc);
 		if (new_crtc_state->active || old_crtc_state->active) {
 			hibernation_block(decon->hibernation);
+			if (!new_crtc_state->self_refresh_active &&
+			    !to_exynos_crtc_state(new_crtc_state)->hibernation_exit)
+				hibernation_commit_arrival(decon->hibernation);
+			/* the CRTC stayed active in fast path hibernation, power it back */
+			hibernation_fast_exit(decon->hibernation);
 
 			hibernation_crtc_mask |= drm_crtc_mask(crtc);
 		}
 	}
 
+	exynos_atomic_defer_fences(old_state);
+
 	DPU_ATRACE_BEGIN("wait_for_fences");
 	exynos_atomic_helper_wait_for_fences(dev, old_state, false);
 	DPU_ATRACE_END("wait_for_fences");
@@ -502,6 +735,8 @@ static void commit_tail(struct drm_atomic_state *old_state)
 	else
 		drm_atomic_helper_commit_tail(old_state);
 
+	exynos_atomic_release_deferred_fences(old_state);
+
 	for_each_new_crtc_in_state(old_state, crtc, new_crtc_state, i) {
 		decon = crtc_to_decon(crtc);
 		if (hibernation_crtc_mask & drm_crtc_mask(crtc))
@@ -523,6 +758,26 @@ static void commit_kthread_work(struct kthread_work *work)
 	commit_tail(old_state);
 }
 
+static void commit_stage_kthread_work(struct kthread_work *work)
+{
+	struct exynos_drm_crtc_state *old_exynos_crtc_state =
+		container_of(work, struct exynos_drm_crtc_state, commit_work);
+	struct drm_atomic_state *old_state = old_exynos_crtc_state->base.state;
+	struct exynos_commit_sync *sync = old_exynos_crtc_state->commit_sync;
+
+	BUG_ON(!old_state || !sync);
+
+	/* state stays alive until the commit tail passes the barrier below */
+	DPU_ATRACE_BEGIN("wait_for_commit_prologue");
+	wait_for_completion(&sync->prologue_done);
+	DPU_ATRACE_END("wait_for_commit_prologue");
+
+	exynos_atomic_commit_crtc_stage(old_state, old_exynos_crtc_state->base.crtc);
+
+	if (atomic_dec_and_test(&sync->stages_left))
+		complete(&sync->stages_done);
+}
+
 static void commit_work(struct work_struct *work)
 {
 	struct drm_atomic_state *old_state =
@@ -531,28 +786,86 @@ static void commit_work(struct work_struct *work)
 	commit_tail(old_state);
 }
 
+/*
+ * A commit can be split into per-CRTC stages if it only updates displays which
+ * stay active, and no plane moves between them. Returns the number of stages,
+ * or 0 if the commit isn't split.
+ */
+static int exynos_atomic_commit_stage_cnt(struct drm_atomic_state *old_state)
+{
+	struct drm_crtc *crtc;
+	struct drm_crtc_state *old_crtc_state, *new_crtc_state;
+	struct drm_plane *plane;
+	struct drm_plane_state *old_plane_state, *new_plane_state;
+	int i, crtc_cnt = 0;
+
+	for_each_oldnew_crtc_in_state(old_state, crtc, old_crtc_state, new_crtc_state, i) {
+		if (!old_crtc_state->active || !new_crtc_state->active ||
+		    drm_atomic_crtc_needs_modeset(new_crtc_state) ||
+		    old_crtc_state->self_refresh_active)
+			return 0;
+		crtc_cnt++;
+	}
+
+	if (crtc_cnt < 2)
+		return 0;
+
+	for_each_oldnew_plane_in_state(old_state, plane, old_plane_state, new_plane_state, i) {
+		if (old_plane_state->crtc && new_plane_state->crtc &&
+		    old_plane_state->crtc != new_plane_state->crtc)
+			return 0;
+	}
+
+	return crtc_cnt;
+}
+
 static void exynos_atomic_queue_work(struct drm_atomic_state *old_state)
 {
 	struct drm_crtc *crtc;
 	struct drm_crtc_state *old_crtc_state;
+	struct exynos_commit_sync *sync = NULL;
+	const int stage_cnt = exynos_atomic_commit_stage_cnt(old_state);
 	int i;
 
 	/*
-	 * queuing to first decon worker in atomic commit even if there are
-	 * multiple displays updated within same commit
-	 *
-	 * TODO: can work be split per display?
+	 * commit tail is queued to the first decon worker. If several active
+	 * displays are updated, the others get a stage of the commit queued to
+	 * their own decon worker, so they are updated in parallel. Stages are
+	 * queued here rather than from the commit tail, to keep the order of
+	 * commits on each worker and not get stuck behind a later commit which
+	 * waits for this one.
 	 */
 	for_each_old_crtc_in_state(old_state, crtc, old_crtc_state, i) {
+		struct exynos_drm_crtc_state *old_exynos_crtc_state =
+			to_exynos_crtc_state(old_crtc_state);
 		struct decon_device *decon = crtc_to_decon(crtc);
-		struct kthread_work *work = &to_exynos_crtc_state(old_crtc_state)->commit_work;
+		struct kthread_work *work = &old_exynos_crtc_state->commit_work;
+
+		if (sync) {
+			old_exynos_crtc_state->commit_sync = sync;
+			kthread_init_work(work, commit_stage_kthread_work);
+			kthread_queue_work(&decon->worker, work);
+			continue;
+		}
+
+		if (stage_cnt) {
+			sync = &old_exynos_crtc_state->sync;
+			init_completion(&sync->prologue_done);
+			init_completion(&sync->stages_done);
+			atomic_set(&sync->stages_left, stage_cnt - 1);
+			old_exynos_crtc_state->commit_sync = sync;
+		}
 
 		kthread_init_work(work, commit_kthread_work);
 		kthread_queue_work(&decon->worker, work);
 
-		return;
+		if (!sync)
+			return;
 	}
 
+	if (sync)
+		return;
+
 	/* fallback to regular commit work if we get here (no crtcs in commit state) */
 	INIT_WORK(&old_state->commit_work, commit_work);
 	queue_work(system_highpri_wq, &old_state->commit_work);
@@ -22,6 +22,7 @@
 #include <drm/drm_property.h>
 #include <drm/drm_file.h>
 #include <drm/samsung_drm.h>
+#include <linux/dma-fence.h>
 #include <linux/kthread.h>
 #include <linux/module.h>
 
@@ -29,6 +30,8 @@
 
 #include "exynos_drm_connector.h"
 #include "exynos_drm_dqe.h"
+#include "exynos_drm_fence_latency.h"
+#include "exynos_drm_te_model.h"
 
 #define MAX_CRTC	3
 #define MAX_PLANE	MAX_WIN_PER_DECON
@@ -123,6 +126,20 @@ struct exynos_drm_plane_state {
 	struct drm_property_blob *gm;
 	struct drm_property_blob *tm;
 	struct drm_property_blob *block;
+
+	/*
+	 * @fence_deferred: fence is waited for by the DECON trigger instead of
+	 *		    the commit tail, see exynos_atomic_defer_fences()
+	 * @fence_cb: callback installed on the deferred fence
+	 * @fence_crtc_state: new CRTC state the deferred fence is counted in
+	 * @fence_wait_ts: time the commit started waiting for the fence
+	 * @fence_ready_ts: time the deferred fence signaled
+	 */
+	bool fence_deferred;
+	struct dma_fence_cb fence_cb;
+	struct exynos_drm_crtc_state *fence_crtc_state;
+	ktime_t fence_wait_ts;
+	ktime_t fence_ready_ts;
 };
 
 static inline struct exynos_drm_plane_state *
@@ -233,6 +250,21 @@ struct exynos_drm_crtc_ops {
 			const struct drm_crtc_state *new_crtc_state);
 };
 
+/*
+ * Commit to several active displays is split into per-CRTC stages, each run on
+ * the worker of its DECON. The shared steps (fence waits, BTS votes, cleanup)
+ * are done by the worker which runs the commit tail.
+ *
+ * @prologue_done: shared steps before the stages are done
+ * @stages_left: stages run on the other DECON workers that didn't finish yet
+ * @stages_done: signaled when @stages_left drops to zero
+ */
+struct exynos_commit_sync {
+	struct completion prologue_done;
+	atomic_t stages_left;
+	struct completion stages_done;
+};
+
 struct exynos_drm_crtc_state {
 	struct drm_crtc_state base;
 	uint32_t color_mode;
@@ -250,6 +282,11 @@ struct exynos_drm_crtc_state {
 	struct drm_gem_object *cgc_gem;
 	enum exynos_drm_writeback_type wb_type;
 	u8 seamless_mode_changed : 1;
+	/**
+	 * @cgc_gem_changed: cgc_lut_fd was set in this commit, the CGC LUT buffer
+	 *                   is loaded again even if it is the same buffer
+	 */
+	u8 cgc_gem_changed : 1;
 	/**
 	 * @bypass: when in this mode any DPU programming is bypassed but all
 	 *          power/regulators are kept enabled
@@ -275,6 +312,16 @@ struct exynos_drm_crtc_state {
 	 */
 	u8 hibernation_exit : 1;
 
+	/**
+	 * @fences_deferred: plane fences of this commit are waited for by the
+	 *		     trigger, see exynos_atomic_defer_fences()
+	 */
+	u8 fences_deferred : 1;
+	/* deferred plane fences of this commit that didn't signal yet */
+	atomic_t fences_pending;
+	/* time the last plane fence of this commit signaled */
+	ktime_t fences_ready_ts;
+
 	unsigned int reserved_win_mask;
 	unsigned int visible_win_mask;
 	struct drm_rect partial_region;
@@ -282,6 +329,10 @@ struct exynos_drm_crtc_state {
 	bool needs_reconfigure;
 
 	struct kthread_work commit_work;
+	/* set in the old states of a commit split into per-CRTC stages */
+	struct exynos_commit_sync *commit_sync;
+	/* storage for commit_sync, used in the state of the CRTC running the commit tail */
+	struct exynos_commit_sync sync;
 };
 
 static inline struct exynos_drm_crtc_state *
@@ -326,6 +377,17 @@ struct exynos_drm_crtc {
 	} props;
 	u8 active_state;
 	u32 rcd_plane_mask;
+
+	/* estimate of the panel TE timing, updated from the TE interrupt */
+	struct te_model te_model;
+	spinlock_t te_model_lock;
+
+	/* wait for plane fences at the trigger instead of the commit tail */
+	bool defer_fences;
+	/* woken up when the last deferred plane fence of a commit signals */
+	wait_queue_head_t fence_wq;
+	/* time from the last plane fence signaling until the trigger */
+	struct fence_latency fence_latency;
 };
 
 struct drm_exynos_file_private {
@@ -403,6 +465,8 @@ int exynos_atomic_commit(struct drm_device *dev, struct drm_atomic_state *state,
 int exynos_atomic_check(struct drm_device *dev, struct drm_atomic_state *state);
 int exynos_atomic_enter_tui(void);
 int exynos_atomic_exit_tui(void);
+int exynos_atomic_wait_for_deferred_fences(struct drm_atomic_state *state,
+					   struct drm_crtc *crtc);
 
 extern struct platform_driver decon_driver;
 extern struct platform_driver dsim_driver;
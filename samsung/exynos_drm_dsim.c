@@ -37,6 +37,7 @@
 #include <linux/regulator/consumer.h>
 #include <linux/component.h>
 #include <linux/iommu.h>
+#include <linux/mm.h>
 
 #include <video/mipi_display.h>
 
@@ -119,6 +120,8 @@ MODULE_DEVICE_TABLE(of, dsim_of_match);
 
 static int dsim_calc_underrun(const struct dsim_device *dsim, uint32_t hs_clock_mhz,
 		uint32_t *underrun);
+static void dsim_hop_restore_locked(struct dsim_device *dsim, struct dsim_pll_param *p);
+static void dsim_hop_select_locked(struct dsim_device *dsim, struct dsim_pll_param *p);
 
 static struct drm_crtc *drm_encoder_get_new_crtc(struct drm_encoder *encoder,
 						 struct drm_atomic_state *state)
@@ -393,10 +396,84 @@ static void __dsim_cmd_packetgo_enable_locked(struct dsim_device *dsim, bool en)
 	}
 }
 
+static inline void dsim_cmd_prof_begin(struct dsim_device *dsim)
+{
+	if (dsim->cmd_prof)
+		memset(dsim->cmd_prof->cur_ns, 0, sizeof(dsim->cmd_prof->cur_ns));
+}
+
+static inline void
+dsim_cmd_prof_add(struct dsim_device *dsim, enum dsim_cmd_prof_stage stage, ktime_t start)
+{
+	if (dsim->cmd_prof)
+		dsim->cmd_prof->cur_ns[stage] += ktime_to_ns(ktime_sub(ktime_get(), start));
+}
+
+static struct dsim_cmd_prof_entry *
+dsim_cmd_prof_get_entry(struct dsim_cmd_prof *prof, u8 type, u8 opcode)
+{
+	const u32 hash = (type * 31 + opcode) % DSIM_CMD_PROF_SLOTS;
+	u32 i;
+
+	for (i = 0; i < DSIM_CMD_PROF_SLOTS; i++) {
+		struct dsim_cmd_prof_entry *e =
+			&prof->entries[(hash + i) % DSIM_CMD_PROF_SLOTS];
+
+		if (!e->used) {
+			e->used = true;
+			e->type = type;
+			e->opcode = opcode;
+			return e;
+		}
+
+		if (e->type == type && e->opcode == opcode)
+			return e;
+	}
+
+	return NULL;
+}
+
+static void dsim_cmd_prof_record(struct dsim_device *dsim, const struct mipi_dsi_msg *msg,
+				 ktime_t start)
+{
+	struct dsim_cmd_prof *prof = dsim->cmd_prof;
+	struct dsim_cmd_prof_entry *e;
+	const u8 opcode = msg->tx_len ? ((const u8 *)msg->tx_buf)[0] : 0;
+	s64 queue_ns;
+	int i;
+
+	if (!prof)
+		return;
+
+	queue_ns = ktime_to_ns(ktime_sub(ktime_get(), start)) -
+		   prof->cur_ns[DSIM_CMD_PROF_VBLANK] - prof->cur_ns[DSIM_CMD_PROF_FIFO];
+	prof->cur_ns[DSIM_CMD_PROF_QUEUE] = max_t(s64, queue_ns, 0);
+
+	e = dsim_cmd_prof_get_entry(prof, msg->type, opcode);
+	if (!e) {
+		prof->dropped++;
+		return;
+	}
+
+	e->cnt++;
+	for (i = 0; i < DSIM_CMD_PROF_STAGE_MAX; i++) {
+		const u64 ns = prof->cur_ns[i];
+		const u64 us = div_u64(ns, NSEC_PER_USEC);
+
+		e->hist[i][min_t(u32, fls64(us), DSIM_CMD_PROF_BUCKETS - 1)]++;
+		e->total_ns[i] += ns;
+		e->max_ns[i] = max(e->max_ns[i], ns);
+	}
+}
+
+static int dsim_cmd_tx_wait_locked(struct dsim_device *dsim);
+
 static void __dsim_check_pend_cmd_locked(struct dsim_device *dsim)
 {
 	WARN_ON(!mutex_is_locked(&dsim->cmd_lock));
 
+	dsim_cmd_tx_wait_locked(dsim);
+
 	if (WARN_ON(dsim_reg_has_pend_cmd(dsim->id)))
 		dsim_dump(dsim);
 
@@ -462,6 +539,7 @@ static void _dsim_disable(struct dsim_device *dsim)
 
 	/* Wait for current read & write CMDs. */
 	mutex_lock(&dsim->cmd_lock);
+	dsim_cmd_tx_wait_locked(dsim);
 	mutex_lock(&g_dsim_lock);
 	/* TODO: 0x1F will be changed */
 	dsim_reg_stop(dsim->id, 0x1F);
@@ -472,6 +550,8 @@ static void _dsim_disable(struct dsim_device *dsim)
 	__dsim_check_pend_cmd_locked(dsim);
 
 	dsim->force_batching = false;
+	dsim->commit_batch.active = false;
+	dsim->commit_batch.owner = NULL;
 	mutex_unlock(&dsim->cmd_lock);
 	mutex_unlock(&dsim->state_lock);
 
@@ -557,6 +637,7 @@ static void dsim_modes_release(struct dsim_pll_params *pll_params)
 		kfree(pll_params->params);
 	}
 	kfree(pll_params->features);
+	kvfree(pll_params->table.cands);
 
 	kfree(pll_params);
 }
@@ -640,8 +721,17 @@ static int dsim_set_clock_mode(struct dsim_device *dsim,
 	if (!p)
 		return -ENOENT;
 
+	/* start from the DT settings, the mode may have been hopped before */
+	dsim_hop_restore_locked(dsim, p);
+
 	if (!dsim_calc_underrun(dsim, p->pll_freq, &underrun_cnt))
 		p->cmd_underrun_cnt = underrun_cnt;
+	else
+		dsim_warn(dsim, "%s: frame doesn't fit in a TE period at %uMHz\n",
+			  p->name, p->pll_freq);
+
+	/* the new mode may need a different clock to stay out of the forbidden bands */
+	dsim_hop_select_locked(dsim, p);
 
 	dsim_update_clock_config(dsim, p);
 	dsim->current_pll_param = p;
@@ -777,6 +867,39 @@ read_node_fail:
 	return NULL;
 }
 
+/*
+ * Solve every HS clock of the PLL output range once, so that clock changes are
+ * a lookup. Without the table clocks are still solved on demand.
+ */
+static void dsim_pll_table_build(struct dsim_device *dsim, struct dsim_pll_params *pll_params)
+{
+	const struct dsim_pll_features *features = pll_params->features;
+	struct dsim_pll_table *table = &pll_params->table;
+	u32 min_mhz, max_mhz, valid = 0, i;
+
+	if (!features)
+		return;
+
+	min_mhz = DIV_ROUND_UP_ULL(features->fout_min, DSIM_PLL_HZ_PER_MHZ);
+	max_mhz = div_u64(features->fout_max, DSIM_PLL_HZ_PER_MHZ);
+	if (max_mhz < min_mhz)
+		return;
+
+	table->cands = kvcalloc(max_mhz - min_mhz + 1, sizeof(*table->cands), GFP_KERNEL);
+	if (!table->cands)
+		return;
+
+	table->min_mhz = min_mhz;
+	table->num = max_mhz - min_mhz + 1;
+
+	for (i = 0; i < table->num; i++)
+		if (!dsim_pll_solve(features, min_mhz + i, &table->cands[i]))
+			valid++;
+
+	dsim_info(dsim, "pll table: %u of %u clocks in %u-%uMHz\n", valid, table->num,
+		  min_mhz, max_mhz);
+}
+
 static struct dsim_pll_params *dsim_of_get_clock_mode(struct dsim_device *dsim)
 {
 	struct device *dev = dsim->dev;
@@ -835,6 +958,7 @@ static struct dsim_pll_params *dsim_of_get_clock_mode(struct dsim_device *dsim)
 	}
 
 	pll_params->features = dsim_of_get_pll_features(dsim, np);
+	dsim_pll_table_build(dsim, pll_params);
 
 	of_node_put(np);
 	of_node_put(mode_np);
@@ -856,6 +980,7 @@ getnode_fail:
 static void dsim_restart(struct dsim_device *dsim)
 {
 	mutex_lock(&dsim->cmd_lock);
+	dsim_cmd_tx_wait_locked(dsim);
 	mutex_lock(&g_dsim_lock);
 	dsim_reg_stop(dsim->id, 0x1F);
 	mutex_unlock(&g_dsim_lock);
@@ -1930,36 +2055,28 @@ static int dsim_wait_for_cmd_fifo_empty(struct dsim_device *dsim, bool is_long)
 static void
 dsim_write_payload(struct dsim_device *dsim, const u8* buf, size_t len)
 {
-	const u8 *p = buf;
-	const u8 *end = buf + len;
-	u32 payload;
-
 	dsim_debug(dsim, "payload length(%lu)\n", len);
 
-	while (p < end) {
-		size_t pkt_size = min_t(size_t, 4, end - p);
-
-		if (pkt_size >= 4)
-			payload = p[0] | p[1] << 8 | p[2] << 16 | p[3] << 24;
-		else if (pkt_size == 3)
-			payload = p[0] | p[1] << 8 | p[2] << 16;
-		else if (pkt_size == 2)
-			payload = p[0] | p[1] << 8;
-		else if (pkt_size == 1)
-			payload = p[0];
+	dsim_reg_wr_tx_payload_buf(dsim->id, buf, len);
+}
 
-		dsim_reg_wr_tx_payload(dsim->id, payload);
-		dsim_debug(dsim, "payload: 0x%x\n", payload);
+/* payload already packed into TX FIFO words by the sender */
+static void
+dsim_write_payload_words(struct dsim_device *dsim, const u32 *words, size_t len)
+{
+	dsim_debug(dsim, "packed payload length(%lu)\n", len);
 
-		p += pkt_size;
-	}
+	dsim_reg_wr_tx_payload_words(dsim->id, words, DIV_ROUND_UP(len, 4));
 }
 
-static void __dsim_cmd_write_locked(struct dsim_device *dsim, const struct mipi_dsi_packet *packet)
+static void __dsim_cmd_write_locked(struct dsim_device *dsim, const struct mipi_dsi_packet *packet,
+				    const u32 *pl_words)
 {
 	WARN_ON(!mutex_is_locked(&dsim->cmd_lock));
 
-	if (packet->payload_length > 0)
+	if (packet->payload_length > 0 && pl_words)
+		dsim_write_payload_words(dsim, pl_words, packet->payload_length);
+	else if (packet->payload_length > 0)
 		dsim_write_payload(dsim, packet->payload, packet->payload_length);
 	dsim_reg_wr_tx_header(dsim->id, packet->header[0], packet->header[1], packet->header[2],
 			      false);
@@ -1970,7 +2087,8 @@ static void __dsim_cmd_write_locked(struct dsim_device *dsim, const struct mipi_
 }
 
 static void dsim_cmd_packetgo_queue_locked(struct dsim_device *dsim,
-					   const struct mipi_dsi_packet *packet)
+					   const struct mipi_dsi_packet *packet,
+					   const u32 *pl_words)
 {
 	/* if this is the first packet being queued, enable packet go feature */
 	if (!dsim->total_pend_ph)
@@ -1979,7 +2097,7 @@ static void dsim_cmd_packetgo_queue_locked(struct dsim_device *dsim,
 	dsim->total_pend_ph++;
 	dsim->total_pend_pl += ALIGN(packet->payload_length, 4);
 
-	__dsim_cmd_write_locked(dsim, packet);
+	__dsim_cmd_write_locked(dsim, packet, pl_words);
 
 	dsim_debug(dsim, "total pending packet header(%u) payload(%u)\n", dsim->total_pend_ph,
 		   dsim->total_pend_pl);
@@ -1995,10 +2113,52 @@ static void __dsim_cmd_prepare(struct dsim_device *dsim)
 	reinit_completion(&dsim->pl_wr_comp);
 }
 
-static int dsim_cmd_packetgo_flush_locked(struct dsim_device *dsim)
+/*
+ * Waits for the command transfer started last to drain out of the command
+ * fifos. Errors are logged here, they belong to the msg which started it.
+ */
+static int dsim_cmd_tx_wait_locked(struct dsim_device *dsim)
+{
+	int ret;
+
+	WARN_ON(!mutex_is_locked(&dsim->cmd_lock));
+
+	if (!dsim->tx_pending)
+		return 0;
+
+	ret = dsim_wait_for_cmd_fifo_empty(dsim, dsim->tx_pending_long);
+	if (ret)
+		dsim_warn(dsim, "failed on wait for cmd fifo empty (%d)\n", ret);
+
+	dsim->tx_pending = false;
+
+	/* clear packetgo pending (even if it timed out) */
+	if (dsim_cmd_packetgo_is_enabled(dsim))
+		__dsim_cmd_packetgo_enable_locked(dsim, false);
+
+	return ret;
+}
+
+/* waits for the transfer the current msg just started */
+static int dsim_cmd_tx_wait_prof_locked(struct dsim_device *dsim)
 {
+	const ktime_t start = ktime_get();
 	int ret;
 
+	ret = dsim_cmd_tx_wait_locked(dsim);
+	dsim_cmd_prof_add(dsim, DSIM_CMD_PROF_FIFO, start);
+
+	return ret;
+}
+
+static void dsim_cmd_tx_start_locked(struct dsim_device *dsim, bool is_long)
+{
+	dsim->tx_pending = true;
+	dsim->tx_pending_long = is_long;
+}
+
+static int dsim_cmd_packetgo_flush_locked(struct dsim_device *dsim, bool async)
+{
 	/* this should only be called with pending packets */
 	WARN_ON(!dsim->total_pend_ph);
 
@@ -2008,26 +2168,24 @@ static int dsim_cmd_packetgo_flush_locked(struct dsim_device *dsim)
 	dsim_debug(dsim, "packet go ready (ph: %d, pl: %d)\n", dsim->total_pend_ph,
 		   dsim->total_pend_pl);
 
-	ret = dsim_wait_for_cmd_fifo_empty(dsim, dsim->total_pend_pl > 0);
-	if (ret)
-		dsim_warn(dsim, "packetgo failed on wait for cmd fifo empty (%d)\n", ret);
-
-	/* clear packetgo pending (even if it timed out) */
-	__dsim_cmd_packetgo_enable_locked(dsim, false);
+	dsim_cmd_tx_start_locked(dsim, dsim->total_pend_pl > 0);
 
-	return ret;
+	return async ? 0 : dsim_cmd_tx_wait_prof_locked(dsim);
 }
 
 static int dsim_write_single_cmd_locked(struct dsim_device *dsim,
-					const struct mipi_dsi_packet *packet)
+					const struct mipi_dsi_packet *packet,
+					const u32 *pl_words, bool async)
 {
 	WARN_ON(dsim_cmd_packetgo_is_enabled(dsim));
 
 	__dsim_cmd_prepare(dsim);
 
-	__dsim_cmd_write_locked(dsim, packet);
+	__dsim_cmd_write_locked(dsim, packet, pl_words);
+
+	dsim_cmd_tx_start_locked(dsim, packet->payload_length > 0);
 
-	return dsim_wait_for_cmd_fifo_empty(dsim, packet->payload_length > 0);
+	return async ? 0 : dsim_cmd_tx_wait_prof_locked(dsim);
 }
 
 /*
@@ -2055,6 +2213,7 @@ static void need_wait_vblank(struct dsim_device *dsim)
 	struct drm_vblank_crtc *vblank;
 	struct drm_crtc *crtc;
 	ktime_t last_vblanktime, diff, cur_time;
+	u32 framedur_ns;
 	int ready_allow_period;
 
 	if (!decon)
@@ -2068,11 +2227,13 @@ static void need_wait_vblank(struct dsim_device *dsim)
 		return;
 
 	vblank = &crtc->dev->vblank[crtc->index];
-	ready_allow_period =
-		mult_frac(vblank->framedur_ns, 95, 100) - PKTGO_READY_MARGIN_NS;
+	framedur_ns = vblank->framedur_ns;
 
-	drm_crtc_vblank_count_and_time(crtc, &last_vblanktime);
 	cur_time = ktime_get();
+	/* the TE model tracks the real panel period across refresh rate switches */
+	if (!exynos_drm_crtc_te_predict(crtc, cur_time, &last_vblanktime, &framedur_ns))
+		drm_crtc_vblank_count_and_time(crtc, &last_vblanktime);
+	ready_allow_period = mult_frac(framedur_ns, 95, 100) - PKTGO_READY_MARGIN_NS;
 	diff = ktime_sub_ns(cur_time, last_vblanktime);
 
 	dsim_debug(dsim, "last(%lld) cur(%lld) diff(%lld) ready allow period(%d)\n",
@@ -2088,22 +2249,46 @@ static void need_wait_vblank(struct dsim_device *dsim)
 
 #define PL_FIFO_THRESHOLD	mult_frac(MAX_PL_FIFO, 75, 100) /* 75% */
 #define IS_LAST(flags)		(((flags) & MIPI_DSI_MSG_LASTCOMMAND) != 0)
+
+static int dsim_cmd_commit_batch_flush_locked(struct dsim_device *dsim);
+
+/* only the commit thread's own commands are held back for the batch */
+static inline bool dsim_cmd_commit_batch_merging(const struct dsim_device *dsim)
+{
+	return dsim->commit_batch.active && dsim->commit_batch.owner == current;
+}
+
 static int dsim_write_data_locked(struct dsim_device *dsim, const struct mipi_dsi_msg *msg)
 {
 	int ret = 0;
 	const u16 flags = msg->flags;
 	bool is_last;
 	struct mipi_dsi_packet packet = { .size = 0 };
+	const u32 *pl_words = NULL;
+	const bool async = (flags & EXYNOS_DSI_MSG_ASYNC) != 0;
 
 	WARN_ON(!mutex_is_locked(&dsim->cmd_lock));
 
+	/* order after the transfer started last, its errors were logged already */
+	dsim_cmd_tx_wait_locked(dsim);
+
 	if (msg->tx_len > 0) {
 		const u8 *tx_buf = msg->tx_buf;
 
-		ret = mipi_dsi_create_packet(&packet, msg);
-		if (ret) {
-			dsim_err(dsim, "unable to create dsi packet (%d)\n", ret);
-			return 0;
+		if (flags & EXYNOS_DSI_MSG_PACKED) {
+			const struct exynos_dsi_packet *pkt = to_exynos_dsi_msg(msg)->packet;
+
+			memcpy(packet.header, pkt->header, sizeof(packet.header));
+			packet.payload_length = pkt->payload_len;
+			packet.payload = pkt->payload_len ? msg->tx_buf : NULL;
+			packet.size = sizeof(packet.header) + packet.payload_length;
+			pl_words = pkt->payload;
+		} else {
+			ret = mipi_dsi_create_packet(&packet, msg);
+			if (ret) {
+				dsim_err(dsim, "unable to create dsi packet (%d)\n", ret);
+				return 0;
+			}
 		}
 
 		DPU_EVENT_LOG_CMD(dsim, msg->type, tx_buf[0], msg->tx_len);
@@ -2114,7 +2299,7 @@ static int dsim_write_data_locked(struct dsim_device *dsim, const struct mipi_ds
 		if (flags & (EXYNOS_DSI_MSG_FORCE_BATCH | EXYNOS_DSI_MSG_FORCE_FLUSH))
 			dsim_warn(dsim, "force batching is attempted in video mode\n");
 		if (packet.size)
-			ret = dsim_write_single_cmd_locked(dsim, &packet);
+			ret = dsim_write_single_cmd_locked(dsim, &packet, pl_words, async);
 		goto err;
 	}
 
@@ -2134,8 +2319,27 @@ static int dsim_write_data_locked(struct dsim_device *dsim, const struct mipi_ds
 		goto err;
 	}
 
+	/* an empty msg only pushes out the commands merged so far */
+	if (!packet.size && (flags & EXYNOS_DSI_MSG_NO_MERGE)) {
+		if (dsim_cmd_commit_batch_merging(dsim))
+			ret = dsim_cmd_commit_batch_flush_locked(dsim);
+		goto err;
+	}
+
 	is_last = (IS_LAST(flags) && !dsim->force_batching) || (flags & EXYNOS_DSI_MSG_FORCE_FLUSH);
 
+	if (is_last && dsim->commit_batch.active &&
+	    !(flags & (EXYNOS_DSI_MSG_FORCE_FLUSH | EXYNOS_DSI_MSG_NO_MERGE))) {
+		if (dsim_cmd_commit_batch_merging(dsim)) {
+			is_last = false;
+			dsim->commit_batch.merged_cnt++;
+			if (!(flags & EXYNOS_DSI_MSG_IGNORE_VBLANK))
+				dsim->commit_batch.wait_vblank = true;
+		} else {
+			dsim->commit_batch.other_cnt++;
+		}
+	}
+
 	if (flags & EXYNOS_DSI_MSG_FORCE_FLUSH) {
 		dsim->force_batching = false;
 		/* force batching should happen only with empty msg */
@@ -2156,17 +2360,23 @@ static int dsim_write_data_locked(struct dsim_device *dsim, const struct mipi_ds
 	if (is_last) {
 		if (dsim_cmd_packetgo_is_enabled(dsim)) {
 			if (packet.size > 0)
-				dsim_cmd_packetgo_queue_locked(dsim, &packet);
+				dsim_cmd_packetgo_queue_locked(dsim, &packet, pl_words);
+
+			/* merged commit commands queued so far go out with this one */
+			if (!(flags & EXYNOS_DSI_MSG_IGNORE_VBLANK) || dsim->commit_batch.wait_vblank) {
+				const ktime_t start = ktime_get();
 
-			if (!(flags & EXYNOS_DSI_MSG_IGNORE_VBLANK))
 				need_wait_vblank(dsim);
+				dsim_cmd_prof_add(dsim, DSIM_CMD_PROF_VBLANK, start);
+			}
 
-			ret = dsim_cmd_packetgo_flush_locked(dsim);
+			ret = dsim_cmd_packetgo_flush_locked(dsim, async);
+			dsim->commit_batch.wait_vblank = false;
 		} else if (packet.size > 0) {
-			ret = dsim_write_single_cmd_locked(dsim, &packet);
+			ret = dsim_write_single_cmd_locked(dsim, &packet, pl_words, async);
 		}
 	} else if (packet.size > 0) {
-		dsim_cmd_packetgo_queue_locked(dsim, &packet);
+		dsim_cmd_packetgo_queue_locked(dsim, &packet, pl_words);
 	}
 
 err:
@@ -2175,6 +2385,83 @@ err:
 	return ret;
 }
 
+static int dsim_cmd_commit_batch_flush_locked(struct dsim_device *dsim)
+{
+	const struct decon_device *decon = dsim_get_decon(dsim);
+	int ret;
+
+	WARN_ON(!mutex_is_locked(&dsim->cmd_lock));
+
+	/* nothing queued, or the queued packets were flushed already */
+	if (!dsim_cmd_packetgo_is_enabled(dsim) || dsim->tx_pending || dsim->force_batching)
+		return 0;
+
+	if (dsim->commit_batch.wait_vblank)
+		need_wait_vblank(dsim);
+
+	if (dsim->commit_batch.merged_cnt) {
+		dsim->commit_batch.flush_cnt++;
+		dsim->commit_batch.merged_total += dsim->commit_batch.merged_cnt;
+	}
+
+	if (decon)
+		DPU_EVENT_LOG(DPU_EVT_DSIM_CMD_BATCH, decon->id, dsim);
+
+	ret = dsim_cmd_packetgo_flush_locked(dsim, false);
+
+	dsim->commit_batch.wait_vblank = false;
+	dsim->commit_batch.merged_cnt = 0;
+
+	return ret;
+}
+
+void dsim_cmd_commit_batch_begin(struct dsim_device *dsim)
+{
+	struct dsim_device *sec_dsi;
+
+	if (dsim->config.mode != DSIM_COMMAND_MODE)
+		return;
+
+	mutex_lock(&dsim->cmd_lock);
+	dsim->commit_batch.active = true;
+	dsim->commit_batch.owner = current;
+	dsim->commit_batch.wait_vblank = false;
+	dsim->commit_batch.merged_cnt = 0;
+	mutex_unlock(&dsim->cmd_lock);
+
+	if (dsim->dual_dsi == DSIM_DUAL_DSI_MAIN) {
+		sec_dsi = exynos_get_dual_dsi(DSIM_DUAL_DSI_SEC);
+		if (sec_dsi)
+			dsim_cmd_commit_batch_begin(sec_dsi);
+	}
+}
+
+void dsim_cmd_commit_batch_end(struct dsim_device *dsim)
+{
+	struct dsim_device *sec_dsi;
+	int ret;
+
+	if (dsim->config.mode != DSIM_COMMAND_MODE)
+		return;
+
+	mutex_lock(&dsim->cmd_lock);
+	if (dsim->commit_batch.active) {
+		dsim->commit_batch.active = false;
+		dsim->commit_batch.owner = NULL;
+
+		ret = dsim_cmd_commit_batch_flush_locked(dsim);
+		if (ret)
+			dsim_warn(dsim, "failed to flush commit commands (%d)\n", ret);
+	}
+	mutex_unlock(&dsim->cmd_lock);
+
+	if (dsim->dual_dsi == DSIM_DUAL_DSI_MAIN) {
+		sec_dsi = exynos_get_dual_dsi(DSIM_DUAL_DSI_SEC);
+		if (sec_dsi)
+			dsim_cmd_commit_batch_end(sec_dsi);
+	}
+}
+
 static int
 dsim_req_read_command(struct dsim_device *dsim, const struct mipi_dsi_msg *msg)
 {
@@ -2211,6 +2498,12 @@ dsim_read_data(struct dsim_device *dsim, const struct mipi_dsi_msg *msg)
 		return -EINVAL;
 	}
 
+	dsim_cmd_tx_wait_locked(dsim);
+
+	/* read request can't pass the packets merged so far */
+	if (dsim->commit_batch.active)
+		dsim_cmd_commit_batch_flush_locked(dsim);
+
 	/* Init RX FIFO before read and clear DSIM_INTSRC */
 	dsim_reg_clear_int(dsim->id, DSIM_INTSRC_RX_DATA_DONE);
 
@@ -2319,6 +2612,7 @@ static ssize_t dsim_host_transfer(struct mipi_dsi_host *host,
 {
 	struct dsim_device *dsim = host_to_dsi(host);
 	struct dsim_device *sec_dsi;
+	const ktime_t start = ktime_get();
 	int ret;
 
 	DPU_ATRACE_BEGIN(__func__);
@@ -2343,6 +2637,7 @@ static ssize_t dsim_host_transfer(struct mipi_dsi_host *host,
 		ret = dsim_read_data(dsim, msg);
 		break;
 	default:
+		dsim_cmd_prof_begin(dsim);
 		ret = dsim_write_data_locked(dsim, msg);
 		if (dsim->dual_dsi == DSIM_DUAL_DSI_MAIN) {
 			sec_dsi = exynos_get_dual_dsi(DSIM_DUAL_DSI_SEC);
@@ -2351,6 +2646,7 @@ static ssize_t dsim_host_transfer(struct mipi_dsi_host *host,
 			else
 				dsim_err(dsim, "could not get secondary dsi\n");
 		}
+		dsim_cmd_prof_record(dsim, msg, start);
 		break;
 	}
 
@@ -2372,72 +2668,6 @@ static const struct mipi_dsi_host_ops dsim_host_ops = {
 	.transfer = dsim_host_transfer,
 };
 
-static int dsim_calc_pmsk(struct dsim_pll_features *pll_features,
-			 struct stdphy_pms *pms, unsigned int hs_clock_mhz)
-{
-	uint64_t hs_clock;
-	uint64_t fvco, q;
-	uint32_t p, m, s, k;
-
-	p = DIV_ROUND_CLOSEST(pll_features->finput, pll_features->foptimum);
-	if (p == 0)
-		p = 1;
-	if ((p < pll_features->p_min) || (p > pll_features->p_max)) {
-		pr_err("%s: p %u is out of range (%u, %u)\n",
-		       __func__, p, pll_features->p_min, pll_features->p_max);
-		return -EINVAL;
-	}
-
-	hs_clock = (uint64_t) hs_clock_mhz * 1000000;
-	if ((hs_clock < pll_features->fout_min) ||
-			(hs_clock > pll_features->fout_max)) {
-		pr_err("%s: hs clock %llu out of range\n", __func__, hs_clock);
-		return -EINVAL;
-	}
-
-	/* find s: vco_min <= fout * 2 ^ s <= vco_max */
-	for (s = 0, fvco = 0; fvco < pll_features->fvco_min; s++)
-		fvco = hs_clock * (1 << s);
-	--s;
-
-	if (fvco > pll_features->fvco_max) {
-		pr_err("%s: no proper s found\n", __func__);
-		return -EINVAL;
-	}
-	if ((s < pll_features->s_min) || (s > pll_features->s_max)) {
-		pr_err("%s: s %u is out of range (%u, %u)\n",
-		       __func__, s, pll_features->s_min, pll_features->s_max);
-		return -EINVAL;
-	}
-
-	/* (hs_clk * 2^s / 2) / (fin / p) = m + k / 2^k_bits */
-	fvco >>= 1;
-	q = fvco << (pll_features->k_bits + 1); /* 1 extra bit for roundup */
-	q /= pll_features->finput / p;
-
-	/* m is the integer part, k is the fraction part */
-	m = q >> (pll_features->k_bits + 1);
-	if ((m < pll_features->m_min) || (m > pll_features->m_max)) {
-		pr_err("%s: m %u is out of range (%u, %u)\n",
-		       __func__, m, pll_features->m_min, pll_features->m_max);
-		return -EINVAL;
-	}
-
-	k = q & ((1 << (pll_features->k_bits + 1)) - 1);
-	k = DIV_ROUND_UP(k, 2);
-
-	/* k is two's complement integer */
-	if (k & (1 << (pll_features->k_bits - 1)))
-		m++;
-
-	pms->p = p;
-	pms->m = m;
-	pms->s = s;
-	pms->k = k;
-
-	return 0;
-}
-
 static int dsim_calc_underrun(const struct dsim_device *dsim, uint32_t hs_clock_mhz,
 		uint32_t *underrun)
 {
@@ -2471,7 +2701,7 @@ static int dsim_calc_underrun(const struct dsim_device *dsim, uint32_t hs_clock_
 					NSEC_PER_SEC / (2 * lanes * wclk);
 
 	if (max_frame_time < min_frame_transfer_time) {
-		pr_err("%s: max frame time %llu < min frame time %llu\n",
+		pr_debug("%s: max frame time %llu < min frame time %llu\n",
 			__func__, max_frame_time, min_frame_transfer_time);
 		return -EINVAL;
 	}
@@ -2483,42 +2713,59 @@ static int dsim_calc_underrun(const struct dsim_device *dsim, uint32_t hs_clock_
 	return 0;
 }
 
-static int dsim_set_hs_clock(struct dsim_device *dsim, unsigned int hs_clock, bool apply_now)
+/* solves @hs_clock into @pll_param, without touching the clock config */
+static int dsim_pll_param_set_hs_clock(struct dsim_device *dsim,
+				       struct dsim_pll_param *pll_param, unsigned int hs_clock)
 {
-	int ret;
-	struct stdphy_pms pms;
+	const struct dsim_pll_cand *cand;
+	struct dsim_pll_cand solved;
 	uint32_t lp_underrun = 0;
-	struct dsim_pll_param *pll_param;
-
-	if (!dsim->pll_params || !dsim->pll_params->features)
-		return -ENODEV;
+	int ret;
 
-	memset(&pms, 0, sizeof(pms));
-	ret = dsim_calc_pmsk(dsim->pll_params->features, &pms, hs_clock);
-	if (ret < 0) {
+	cand = dsim_pll_table_lookup(&dsim->pll_params->table, hs_clock);
+	if (!cand && !dsim->pll_params->table.cands &&
+	    !dsim_pll_solve(dsim->pll_params->features, hs_clock, &solved))
+		cand = &solved;
+	if (!cand) {
 		dsim_err(dsim, "Failed to update pll for hsclk %d\n", hs_clock);
 		return -EINVAL;
 	}
 
-	mutex_lock(&dsim->state_lock);
 	ret = dsim_calc_underrun(dsim, hs_clock, &lp_underrun);
 	if (ret < 0) {
 		dsim_err(dsim, "Failed to update underrun\n");
-		goto out;
+		return ret;
 	}
 
+	pll_param->pll_freq = hs_clock;
+	pll_param->p = cand->p;
+	pll_param->m = cand->m;
+	pll_param->s = cand->s;
+	pll_param->k = cand->k;
+	pll_param->cmd_underrun_cnt = lp_underrun;
+
+	return 0;
+}
+
+static int dsim_set_hs_clock(struct dsim_device *dsim, unsigned int hs_clock, bool apply_now)
+{
+	int ret;
+	struct dsim_pll_param *pll_param;
+
+	if (!dsim->pll_params || !dsim->pll_params->features)
+		return -ENODEV;
+
+	mutex_lock(&dsim->state_lock);
 	pll_param = dsim->current_pll_param;
 	if (!pll_param) {
 		ret = -EAGAIN;
 		goto out;
 	}
 
-	pll_param->pll_freq = hs_clock;
-	pll_param->p = pms.p;
-	pll_param->m = pms.m;
-	pll_param->s = pms.s;
-	pll_param->k = pms.k;
-	pll_param->cmd_underrun_cnt = lp_underrun;
+	ret = dsim_pll_param_set_hs_clock(dsim, pll_param, hs_clock);
+	if (ret < 0)
+		goto out;
+
 	dsim_update_clock_config(dsim, pll_param);
 
 	if (!apply_now || dsim->state != DSIM_STATE_HSCLKEN)
@@ -2532,6 +2779,325 @@ out:
 	return ret;
 }
 
+static BLOCKING_NOTIFIER_HEAD(dsim_hop_notifier);
+
+/* called with state_lock held, as the underrun depends on the mode timing */
+static bool dsim_hop_clock_usable(void *priv, u32 hs_clock_mhz)
+{
+	struct dsim_device *dsim = priv;
+	uint32_t underrun;
+
+	if (!dsim_pll_table_lookup(&dsim->pll_params->table, hs_clock_mhz))
+		return false;
+
+	/* the frame still has to fit between two TEs at the new rate */
+	return !dsim_calc_underrun(dsim, hs_clock_mhz, &underrun);
+}
+
+/* index of @p in the DT modes, or -1 if it isn't one of them */
+static int dsim_hop_mode_index(const struct dsim_device *dsim, const struct dsim_pll_param *p)
+{
+	const struct dsim_pll_params *pll_params = dsim->pll_params;
+	unsigned int i;
+
+	for (i = 0; i < pll_params->num_modes; i++)
+		if (pll_params->params[i] == p)
+			return i;
+
+	return -1;
+}
+
+static u32 dsim_hop_nominal_mhz(const struct dsim_device *dsim, const struct dsim_pll_param *p)
+{
+	const int i = dsim_hop_mode_index(dsim, p);
+
+	return i < 0 ? p->pll_freq : dsim->hop.nominal_mhz[i];
+}
+
+/*
+ * Puts the DT settings of @p back as they were, instead of solving the nominal
+ * clock again, which may give a different PMSK than the one characterized.
+ */
+static void dsim_hop_restore_locked(struct dsim_device *dsim, struct dsim_pll_param *p)
+{
+	const int i = dsim->hop.nominal_mhz ? dsim_hop_mode_index(dsim, p) : -1;
+	const struct dsim_hop_pll *n;
+
+	if (i < 0)
+		return;
+
+	n = &dsim->hop.nominal_pll[i];
+	p->pll_freq = dsim->hop.nominal_mhz[i];
+	p->p = n->p;
+	p->m = n->m;
+	p->s = n->s;
+	p->k = n->k;
+	p->cmd_underrun_cnt = n->cmd_underrun_cnt;
+}
+
+static int dsim_hop_restore(struct dsim_device *dsim, struct dsim_pll_param *p, bool apply_now)
+{
+	mutex_lock(&dsim->state_lock);
+	dsim_hop_restore_locked(dsim, p);
+	dsim_update_clock_config(dsim, p);
+
+	if (apply_now && dsim->state == DSIM_STATE_HSCLKEN)
+		dsim_restart(dsim);
+	mutex_unlock(&dsim->state_lock);
+
+	return 0;
+}
+
+/* called with state_lock and hop->lock held */
+static u32 dsim_hop_pick_locked(struct dsim_device *dsim, u32 nominal_mhz)
+{
+	const struct dsim_hop *hop = &dsim->hop;
+
+	return dsim_hop_pick(hop->bands, hop->band_cnt, hop->nominal_mhz,
+			     dsim->pll_params->num_modes, nominal_mhz,
+			     dsim_hop_clock_usable, dsim);
+}
+
+/*
+ * Moves @p, a DT mode just restored by a mode set, to the clock picked for the
+ * current bands. Done before the clock config is written, so that the link is
+ * enabled with the right clock instead of being restarted right after.
+ */
+static void dsim_hop_select_locked(struct dsim_device *dsim, struct dsim_pll_param *p)
+{
+	struct dsim_hop *hop = &dsim->hop;
+	const u32 nominal_mhz = p->pll_freq;
+	u32 target_mhz;
+
+	if (!hop->nominal_mhz)
+		return;
+
+	mutex_lock(&hop->lock);
+	target_mhz = hop->band_cnt ? dsim_hop_pick_locked(dsim, nominal_mhz) : nominal_mhz;
+	if (!target_mhz) {
+		hop->rejected++;
+		dsim_warn(dsim, "no hs clock near %uMHz avoids the forbidden bands\n",
+			  nominal_mhz);
+	} else if (target_mhz != nominal_mhz &&
+		   dsim_pll_param_set_hs_clock(dsim, p, target_mhz)) {
+		target_mhz = 0;
+	}
+
+	hop->active = target_mhz && target_mhz != nominal_mhz;
+	if (hop->active)
+		hop->hops++;
+	mutex_unlock(&hop->lock);
+}
+
+/*
+ * Holds the CRTC lock, so that no commit can be set up, or run its tail inline,
+ * while the link is restarted, and waits for the commit set up last to be done
+ * with the hardware. Runs off the DECON worker, as the tail of that commit may
+ * still be queued there. In command mode the panel refreshes from its own
+ * memory, so the switch is seamless as long as it's done before the next frame
+ * transfer.
+ */
+static void dsim_hop_work(struct work_struct *work)
+{
+	struct dsim_hop *hop = container_of(work, struct dsim_hop, work);
+	struct dsim_device *dsim = container_of(hop, struct dsim_device, hop);
+	struct decon_device *decon = (struct decon_device *)dsim_get_decon(dsim);
+	struct dsim_pll_param *p = dsim->current_pll_param;
+	struct drm_crtc_commit *commit = NULL;
+	struct drm_crtc *crtc;
+	u32 nominal_mhz, target_mhz, prev_mhz, latency_us, frame_us;
+	bool was_active, hs_clk_en;
+	ktime_t start;
+	int ret;
+
+	if (!decon || !p)
+		return;
+
+	crtc = &decon->crtc->base;
+	drm_modeset_lock(&crtc->mutex, NULL);
+	if (crtc->state->commit)
+		commit = drm_crtc_commit_get(crtc->state->commit);
+	if (commit) {
+		ret = wait_for_completion_timeout(&commit->hw_done, 10 * HZ);
+		drm_crtc_commit_put(commit);
+		if (!ret) {
+			dsim_warn(dsim, "%s: previous commit timed out\n", __func__);
+			goto out_unlock;
+		}
+	}
+
+	DPU_ATRACE_BEGIN(__func__);
+	hibernation_block(decon->hibernation);
+
+	nominal_mhz = dsim_hop_nominal_mhz(dsim, p);
+
+	/* dsim_set_clock_mode() takes hop->lock under state_lock */
+	mutex_lock(&dsim->state_lock);
+	mutex_lock(&hop->lock);
+	if (hop->band_cnt)
+		target_mhz = dsim_hop_pick_locked(dsim, nominal_mhz);
+	else
+		target_mhz = hop->active ? nominal_mhz : p->pll_freq;
+
+	if (!target_mhz) {
+		hop->rejected++;
+		mutex_unlock(&hop->lock);
+		mutex_unlock(&dsim->state_lock);
+		dsim_warn(dsim, "no hs clock near %uMHz avoids the forbidden bands\n",
+			  nominal_mhz);
+		goto out;
+	}
+
+	was_active = hop->active;
+	hop->active = target_mhz != nominal_mhz;
+	mutex_unlock(&hop->lock);
+	prev_mhz = p->pll_freq;
+	hs_clk_en = dsim->state == DSIM_STATE_HSCLKEN;
+	mutex_unlock(&dsim->state_lock);
+
+	if (target_mhz == prev_mhz)
+		goto out;
+
+	if (!hs_clk_en) {
+		/* applied when the link is enabled again */
+		ret = target_mhz == nominal_mhz ? dsim_hop_restore(dsim, p, false) :
+			dsim_set_hs_clock(dsim, target_mhz, false);
+		goto done;
+	}
+
+	if (!decon_wait_for_frame_idle(decon))
+		dsim_warn(dsim, "%s: frame done timed out\n", __func__);
+
+	start = ktime_get();
+	ret = target_mhz == nominal_mhz ? dsim_hop_restore(dsim, p, true) :
+		dsim_set_hs_clock(dsim, target_mhz, true);
+	latency_us = ktime_us_delta(ktime_get(), start);
+
+	frame_us = USEC_PER_SEC / (dsim->config.p_timing.vrefresh ?: 60);
+	hop->max_latency_us = max(hop->max_latency_us, latency_us);
+	if (latency_us > frame_us) {
+		hop->late++;
+		dsim_warn(dsim, "hs clock switch took %uus, longer than a frame (%uus)\n",
+			  latency_us, frame_us);
+	}
+done:
+	if (!ret) {
+		hop->hops++;
+		dsim_info(dsim, "hs clock hopped %u -> %uMHz\n", prev_mhz, target_mhz);
+	} else {
+		/* still running at @prev_mhz */
+		mutex_lock(&hop->lock);
+		hop->active = was_active;
+		mutex_unlock(&hop->lock);
+		dsim_warn(dsim, "failed to hop hs clock to %uMHz (%d)\n", target_mhz, ret);
+	}
+out:
+	hibernation_unblock_enter(decon->hibernation);
+	DPU_ATRACE_END(__func__);
+out_unlock:
+	drm_modeset_unlock(&crtc->mutex);
+}
+
+static void dsim_hop_queue(struct dsim_device *dsim)
+{
+	struct decon_device *decon = (struct decon_device *)dsim_get_decon(dsim);
+
+	if (!decon || !dsim->hop.nominal_mhz)
+		return;
+
+	queue_work(system_highpri_wq, &dsim->hop.work);
+}
+
+static int dsim_hop_set_bands(struct dsim_device *dsim, const struct dsim_hop_band *bands,
+			      unsigned int cnt)
+{
+	const struct dsim_pll_params *pll_params = dsim->pll_params;
+	struct dsim_hop *hop = &dsim->hop;
+	u32 min_mhz = U32_MAX;
+	unsigned int i;
+
+	if (cnt > DSIM_HOP_MAX_BANDS)
+		return -E2BIG;
+
+	for (i = 0; i < pll_params->num_modes; i++)
+		min_mhz = min(min_mhz, dsim_hop_min_mhz(hop->nominal_mhz[i]));
+
+	for (i = 0; i < cnt; i++) {
+		if (!dsim_hop_band_valid(&bands[i], min_mhz)) {
+			dsim_warn(dsim, "invalid forbidden band %u-%ukHz\n",
+				  bands[i].lo_khz, bands[i].hi_khz);
+			return -EINVAL;
+		}
+	}
+
+	mutex_lock(&hop->lock);
+	memcpy(hop->bands, bands, cnt * sizeof(*bands));
+	hop->band_cnt = cnt;
+	mutex_unlock(&hop->lock);
+
+	dsim_hop_queue(dsim);
+
+	return 0;
+}
+
+static int dsim_hop_notifier_call(struct notifier_block *nb, unsigned long cnt, void *data)
+{
+	struct dsim_device *dsim = container_of(nb, struct dsim_device, hop.nb);
+
+	return notifier_from_errno(dsim_hop_set_bands(dsim, data, cnt));
+}
+
+int dsim_hop_update_bands(const struct dsim_hop_band *bands, unsigned int cnt)
+{
+	return notifier_to_errno(blocking_notifier_call_chain(&dsim_hop_notifier, cnt,
+							      (void *)bands));
+}
+EXPORT_SYMBOL_GPL(dsim_hop_update_bands);
+
+static void dsim_hop_init(struct dsim_device *dsim)
+{
+	const struct dsim_pll_params *pll_params = dsim->pll_params;
+	struct dsim_hop *hop = &dsim->hop;
+	unsigned int i;
+
+	mutex_init(&hop->lock);
+	INIT_WORK(&hop->work, dsim_hop_work);
+
+	if (!pll_params || !pll_params->num_modes || !pll_params->table.cands)
+		return;
+
+	hop->nominal_pll = devm_kcalloc(dsim->dev, pll_params->num_modes,
+					sizeof(*hop->nominal_pll), GFP_KERNEL);
+	if (!hop->nominal_pll)
+		return;
+
+	hop->nominal_mhz = devm_kcalloc(dsim->dev, pll_params->num_modes,
+					sizeof(*hop->nominal_mhz), GFP_KERNEL);
+	if (!hop->nominal_mhz)
+		return;
+
+	for (i = 0; i < pll_params->num_modes; i++) {
+		const struct dsim_pll_param *p = pll_params->params[i];
+
+		hop->nominal_mhz[i] = p->pll_freq;
+		hop->nominal_pll[i].p = p->p;
+		hop->nominal_pll[i].m = p->m;
+		hop->nominal_pll[i].s = p->s;
+		hop->nominal_pll[i].k = p->k;
+		hop->nominal_pll[i].cmd_underrun_cnt = p->cmd_underrun_cnt;
+	}
+
+	hop->nb.notifier_call = dsim_hop_notifier_call;
+	blocking_notifier_chain_register(&dsim_hop_notifier, &hop->nb);
+}
+
+static void dsim_hop_deinit(struct dsim_device *dsim)
+{
+	if (dsim->hop.nominal_mhz)
+		blocking_notifier_chain_unregister(&dsim_hop_notifier, &dsim->hop.nb);
+	cancel_work_sync(&dsim->hop.work);
+}
+
 static ssize_t bist_mode_show(struct device *dev,
 				      struct device_attribute *attr, char *buf)
 {
@@ -2629,6 +3195,62 @@ static ssize_t hs_clock_store(struct device *dev,
 }
 static DEVICE_ATTR_RW(hs_clock);
 
+static ssize_t mipi_hop_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+	struct dsim_device *dsim = dev_get_drvdata(dev);
+	struct dsim_hop *hop = &dsim->hop;
+	ssize_t len;
+	u32 i;
+
+	mutex_lock(&hop->lock);
+	len = scnprintf(buf, PAGE_SIZE, "hs_clock %u%s hops %u rejected %u late %u max %uus\nbands",
+			dsim->clk_param.hs_clk, hop->active ? " (hopped)" : "", hop->hops,
+			hop->rejected, hop->late, hop->max_latency_us);
+	for (i = 0; i < hop->band_cnt; i++)
+		len += scnprintf(buf + len, PAGE_SIZE - len, " %u-%u",
+				 hop->bands[i].lo_khz, hop->bands[i].hi_khz);
+	mutex_unlock(&hop->lock);
+	len += scnprintf(buf + len, PAGE_SIZE - len, "\n");
+
+	return len;
+}
+
+/* space separated "lo-hi" forbidden bands in kHz, nothing clears them */
+static ssize_t mipi_hop_store(struct device *dev, struct device_attribute *attr,
+			      const char *buf, size_t len)
+{
+	struct dsim_device *dsim = dev_get_drvdata(dev);
+	struct dsim_hop_band bands[DSIM_HOP_MAX_BANDS];
+	unsigned int cnt = 0;
+	char params[256];
+	char *p = params, *tok;
+	int rc;
+
+	if (!dsim->hop.nominal_mhz)
+		return -ENODEV;
+
+	strlcpy(params, buf, sizeof(params));
+	while ((tok = strsep(&p, " \n")) != NULL) {
+		if (!*tok)
+			continue;
+
+		if (cnt == DSIM_HOP_MAX_BANDS)
+			return -E2BIG;
+
+		/* the band itself is validated by dsim_hop_set_bands() */
+		if (sscanf(tok, "%u-%u", &bands[cnt].lo_khz, &bands[cnt].hi_khz) != 2)
+			return -EINVAL;
+		cnt++;
+	}
+
+	rc = dsim_hop_set_bands(dsim, bands, cnt);
+	if (rc < 0)
+		return rc;
+
+	return len;
+}
+static DEVICE_ATTR_RW(mipi_hop);
+
 static int dsim_get_pinctrl(struct dsim_device *dsim)
 {
 	int ret = 0;
@@ -2708,6 +3330,11 @@ static int dsim_probe(struct platform_device *pdev)
 	if (ret < 0)
 		dsim_err(dsim, "failed to add sysfs hs_clock entries\n");
 
+	dsim_hop_init(dsim);
+	ret = device_create_file(dsim->dev, &dev_attr_mipi_hop);
+	if (ret < 0)
+		dsim_err(dsim, "failed to add sysfs mipi_hop entries\n");
+
 	platform_set_drvdata(pdev, &dsim->encoder);
 
 #if defined(CONFIG_CPU_IDLE)
@@ -2748,6 +3375,8 @@ static int dsim_remove(struct platform_device *pdev)
 
 	device_remove_file(dsim->dev, &dev_attr_bist_mode);
 	device_remove_file(dsim->dev, &dev_attr_hs_clock);
+	device_remove_file(dsim->dev, &dev_attr_mipi_hop);
+	dsim_hop_deinit(dsim);
 	pm_runtime_disable(&pdev->dev);
 
 	component_del(&pdev->dev, &dsim_component_ops);
@@ -20,11 +20,15 @@
 #include <drm/drm_mipi_dsi.h>
 #include <drm/drm_property.h>
 #include <drm/drm_panel.h>
+#include <linux/notifier.h>
+#include <linux/workqueue.h>
 #include <video/videomode.h>
 
 #include <dsim_cal.h>
 
 #include "exynos_drm_drv.h"
+#include "exynos_drm_dsim_hop.h"
+#include "exynos_drm_dsim_pll.h"
 
 enum dsim_state {
 	DSIM_STATE_HSCLKEN,     /* dsim fully active */
@@ -40,21 +44,49 @@ enum dsim_dual_dsi {
 	DSIM_DUAL_DSI_SEC,
 };
 
-struct dsim_pll_features {
-	u64 finput;
-	u64 foptimum;
-	u64 fout_min, fout_max;
-	u64 fvco_min, fvco_max;
-	u32 p_min, p_max;
-	u32 m_min, m_max;
-	u32 s_min, s_max;
-	u32 k_bits;
-};
-
 struct dsim_pll_params {
 	unsigned int num_modes;
 	struct dsim_pll_param **params;
 	struct dsim_pll_features *features;
+	/* best PMSK for each HS clock in the PLL output range, built at probe */
+	struct dsim_pll_table table;
+};
+
+/* DT PLL settings of a mode, which hopping overwrites */
+struct dsim_hop_pll {
+	unsigned int p;
+	unsigned int m;
+	unsigned int s;
+	unsigned int k;
+	unsigned int cmd_underrun_cnt;
+};
+
+/*
+ * MIPI clock hopping, moves the HS clock out of the forbidden bands at a
+ * frame boundary, and back to the mode clock once the bands are cleared.
+ *
+ * @lock: protects @bands and @band_cnt
+ * @nominal_mhz: HS clock of each DT mode, before any hop
+ * @nominal_pll: PLL settings of each DT mode, before any hop
+ * @active: current HS clock was picked by hopping
+ * @hops: clock switches done
+ * @rejected: band updates no usable clock was found for
+ * @late: switches which took longer than a frame
+ * @max_latency_us: longest switch, from the frame boundary to the link restart
+ */
+struct dsim_hop {
+	struct mutex lock;
+	struct dsim_hop_band bands[DSIM_HOP_MAX_BANDS];
+	u32 band_cnt;
+	u32 *nominal_mhz;
+	struct dsim_hop_pll *nominal_pll;
+	bool active;
+	struct work_struct work;
+	struct notifier_block nb;
+	u32 hops;
+	u32 rejected;
+	u32 late;
+	u32 max_latency_us;
 };
 
 struct dsim_resources {
@@ -66,6 +98,39 @@ struct dsim_resources {
 	struct phy *phy_ex;
 };
 
+#define DSIM_CMD_PROF_SLOTS	64
+#define DSIM_CMD_PROF_BUCKETS	16
+
+enum dsim_cmd_prof_stage {
+	/* lock contention, previous transfer and FIFO writes */
+	DSIM_CMD_PROF_QUEUE,
+	/* packetgo waiting for the vblank ready window */
+	DSIM_CMD_PROF_VBLANK,
+	/* waiting for the command fifos to drain */
+	DSIM_CMD_PROF_FIFO,
+	DSIM_CMD_PROF_STAGE_MAX,
+};
+
+/* transfer latencies of the commands sharing a packet type and DCS opcode */
+struct dsim_cmd_prof_entry {
+	bool used;
+	u8 type;
+	u8 opcode;
+	u32 cnt;
+	/* bucket 0 counts < 1us, bucket n [2^(n-1), 2^n) us, the last one the rest */
+	u32 hist[DSIM_CMD_PROF_STAGE_MAX][DSIM_CMD_PROF_BUCKETS];
+	u64 total_ns[DSIM_CMD_PROF_STAGE_MAX];
+	u64 max_ns[DSIM_CMD_PROF_STAGE_MAX];
+};
+
+struct dsim_cmd_prof {
+	struct dsim_cmd_prof_entry entries[DSIM_CMD_PROF_SLOTS];
+	/* transfers not recorded because all entries were taken */
+	u32 dropped;
+	/* stage latencies of the transfer in progress */
+	s64 cur_ns[DSIM_CMD_PROF_STAGE_MAX];
+};
+
 struct dsim_device {
 	struct drm_encoder encoder;
 	struct mipi_dsi_host dsi_host;
@@ -118,8 +183,37 @@ struct dsim_device {
 	u16 total_pend_pl;
 	/* override message flag MIPI_DSI_MSG_LASTCOMMAND */
 	bool force_batching;
+	/*
+	 * a command transfer was started without waiting for the command
+	 * fifos to drain, the next command user waits for it
+	 */
+	bool tx_pending;
+	bool tx_pending_long;
+
+	/*
+	 * commands sent by the commit thread during an atomic commit are merged
+	 * into one packetgo batch, flushed once before the planes are committed
+	 */
+	struct {
+		bool active;
+		/* commands of other threads aren't held back */
+		const struct task_struct *owner;
+		/* one of the merged commands asked to be sent in vblank */
+		bool wait_vblank;
+		u32 merged_cnt;
+		/* batches flushed with merged commands, and commands merged in them */
+		u32 flush_cnt;
+		u32 merged_total;
+		/* commands of other threads sent on their own while a batch was open */
+		u32 other_cnt;
+	} commit_batch;
+
+	/* command transfer profiler, protected by cmd_lock. NULL if disabled */
+	struct dsim_cmd_prof *cmd_prof;
 
 	enum dsim_dual_dsi dual_dsi;
+
+	struct dsim_hop hop;
 };
 
 extern struct dsim_device *dsim_drvdata[MAX_DSI_CNT];
@@ -163,6 +257,22 @@ dsim_get_decon(const struct dsim_device *dsim)
 	return to_exynos_crtc(crtc)->ctx;
 }
 
+/**
+ * dsim_hop_update_bands - replace the bands all DSI clocks should stay out of
+ * @bands: forbidden bands, in kHz
+ * @cnt: number of @bands, 0 clears them
+ *
+ * Meant for RF drivers, clocks are switched asynchronously at the next frame
+ * boundary. Bands starting at 0, or wider than the harmonic spacing of the
+ * lowest clock that may be picked, are rejected.
+ *
+ * Return: 0 on success, negative error code otherwise
+ */
+int dsim_hop_update_bands(const struct dsim_hop_band *bands, unsigned int cnt);
+
+void dsim_cmd_commit_batch_begin(struct dsim_device *dsim);
+void dsim_cmd_commit_batch_end(struct dsim_device *dsim);
+
 #ifdef CONFIG_DEBUG_FS
 void dsim_diag_create_debugfs(struct dsim_device *dsim);
 void dsim_diag_remove_debugfs(struct dsim_device *dsim);
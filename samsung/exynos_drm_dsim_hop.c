@@ -0,0 +1,105 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Copyright (C) 2023 Google LLC
+ *
+ * DSI clock hopping policy for Samsung EXYNOS DRM
+ *
+ * The link is DDR, so the clock lane toggles at half the HS bit rate and its
+ * harmonics are spaced by that fundamental. A clock is forbidden when one of
+ * the harmonics falls inside a band. The clock closest to the mode clock is
+ * picked, DT mode clocks first as the panels were characterized with them,
+ * then every MHz searching outwards.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include "exynos_drm_dsim_hop.h"
+
+static inline u64 dsim_hop_f0_khz(u32 hs_clock_mhz)
+{
+	return (u64)hs_clock_mhz * 1000 / 2;
+}
+
+/*
+ * A band starting at 0 would take the DC term as a harmonic, and one at least
+ * as wide as the harmonic spacing of the lowest clock that may be picked
+ * forbids all of them.
+ */
+bool dsim_hop_band_valid(const struct dsim_hop_band *b, u32 min_hs_clock_mhz)
+{
+	return b->lo_khz && b->lo_khz <= b->hi_khz &&
+	       b->hi_khz - b->lo_khz < dsim_hop_f0_khz(min_hs_clock_mhz);
+}
+
+bool dsim_hop_clock_allowed(const struct dsim_hop_band *bands, u32 band_cnt,
+			    u32 hs_clock_mhz)
+{
+	const u64 f0_khz = dsim_hop_f0_khz(hs_clock_mhz);
+	u32 i;
+
+	if (!f0_khz)
+		return false;
+
+	for (i = 0; i < band_cnt; i++) {
+		const struct dsim_hop_band *b = &bands[i];
+		/* lowest harmonic at or above the start of the band */
+		u64 n = DIV_ROUND_UP_ULL(b->lo_khz, f0_khz);
+
+		if (!n)
+			n = 1;
+
+		if (n * f0_khz <= b->hi_khz)
+			return false;
+	}
+
+	return true;
+}
+
+static bool dsim_hop_usable(const struct dsim_hop_band *bands, u32 band_cnt, u32 hs_clock_mhz,
+			    dsim_hop_usable_fn usable, void *priv)
+{
+	return dsim_hop_clock_allowed(bands, band_cnt, hs_clock_mhz) &&
+	       usable(priv, hs_clock_mhz);
+}
+
+/*
+ * Returns the usable clock closest to @nominal_mhz, or 0 if there is none
+ * within DSIM_HOP_MAX_OFFSET_PCT of it.
+ */
+u32 dsim_hop_pick(const struct dsim_hop_band *bands, u32 band_cnt,
+		  const u32 *mode_mhz, u32 num_modes, u32 nominal_mhz,
+		  dsim_hop_usable_fn usable, void *priv)
+{
+	const u32 max_offset = nominal_mhz * DSIM_HOP_MAX_OFFSET_PCT / 100;
+	u32 best = 0, best_offset = U32_MAX, offset;
+	u32 i;
+
+	if (dsim_hop_usable(bands, band_cnt, nominal_mhz, usable, priv))
+		return nominal_mhz;
+
+	for (i = 0; i < num_modes; i++) {
+		const u32 mhz = mode_mhz[i];
+
+		offset = mhz > nominal_mhz ? mhz - nominal_mhz : nominal_mhz - mhz;
+		if (offset <= max_offset && offset < best_offset &&
+		    dsim_hop_usable(bands, band_cnt, mhz, usable, priv)) {
+			best = mhz;
+			best_offset = offset;
+		}
+	}
+
+	if (best)
+		return best;
+
+	for (offset = 1; offset <= max_offset; offset++) {
+		if (dsim_hop_usable(bands, band_cnt, nominal_mhz + offset, usable, priv))
+			return nominal_mhz + offset;
+		if (offset < nominal_mhz &&
+		    dsim_hop_usable(bands, band_cnt, nominal_mhz - offset, usable, priv))
+			return nominal_mhz - offset;
+	}
+
+	return 0;
+}
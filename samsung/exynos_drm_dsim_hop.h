@@ -0,0 +1,63 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ *
+ * Copyright (C) 2023 Google LLC
+ *
+ * Header file for the DSI clock hopping policy.
+ *
+ * Decides which HS clocks keep their harmonics out of the forbidden RF bands
+ * and picks the closest usable one. It doesn't access any hardware or driver
+ * state and can be built outside of the kernel as well, in that case the few
+ * kernel helpers it depends on are provided below.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef __EXYNOS_DRM_DSIM_HOP_H__
+#define __EXYNOS_DRM_DSIM_HOP_H__
+
+#ifdef __KERNEL__
+#include <linux/kernel.h>
+#include <linux/types.h>
+#else
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef uint32_t u32;
+typedef int32_t s32;
+typedef uint64_t u64;
+
+#define U32_MAX			((u32)~0U)
+
+#define DIV_ROUND_UP_ULL(x, y)	(((x) + (y) - 1) / (y))
+#endif
+
+/* frequency range in kHz which the DSI clock harmonics should stay out of */
+struct dsim_hop_band {
+	u32 lo_khz;
+	u32 hi_khz;
+};
+
+#define DSIM_HOP_MAX_BANDS	8
+
+/* clocks further than that from the mode clock aren't picked */
+#define DSIM_HOP_MAX_OFFSET_PCT	10
+
+/* checks a HS clock beyond the bands, e.g. PLL and frame time constraints */
+typedef bool (*dsim_hop_usable_fn)(void *priv, u32 hs_clock_mhz);
+
+bool dsim_hop_band_valid(const struct dsim_hop_band *b, u32 min_hs_clock_mhz);
+bool dsim_hop_clock_allowed(const struct dsim_hop_band *bands, u32 band_cnt,
+			    u32 hs_clock_mhz);
+u32 dsim_hop_pick(const struct dsim_hop_band *bands, u32 band_cnt,
+		  const u32 *mode_mhz, u32 num_modes, u32 nominal_mhz,
+		  dsim_hop_usable_fn usable, void *priv);
+
+/* lowest clock dsim_hop_pick() may return for @nominal_mhz */
+static inline u32 dsim_hop_min_mhz(u32 nominal_mhz)
+{
+	return nominal_mhz - nominal_mhz * DSIM_HOP_MAX_OFFSET_PCT / 100;
+}
+
+#endif /* __EXYNOS_DRM_DSIM_HOP_H__ */
@@ -0,0 +1,115 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Copyright (C) 2023 Google LLC
+ *
+ * DSI PLL PMSK solver for Samsung EXYNOS DRM
+ *
+ * The PLL output is fout = (fin / P) * (M + K / 2^k_bits) * 2 / 2^S. For a
+ * requested HS clock every S which keeps the VCO in range and every P which
+ * keeps the reference close to its optimum are tried, M and K are rounded to
+ * the nearest divider step. The valid combinations are ranked by the clock
+ * error first, as the HS clocks are picked to keep EMI away from the RF bands,
+ * then by the expected jitter and by the VCO margin. With a VCO range wider than
+ * an octave, the margin makes a higher S win over the lowest one in range when
+ * both are as accurate.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include "exynos_drm_dsim_pll.h"
+
+/* references further than that from the optimum aren't characterized */
+#define DSIM_PLL_FREF_RANGE	2
+
+/* cost weights, per ppm of clock error and per percent of reference offset */
+#define DSIM_PLL_ERR_COST	16
+#define DSIM_PLL_FREF_COST	2
+/* the sigma-delta modulator adds jitter when K isn't zero */
+#define DSIM_PLL_FRAC_COST	8
+/* VCO margin is counted in percent of the range, up to the middle of it */
+#define DSIM_PLL_VCO_MARGIN_MAX	50
+
+static inline u64 dsim_pll_absdiff(u64 a, u64 b)
+{
+	return a > b ? a - b : b - a;
+}
+
+static u32 dsim_pll_cost(const struct dsim_pll_features *f, u64 fout, u64 fref,
+			 u64 fvco, u32 err_hz, bool frac)
+{
+	const u64 vco_margin = fvco - f->fvco_min < f->fvco_max - fvco ?
+			       fvco - f->fvco_min : f->fvco_max - fvco;
+	u64 margin_pct = div64_u64(vco_margin * 100, f->fvco_max - f->fvco_min + 1);
+	u64 cost;
+
+	if (margin_pct > DSIM_PLL_VCO_MARGIN_MAX)
+		margin_pct = DSIM_PLL_VCO_MARGIN_MAX;
+
+	cost = div64_u64((u64)err_hz * 1000000, fout) * DSIM_PLL_ERR_COST;
+	cost += div64_u64(dsim_pll_absdiff(fref, f->foptimum) * 100, f->foptimum) *
+		DSIM_PLL_FREF_COST;
+	cost += frac ? DSIM_PLL_FRAC_COST : 0;
+	cost += DSIM_PLL_VCO_MARGIN_MAX - margin_pct;
+
+	return cost < U32_MAX ? cost : U32_MAX - 1;
+}
+
+int dsim_pll_solve(const struct dsim_pll_features *f, u32 hs_clock_mhz,
+		   struct dsim_pll_cand *best)
+{
+	const u64 fout = hs_clock_mhz * DSIM_PLL_HZ_PER_MHZ;
+	const u64 k_one = 1ULL << f->k_bits;
+	u32 p, s, cnt = 0;
+
+	best->cand_cnt = 0;
+	best->cost = U32_MAX;
+
+	if (!f->finput || !f->foptimum || !f->k_bits || fout < f->fout_min ||
+	    fout > f->fout_max)
+		return -1;
+
+	for (s = f->s_min; s <= f->s_max; s++) {
+		const u64 fvco = fout << s;
+
+		if (fvco < f->fvco_min || fvco > f->fvco_max)
+			continue;
+
+		for (p = f->p_min ? f->p_min : 1; p <= f->p_max; p++) {
+			const u64 fref = div64_u64(f->finput, p);
+			u64 mk, m, fgen;
+			u32 err_hz, cost;
+
+			if (fref * DSIM_PLL_FREF_RANGE < f->foptimum ||
+			    fref > f->foptimum * DSIM_PLL_FREF_RANGE)
+				continue;
+
+			/* (fvco / 2) / fref = M + K / 2^k_bits, to the nearest step */
+			mk = div64_u64(((fvco >> 1) << f->k_bits) + fref / 2, fref);
+			/* K is signed, M is rounded to the nearest integer */
+			m = (mk + k_one / 2) >> f->k_bits;
+			if (m < f->m_min || m > f->m_max)
+				continue;
+
+			fgen = ((fref * mk) << 1) >> (f->k_bits + s);
+			err_hz = dsim_pll_absdiff(fgen, fout);
+			cost = dsim_pll_cost(f, fout, fref, fvco, err_hz, mk != m << f->k_bits);
+			cnt++;
+
+			if (cost >= best->cost)
+				continue;
+
+			best->p = p;
+			best->s = s;
+			best->m = m;
+			best->k = (mk - (m << f->k_bits)) & (k_one - 1);
+			best->err_hz = err_hz;
+			best->cost = cost;
+		}
+	}
+
+	best->cand_cnt = cnt < 0xffff ? cnt : 0xffff;
+
+	return cnt ? 0 : -1;
+}
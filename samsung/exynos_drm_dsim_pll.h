@@ -0,0 +1,95 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ *
+ * Copyright (C) 2023 Google LLC
+ *
+ * Header file for the DSI PLL PMSK solver.
+ *
+ * The solver enumerates the P/M/S/K combinations allowed by the PLL limits for
+ * a requested HS clock and picks the best one. It doesn't access any hardware
+ * or driver state and can be built outside of the kernel as well, in that case
+ * the few kernel helpers it depends on are provided below.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef __EXYNOS_DRM_DSIM_PLL_H__
+#define __EXYNOS_DRM_DSIM_PLL_H__
+
+#ifdef __KERNEL__
+#include <linux/kernel.h>
+#include <linux/math64.h>
+#include <linux/types.h>
+#else
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef int64_t s64;
+typedef uint64_t u64;
+
+#define U32_MAX			((u32)~0U)
+
+#define div64_u64(x, y)		((x) / (y))
+#endif
+
+#define DSIM_PLL_HZ_PER_MHZ	1000000ULL
+
+struct dsim_pll_features {
+	u64 finput;
+	u64 foptimum;
+	u64 fout_min, fout_max;
+	u64 fvco_min, fvco_max;
+	u32 p_min, p_max;
+	u32 m_min, m_max;
+	u32 s_min, s_max;
+	u32 k_bits;
+};
+
+/*
+ * Best PMSK combination for one HS clock, kept compact as the table has an
+ * entry for every MHz of the output range.
+ *
+ * @k: fractional part of the divider, two's complement in k_bits
+ * @cand_cnt: number of valid combinations, 0 if the clock can't be generated
+ * @err_hz: distance of the generated clock from the requested one
+ * @cost: ranking of the combination, lower is better
+ */
+struct dsim_pll_cand {
+	u8 p;
+	u8 s;
+	u16 m;
+	u16 k;
+	u16 cand_cnt;
+	u32 err_hz;
+	u32 cost;
+};
+
+/* best combination for each MHz in [min_mhz, min_mhz + num) */
+struct dsim_pll_table {
+	u32 min_mhz;
+	u32 num;
+	struct dsim_pll_cand *cands;
+};
+
+int dsim_pll_solve(const struct dsim_pll_features *f, u32 hs_clock_mhz,
+		   struct dsim_pll_cand *best);
+
+static inline const struct dsim_pll_cand *
+dsim_pll_table_lookup(const struct dsim_pll_table *t, u32 hs_clock_mhz)
+{
+	const struct dsim_pll_cand *c;
+
+	if (!t->cands || hs_clock_mhz < t->min_mhz || hs_clock_mhz - t->min_mhz >= t->num)
+		return NULL;
+
+	c = &t->cands[hs_clock_mhz - t->min_mhz];
+
+	return c->cand_cnt ? c : NULL;
+}
+
+#endif /* __EXYNOS_DRM_DSIM_PLL_H__ */
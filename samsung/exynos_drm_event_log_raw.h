@@ -0,0 +1,325 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ *
+ * Copyright (C) 2023 Google LLC
+ *
+ * Layout of the binary event log exported through the "event_raw" debugfs
+ * file of each DECON.
+ *
+ * Only depends on the fixed size types of <linux/types.h> so that tools
+ * decoding a snapshot off the device can include it as is.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef __EXYNOS_DRM_EVENT_LOG_RAW_H__
+#define __EXYNOS_DRM_EVENT_LOG_RAW_H__
+
+#include <linux/types.h>
+
+/*
+ * Types of the events in the log. The values are stored in struct dpu_log_raw
+ * as well, so they are part of the export layout.
+ */
+enum dpu_event_type {
+	DPU_EVT_NONE = 0,
+
+	DPU_EVT_DECON_ENABLED,
+	DPU_EVT_DECON_DISABLED,
+	DPU_EVT_DECON_FRAMEDONE,
+	DPU_EVT_DECON_FRAMESTART,
+	DPU_EVT_DECON_RSC_OCCUPANCY,
+	DPU_EVT_DECON_TRIG_MASK,
+	DPU_EVT_DECON_UPDATE_CONFIG,
+
+	DPU_EVT_DSIM_ENABLED,
+	DPU_EVT_DSIM_DISABLED,
+	DPU_EVT_DSIM_COMMAND,
+	DPU_EVT_DSIM_ULPS_ENTER,
+	DPU_EVT_DSIM_ULPS_EXIT,
+	DPU_EVT_DSIM_UNDERRUN,
+	DPU_EVT_DSIM_FRAMEDONE,
+	DPU_EVT_DSIM_PH_FIFO_TIMEOUT,
+	DPU_EVT_DSIM_PL_FIFO_TIMEOUT,
+
+	DPU_EVT_DPP_FRAMEDONE,
+	DPU_EVT_DPP_SET_PROTECTION,
+	DPU_EVT_DMA_RECOVERY,
+
+	DPU_EVT_IDMA_AFBC_CONFLICT,
+	DPU_EVT_IDMA_FBC_ERROR,
+	DPU_EVT_IDMA_READ_SLAVE_ERROR,
+	DPU_EVT_IDMA_DEADLOCK,
+	DPU_EVT_IDMA_CFG_ERROR,
+
+	DPU_EVT_ATOMIC_COMMIT,
+	DPU_EVT_TE_INTERRUPT,
+
+	DPU_EVT_DECON_RUNTIME_SUSPEND,
+	DPU_EVT_DECON_RUNTIME_RESUME,
+	DPU_EVT_DECON_SUSPEND,
+	DPU_EVT_DECON_RESUME,
+	DPU_EVT_DSIM_RUNTIME_SUSPEND,
+	DPU_EVT_DSIM_RUNTIME_RESUME,
+	DPU_EVT_DSIM_SUSPEND,
+	DPU_EVT_DSIM_RESUME,
+	DPU_EVT_ENTER_HIBERNATION_IN,
+	DPU_EVT_ENTER_HIBERNATION_OUT,
+	DPU_EVT_EXIT_HIBERNATION_IN,
+	DPU_EVT_EXIT_HIBERNATION_OUT,
+
+	DPU_EVT_ATOMIC_BEGIN,
+	DPU_EVT_ATOMIC_FLUSH,
+
+	DPU_EVT_WB_ENABLE,
+	DPU_EVT_WB_DISABLE,
+	DPU_EVT_WB_ATOMIC_COMMIT,
+	DPU_EVT_WB_FRAMEDONE,
+	DPU_EVT_WB_ENTER_HIBERNATION,
+	DPU_EVT_WB_EXIT_HIBERNATION,
+
+	DPU_EVT_PLANE_PREPARE_FB,
+	DPU_EVT_PLANE_CLEANUP_FB,
+	DPU_EVT_PLANE_UPDATE,
+	DPU_EVT_PLANE_DISABLE,
+
+	DPU_EVT_REQ_CRTC_INFO_OLD,
+	DPU_EVT_REQ_CRTC_INFO_NEW,
+
+	DPU_EVT_FRAMESTART_TIMEOUT,
+
+	DPU_EVT_BTS_RELEASE_BW,
+	DPU_EVT_BTS_CALC_BW,
+	DPU_EVT_BTS_UPDATE_BW,
+
+	DPU_EVT_PARTIAL_INIT,
+	DPU_EVT_PARTIAL_PREPARE,
+	DPU_EVT_PARTIAL_UPDATE,
+	DPU_EVT_PARTIAL_RESTORE,
+
+	DPU_EVT_DSIM_CRC,
+	DPU_EVT_DSIM_ECC,
+
+	DPU_EVT_VBLANK_ENABLE,
+	DPU_EVT_VBLANK_DISABLE,
+
+	DPU_EVT_DIMMING_START,
+	DPU_EVT_DIMMING_END,
+
+	DPU_EVT_CGC_FRAMEDONE,
+	DPU_EVT_ITMON_ERROR,
+	DPU_EVT_SYSMMU_FAULT,
+
+	DPU_EVT_BTS_PREFETCH,
+	DPU_EVT_DSIM_CMD_BATCH,
+	DPU_EVT_PLANE_FENCE,
+
+	/* exported by event_raw, new events are only added right above */
+	DPU_EVT_MAX, /* End of EVENT */
+};
+
+/*
+ * Binary event log export layout. The "event_raw" debugfs file starts with
+ * struct dpu_log_raw_header followed by record_cnt entries of struct
+ * dpu_log_raw (record_size bytes each) ordered from oldest to newest. Entries
+ * which were being written while the snapshot was taken are zeroed (type
+ * DPU_EVT_NONE).
+ *
+ * Only fixed size fields are used, and enum dpu_event_type values are only
+ * ever appended, so the layout doesn't depend on the kernel build. Kernel
+ * pointers and DMA addresses aren't exported. Bump DPU_EVENT_LOG_RAW_VERSION
+ * whenever struct dpu_log_raw or one of its payloads changes.
+ */
+#define DPU_EVENT_LOG_RAW_MAGIC		0x45555044 /* "DPUE" */
+#define DPU_EVENT_LOG_RAW_VERSION	5
+
+struct dpu_log_raw_header {
+	__u32 magic;
+	__u16 version;
+	__u16 header_size;
+	__u32 record_size;
+	__u32 record_cnt;
+	__u32 decon_id;
+	__u32 reserved;
+	/* local_clock() at the time of the snapshot */
+	__u64 ts_nsec;
+};
+
+/*
+ * Payloads of struct dpu_log_raw, the one used depends on the event type in
+ * the same way as the union of struct dpu_log. Flags are 0 or 1, and state
+ * and mode fields hold the value of the matching driver enum.
+ */
+struct dpu_log_raw_dsim_cmd {
+	__u32 id;
+	__u32 d0;
+	__u32 len;
+};
+
+struct dpu_log_raw_dsim_batch {
+	__u32 merged;
+	__u32 ph;
+	__u32 pl;
+};
+
+struct dpu_log_raw_dpp {
+	__u32 id;
+	__u32 win_id;
+	__u64 comp_src;
+	__u32 recovery_cnt;
+	__u32 last_secure_pid;
+	__u32 mst_security;
+	__u32 reserved;
+};
+
+struct dpu_log_raw_win {
+	__u32 win_idx;
+	__u32 plane_idx;
+	__u32 secure;
+};
+
+struct dpu_log_raw_win_config {
+	__u32 state;
+	__u32 src_x;
+	__u32 src_y;
+	__u32 src_w;
+	__u32 src_h;
+	__s32 dst_x;
+	__s32 dst_y;
+	__u32 dst_w;
+	__u32 dst_h;
+	__u32 is_rot;
+	__u32 is_comp;
+	__u32 is_secure;
+	__u32 dpp_id;
+	__u32 zpos;
+	__u32 format;
+	__u32 reserved;
+	__u64 comp_src;
+};
+
+#define DPU_LOG_RAW_MAX_WIN	8
+
+struct dpu_log_raw_atomic {
+	struct dpu_log_raw_win_config win_config[DPU_LOG_RAW_MAX_WIN];
+	struct dpu_log_raw_win_config rcd_win_config;
+};
+
+struct dpu_log_raw_rsc_occupancy {
+	__u64 rsc_ch;
+	__u64 rsc_win;
+};
+
+struct dpu_log_raw_pd {
+	__u32 decon_state;
+	__u32 rpm_active;
+	__u32 dsim_state;
+	__u32 dsim_rpm_active;
+};
+
+struct dpu_log_raw_crtc_info {
+	__u32 enable;
+	__u32 active;
+	__u32 planes_changed;
+	__u32 mode_changed;
+	__u32 active_changed;
+	__u32 self_refresh;
+	__u32 connectors_changed;
+};
+
+/* in kHz */
+struct dpu_log_raw_freqs {
+	__u64 mif_freq;
+	__u64 int_freq;
+	__u64 disp_freq;
+};
+
+struct dpu_log_raw_bts_update {
+	struct dpu_log_raw_freqs freqs;
+	__u32 peak;
+	__u32 prev_peak;
+	__u32 rt_avg_bw;
+	__u32 prev_rt_avg_bw;
+	__u32 total_bw;
+	__u32 prev_total_bw;
+};
+
+struct dpu_log_raw_bts_cal {
+	struct dpu_log_raw_freqs freqs;
+	__u32 disp_freq;
+	__u32 peak;
+	__u32 rt_avg_bw;
+	__u32 read_bw;
+	__u32 write_bw;
+	__u32 fps;
+};
+
+struct dpu_log_raw_bts_event {
+	struct dpu_log_raw_freqs freqs;
+	__u32 value;
+	__u32 reserved;
+};
+
+struct dpu_log_raw_bts_prefetch {
+	__u32 peak;
+	__u32 rt;
+	__u32 disp_freq;
+	__u32 hit_cnt;
+	__u32 miss_cnt;
+	__u32 over_cnt;
+};
+
+struct dpu_log_raw_rect {
+	__s32 x1;
+	__s32 y1;
+	__s32 x2;
+	__s32 y2;
+};
+
+struct dpu_log_raw_partial {
+	__u32 min_w;
+	__u32 min_h;
+	struct dpu_log_raw_rect prev;
+	struct dpu_log_raw_rect req;
+	struct dpu_log_raw_rect adj;
+	__u32 reconfigure;
+};
+
+struct dpu_log_raw_plane_info {
+	__u32 index;
+	__u32 width;
+	__u32 height;
+	__u32 zpos;
+	__u32 format;
+};
+
+struct dpu_log_raw_plane_fence {
+	__u32 index;
+	__u32 ready_us;
+	__u32 wait_us;
+	__u32 deferred;
+	__s32 status;
+};
+
+struct dpu_log_raw_decon_cfg {
+	__u32 fps;
+	__u32 image_width;
+	__u32 image_height;
+	__u32 out_type;
+	__u32 op_mode;
+	__u32 dsi_mode;
+	__u32 trig_mode;
+};
+
+#define DPU_LOG_RAW_DATA_SIZE	648
+
+struct dpu_log_raw {
+	__u64 ts_nsec;
+	__u32 type;
+	__u32 reserved;
+	/* struct dpu_log_raw_* payload of the event type, zero padded */
+	__u64 data[DPU_LOG_RAW_DATA_SIZE / sizeof(__u64)];
+};
+
+#endif /* __EXYNOS_DRM_EVENT_LOG_RAW_H__ */
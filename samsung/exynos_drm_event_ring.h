@@ -0,0 +1,115 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ *
+ * Copyright (C) 2023 Google LLC
+ *
+ * Lock-free reservation of the DPU event log entries.
+ *
+ * Writers claim an entry by incrementing the ring index, mark it as in flight
+ * and fill it. The entry is published by dpu_event_commit() which stores the
+ * event type last. Readers use the per-entry sequence to drop entries that got
+ * recycled while they were copied. An entry can only be torn if its writer is
+ * lapped by the whole ring while filling it.
+ *
+ * The ring is an array of struct dpu_log, which has to be defined before this
+ * header is included. Only its seq and type fields are used here, the rest of
+ * an entry is copied as a whole. It doesn't access any other driver state and
+ * can be built outside of the kernel as well, in that case the few kernel
+ * helpers it depends on are provided below.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef __EXYNOS_DRM_EVENT_RING_H__
+#define __EXYNOS_DRM_EVENT_RING_H__
+
+#ifdef __KERNEL__
+#include <linux/atomic.h>
+#include <linux/compiler.h>
+#include <linux/string.h>
+#include <linux/types.h>
+#include <asm/barrier.h>
+#else
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+typedef uint32_t u32;
+
+typedef struct {
+	int counter;
+} atomic_t;
+
+#define atomic_inc_return(v)	__atomic_add_fetch(&(v)->counter, 1, __ATOMIC_SEQ_CST)
+#define atomic_read(v)		__atomic_load_n(&(v)->counter, __ATOMIC_RELAXED)
+#define atomic_set(v, i)	__atomic_store_n(&(v)->counter, (i), __ATOMIC_RELAXED)
+
+#define READ_ONCE(x)		(*(const volatile __typeof__(x) *)&(x))
+#define WRITE_ONCE(x, val)	(*(volatile __typeof__(x) *)&(x) = (val))
+
+#define smp_wmb()		__atomic_thread_fence(__ATOMIC_RELEASE)
+#define smp_rmb()		__atomic_thread_fence(__ATOMIC_ACQUIRE)
+#define smp_store_release(p, v)	__atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#endif
+
+/*
+ * dpu_event_reserve() - claim the next entry of an event log ring
+ * @ring: array of @size entries
+ * @size: entry count of @ring
+ * @idx: ring index, the sequence of the last claimed entry
+ *
+ * The entry is returned marked as in flight, it's up to the caller to fill it
+ * and publish it with dpu_event_commit().
+ */
+static inline struct dpu_log *dpu_event_reserve(struct dpu_log *ring, u32 size, atomic_t *idx)
+{
+	const int seq = atomic_inc_return(idx);
+	struct dpu_log *log = &ring[seq % size];
+
+	WRITE_ONCE(log->type, DPU_EVT_NONE);
+	smp_wmb();
+	WRITE_ONCE(log->seq, seq);
+	smp_wmb();
+
+	return log;
+}
+
+static inline void dpu_event_commit(struct dpu_log *log, enum dpu_event_type type)
+{
+	smp_store_release(&log->type, type);
+}
+
+/*
+ * dpu_event_read() - take a consistent snapshot of an event log entry
+ * @src: entry in the event log ring
+ * @dst: local copy of the entry
+ *
+ * Returns false if the entry is still being written or got reused by another
+ * writer while it was copied, in which case @dst must be ignored.
+ */
+static inline bool dpu_event_read(const struct dpu_log *src, struct dpu_log *dst)
+{
+	enum dpu_event_type type;
+	u32 seq;
+
+	seq = READ_ONCE(src->seq);
+	smp_rmb();
+	type = READ_ONCE(src->type);
+	if (type == DPU_EVT_NONE)
+		return false;
+	smp_rmb();
+
+	memcpy(dst, src, sizeof(*dst));
+
+	smp_rmb();
+	if (READ_ONCE(src->seq) != seq)
+		return false;
+
+	dst->seq = seq;
+	dst->type = type;
+
+	return true;
+}
+
+#endif /* __EXYNOS_DRM_EVENT_RING_H__ */
@@ -325,6 +325,33 @@ static void conn_state_to_win_config(struct dpu_bts_win_config *win_config,
 			win_config->comp_src);
 }
 
+/*
+ * Most commits only flip buffers, so keep the previous config if nothing BTS
+ * cares about changed and mark it dirty otherwise.
+ */
+static void exynos_bts_update_win_config(struct decon_device *decon,
+					 struct dpu_bts_win_config *win_config, int dirty_bit,
+					 const struct drm_plane_state *plane_state, u32 dpp_id)
+{
+	struct dpu_bts_win_config new_config = *win_config;
+
+	plane_state_to_win_config(&new_config, plane_state, dpp_id);
+	if (memcmp(win_config, &new_config, sizeof(new_config))) {
+		*win_config = new_config;
+		decon->bts.dirty |= BIT(dirty_bit);
+	}
+}
+
+static void exynos_bts_disable_win_config(struct decon_device *decon,
+					  struct dpu_bts_win_config *win_config, int dirty_bit)
+{
+	if (win_config->state == DPU_WIN_STATE_DISABLED)
+		return;
+
+	win_config->state = DPU_WIN_STATE_DISABLED;
+	decon->bts.dirty |= BIT(dirty_bit);
+}
+
 static void exynos_atomic_bts_pre_update(struct drm_device *dev,
 					 struct drm_atomic_state *old_state)
 {
@@ -350,7 +377,8 @@ static void exynos_atomic_bts_pre_update(struct drm_device *dev,
 			if (new_plane_state->crtc) {
 				decon = crtc_to_decon(new_plane_state->crtc);
 				win_config = &decon->bts.rcd_win_config.win;
-				plane_state_to_win_config(win_config, new_plane_state, dpp->id);
+				exynos_bts_update_win_config(decon, win_config, DPU_BTS_DIRTY_RCD,
+							     new_plane_state, dpp->id);
 
 				decon->bts.rcd_win_config.dma_addr =
 					exynos_drm_fb_dma_addr(new_plane_state->fb, 0);
@@ -363,7 +391,8 @@ static void exynos_atomic_bts_pre_update(struct drm_device *dev,
 			decon = crtc_to_decon(new_plane_state->crtc);
 			win_config = &decon->bts.win_config[zpos];
 
-			plane_state_to_win_config(win_config, new_plane_state, dpp->id);
+			exynos_bts_update_win_config(decon, win_config, zpos,
+						     new_plane_state, dpp->id);
 
 			decon->dpp[i]->dbg_dma_addr =
 				exynos_drm_fb_dma_addr(new_plane_state->fb, 0);
@@ -393,10 +422,11 @@ static void exynos_atomic_bts_pre_update(struct drm_device *dev,
 			decon = crtc_to_decon(new_conn_state->crtc);
 			win_config = &decon->bts.wb_config;
 			conn_state_to_win_config(win_config, new_conn_state);
+			decon->bts.dirty |= BIT(DPU_BTS_DIRTY_WB);
 		} else if (old_job && !new_job) {
 			decon = crtc_to_decon(old_conn_state->crtc);
 			win_config = &decon->bts.wb_config;
-			win_config->state = DPU_WIN_STATE_DISABLED;
+			exynos_bts_disable_win_config(decon, win_config, DPU_BTS_DIRTY_WB);
 		}
 	}
 
@@ -415,12 +445,13 @@ static void exynos_atomic_bts_pre_update(struct drm_device *dev,
 
 			for (j = num_planes; j < MAX_WIN_PER_DECON; j++) {
 				win_config = &decon->bts.win_config[j];
-				win_config->state = DPU_WIN_STATE_DISABLED;
+				exynos_bts_disable_win_config(decon, win_config, j);
 			}
 
 			if ((new_crtc_state->plane_mask & exynos_crtc->rcd_plane_mask) == 0) {
 				win_config = &decon->bts.rcd_win_config.win;
-				win_config->state = DPU_WIN_STATE_DISABLED;
+				exynos_bts_disable_win_config(decon, win_config,
+							      DPU_BTS_DIRTY_RCD);
 			}
 		}
 
@@ -739,56 +770,161 @@ static void exynos_drm_atomic_helper_commit_modeset_disables(struct drm_device *
 	exynos_crtc_set_mode(dev, old_state);
 }
 
-static void exynos_atomic_commit_tail(struct drm_atomic_state *old_state)
+/*
+ * Panel commands sent while committing to an already active display are
+ * merged and sent out once, right before the planes are committed. Only the
+ * commands of the thread which opened the batch are merged, so it is opened
+ * and closed by the thread committing the connectors of the display. If
+ * @filter is set, only the display of that crtc is handled.
+ */
+static void exynos_atomic_commit_cmd_batch(struct drm_atomic_state *old_state,
+					   const struct drm_crtc *filter, bool begin)
 {
-	int i;
-	struct drm_device *dev = old_state->dev;
-	struct decon_device *decon;
 	struct drm_crtc *crtc;
 	struct drm_crtc_state *new_crtc_state;
-	struct drm_connector *connector;
-	struct drm_connector_state *old_conn_state;
-	struct drm_connector_state *new_conn_state;
-	unsigned int disabling_crtc_mask = 0;
+	struct dsim_device *dsim;
+	int i;
 
-	DPU_ATRACE_BEGIN("exynos_atomic_commit_tail");
-	DPU_ATRACE_BEGIN("modeset");
-	exynos_drm_atomic_helper_commit_modeset_disables(dev, old_state, &disabling_crtc_mask);
+	for_each_new_crtc_in_state(old_state, crtc, new_crtc_state, i) {
+		if (filter && crtc != filter)
+			continue;
 
-	exynos_atomic_bts_pre_update(dev, old_state);
+		if (!new_crtc_state->active || drm_atomic_crtc_needs_modeset(new_crtc_state))
+			continue;
 
-	drm_atomic_helper_commit_modeset_enables(dev, old_state);
-	DPU_ATRACE_END("modeset");
+		dsim = decon_get_dsim(crtc_to_decon(crtc));
+		if (!dsim)
+			continue;
+
+		if (begin)
+			dsim_cmd_commit_batch_begin(dsim);
+		else
+			dsim_cmd_commit_batch_end(dsim);
+	}
+}
+
+static void exynos_atomic_commit_connectors(struct drm_atomic_state *old_state,
+					    const struct drm_crtc *filter, bool pre_commit)
+{
+	struct drm_connector *connector;
+	struct drm_connector_state *old_conn_state, *new_conn_state;
+	struct drm_crtc_state *new_crtc_state;
+	int i;
 
-	DPU_ATRACE_BEGIN("connector_pre_commit");
 	for_each_oldnew_connector_in_state(old_state, connector,
 				 old_conn_state, new_conn_state, i) {
+		struct exynos_drm_connector *exynos_connector;
+		const struct exynos_drm_connector_helper_funcs *funcs;
+
 		if (!new_conn_state->crtc)
 			continue;
 
+		if (filter && new_conn_state->crtc != filter)
+			continue;
+
 		new_crtc_state = drm_atomic_get_new_crtc_state(old_state, new_conn_state->crtc);
 		if (!new_crtc_state->active)
 			continue;
 
-		if (is_exynos_drm_connector(connector)) {
-			struct exynos_drm_connector *exynos_connector =
-				to_exynos_connector(connector);
-			const struct exynos_drm_connector_helper_funcs *funcs =
-				exynos_connector->helper_private;
+		if (!is_exynos_drm_connector(connector))
+			continue;
+
+		exynos_connector = to_exynos_connector(connector);
+		funcs = exynos_connector->helper_private;
+		if (pre_commit) {
 			if (!funcs->atomic_pre_commit)
 				continue;
 
 			funcs->atomic_pre_commit(exynos_connector,
 					to_exynos_connector_state(old_conn_state),
 					to_exynos_connector_state(new_conn_state));
+		} else {
+			funcs->atomic_commit(exynos_connector,
+					to_exynos_connector_state(old_conn_state),
+					to_exynos_connector_state(new_conn_state));
 		}
 	}
-	DPU_ATRACE_END("connector_pre_commit");
+}
 
-	DPU_ATRACE_BEGIN("commit_planes");
-	drm_atomic_helper_commit_planes(dev, old_state,
-					DRM_PLANE_COMMIT_ACTIVE_ONLY);
-	DPU_ATRACE_END("commit_planes");
+/*
+ * Per-CRTC part of a commit split by exynos_atomic_queue_work(). It runs on the
+ * worker of the crtc's DECON once the shared steps are done, so that waiting
+ * for the TE of one display doesn't delay the update of the other.
+ */
+void exynos_atomic_commit_crtc_stage(struct drm_atomic_state *old_state,
+				     struct drm_crtc *crtc)
+{
+	struct drm_crtc_state *old_crtc_state = drm_atomic_get_old_crtc_state(old_state, crtc);
+
+	DPU_ATRACE_BEGIN("commit_crtc_stage");
+	exynos_atomic_commit_cmd_batch(old_state, crtc, true);
+	exynos_atomic_commit_connectors(old_state, crtc, true);
+	exynos_atomic_commit_cmd_batch(old_state, crtc, false);
+
+	drm_atomic_helper_commit_planes_on_crtc(old_crtc_state);
+
+	exynos_atomic_commit_connectors(old_state, crtc, false);
+	DPU_ATRACE_END("commit_crtc_stage");
+}
+
+static struct exynos_commit_sync *exynos_atomic_get_commit_sync(struct drm_atomic_state *old_state,
+								struct drm_crtc **own_crtc)
+{
+	struct drm_crtc *crtc;
+	struct drm_crtc_state *old_crtc_state;
+	int i;
+
+	/* commit tail runs on the worker of the first crtc, see exynos_atomic_queue_work() */
+	for_each_old_crtc_in_state(old_state, crtc, old_crtc_state, i) {
+		*own_crtc = crtc;
+		return to_exynos_crtc_state(old_crtc_state)->commit_sync;
+	}
+
+	return NULL;
+}
+
+static void exynos_atomic_commit_tail(struct drm_atomic_state *old_state)
+{
+	int i;
+	struct drm_device *dev = old_state->dev;
+	struct decon_device *decon;
+	struct drm_crtc *crtc, *own_crtc = NULL;
+	struct drm_crtc_state *new_crtc_state;
+	struct exynos_commit_sync *sync;
+	unsigned int disabling_crtc_mask = 0;
+
+	DPU_ATRACE_BEGIN("exynos_atomic_commit_tail");
+	sync = exynos_atomic_get_commit_sync(old_state, &own_crtc);
+
+	DPU_ATRACE_BEGIN("modeset");
+	exynos_drm_atomic_helper_commit_modeset_disables(dev, old_state, &disabling_crtc_mask);
+
+	exynos_atomic_bts_pre_update(dev, old_state);
+
+	drm_atomic_helper_commit_modeset_enables(dev, old_state);
+	DPU_ATRACE_END("modeset");
+
+	if (sync) {
+		/* let the stages of the other displays go, and run the own one */
+		complete_all(&sync->prologue_done);
+		exynos_atomic_commit_crtc_stage(old_state, own_crtc);
+
+		DPU_ATRACE_BEGIN("wait_for_crtc_stages");
+		wait_for_completion(&sync->stages_done);
+		DPU_ATRACE_END("wait_for_crtc_stages");
+	} else {
+		DPU_ATRACE_BEGIN("connector_pre_commit");
+		exynos_atomic_commit_cmd_batch(old_state, NULL, true);
+		exynos_atomic_commit_connectors(old_state, NULL, true);
+		DPU_ATRACE_END("connector_pre_commit");
+
+		exynos_atomic_commit_cmd_batch(old_state, NULL, false);
+
+		DPU_ATRACE_BEGIN("commit_planes");
+		drm_atomic_helper_commit_planes(dev, old_state,
+						DRM_PLANE_COMMIT_ACTIVE_ONLY);
+		DPU_ATRACE_END("commit_planes");
+	}
 
 	/*
 	 * hw is flushed at this point, signal flip done for fake commit to
@@ -799,28 +935,12 @@ static void exynos_atomic_commit_tail(struct drm_atomic_state *old_state)
 
 	drm_atomic_helper_fake_vblank(old_state);
 
-	DPU_ATRACE_BEGIN("connector_commit");
-	for_each_oldnew_connector_in_state(old_state, connector,
-				 old_conn_state, new_conn_state, i) {
-		if (!new_conn_state->crtc)
-			continue;
-
-		new_crtc_state = drm_atomic_get_new_crtc_state(old_state, new_conn_state->crtc);
-		if (!new_crtc_state->active)
-			continue;
-
-		if (is_exynos_drm_connector(connector)) {
-			struct exynos_drm_connector *exynos_connector =
-				to_exynos_connector(connector);
-			const struct exynos_drm_connector_helper_funcs *funcs =
-				exynos_connector->helper_private;
-
-			funcs->atomic_commit(exynos_connector,
-					to_exynos_connector_state(old_conn_state),
-					to_exynos_connector_state(new_conn_state));
-		}
+	if (!sync) {
+		DPU_ATRACE_BEGIN("connector_commit");
+		exynos_atomic_commit_connectors(old_state, NULL, false);
+		DPU_ATRACE_END("connector_commit");
 	}
-	DPU_ATRACE_END("connector_commit");
+
 	DPU_ATRACE_BEGIN("wait_for_crtc_flip");
 	exynos_crtc_wait_for_flip_done(old_state);
 	DPU_ATRACE_END("wait_for_crtc_flip");
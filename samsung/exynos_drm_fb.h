@@ -38,6 +38,8 @@ dma_addr_t exynos_drm_fb_dma_addr(const struct drm_framebuffer *fb, int index);
 void *exynos_drm_fb_to_vaddr(const struct drm_framebuffer *fb);
 
 void exynos_drm_mode_config_init(struct drm_device *dev);
+void exynos_atomic_commit_crtc_stage(struct drm_atomic_state *old_state,
+				     struct drm_crtc *crtc);
 void exynos_rmem_register(struct decon_device *decon);
 
 #endif
@@ -0,0 +1,44 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Copyright (C) 2023 Google LLC
+ *
+ * Plane fence to trigger latency statistics for Samsung EXYNOS DRM
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include "exynos_drm_fence_latency.h"
+
+int fence_latency_bucket(u64 us)
+{
+	const int bucket = fls64(div_u64(us, FENCE_LATENCY_HIST_MIN_US));
+
+	return bucket < FENCE_LATENCY_HIST_BUCKETS ? bucket : FENCE_LATENCY_HIST_BUCKETS - 1;
+}
+
+/*
+ * Records the latency of a trigger at @trigger_ns whose last fence signaled at
+ * @ready_ns, and returns it in us. A fence reported to signal after the
+ * trigger, e.g. when it timed out, counts as no latency.
+ */
+u64 fence_latency_record(struct fence_latency *fl, enum fence_latency_path path,
+			 s64 ready_ns, s64 trigger_ns)
+{
+	const u64 us = trigger_ns > ready_ns ?
+			div_u64((u64)(trigger_ns - ready_ns), NSEC_PER_USEC) : 0;
+
+	fl->hist[path][fence_latency_bucket(us)]++;
+	fl->cnt[path]++;
+	fl->sum_us[path] += us;
+	if (us > fl->max_us[path])
+		fl->max_us[path] = us > (u32)~0U ? (u32)~0U : (u32)us;
+
+	return us;
+}
+
+u32 fence_latency_avg_us(const struct fence_latency *fl, enum fence_latency_path path)
+{
+	return fl->cnt[path] ? div_u64(fl->sum_us[path], fl->cnt[path]) : 0;
+}
@@ -0,0 +1,66 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ *
+ * Copyright (C) 2023 Google LLC
+ *
+ * Header file for the plane fence to trigger latency statistics.
+ *
+ * Accounts the time from the last plane fence of a commit signaling, i.e. the
+ * GPU finishing its last layer, until the DECON trigger, separately for the
+ * commits whose fences were waited for in the commit tail and for those which
+ * deferred them to the trigger. It doesn't access any hardware or driver state
+ * and can be built outside of the kernel as well, in that case the few kernel
+ * helpers it depends on are provided below.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef __EXYNOS_DRM_FENCE_LATENCY_H__
+#define __EXYNOS_DRM_FENCE_LATENCY_H__
+
+#ifdef __KERNEL__
+#include <linux/bitops.h>
+#include <linux/kernel.h>
+#include <linux/math64.h>
+#include <linux/types.h>
+#else
+#include <stdint.h>
+
+typedef uint32_t u32;
+typedef int64_t s64;
+typedef uint64_t u64;
+
+#define NSEC_PER_USEC		1000L
+
+#define div_u64(x, y)		((x) / (y))
+
+static inline int fls64(u64 x)
+{
+	return x ? 64 - __builtin_clzll(x) : 0;
+}
+#endif
+
+enum fence_latency_path {
+	FENCE_LATENCY_BLOCKING,
+	FENCE_LATENCY_DEFERRED,
+	FENCE_LATENCY_PATH_MAX,
+};
+
+/* the first bucket is below 125us and each next one is twice as wide */
+#define FENCE_LATENCY_HIST_MIN_US	125
+#define FENCE_LATENCY_HIST_BUCKETS	10
+
+struct fence_latency {
+	u32 hist[FENCE_LATENCY_PATH_MAX][FENCE_LATENCY_HIST_BUCKETS];
+	u32 cnt[FENCE_LATENCY_PATH_MAX];
+	u32 max_us[FENCE_LATENCY_PATH_MAX];
+	u64 sum_us[FENCE_LATENCY_PATH_MAX];
+};
+
+int fence_latency_bucket(u64 us);
+u64 fence_latency_record(struct fence_latency *fl, enum fence_latency_path path,
+			 s64 ready_ns, s64 trigger_ns);
+u32 fence_latency_avg_us(const struct fence_latency *fl, enum fence_latency_path path);
+
+#endif /* __EXYNOS_DRM_FENCE_LATENCY_H__ */
@@ -30,6 +30,22 @@
 #include "exynos_drm_writeback.h"
 
 #define HIBERNATION_ENTRY_MIN_TIME_MS		50
+#define HIBERNATION_EXIT_HIST_MIN_US		250
+#define HIBERNATION_WAKE_HIST_MIN_US		USEC_PER_MSEC
+
+/* longer intervals are idle time anyway, don't let them dominate the average */
+#define HIBERNATION_POLICY_MAX_INTERVAL_US	USEC_PER_SEC
+/* intervals needed before the prediction is trusted */
+#define HIBERNATION_POLICY_MIN_SAMPLES		8
+/* averages are updated with a gain of 1 / (1 << shift) */
+#define HIBERNATION_POLICY_EWMA_SHIFT		3
+/* commits later than interval + dev * mult don't follow the pattern anymore */
+#define HIBERNATION_POLICY_DEV_MULT		2
+/* transitions run at full power, the residency has to cover them a few times over */
+#define HIBERNATION_POLICY_BREAK_EVEN_SHIFT	2
+/* transition costs used until they are measured */
+#define HIBERNATION_POLICY_ENTER_US		1000
+#define HIBERNATION_POLICY_EXIT_US		2000
 #define CAMERA_OPERATION_MASK	0xF
 
 static bool is_camera_operating(struct exynos_hibernation *hiber)
@@ -187,15 +203,279 @@ out_drop_locks:
 	return ret;
 }
 
+static inline u32 hibernation_ewma(u32 avg, u32 sample)
+{
+	return avg + (((s32)sample - (s32)avg) >> HIBERNATION_POLICY_EWMA_SHIFT);
+}
+
+static inline s64 hibernation_break_even_us(const struct exynos_hibernation_policy *p)
+{
+	return (s64)(p->enter_us + p->exit_us) << HIBERNATION_POLICY_BREAK_EVEN_SHIFT;
+}
+
+/* classify the residency of the hibernation entry being left, if any */
+static void hibernation_policy_leave(struct exynos_hibernation *hiber)
+{
+	struct exynos_hibernation_policy *p = &hiber->policy;
+	const ktime_t enter_ts = xchg(&p->enter_ts, 0);
+
+	if (!enter_ts)
+		return;
+
+	if (ktime_us_delta(ktime_get(), enter_ts) >= hibernation_break_even_us(p))
+		p->hits++;
+	else
+		p->false_entries++;
+}
+
+void hibernation_commit_arrival(struct exynos_hibernation *hiber)
+{
+	struct exynos_hibernation_policy *p;
+	const ktime_t now = ktime_get();
+	u32 interval_us;
+
+	if (!hiber)
+		return;
+
+	p = &hiber->policy;
+	hibernation_policy_leave(hiber);
+
+	if (p->last_commit_ts) {
+		interval_us = min_t(s64, ktime_us_delta(now, p->last_commit_ts),
+				    HIBERNATION_POLICY_MAX_INTERVAL_US);
+
+		if (!p->samples) {
+			p->interval_us = interval_us;
+			p->dev_us = interval_us / 2;
+		} else {
+			p->dev_us = hibernation_ewma(p->dev_us,
+					abs((s32)interval_us - (s32)p->interval_us));
+			p->interval_us = hibernation_ewma(p->interval_us, interval_us);
+		}
+
+		if (p->samples < HIBERNATION_POLICY_MIN_SAMPLES)
+			p->samples++;
+	}
+
+	p->last_commit_ts = now;
+}
+
+/* enter only if the next commit isn't expected before the entry pays off */
+static bool hibernation_policy_allow(struct exynos_hibernation *hiber)
+{
+	const struct exynos_hibernation_policy *p = &hiber->policy;
+	s64 elapsed_us;
+
+	if (!p->enabled || p->samples < HIBERNATION_POLICY_MIN_SAMPLES)
+		return true;
+
+	elapsed_us = ktime_us_delta(ktime_get(), p->last_commit_ts);
+
+	/* commits stopped following the pattern, display is going idle */
+	if (elapsed_us > p->interval_us + HIBERNATION_POLICY_DEV_MULT * p->dev_us)
+		return true;
+
+	return (s64)p->interval_us - elapsed_us >= hibernation_break_even_us(p);
+}
+
+/* the first bucket is below @min_us, each next one is twice as wide as the previous */
+static int hibernation_hist_bucket(s64 us, u32 min_us, int buckets)
+{
+	if (us < min_us)
+		return 0;
+
+	return min_t(int, fls64(div_u64(us, min_us)), buckets - 1);
+}
+
+static void hibernation_record_exit(struct exynos_hibernation *hiber,
+				    enum exynos_hibernation_path path, ktime_t start)
+{
+	const s64 exit_us = ktime_us_delta(ktime_get(), start);
+	const int bucket = hibernation_hist_bucket(exit_us, HIBERNATION_EXIT_HIST_MIN_US,
+						   HIBERNATION_EXIT_HIST_BUCKETS);
+
+	hiber->exit_hist[path][bucket]++;
+	hiber->policy.exit_us = hibernation_ewma(hiber->policy.exit_us,
+			min_t(s64, exit_us, HIBERNATION_POLICY_MAX_INTERVAL_US));
+	pr_debug("%s: %s exit took %lldus\n", __func__,
+		 path == HIBERNATION_PATH_FAST ? "fast" : "commit", exit_us);
+}
+
+/* the fast path skips the connector and bridge hooks of a self refresh commit */
+static bool exynos_hibernation_fast_possible(struct exynos_hibernation *hiber)
+{
+	struct drm_crtc *crtc = &hiber->decon->crtc->base;
+	const struct drm_crtc_state *crtc_state = crtc->state;
+	const struct exynos_drm_crtc_state *exynos_crtc_state = to_exynos_crtc_state(crtc_state);
+	struct drm_connector_list_iter conn_iter;
+	struct drm_connector *conn;
+	bool possible = true;
+
+	/* the handler holds one block itself, any other one is a commit on its way */
+	if (atomic_read(&hiber->block_cnt) > 1)
+		return false;
+
+	if (!crtc_state->active || crtc_state->self_refresh_active ||
+	    exynos_crtc_state->bypass || exynos_crtc_state->wb_type != EXYNOS_WB_NONE)
+		return false;
+
+	/* a new state was swapped in but its commit tail didn't program it yet */
+	if (crtc_state->commit && !completion_done(&crtc_state->commit->hw_done))
+		return false;
+
+	drm_connector_list_iter_begin(crtc->dev, &conn_iter);
+	drm_for_each_connector_iter(conn, &conn_iter) {
+		const struct drm_connector_state *conn_state = conn->state;
+		const struct exynos_drm_connector_state *exynos_conn_state;
+
+		if (conn_state->crtc != crtc)
+			continue;
+
+		if (!is_exynos_drm_connector(conn) || !conn_state->self_refresh_aware) {
+			possible = false;
+			break;
+		}
+
+		/* panel idle mode is switched by the bridge when self refresh is entered */
+		exynos_conn_state = to_exynos_connector_state(conn_state);
+		if (exynos_conn_state->panel_idle_support || exynos_conn_state->blanked_mode) {
+			possible = false;
+			break;
+		}
+	}
+	drm_connector_list_iter_end(&conn_iter);
+
+	return possible;
+}
+
+static int exynos_hibernation_fast_enter(struct exynos_hibernation *hiber)
+{
+	struct drm_crtc *crtc = &hiber->decon->crtc->base;
+	int ret = -EBUSY;
+
+	/* commits take fast_lock with modeset locks held, so don't wait for them here */
+	if (!ww_mutex_trylock(&crtc->mutex.mutex))
+		return -EBUSY;
+
+	mutex_lock(&hiber->fast_lock);
+	if (exynos_hibernation_fast_possible(hiber)) {
+		ret = decon_fast_hibernation_enter(hiber->decon);
+		if (!ret) {
+			hiber->fast_active = true;
+			hiber->fast_enter_cnt++;
+		}
+	}
+	mutex_unlock(&hiber->fast_lock);
+
+	ww_mutex_unlock(&crtc->mutex.mutex);
+
+	return ret;
+}
+
+void hibernation_fast_exit(struct exynos_hibernation *hiber)
+{
+	ktime_t start;
+
+	if (!hiber)
+		return;
+
+	mutex_lock(&hiber->fast_lock);
+	if (hiber->fast_active) {
+		DPU_ATRACE_BEGIN(__func__);
+		hibernation_policy_leave(hiber);
+		start = ktime_get();
+		decon_fast_hibernation_exit(hiber->decon);
+		hiber->fast_active = false;
+		hibernation_record_exit(hiber, HIBERNATION_PATH_FAST, start);
+		DPU_ATRACE_END(__func__);
+	}
+	mutex_unlock(&hiber->fast_lock);
+}
+
+static void exynos_hibernation_fast_exit_work(struct kthread_work *work)
+{
+	struct exynos_hibernation *hiber = container_of(work,
+			struct exynos_hibernation, fast_exit_work);
+
+	hibernation_fast_exit(hiber);
+}
+
+void hibernation_early_wake(struct exynos_hibernation *hiber)
+{
+	struct decon_device *decon;
+	bool early;
+
+	if (!hiber)
+		return;
+
+	decon = hiber->decon;
+	if (decon->state != DECON_STATE_HIBERNATION)
+		return;
+
+	early = hiber->early_wake_enabled && READ_ONCE(hiber->fast_active);
+
+	/* only the first frame since entry is measured */
+	if (cmpxchg(&hiber->wake_ts, 0, ktime_get()))
+		return;
+
+	hiber->wake_type = early ? HIBERNATION_WAKE_EARLY : HIBERNATION_WAKE_COMMIT;
+	if (!early)
+		return;
+
+	DPU_ATRACE_BEGIN(__func__);
+	kthread_queue_work(&decon->worker, &hiber->fast_exit_work);
+	DPU_ATRACE_END(__func__);
+}
+
+void hibernation_frame_done(struct exynos_hibernation *hiber)
+{
+	ktime_t wake_ts;
+	s64 wake_us;
+
+	if (!hiber || !hiber->wake_ts)
+		return;
+
+	wake_ts = xchg(&hiber->wake_ts, 0);
+	if (!wake_ts)
+		return;
+
+	wake_us = ktime_us_delta(ktime_get(), wake_ts);
+	hiber->wake_hist[hiber->wake_type][hibernation_hist_bucket(wake_us,
+			HIBERNATION_WAKE_HIST_MIN_US, HIBERNATION_WAKE_HIST_BUCKETS)]++;
+	pr_debug("%s: first frame after %s wake up took %lldus\n", __func__,
+		 hiber->wake_type == HIBERNATION_WAKE_EARLY ? "early" : "commit", wake_us);
+}
+
 static int exynos_hibernation_enter(struct exynos_hibernation *hiber, bool nonblock)
 {
 	struct decon_device *decon = hiber->decon;
+	const ktime_t start = ktime_get();
 	int ret;
 
 	pr_debug("%s +\n", __func__);
 
 	DPU_ATRACE_BEGIN(__func__);
+	/* blocking entries come from suspend, which always commits */
+	if (nonblock && hiber->fast_enabled) {
+		ret = exynos_hibernation_fast_enter(hiber);
+		if (!ret) {
+			hiber->policy.enter_us = hibernation_ewma(hiber->policy.enter_us,
+					ktime_us_delta(ktime_get(), start));
+			goto out;
+		}
+
+		hiber->fast_fallback_cnt++;
+		pr_debug("%s: fast path not possible (%d)\n", __func__, ret);
+	}
+
 	ret = exynos_crtc_self_refresh_update(&decon->crtc->base, true, nonblock);
+out:
+	if (!ret) {
+		hiber->policy.entered++;
+		hiber->policy.enter_ts = ktime_get();
+		/* a frame checked but never committed doesn't count */
+		WRITE_ONCE(hiber->wake_ts, 0);
+	}
 	DPU_ATRACE_END(__func__);
 
 	return ret;
@@ -204,10 +484,23 @@ static int exynos_hibernation_enter(struct exynos_hibernation *hiber, bool nonbl
 static int exynos_hibernation_exit(struct exynos_hibernation *hiber, bool nonblock)
 {
 	struct decon_device *decon = hiber->decon;
-	int ret;
+	ktime_t start = ktime_get();
+	int ret = 0;
 
 	DPU_ATRACE_BEGIN(__func__);
-	ret = exynos_crtc_self_refresh_update(&decon->crtc->base, false, nonblock);
+	hibernation_policy_leave(hiber);
+
+	/* entry work was cancelled or waited for by the caller, fast_active is stable */
+	if (hiber->fast_active) {
+		if (nonblock)
+			kthread_queue_work(&decon->worker, &hiber->fast_exit_work);
+		else
+			hibernation_fast_exit(hiber);
+	} else {
+		ret = exynos_crtc_self_refresh_update(&decon->crtc->base, false, nonblock);
+		if (!ret && !nonblock)
+			hibernation_record_exit(hiber, HIBERNATION_PATH_COMMIT, start);
+	}
 	DPU_ATRACE_END(__func__);
 
 	pr_debug("%s: DPU power %s\n", __func__,
@@ -343,6 +636,13 @@ static int _exynos_hibernation_run(struct exynos_hibernation *hibernation, bool
 		goto ret;
 	}
 
+	/* suspend doesn't wait for the next commit */
+	if (nonblock && !hibernation_policy_allow(hibernation)) {
+		hibernation->policy.deferred++;
+		rc = -EAGAIN;
+		goto ret;
+	}
+
 	hibernation_block(hibernation);
 	rc = funcs->enter(hibernation, nonblock);
 	hibernation_unblock(hibernation);
@@ -385,6 +685,9 @@ int exynos_hibernation_suspend(struct exynos_hibernation *hiber)
 	/* make sure all work is complete (including async commits) */
 	kthread_flush_worker(&hiber->decon->worker);
 
+	/* suspend needs the CRTC inactive in DRM state, which the fast path doesn't do */
+	hibernation_fast_exit(hiber);
+
 	if (atomic_read(&hiber->block_cnt) > 0)
 		ret = -EBUSY;
 	else
@@ -434,13 +737,20 @@ exynos_hibernation_register(struct decon_device *decon)
 	hibernation->decon = decon;
 	hibernation->funcs = &hibernation_funcs;
 	hibernation->enabled = true;
+	hibernation->fast_enabled = true;
+	hibernation->policy.enabled = true;
+	hibernation->early_wake_enabled = true;
+	hibernation->policy.enter_us = HIBERNATION_POLICY_ENTER_US;
+	hibernation->policy.exit_us = HIBERNATION_POLICY_EXIT_US;
 
 	mutex_init(&hibernation->lock);
+	mutex_init(&hibernation->fast_lock);
 
 	atomic_set(&hibernation->block_cnt, 0);
 	DPU_ATRACE_INT_PID("hiber_blk_cnt", 0, decon->thread->pid);
 
 	kthread_init_delayed_work(&hibernation->dwork, exynos_hibernation_handler);
+	kthread_init_work(&hibernation->fast_exit_work, exynos_hibernation_fast_exit_work);
 
 	pr_info("display hibernation is supported\n");
 
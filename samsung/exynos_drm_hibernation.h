@@ -20,12 +20,67 @@
 #include <linux/sched.h>
 #include <linux/kthread.h>
 #include <linux/io.h>
+#include <linux/ktime.h>
 
 struct decon_device;
 struct dsim_device;
 struct exynos_hibernation;
 struct writeback_device;
 
+/* exit latency histogram, the first bucket is below 250us and each next one is twice as wide */
+#define HIBERNATION_EXIT_HIST_BUCKETS	8
+/* first frame after wake up histogram, the first bucket is below 1ms */
+#define HIBERNATION_WAKE_HIST_BUCKETS	8
+
+enum exynos_hibernation_wake {
+	/* exit started by the commit itself */
+	HIBERNATION_WAKE_COMMIT,
+	/* exit started from atomic check, ahead of the commit */
+	HIBERNATION_WAKE_EARLY,
+	HIBERNATION_WAKE_MAX,
+};
+
+enum exynos_hibernation_path {
+	/* self refresh state is switched with an atomic commit */
+	HIBERNATION_PATH_COMMIT,
+	/* hardware is powered down while the CRTC stays active in DRM state */
+	HIBERNATION_PATH_FAST,
+	HIBERNATION_PATH_MAX,
+};
+
+/*
+ * Adaptive entry policy, commit inter-arrival times are tracked per DECON and
+ * hibernation is deferred while the next commit is expected before the
+ * residency would pay for the transitions.
+ *
+ * @enabled: defer entries based on the prediction, otherwise only collect stats
+ * @last_commit_ts: arrival time of the most recent commit
+ * @enter_ts: time hibernation was entered, 0 when not in hibernation
+ * @interval_us: smoothed commit inter-arrival time
+ * @dev_us: smoothed mean deviation of @interval_us
+ * @samples: number of intervals @interval_us is based on, saturates
+ * @enter_us: smoothed hibernation entry cost
+ * @exit_us: smoothed hibernation exit cost
+ * @entered: hibernation entries
+ * @deferred: entries the policy deferred
+ * @hits: entries which stayed long enough to pay for the transitions
+ * @false_entries: entries which were left too early to save anything
+ */
+struct exynos_hibernation_policy {
+	bool enabled;
+	ktime_t last_commit_ts;
+	ktime_t enter_ts;
+	u32 interval_us;
+	u32 dev_us;
+	u32 samples;
+	u32 enter_us;
+	u32 exit_us;
+	u32 entered;
+	u32 deferred;
+	u32 hits;
+	u32 false_entries;
+};
+
 struct exynos_hibernation_funcs {
 	int (*enter)(struct exynos_hibernation *hiber, bool nonblock);
 	int (*exit)(struct exynos_hibernation *hiber, bool nonblock);
@@ -44,6 +99,26 @@ struct exynos_hibernation {
 	struct writeback_device *wb;
 	const struct exynos_hibernation_funcs *funcs;
 	bool enabled;
+
+	/* enter through the fast path unless something conflicts with it */
+	bool fast_enabled;
+	/* protects @fast_active, commits take it so it can't wait for modeset locks */
+	struct mutex fast_lock;
+	bool fast_active;
+	struct kthread_work fast_exit_work;
+	/* fast path entries, and the ones which fell back to a self refresh commit */
+	u32 fast_enter_cnt;
+	u32 fast_fallback_cnt;
+	u32 exit_hist[HIBERNATION_PATH_MAX][HIBERNATION_EXIT_HIST_BUCKETS];
+
+	struct exynos_hibernation_policy policy;
+
+	/* start leaving fast path hibernation as soon as a new frame is being checked */
+	bool early_wake_enabled;
+	/* time a new frame was first seen while in hibernation, 0 if none */
+	ktime_t wake_ts;
+	enum exynos_hibernation_wake wake_type;
+	u32 wake_hist[HIBERNATION_WAKE_MAX][HIBERNATION_WAKE_HIST_BUCKETS];
 };
 
 /**
@@ -60,6 +135,41 @@ int hibernation_block(struct exynos_hibernation *hiber);
  */
 void hibernation_block_exit(struct exynos_hibernation *hiber);
 
+/**
+ * hibernation_commit_arrival - account a commit for the adaptive entry policy
+ * @hiber: hibernation block ptr
+ *
+ * Should be called once per commit which updates the CRTC, internal self
+ * refresh commits excluded.
+ */
+void hibernation_commit_arrival(struct exynos_hibernation *hiber);
+
+/**
+ * hibernation_early_wake - a new frame is on its way, start leaving hibernation
+ * @hiber: hibernation block ptr
+ *
+ * Called from atomic check, so that the exit overlaps with the rest of the
+ * composition instead of delaying the commit. Only fast path hibernation is
+ * left early, self refresh is left by the commit itself as it needs the
+ * modeset locks the caller holds.
+ */
+void hibernation_early_wake(struct exynos_hibernation *hiber);
+
+/**
+ * hibernation_frame_done - account the first frame after hibernation
+ * @hiber: hibernation block ptr
+ */
+void hibernation_frame_done(struct exynos_hibernation *hiber);
+
+/**
+ * hibernation_fast_exit - exit hibernation if it was entered through the fast path
+ * @hiber: hibernation block ptr
+ *
+ * The CRTC stays active in DRM state while in fast path hibernation, so commits
+ * have to bring the hardware back themselves before programming it.
+ */
+void hibernation_fast_exit(struct exynos_hibernation *hiber);
+
 /**
  * hibernation_unblock_enter - unblock hibernation and schedule hibernation work if no one
  *	else is blocking it
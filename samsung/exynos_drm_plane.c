@@ -49,6 +49,7 @@ exynos_drm_plane_duplicate_state(struct drm_plane *plane)
 		drm_property_blob_get(copy->block);
 
 	__drm_atomic_helper_plane_duplicate_state(plane, &copy->base);
+	copy->fence_deferred = false;
 
 	new_exynos_state = copy;
 	if (old_state->fb) {
@@ -67,6 +68,10 @@ static void exynos_drm_plane_destroy_state(struct drm_plane *plane,
 	struct exynos_drm_plane_state *old_exynos_state =
 					to_exynos_plane_state(old_state);
 
+	/* a deferred fence is released by the DECON trigger it was waited for */
+	if (WARN_ON(old_exynos_state->fence_deferred && old_state->fence))
+		dma_fence_remove_callback(old_state->fence, &old_exynos_state->fence_cb);
+
 	if (old_exynos_state->old_fb) {
 		drm_framebuffer_put(old_exynos_state->old_fb);
 		old_exynos_state->old_fb = NULL;
@@ -0,0 +1,205 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Copyright (C) 2023 Google LLC
+ *
+ * TE timing model for Samsung EXYNOS DRM panels
+ *
+ * The model is a phase locked loop driven by the TE interrupt timestamps. Each
+ * TE that lands close to the predicted one pulls the phase and the period of
+ * the estimate towards it, which follows the slow drift of the panel
+ * oscillator and averages out the interrupt latency jitter. TEs that don't fit
+ * are treated as outliers, and two consecutive outliers with the same interval
+ * mean the panel switched to a new refresh rate. The period learned for a rate
+ * is kept, so switching back to it doesn't need to converge again.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include "exynos_drm_te_model.h"
+
+#define TE_MODEL_FRAC_BITS	16
+
+/* intervals outside of the range are glitches, or TE was stopped */
+#define TE_MODEL_MIN_PERIOD_NS	(2 * NSEC_PER_MSEC)
+#define TE_MODEL_MAX_PERIOD_NS	NSEC_PER_SEC
+
+/* a TE matches the estimate if it's within period >> shift of the prediction */
+#define TE_MODEL_TOLERANCE_SHIFT	4
+
+/* loop gains, phase error is applied as err >> shift */
+#define TE_MODEL_PHASE_SHIFT	2
+#define TE_MODEL_PERIOD_SHIFT	4
+
+/* consecutive matching TEs needed before the estimate is used */
+#define TE_MODEL_MIN_LOCKED	4
+
+/* how far past the last TE the estimate is extrapolated */
+#define TE_MODEL_MAX_PREDICT_NS	NSEC_PER_SEC
+/* periods without TE after which TE is assumed stopped, e.g. irq disabled */
+#define TE_MODEL_MAX_MISSED	2
+
+static inline u64 te_model_period_ns(const struct te_model *m)
+{
+	return m->period_q >> TE_MODEL_FRAC_BITS;
+}
+
+static inline bool te_model_within(u64 a, u64 b, u64 ref)
+{
+	const u64 delta = a > b ? a - b : b - a;
+
+	return delta <= (ref >> TE_MODEL_TOLERANCE_SHIFT);
+}
+
+static int te_model_find_rate(const struct te_model *m, u64 period_ns)
+{
+	int i;
+
+	for (i = 0; i < TE_MODEL_MAX_RATES; i++) {
+		const u64 learned_ns = m->rates[i].period_q >> TE_MODEL_FRAC_BITS;
+
+		if (learned_ns && te_model_within(learned_ns, period_ns, period_ns))
+			return i;
+	}
+
+	return -1;
+}
+
+/* switch the estimate to a new period, seeded from the learned one if any */
+static void te_model_relock(struct te_model *m, u64 ts_ns, u64 period_ns)
+{
+	int i = te_model_find_rate(m, period_ns);
+
+	if (i < 0) {
+		i = m->next_rate;
+		m->next_rate = (m->next_rate + 1) % TE_MODEL_MAX_RATES;
+		m->rates[i].period_q = period_ns << TE_MODEL_FRAC_BITS;
+	}
+
+	m->cur_rate = i;
+	m->period_q = m->rates[i].period_q;
+	m->anchor_ns = ts_ns;
+	m->locked_cnt = 1;
+	m->miss_cnt = 0;
+	m->relocks++;
+}
+
+static void te_model_outlier(struct te_model *m, u64 ts_ns, u64 interval_ns)
+{
+	m->outliers++;
+	m->locked_cnt = 0;
+	/* keep the period, but take the phase from the TE that didn't fit */
+	m->anchor_ns = ts_ns;
+
+	if (m->miss_cnt && te_model_within(interval_ns, m->cand_ns, interval_ns)) {
+		te_model_relock(m, ts_ns, interval_ns);
+		return;
+	}
+
+	m->cand_ns = interval_ns;
+	m->miss_cnt = 1;
+}
+
+void te_model_reset(struct te_model *m)
+{
+	int i;
+
+	m->anchor_ns = 0;
+	m->last_ts_ns = 0;
+	m->period_q = 0;
+	m->cand_ns = 0;
+	m->locked_cnt = 0;
+	m->miss_cnt = 0;
+	m->cur_rate = -1;
+	m->next_rate = 0;
+	m->last_err_ns = 0;
+	m->outliers = 0;
+	m->relocks = 0;
+	for (i = 0; i < TE_MODEL_MAX_RATES; i++)
+		m->rates[i].period_q = 0;
+}
+
+void te_model_update(struct te_model *m, u64 ts_ns)
+{
+	const u64 prev_ns = m->last_ts_ns;
+	u64 interval_ns, expected_ns;
+	s64 err_ns;
+
+	if (prev_ns && ts_ns <= prev_ns)
+		return;
+
+	interval_ns = ts_ns - prev_ns;
+	if (prev_ns && interval_ns < TE_MODEL_MIN_PERIOD_NS)
+		return;
+
+	m->last_ts_ns = ts_ns;
+
+	/* first TE, or TE was stopped: restart the phase, keep the period */
+	if (!prev_ns || interval_ns > TE_MODEL_MAX_PERIOD_NS) {
+		m->anchor_ns = ts_ns;
+		m->locked_cnt = 0;
+		m->miss_cnt = 0;
+		return;
+	}
+
+	if (!m->period_q) {
+		te_model_relock(m, ts_ns, interval_ns);
+		return;
+	}
+
+	expected_ns = m->anchor_ns + te_model_period_ns(m);
+	err_ns = (s64)(ts_ns - expected_ns);
+	if (!te_model_within(ts_ns, expected_ns, te_model_period_ns(m))) {
+		te_model_outlier(m, ts_ns, interval_ns);
+		return;
+	}
+
+	m->anchor_ns = expected_ns + (err_ns >> TE_MODEL_PHASE_SHIFT);
+	m->period_q += (err_ns * (1 << TE_MODEL_FRAC_BITS)) >> TE_MODEL_PERIOD_SHIFT;
+	m->last_err_ns = err_ns;
+	m->miss_cnt = 0;
+	if (m->locked_cnt < TE_MODEL_MIN_LOCKED)
+		m->locked_cnt++;
+
+	if (m->cur_rate >= 0)
+		m->rates[m->cur_rate].period_q = m->period_q;
+}
+
+/*
+ * Returns the predicted timestamp of the most recent TE at or before @now_ns
+ * and the estimated period, or false if the estimate isn't reliable enough or
+ * no TE was seen for the last TE_MODEL_MAX_MISSED periods.
+ */
+bool te_model_predict(const struct te_model *m, u64 now_ns, u64 *last_te_ns,
+		      u32 *period_ns)
+{
+	u64 elapsed_ns, cnt;
+
+	if (m->locked_cnt < TE_MODEL_MIN_LOCKED || !m->period_q)
+		return false;
+
+	/* the panel may have stopped TE, don't extrapolate from an old phase */
+	if (now_ns > m->last_ts_ns &&
+	    now_ns - m->last_ts_ns > TE_MODEL_MAX_MISSED * te_model_period_ns(m))
+		return false;
+
+	/* the fitted phase may be slightly ahead of the TE that just arrived */
+	if (now_ns < m->anchor_ns) {
+		if (!te_model_within(now_ns, m->anchor_ns, te_model_period_ns(m)))
+			return false;
+		*last_te_ns = now_ns;
+		*period_ns = te_model_period_ns(m);
+		return true;
+	}
+
+	elapsed_ns = now_ns - m->anchor_ns;
+	if (elapsed_ns > TE_MODEL_MAX_PREDICT_NS)
+		return false;
+
+	cnt = div64_u64(elapsed_ns << TE_MODEL_FRAC_BITS, m->period_q);
+	*last_te_ns = m->anchor_ns + ((cnt * m->period_q) >> TE_MODEL_FRAC_BITS);
+	*period_ns = te_model_period_ns(m);
+
+	return true;
+}
@@ -0,0 +1,81 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ *
+ * Copyright (C) 2023 Google LLC
+ *
+ * Header file for the panel TE timing model.
+ *
+ * The model estimates the real TE period and phase from the TE interrupt
+ * timestamps, so that the next vsync can be predicted without assuming the
+ * nominal refresh period. It doesn't access any hardware or driver state and
+ * can be built outside of the kernel as well, in that case the few kernel
+ * helpers it depends on are provided below.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef __EXYNOS_DRM_TE_MODEL_H__
+#define __EXYNOS_DRM_TE_MODEL_H__
+
+#ifdef __KERNEL__
+#include <linux/kernel.h>
+#include <linux/math64.h>
+#include <linux/types.h>
+#else
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef uint32_t u32;
+typedef int64_t s64;
+typedef uint64_t u64;
+
+#define NSEC_PER_MSEC		1000000L
+#define NSEC_PER_SEC		1000000000L
+
+#define div64_u64(x, y)		((x) / (y))
+#define div64_s64(x, y)		((x) / (y))
+#endif
+
+/* number of refresh rates the learned period is kept for */
+#define TE_MODEL_MAX_RATES	8
+
+/* learned period of a refresh rate, in ns << TE_MODEL_FRAC_BITS */
+struct te_model_rate {
+	u64 period_q;
+};
+
+/*
+ * @anchor_ns: fitted timestamp of the most recent TE
+ * @last_ts_ns: raw timestamp of the most recent TE
+ * @period_q: estimated TE period, in ns << TE_MODEL_FRAC_BITS
+ * @cand_ns: interval that didn't fit @period_q, candidate for a new period
+ * @locked_cnt: consecutive TEs that matched the estimate
+ * @miss_cnt: consecutive TEs that didn't match the estimate
+ * @cur_rate: slot of @rates the current estimate is saved to, or -1
+ * @next_rate: slot of @rates to be replaced next
+ * @last_err_ns: phase error of the most recent TE that matched the estimate
+ * @outliers: TEs that didn't match the estimate since the last reset
+ * @relocks: times the estimate switched to a new period since the last reset
+ */
+struct te_model {
+	u64 anchor_ns;
+	u64 last_ts_ns;
+	u64 period_q;
+	u64 cand_ns;
+	u32 locked_cnt;
+	u32 miss_cnt;
+	int cur_rate;
+	int next_rate;
+	s64 last_err_ns;
+	u32 outliers;
+	u32 relocks;
+	struct te_model_rate rates[TE_MODEL_MAX_RATES];
+};
+
+void te_model_reset(struct te_model *m);
+void te_model_update(struct te_model *m, u64 ts_ns);
+bool te_model_predict(const struct te_model *m, u64 now_ns, u64 *last_te_ns,
+		      u32 *period_ns);
+
+#endif /* __EXYNOS_DRM_TE_MODEL_H__ */
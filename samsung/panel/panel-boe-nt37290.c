@@ -912,6 +912,7 @@ static void nt37290_wait_one_vblank(struct exynos_panel *ctx,
 		crtc = ctx->exynos_connector.base.state->crtc;
 
 	DPU_ATRACE_BEGIN(__func__);
+	exynos_panel_flush_merged(ctx);
 
 	if (crtc && !drm_crtc_vblank_get(crtc)) {
 		drm_crtc_wait_one_vblank(crtc);
@@ -30,6 +30,7 @@
 
 #include <trace/dpu_trace.h>
 #include "../exynos_drm_connector.h"
+#include "../exynos_drm_crtc.h"
 #include "../exynos_drm_dsim.h"
 #include "panel-samsung-drv.h"
 
@@ -60,6 +61,8 @@ static void panel_update_local_hbm_locked(struct exynos_panel *ctx, bool enable)
 static void exynos_panel_check_mipi_sync_timing(struct drm_crtc *crtc,
 					 const struct exynos_panel_mode *current_mode,
 					 struct exynos_panel *ctx);
+static struct drm_crtc *get_exynos_panel_connector_crtc(struct exynos_panel *ctx);
+static void exynos_panel_compile_cmd_sets(struct exynos_panel *ctx);
 
 static inline bool is_backlight_off_state(const struct backlight_device *bl)
 {
@@ -399,6 +402,8 @@ int exynos_panel_init(struct exynos_panel *ctx)
 		ctx->panel_rev = PANEL_REV_LATEST;
 	}
 
+	exynos_panel_compile_cmd_sets(ctx);
+
 	if (funcs && funcs->read_id)
 		ret = funcs->read_id(ctx);
 	else
@@ -728,14 +733,277 @@ int exynos_panel_prepare(struct drm_panel *panel)
 }
 EXPORT_SYMBOL(exynos_panel_prepare);
 
+static inline bool exynos_panel_cmd_rev_match(const struct exynos_panel *ctx,
+					      const struct exynos_dsi_cmd *c)
+{
+	return !ctx->panel_rev || (c->panel_rev & ctx->panel_rev);
+}
+
+static const struct exynos_dsi_cmd *
+exynos_panel_find_last_cmd(const struct exynos_panel *ctx, const struct exynos_dsi_cmd_set *cmd_set)
+{
+	const struct exynos_dsi_cmd *c = &cmd_set->cmds[cmd_set->num_cmd - 1];
+
+	if (!c->panel_rev)
+		return c;
+
+	for (; c >= cmd_set->cmds; c--) {
+		if (c->panel_rev & ctx->panel_rev)
+			return c;
+	}
+
+	return NULL;
+}
+
+static u8 exynos_dsi_dcs_write_type(size_t len)
+{
+	switch (len) {
+	case 0:
+		/* allow flag only messages to dsim */
+		return 0;
+	case 1:
+		return MIPI_DSI_DCS_SHORT_WRITE;
+	case 2:
+		return MIPI_DSI_DCS_SHORT_WRITE_PARAM;
+	default:
+		return MIPI_DSI_DCS_LONG_WRITE;
+	}
+}
+
+/*
+ * Commands sent from the panel workers return once the transfer is started, so
+ * that the workers don't keep the DSI host busy waiting for the command fifos
+ * while the commit thread has commands to send.
+ */
+static bool exynos_dsi_dcs_async(struct mipi_dsi_device *dsi)
+{
+	const struct exynos_panel *ctx = mipi_dsi_get_drvdata(dsi);
+	const struct work_struct *work = current_work();
+
+	if (!ctx || !work)
+		return false;
+
+	return work == &ctx->idle_work.work || work == &ctx->hbm.local_hbm.timeout_work.work;
+}
+
+static ssize_t __exynos_dsi_dcs_transfer(struct mipi_dsi_device *dsi, u8 type,
+					 const void *data, size_t len, u16 flags,
+					 const struct exynos_dsi_packet *packet)
+{
+	const struct mipi_dsi_host_ops *ops = dsi->host->ops;
+	struct exynos_dsi_msg xmsg = {
+		.msg = {
+			.channel = dsi->channel,
+			.tx_buf = data,
+			.tx_len = len,
+			.type = type,
+		},
+		.packet = packet,
+	};
+	struct mipi_dsi_msg *msg = &xmsg.msg;
+
+	if (!ops || !ops->transfer)
+		return -ENOSYS;
+
+	msg->flags = flags;
+	if (dsi->mode_flags & MIPI_DSI_MODE_LPM)
+		msg->flags |= MIPI_DSI_MSG_USE_LPM;
+	if (packet)
+		msg->flags |= EXYNOS_DSI_MSG_PACKED;
+	if (exynos_dsi_dcs_async(dsi))
+		msg->flags |= EXYNOS_DSI_MSG_ASYNC;
+
+	return ops->transfer(dsi->host, msg);
+}
+
+static ssize_t exynos_dsi_dcs_transfer(struct mipi_dsi_device *dsi, u8 type,
+				     const void *data, size_t len, u16 flags)
+{
+	return __exynos_dsi_dcs_transfer(dsi, type, data, len, flags, NULL);
+}
+
+static ssize_t exynos_dsi_dcs_write_packet(struct mipi_dsi_device *dsi,
+					   const struct exynos_dsi_compiled_cmd *cc, u16 flags)
+{
+	const struct exynos_dsi_cmd *c = cc->cmd;
+
+	return __exynos_dsi_dcs_transfer(dsi, cc->type, c->cmd, c->cmd_len, flags,
+					 c->cmd_len ? &cc->packet : NULL);
+}
+
+/*
+ * Builds the packets of all commands of @cmd_set matching the current panel
+ * revision, so that sending the set doesn't need to filter the commands and
+ * pack their payloads again. Payload words are allocated along with the set.
+ */
+static struct exynos_dsi_compiled_set *
+exynos_panel_compile_cmd_set(struct exynos_panel *ctx, const struct exynos_dsi_cmd_set *cmd_set)
+{
+	struct mipi_dsi_device *dsi = to_mipi_dsi_device(ctx->dev);
+	const struct exynos_dsi_cmd *last_cmd = exynos_panel_find_last_cmd(ctx, cmd_set);
+	const struct exynos_dsi_cmd *c;
+	struct exynos_dsi_compiled_set *set;
+	u32 num_cmd = 0, num_words = 0;
+	u32 *words;
+	int i = 0;
+
+	for (c = cmd_set->cmds; last_cmd && c <= last_cmd; c++) {
+		if (!exynos_panel_cmd_rev_match(ctx, c))
+			continue;
+
+		num_cmd++;
+		if (exynos_dsi_dcs_write_type(c->cmd_len) == MIPI_DSI_DCS_LONG_WRITE)
+			num_words += DIV_ROUND_UP(c->cmd_len, 4);
+	}
+
+	set = kzalloc(struct_size(set, cmds, num_cmd) + num_words * sizeof(u32), GFP_KERNEL);
+	if (!set)
+		return NULL;
+
+	kref_init(&set->ref);
+	set->cmd_set = cmd_set;
+	set->panel_rev = ctx->panel_rev;
+	set->num_cmd = num_cmd;
+	words = (u32 *)&set->cmds[num_cmd];
+
+	for (c = cmd_set->cmds; last_cmd && c <= last_cmd; c++) {
+		struct exynos_dsi_compiled_cmd *cc;
+		struct mipi_dsi_packet packet;
+		struct mipi_dsi_msg msg = {
+			.channel = dsi->channel,
+			.tx_buf = c->cmd,
+			.tx_len = c->cmd_len,
+			.type = exynos_dsi_dcs_write_type(c->cmd_len),
+		};
+		size_t j;
+
+		if (!exynos_panel_cmd_rev_match(ctx, c))
+			continue;
+
+		cc = &set->cmds[i++];
+		cc->cmd = c;
+		cc->type = msg.type;
+		cc->last = (c == last_cmd);
+
+		if (!c->cmd_len)
+			continue;
+
+		if (mipi_dsi_create_packet(&packet, &msg)) {
+			dev_warn(ctx->dev, "unable to compile cmd 0x%02x\n", c->cmd[0]);
+			kfree(set);
+			return NULL;
+		}
+
+		memcpy(cc->packet.header, packet.header, sizeof(cc->packet.header));
+		cc->packet.payload_len = packet.payload_length;
+		if (!packet.payload_length)
+			continue;
+
+		for (j = 0; j < packet.payload_length; j++)
+			words[j / 4] |= packet.payload[j] << ((j % 4) * 8);
+		cc->packet.payload = words;
+		words += DIV_ROUND_UP(packet.payload_length, 4);
+	}
+
+	return set;
+}
+
+static void exynos_panel_compiled_set_release(struct kref *ref)
+{
+	kfree(container_of(ref, struct exynos_dsi_compiled_set, ref));
+}
+
+static void exynos_panel_put_compiled_set(struct exynos_dsi_compiled_set *set)
+{
+	if (set)
+		kref_put(&set->ref, exynos_panel_compiled_set_release);
+}
+
+/*
+ * Returns @cmd_set compiled for the current panel revision, to be released with
+ * exynos_panel_put_compiled_set() once sent.
+ */
+static struct exynos_dsi_compiled_set *
+exynos_panel_get_compiled_set(struct exynos_panel *ctx, const struct exynos_dsi_cmd_set *cmd_set)
+{
+	struct exynos_dsi_compiled_set *set;
+
+	mutex_lock(&ctx->compiled_cmd_lock);
+	hash_for_each_possible(ctx->compiled_cmd_sets, set, node, (unsigned long)cmd_set) {
+		if (set->cmd_set == cmd_set)
+			break;
+	}
+
+	/* another sender may still be replaying a stale set, the last one frees it */
+	if (set && set->panel_rev != ctx->panel_rev) {
+		hash_del(&set->node);
+		exynos_panel_put_compiled_set(set);
+		set = NULL;
+	}
+
+	if (!set) {
+		set = exynos_panel_compile_cmd_set(ctx, cmd_set);
+		if (set)
+			hash_add(ctx->compiled_cmd_sets, &set->node, (unsigned long)cmd_set);
+	}
+	if (set)
+		kref_get(&set->ref);
+	mutex_unlock(&ctx->compiled_cmd_lock);
+
+	return set;
+}
+
+static void exynos_panel_free_compiled_sets(struct exynos_panel *ctx)
+{
+	struct exynos_dsi_compiled_set *set;
+	struct hlist_node *tmp;
+	int bkt;
+
+	mutex_lock(&ctx->compiled_cmd_lock);
+	hash_for_each_safe(ctx->compiled_cmd_sets, bkt, tmp, set, node) {
+		hash_del(&set->node);
+		exynos_panel_put_compiled_set(set);
+	}
+	mutex_unlock(&ctx->compiled_cmd_lock);
+}
+
+static void exynos_panel_compile_cmd_sets(struct exynos_panel *ctx)
+{
+	const struct exynos_panel_desc *desc = ctx->desc;
+	const struct exynos_binned_lp *binned_lp;
+	int i;
+
+	if (desc->off_cmd_set && desc->off_cmd_set->num_cmd)
+		exynos_panel_put_compiled_set(exynos_panel_get_compiled_set(ctx,
+								desc->off_cmd_set));
+
+	if (desc->lp_cmd_set && desc->lp_cmd_set->num_cmd)
+		exynos_panel_put_compiled_set(exynos_panel_get_compiled_set(ctx,
+								desc->lp_cmd_set));
+
+	for_each_exynos_binned_lp(i, binned_lp, ctx) {
+		if (binned_lp->cmd_set && binned_lp->cmd_set->num_cmd)
+			exynos_panel_put_compiled_set(exynos_panel_get_compiled_set(ctx,
+								binned_lp->cmd_set));
+	}
+}
+
+/* the delay after a command only makes sense if the command isn't held back */
+static inline u16 exynos_dsi_cmd_flags(u16 dsi_flags, u32 delay_ms)
+{
+	return delay_ms ? (dsi_flags | EXYNOS_DSI_MSG_NO_MERGE) : dsi_flags;
+}
+
 void exynos_panel_send_cmd_set_flags(struct exynos_panel *ctx,
 				     const struct exynos_dsi_cmd_set *cmd_set, u32 flags)
 {
 	struct mipi_dsi_device *dsi = to_mipi_dsi_device(ctx->dev);
+	struct exynos_dsi_compiled_set *set;
 	const struct exynos_dsi_cmd *c;
 	const struct exynos_dsi_cmd *last_cmd = NULL;
 	const u32 async_mask = PANEL_CMD_SET_BATCH | PANEL_CMD_SET_QUEUE;
 	u16 dsi_flags = 0;
+	int i;
 
 	if (!cmd_set || !cmd_set->num_cmd)
 		return;
@@ -750,18 +1018,25 @@ void exynos_panel_send_cmd_set_flags(struct exynos_panel *ctx,
 	if (!(flags & async_mask))
 		dsi_flags |= MIPI_DSI_MSG_LASTCOMMAND;
 
-	c = &cmd_set->cmds[cmd_set->num_cmd - 1];
-	if (!c->panel_rev) {
-		last_cmd = c;
-	} else {
-		for (; c >= cmd_set->cmds; c--) {
-			if (c->panel_rev & ctx->panel_rev) {
-				last_cmd = c;
-				break;
-			}
+	set = exynos_panel_get_compiled_set(ctx, cmd_set);
+	if (set) {
+		for (i = 0; i < set->num_cmd; i++) {
+			const struct exynos_dsi_compiled_cmd *cc = &set->cmds[i];
+			u32 delay_ms = cc->cmd->delay_ms;
+
+			if (cc->last && !(flags & PANEL_CMD_SET_QUEUE))
+				dsi_flags |= MIPI_DSI_MSG_LASTCOMMAND;
+
+			exynos_dsi_dcs_write_packet(dsi, cc, exynos_dsi_cmd_flags(dsi_flags, delay_ms));
+			if (delay_ms)
+				usleep_range(delay_ms * 1000, delay_ms * 1000 + 10);
 		}
+		exynos_panel_put_compiled_set(set);
+		return;
 	}
 
+	last_cmd = exynos_panel_find_last_cmd(ctx, cmd_set);
+
 	/* no commands to transfer */
 	if (!last_cmd)
 		return;
@@ -769,13 +1044,14 @@ void exynos_panel_send_cmd_set_flags(struct exynos_panel *ctx,
 	for (c = cmd_set->cmds; c <= last_cmd; c++) {
 		u32 delay_ms = c->delay_ms;
 
-		if (ctx->panel_rev && !(c->panel_rev & ctx->panel_rev))
+		if (!exynos_panel_cmd_rev_match(ctx, c))
 			continue;
 
 		if ((c == last_cmd) && !(flags & PANEL_CMD_SET_QUEUE))
 			dsi_flags |= MIPI_DSI_MSG_LASTCOMMAND;
 
-		exynos_dsi_dcs_write_buffer(dsi, c->cmd, c->cmd_len, dsi_flags);
+		exynos_dsi_dcs_write_buffer(dsi, c->cmd, c->cmd_len,
+					    exynos_dsi_cmd_flags(dsi_flags, delay_ms));
 		if (delay_ms)
 			usleep_range(delay_ms * 1000, delay_ms * 1000 + 10);
 	}
@@ -1455,6 +1731,8 @@ static ssize_t osc2_clk_khz_store(struct device *dev, struct device_attribute *a
 	struct exynos_panel *ctx = mipi_dsi_get_drvdata(dsi);
 	const struct exynos_panel_funcs *funcs = ctx->desc->exynos_panel_func;
 	unsigned int osc2_clk_khz;
+	struct drm_crtc *crtc;
+	bool changed = false;
 	int ret;
 
 	if (!funcs || !funcs->set_osc2_clk_khz)
@@ -1467,10 +1745,17 @@ static ssize_t osc2_clk_khz_store(struct device *dev, struct device_attribute *a
 	}
 
 	mutex_lock(&ctx->mode_lock);
-	if (osc2_clk_khz != ctx->osc2_clk_khz)
+	if (osc2_clk_khz != ctx->osc2_clk_khz) {
 		funcs->set_osc2_clk_khz(ctx, osc2_clk_khz);
+		changed = true;
+	}
 	mutex_unlock(&ctx->mode_lock);
 
+	/* TE periods learned with the previous oscillator clock are no longer valid */
+	crtc = changed ? get_exynos_panel_connector_crtc(ctx) : NULL;
+	if (crtc)
+		exynos_drm_crtc_te_model_reset(crtc);
+
 	return count;
 }
 
@@ -1838,6 +2123,7 @@ static void exynos_panel_pre_commit_properties(
 		 * update should be delayed.
 		 */
 		DPU_ATRACE_BEGIN("dbv_wait");
+		exynos_panel_flush_merged(ctx);
 		if (!drm_crtc_vblank_get(conn_state->base.crtc)) {
 			drm_crtc_wait_one_vblank(conn_state->base.crtc);
 			drm_crtc_vblank_put(conn_state->base.crtc);
@@ -2000,6 +2286,7 @@ static int exynos_drm_connector_check_mode(struct exynos_panel *ctx,
 
 	/* self refresh is only supported in command mode */
 	connector_state->self_refresh_aware = !is_video_mode;
+	exynos_connector_state->panel_idle_support = ctx->desc->is_panel_idle_supported;
 
 	if (crtc_state->connectors_changed || !is_panel_active(ctx))
 		exynos_connector_state->seamless_possible = false;
@@ -2165,52 +2452,10 @@ static int panel_debugfs_add(struct exynos_panel *ctx, struct dentry *parent)
 	return 0;
 }
 
-static ssize_t exynos_dsi_dcs_transfer(struct mipi_dsi_device *dsi, u8 type,
-				     const void *data, size_t len, u16 flags)
-{
-	const struct mipi_dsi_host_ops *ops = dsi->host->ops;
-	struct mipi_dsi_msg msg = {
-		.channel = dsi->channel,
-		.tx_buf = data,
-		.tx_len = len,
-		.type = type,
-	};
-
-	if (!ops || !ops->transfer)
-		return -ENOSYS;
-
-	msg.flags = flags;
-	if (dsi->mode_flags & MIPI_DSI_MODE_LPM)
-		msg.flags |= MIPI_DSI_MSG_USE_LPM;
-
-	return ops->transfer(dsi->host, &msg);
-}
-
 ssize_t exynos_dsi_dcs_write_buffer(struct mipi_dsi_device *dsi,
 				  const void *data, size_t len, u16 flags)
 {
-	u8 type;
-
-	switch (len) {
-	case 0:
-		/* allow flag only messages to dsim */
-		type = 0;
-		break;
-
-	case 1:
-		type = MIPI_DSI_DCS_SHORT_WRITE;
-		break;
-
-	case 2:
-		type = MIPI_DSI_DCS_SHORT_WRITE_PARAM;
-		break;
-
-	default:
-		type = MIPI_DSI_DCS_LONG_WRITE;
-		break;
-	}
-
-	return exynos_dsi_dcs_transfer(dsi, type, data, len, flags);
+	return exynos_dsi_dcs_transfer(dsi, exynos_dsi_dcs_write_type(len), data, len, flags);
 }
 EXPORT_SYMBOL(exynos_dsi_dcs_write_buffer);
 
@@ -3487,6 +3732,9 @@ int exynos_panel_wait_for_vblank(struct exynos_panel *ctx)
 	if (ctx->exynos_connector.base.state)
 		crtc = ctx->exynos_connector.base.state->crtc;
 
+	/* the caller waits for the commands sent so far to take effect */
+	exynos_panel_flush_merged(ctx);
+
 	if (crtc && !drm_crtc_vblank_get(crtc)) {
 		drm_crtc_wait_one_vblank(crtc);
 		drm_crtc_vblank_put(crtc);
@@ -3685,7 +3933,16 @@ static void exynos_panel_check_mipi_sync_timing(struct drm_crtc *crtc,
 		now = ktime_get();
 		since_last_te_us = ktime_us_delta(now, last_te);
 		if (!vblank_taken) {
-			ktime_t predicted_te = exynos_panel_te_ts_prediction(ctx, last_te,
+			ktime_t predicted_te = 0;
+			u32 measured_period_ns;
+
+			/* prefer the measured TE timing, it isn't limited by rr switches */
+			if (exynos_drm_crtc_te_predict(crtc, now, &predicted_te,
+						       &measured_period_ns))
+				cur_te_period_us = DIV_ROUND_CLOSEST(measured_period_ns,
+								     NSEC_PER_USEC);
+			else
+				predicted_te = exynos_panel_te_ts_prediction(ctx, last_te,
 					USEC_PER_SEC / drm_mode_vrefresh(&current_mode->mode));
 			if (predicted_te) {
 				DPU_ATRACE_BEGIN("predicted_te");
@@ -4234,6 +4491,8 @@ int exynos_panel_common_init(struct mipi_dsi_device *dsi,
 	mutex_init(&ctx->mode_lock);
 	mutex_init(&ctx->bl_state_lock);
 	mutex_init(&ctx->lp_state_lock);
+	mutex_init(&ctx->compiled_cmd_lock);
+	hash_init(ctx->compiled_cmd_sets);
 
 	drm_panel_init(&ctx->panel, dev, ctx->desc->panel_func, DRM_MODE_CONNECTOR_DSI);
 
@@ -4309,6 +4568,8 @@ int exynos_panel_remove(struct mipi_dsi_device *dsi)
 	sysfs_remove_file(&ctx->bl->dev.kobj, &dev_attr_cabc_mode.attr);
 	devm_backlight_device_unregister(ctx->dev, ctx->bl);
 
+	exynos_panel_free_compiled_sets(ctx);
+
 	return 0;
 }
 EXPORT_SYMBOL(exynos_panel_remove);
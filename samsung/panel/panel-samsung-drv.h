@@ -18,6 +18,8 @@
 #include <linux/delay.h>
 #include <linux/regulator/consumer.h>
 #include <linux/gpio/consumer.h>
+#include <linux/hashtable.h>
+#include <linux/kref.h>
 #include <linux/backlight.h>
 #include <drm/drm_bridge.h>
 #include <drm/drm_connector.h>
@@ -467,6 +469,39 @@ struct exynos_dsi_cmd_set {
 	const struct exynos_dsi_cmd *cmds;
 };
 
+/**
+ * struct exynos_dsi_compiled_cmd - dsi command with its packet built ahead.
+ * @cmd:      Original dsi command.
+ * @type:     DSI data type the command is sent with.
+ * @last:     The command is the last one of the set.
+ * @packet:   Packet header and TX FIFO payload words for @cmd.
+ */
+struct exynos_dsi_compiled_cmd {
+	const struct exynos_dsi_cmd *cmd;
+	u8 type;
+	bool last;
+	struct exynos_dsi_packet packet;
+};
+
+/**
+ * struct exynos_dsi_compiled_set - dsi command sequence compiled for a panel
+ * revision. Only the commands matching @panel_rev are kept.
+ * @node:      Entry in the panel compiled command set table.
+ * @ref:       Held by the table and by each sender replaying the set.
+ * @cmd_set:   Command sequence this was compiled from.
+ * @panel_rev: Panel revision the commands were filtered with.
+ * @num_cmd:   Number of commands to send.
+ * @cmds:      Commands to send, in order.
+ */
+struct exynos_dsi_compiled_set {
+	struct hlist_node node;
+	struct kref ref;
+	const struct exynos_dsi_cmd_set *cmd_set;
+	u32 panel_rev;
+	u32 num_cmd;
+	struct exynos_dsi_compiled_cmd cmds[];
+};
+
 /**
  * struct exynos_binned_lp - information for binned lp mode.
  * @name:         Name of this binned lp mode.
@@ -641,6 +676,10 @@ struct exynos_panel {
 	u32 panel_rev;
 	enum drm_panel_orientation orientation;
 
+	/* command sets compiled for panel_rev, keyed by the command set */
+	DECLARE_HASHTABLE(compiled_cmd_sets, 4);
+	struct mutex compiled_cmd_lock;
+
 	struct device_node *touch_dev;
 
 	struct te2_data te2;
@@ -875,8 +914,10 @@ static inline bool is_local_hbm_disabled(struct exynos_panel *ctx)
 		EXYNOS_DCS_WRITE_PRINT_ERR(ctx, d, ARRAY_SIZE(d), ret);	\
 } while (0)
 
+/* the delay only makes sense if the command isn't held back in a commit batch */
 #define EXYNOS_DCS_WRITE_SEQ_DELAY(ctx, delay, seq...) do {		\
-	EXYNOS_DCS_WRITE_SEQ(ctx, seq);					\
+	EXYNOS_DCS_WRITE_SEQ_FLAGS(ctx, MIPI_DSI_MSG_LASTCOMMAND |	\
+				   EXYNOS_DSI_MSG_NO_MERGE, seq);	\
 	usleep_range(delay * 1000, delay * 1000 + 10);			\
 } while (0)
 
@@ -896,7 +937,8 @@ static inline bool is_local_hbm_disabled(struct exynos_panel *ctx)
 } while (0)
 
 #define EXYNOS_DCS_WRITE_TABLE_DELAY(ctx, delay, table) do {		\
-	EXYNOS_DCS_WRITE_TABLE(ctx, table);				\
+	EXYNOS_DCS_WRITE_TABLE_FLAGS(ctx, table, MIPI_DSI_MSG_LASTCOMMAND |	\
+				     EXYNOS_DSI_MSG_NO_MERGE);		\
 	usleep_range(delay * 1000, delay * 1000 + 10);			\
 } while (0)
 
@@ -998,4 +1040,14 @@ static inline void exynos_dsi_dcs_write_buffer_force_batch_end(struct mipi_dsi_d
 				    EXYNOS_DSI_MSG_FORCE_FLUSH | EXYNOS_DSI_MSG_IGNORE_VBLANK);
 }
 
+/*
+ * Sends the commands held back in the commit batch so far. Needed before
+ * sleeping or waiting for vblank between commands in the commit path.
+ */
+static inline void exynos_panel_flush_merged(struct exynos_panel *ctx)
+{
+	exynos_dsi_dcs_write_buffer(to_mipi_dsi_device(ctx->dev), NULL, 0,
+				    EXYNOS_DSI_MSG_NO_MERGE);
+}
+
 #endif /* _PANEL_SAMSUNG_DRV_ */
@@ -542,6 +542,7 @@ static void s6e3fc3_p10_set_nolp_mode(struct exynos_panel *ctx,
 	if (ctx->panel_rev >= PANEL_REV_EVT1)
 		EXYNOS_DCS_WRITE_TABLE(ctx, test_key_off_f0);
 	s6e3fc3_p10_change_frequency(ctx, vrefresh);
+	exynos_panel_flush_merged(ctx);
 	usleep_range(delay_us, delay_us + 10);
 	EXYNOS_DCS_WRITE_TABLE(ctx, display_on);
 
@@ -295,6 +295,7 @@ static void s6e3fc3_set_nolp_mode(struct exynos_panel *ctx,
 	/* backlight control and dimming */
 	s6e3fc3_update_wrctrld(ctx);
 	s6e3fc3_change_frequency(ctx, vrefresh);
+	exynos_panel_flush_merged(ctx);
 	usleep_range(delay_us, delay_us + 10);
 	EXYNOS_DCS_WRITE_TABLE(ctx, display_on);
 
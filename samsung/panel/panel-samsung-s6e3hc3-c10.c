@@ -593,6 +593,7 @@ static bool s6e3hc3_c10_set_self_refresh(struct exynos_panel *ctx, bool enable)
 		 */
 		dev_dbg(ctx->dev, "wait one vblank after exit idle\n");
 		DPU_ATRACE_BEGIN("wait_one_vblank");
+		exynos_panel_flush_merged(ctx);
 		if (crtc) {
 			int ret = drm_crtc_vblank_get(crtc);
 
@@ -687,10 +688,12 @@ static void s6e3hc3_c10_set_nolp_mode(struct exynos_panel *ctx,
 		return;
 
 	EXYNOS_DCS_WRITE_TABLE(ctx, display_off);
+	exynos_panel_flush_merged(ctx);
 	usleep_range(delay_us, delay_us + 10);
 	/* backlight control and dimming */
 	s6e3hc3_c10_write_display_mode(ctx, &pmode->mode);
 	s6e3hc3_c10_change_frequency(ctx, pmode);
+	exynos_panel_flush_merged(ctx);
 	usleep_range(delay_us, delay_us + 10);
 	EXYNOS_DCS_WRITE_TABLE(ctx, display_on);
 
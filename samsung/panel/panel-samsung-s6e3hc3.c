@@ -672,6 +672,7 @@ static void s6e3hc3_set_nolp_mode(struct exynos_panel *ctx,
 	if (ctx->panel_rev == PANEL_REV_PROTO1)
 		EXYNOS_DCS_WRITE_SEQ(ctx, 0x49, 0x02);	/* normal gamma */
 	s6e3hc3_change_frequency(ctx, pmode);
+	exynos_panel_flush_merged(ctx);
 	usleep_range(delay_us, delay_us + 10);
 	EXYNOS_DCS_WRITE_TABLE(ctx, display_on);
 
@@ -980,8 +981,10 @@ static void s6e3hc3_set_hbm_setting(struct exynos_panel *ctx,
 		if (is_hbm_on) {
 			EXYNOS_DCS_WRITE_SEQ(ctx, 0xB0, 0x00, 0x01, 0x49);
 			EXYNOS_DCS_WRITE_SEQ(ctx, 0x49, 0x00);
+			exynos_panel_flush_merged(ctx);
 			usleep_range(17000, 17010);
 		} else {
+			exynos_panel_flush_merged(ctx);
 			usleep_range(17000, 17010);
 			EXYNOS_DCS_WRITE_SEQ(ctx, 0xB0, 0x00, 0x01, 0x49);
 			EXYNOS_DCS_WRITE_SEQ(ctx, 0x49, 0x01);
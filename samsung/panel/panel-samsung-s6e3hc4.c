@@ -652,6 +652,7 @@ static bool s6e3hc4_set_self_refresh(struct exynos_panel *ctx, bool enable)
 		 */
 		dev_dbg(ctx->dev, "wait one vblank after exit idle\n");
 		DPU_ATRACE_BEGIN("wait_one_vblank");
+		exynos_panel_flush_merged(ctx);
 		if (crtc) {
 			int ret = drm_crtc_vblank_get(crtc);
 
@@ -0,0 +1,486 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Copyright (C) 2023 Google LLC
+ *
+ * CPU time of the bandwidth calculation on the commit thread
+ *
+ * A recorded-like sequence of commits, mostly buffer flips with a sliding
+ * window now and then and a video layer going away, is run through the model
+ * twice the way dpu_bts_calc_bw() does. Once recalculating every window and
+ * the overlap on every commit as before, once keeping the per-window results
+ * and only recalculating what exynos_bts_update_win_config() marked dirty.
+ * Both have to vote the same on every commit, then the commit thread CPU time
+ * of each is printed.
+ *
+ * Then random stacks of 1 up to DPU_BTS_MAX_LAYERS layers go through the line
+ * sweep of dpu_bts_calc_overlap_bw() and through the pairwise check it
+ * replaced. Both have to find the same peaks, and the time each takes for a
+ * stack is printed.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "exynos_drm_bts_calc.h"
+
+#define AXI_PORTS		4
+#define WINS			6
+#define DIRTY_ALL		((1U << WINS) - 1)
+#define FRAMES			1200
+#define LOOPS			50
+
+static int failures;
+
+#define CHECK(cond, fmt, ...) do {					\
+	if (!(cond)) {							\
+		fprintf(stderr, "%s:%d: " fmt "\n", __func__, __LINE__,	\
+			##__VA_ARGS__);					\
+		failures++;						\
+	}								\
+} while (0)
+
+/* DISP DVFS levels as in the gs101 DT */
+static const u32 dfs_lv_khz[] = { 664000, 533000, 400000, 310000, 267000, 200000, 134000 };
+
+#define fourcc_code(a, b, c, d)	((u32)(a) | ((u32)(b) << 8) | \
+				 ((u32)(c) << 16) | ((u32)(d) << 24))
+
+/* head of dpu_formats_list, searched the same way as dpu_find_fmt_info() does */
+static const struct fmt {
+	u32 fmt;
+	u32 bpp;
+	bool yuv;
+} formats[] = {
+	{ fourcc_code('C', '8', ' ', ' '), 8, false },
+	{ fourcc_code('A', 'R', '2', '4'), 32, false },
+	{ fourcc_code('A', 'B', '2', '4'), 32, false },
+	{ fourcc_code('R', 'A', '2', '4'), 32, false },
+	{ fourcc_code('B', 'A', '2', '4'), 32, false },
+	{ fourcc_code('X', 'R', '2', '4'), 32, false },
+	{ fourcc_code('X', 'B', '2', '4'), 32, false },
+	{ fourcc_code('R', 'X', '2', '4'), 32, false },
+	{ fourcc_code('B', 'X', '2', '4'), 32, false },
+	{ fourcc_code('R', 'G', '1', '6'), 16, false },
+	{ fourcc_code('B', 'G', '1', '6'), 16, false },
+	{ fourcc_code('A', 'R', '3', '0'), 32, false },
+	{ fourcc_code('A', 'B', '3', '0'), 32, false },
+	{ fourcc_code('R', 'A', '3', '0'), 32, false },
+	{ fourcc_code('B', 'A', '3', '0'), 32, false },
+	{ fourcc_code('N', 'V', '1', '2'), 12, true },
+	{ fourcc_code('N', 'V', '2', '1'), 12, true },
+	{ fourcc_code('P', '0', '1', '0'), 24, true },
+};
+
+static const struct fmt *find_fmt(u32 fmt)
+{
+	u32 i;
+
+	for (i = 0; i < sizeof(formats) / sizeof(formats[0]); i++)
+		if (formats[i].fmt == fmt)
+			return &formats[i];
+
+	return &formats[0];
+}
+
+/* FHD command mode panel at 120Hz, with the DT defaults of exynos_drm_decon.c */
+static void panel_params(struct dpu_bts_params *p)
+{
+	memset(p, 0, sizeof(*p));
+	p->lcd_w = 1080;
+	p->lcd_h = 2400;
+	p->fps = 120;
+	p->vbp = 15;
+	p->vfp = 8;
+	p->vsa = 1;
+	p->vblank_usec = 700;
+	p->dsc_enabled = true;
+	p->dsc_count = 1;
+	p->dsc_slice_count = 2;
+
+	p->ppc = 2;
+	p->ppc_rotator = 4;
+	p->ppc_scaler = 2;
+	p->delay_comp = 4;
+	p->delay_scaler = 2;
+	p->bus_width = 16;
+	p->bus_util_pct = 65;
+	p->rot_util_pct = 60;
+	p->afbc_rgb_util_pct = 100;
+	p->afbc_yuv_util_pct = 100;
+	p->afbc_rgb_rt_util_pct = 100;
+	p->afbc_yuv_rt_util_pct = 100;
+
+	p->dfs_lv_cnt = sizeof(dfs_lv_khz) / sizeof(dfs_lv_khz[0]);
+	p->dfs_lv_khz = dfs_lv_khz;
+}
+
+/*
+ * Window config of @frame: wallpaper, app, status and navigation bars, a
+ * rotated video which is closed after frame 600 and a toast sliding in over
+ * frames 300 to 360. Everything else is a buffer flip.
+ */
+static void frame_config(u32 frame, u32 win, struct dpu_bts_win_config *config)
+{
+	memset(config, 0, sizeof(*config));
+	config->state = DPU_WIN_STATE_BUFFER;
+	config->dpp_id = win;
+	config->zpos = win;
+	config->format = fourcc_code('A', 'R', '2', '4');
+
+	switch (win) {
+	case 0:
+		config->src_w = config->dst_w = 1080;
+		config->src_h = config->dst_h = 2400;
+		config->format = fourcc_code('A', 'B', '2', '4');
+		config->is_comp = true;
+		break;
+	case 1:
+		config->src_w = config->dst_w = 1080;
+		config->src_h = config->dst_h = 2400;
+		config->is_comp = true;
+		break;
+	case 2:
+		config->src_w = config->dst_w = 1080;
+		config->src_h = config->dst_h = 96;
+		break;
+	case 3:
+		config->src_w = config->dst_w = 1080;
+		config->src_h = config->dst_h = 120;
+		config->dst_y = 2280;
+		break;
+	case 4:
+		if (frame >= 600) {
+			config->state = DPU_WIN_STATE_DISABLED;
+			break;
+		}
+		config->src_w = 1920;
+		config->src_h = 1080;
+		config->dst_y = 600;
+		config->dst_w = 1080;
+		config->dst_h = 608;
+		config->format = fourcc_code('N', 'V', '1', '2');
+		config->is_rot = true;
+		break;
+	case 5:
+		config->src_w = config->dst_w = 900;
+		config->src_h = config->dst_h = 160;
+		config->dst_x = 90;
+		if (frame < 300)
+			config->dst_y = 2400 - 160;
+		else if (frame < 360)
+			config->dst_y = 2400 - 160 - (frame - 300) * 6;
+		else
+			config->dst_y = 2400 - 160 - 360;
+		break;
+	}
+}
+
+/* BTS state of one DECON, the part dpu_bts_calc_bw() works on */
+struct decon_bts {
+	struct dpu_bts_win_config win_config[WINS];
+	struct bts_dpp_info win_info[WINS];
+	u32 dirty;
+};
+
+/* votes of one commit */
+struct votes {
+	u32 read_bw;
+	u32 rt_bw[WINS];
+	u32 overlap_bw;
+	u32 ch_bw[AXI_PORTS];
+	u32 bus_freq;
+	u32 op_freq;
+};
+
+/* dpu_bts_update_dpp_bw() */
+static void update_dpp_bw(struct bts_dpp_info *dpp, const struct dpu_bts_win_config *config,
+			  const struct dpu_bts_params *p, u32 vblank_us)
+{
+	const struct fmt *fmt;
+
+	if (config->state != DPU_WIN_STATE_BUFFER) {
+		memset(dpp, 0, sizeof(*dpp));
+		return;
+	}
+
+	fmt = find_fmt(config->format);
+	dpp->bpp = fmt->bpp;
+	dpp->src_w = config->src_w;
+	dpp->src_h = config->src_h;
+	dpp->dst.x1 = config->dst_x;
+	dpp->dst.x2 = config->dst_x + config->dst_w;
+	dpp->dst.y1 = config->dst_y;
+	dpp->dst.y2 = config->dst_y + config->dst_h;
+	dpp->rotation = config->is_rot;
+	dpp->is_afbc = config->is_comp;
+	dpp->is_yuv = fmt->yuv;
+	dpu_bts_calc_dpp_bw(dpp, p, vblank_us, config->dpp_id);
+}
+
+/* dpu_bts_update_overlap_bw() */
+static void update_overlap_bw(const struct decon_bts *bts, struct votes *v)
+{
+	struct dpu_bts_layer layers[WINS];
+	u32 i, cnt = 0;
+
+	for (i = 0; i < WINS; i++) {
+		if (bts->win_config[i].state != DPU_WIN_STATE_BUFFER)
+			continue;
+
+		layers[cnt].y1 = bts->win_info[i].dst.y1;
+		layers[cnt].y2 = bts->win_info[i].dst.y2;
+		layers[cnt].rt_bw = bts->win_info[i].rt_bw;
+		layers[cnt].ch_num = bts->win_config[i].dpp_id % AXI_PORTS;
+		cnt++;
+	}
+
+	dpu_bts_calc_overlap_bw(layers, cnt, &v->overlap_bw, v->ch_bw, AXI_PORTS);
+}
+
+/*
+ * One commit: the window configs are taken over from the planes as by
+ * exynos_atomic_bts_pre_update(), then the votes are calculated as by
+ * dpu_bts_calc_bw(). With @incremental unset every window is dirty.
+ */
+static void commit(struct decon_bts *bts, struct votes *v, const struct dpu_bts_params *p,
+		   u64 resol_clk, u32 vblank_us, u32 frame, bool incremental)
+{
+	struct dpu_bts_win_config new_config;
+	u32 dirty, max_ch_bw = 0;
+	u32 i;
+
+	for (i = 0; i < WINS; i++) {
+		frame_config(frame, i, &new_config);
+		if (!incremental) {
+			bts->win_config[i] = new_config;
+		} else if (memcmp(&bts->win_config[i], &new_config, sizeof(new_config))) {
+			bts->win_config[i] = new_config;
+			bts->dirty |= 1U << i;
+		}
+	}
+
+	dirty = incremental ? bts->dirty : DIRTY_ALL;
+	bts->dirty = 0;
+
+	v->read_bw = 0;
+	for (i = 0; i < WINS; i++) {
+		if (dirty & (1U << i))
+			update_dpp_bw(&bts->win_info[i], &bts->win_config[i], p, vblank_us);
+		v->rt_bw[i] = bts->win_info[i].rt_bw;
+		v->read_bw += bts->win_info[i].bw;
+	}
+
+	if (dirty)
+		update_overlap_bw(bts, v);
+	for (i = 0; i < AXI_PORTS; i++)
+		max_ch_bw = max(max_ch_bw, v->ch_bw[i]);
+
+	v->bus_freq = max_ch_bw * 100 / (p->bus_width * p->bus_util_pct);
+	v->op_freq = dpu_bts_calc_disp_op_freq(p, bts->win_config, WINS, resol_clk,
+					       v->bus_freq);
+}
+
+static void reset(struct decon_bts *bts, struct votes *v)
+{
+	memset(bts, 0, sizeof(*bts));
+	memset(v, 0, sizeof(*v));
+	/* as after dpu_bts_init() or a mode change */
+	bts->dirty = DIRTY_ALL;
+}
+
+static double thread_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void bench_incremental(void)
+{
+	static struct decon_bts full_bts, incr_bts;
+	struct votes full, incr;
+	struct dpu_bts_params p;
+	double start, full_ns, incr_ns;
+	u32 frame, loop, dirty_cnt = 0;
+	u64 resol_clk;
+	u32 vblank_us;
+
+	panel_params(&p);
+	resol_clk = dpu_bts_calc_resol_clock(p.lcd_w, p.lcd_h, p.fps);
+	vblank_us = dpu_bts_calc_vblank_time_ns(&p) / 1000U;
+	vblank_us = (vblank_us * p.rot_util_pct) / 100;
+
+	reset(&full_bts, &full);
+	reset(&incr_bts, &incr);
+	for (frame = 0; frame < FRAMES; frame++) {
+		commit(&full_bts, &full, &p, resol_clk, vblank_us, frame, false);
+		commit(&incr_bts, &incr, &p, resol_clk, vblank_us, frame, true);
+		CHECK(!memcmp(&full, &incr, sizeof(full)),
+		      "frame %u: read %u/%u overlap %u/%u bus %u/%u op %u/%u", frame,
+		      full.read_bw, incr.read_bw, full.overlap_bw, incr.overlap_bw,
+		      full.bus_freq, incr.bus_freq, full.op_freq, incr.op_freq);
+	}
+
+	/* most commits of the workload have to be plain buffer flips */
+	for (frame = 1; frame < FRAMES; frame++) {
+		struct dpu_bts_win_config a, b;
+		u32 i;
+
+		for (i = 0; i < WINS; i++) {
+			frame_config(frame - 1, i, &a);
+			frame_config(frame, i, &b);
+			if (memcmp(&a, &b, sizeof(a))) {
+				dirty_cnt++;
+				break;
+			}
+		}
+	}
+	CHECK(dirty_cnt && dirty_cnt < FRAMES / 10, "%u of %u commits changed a window",
+	      dirty_cnt, FRAMES);
+
+	start = thread_ns();
+	for (loop = 0; loop < LOOPS; loop++) {
+		reset(&full_bts, &full);
+		for (frame = 0; frame < FRAMES; frame++)
+			commit(&full_bts, &full, &p, resol_clk, vblank_us, frame, false);
+	}
+	full_ns = (thread_ns() - start) / (LOOPS * FRAMES);
+
+	start = thread_ns();
+	for (loop = 0; loop < LOOPS; loop++) {
+		reset(&incr_bts, &incr);
+		for (frame = 0; frame < FRAMES; frame++)
+			commit(&incr_bts, &incr, &p, resol_clk, vblank_us, frame, true);
+	}
+	incr_ns = (thread_ns() - start) / (LOOPS * FRAMES);
+
+	printf("%u windows, %u commits, %u changed a window: full %.1fns, incremental %.1fns per commit\n",
+	       WINS, FRAMES, dirty_cnt, full_ns, incr_ns);
+}
+
+/*
+ * dpu_bts_calc_overlap_bw() before the sweep, summing up the layers covering
+ * the first line of every layer
+ */
+static __attribute__((noinline)) void pairwise_overlap_bw(const struct dpu_bts_layer *layers,
+							  u32 layer_cnt, u32 *max_overlap_bw,
+							  u32 *ch_bw, u32 ch_cnt)
+{
+	u32 i, j;
+
+	*max_overlap_bw = 0;
+	for (i = 0; i < ch_cnt; ++i)
+		ch_bw[i] = 0;
+
+	for (i = 0; i < layer_cnt; i++) {
+		const u32 ch_num = layers[i].ch_num;
+		u32 overlap_bw = 0, overlap_ch_bw = 0;
+
+		for (j = 0; j < layer_cnt; j++) {
+			if (i != j && !(layers[i].y1 >= layers[j].y1 && layers[i].y1 < layers[j].y2))
+				continue;
+
+			overlap_bw += layers[j].rt_bw;
+			if (layers[j].ch_num == ch_num)
+				overlap_ch_bw += layers[j].rt_bw;
+		}
+
+		*max_overlap_bw = max(*max_overlap_bw, overlap_bw);
+		ch_bw[ch_num] = max(ch_bw[ch_num], overlap_ch_bw);
+	}
+}
+
+static u32 rand_next(u32 *state)
+{
+	*state = *state * 1103515245 + 12345;
+
+	return *state >> 8;
+}
+
+/* random stacks of @cnt layers on a 2400 lines panel, some of them full screen */
+static void random_layers(struct dpu_bts_layer *layers, u32 cnt, u32 *state)
+{
+	u32 i;
+
+	for (i = 0; i < cnt; i++) {
+		struct dpu_bts_layer *layer = &layers[i];
+
+		if (!(rand_next(state) % 4)) {
+			layer->y1 = 0;
+			layer->y2 = 2400;
+		} else {
+			layer->y1 = rand_next(state) % 2400;
+			layer->y2 = layer->y1 + 1 + rand_next(state) % (2400 - layer->y1);
+		}
+		layer->rt_bw = 1000 + rand_next(state) % 2000000;
+		layer->ch_num = rand_next(state) % AXI_PORTS;
+	}
+}
+
+#define STACKS			256
+#define OVERLAP_LOOPS		200
+
+/* the sweep against the pairwise check for 1 to DPU_BTS_MAX_LAYERS layers */
+static void bench_overlap(void)
+{
+	static struct dpu_bts_layer stacks[STACKS][DPU_BTS_MAX_LAYERS];
+	u32 sweep_ch_bw[AXI_PORTS], pairwise_ch_bw[AXI_PORTS];
+	u32 sweep_bw, pairwise_bw;
+	double start, sweep_ns, pairwise_ns;
+	u32 cnt, i, loop, state = 1;
+
+	for (cnt = 1; cnt <= DPU_BTS_MAX_LAYERS; cnt++) {
+		for (i = 0; i < STACKS; i++) {
+			random_layers(stacks[i], cnt, &state);
+
+			dpu_bts_calc_overlap_bw(stacks[i], cnt, &sweep_bw, sweep_ch_bw, AXI_PORTS);
+			pairwise_overlap_bw(stacks[i], cnt, &pairwise_bw, pairwise_ch_bw, AXI_PORTS);
+			CHECK(sweep_bw == pairwise_bw &&
+			      !memcmp(sweep_ch_bw, pairwise_ch_bw, sizeof(sweep_ch_bw)),
+			      "%u layers, stack %u: overlap %u instead of %u, ch %u/%u/%u/%u instead of %u/%u/%u/%u",
+			      cnt, i, sweep_bw, pairwise_bw,
+			      sweep_ch_bw[0], sweep_ch_bw[1], sweep_ch_bw[2], sweep_ch_bw[3],
+			      pairwise_ch_bw[0], pairwise_ch_bw[1], pairwise_ch_bw[2],
+			      pairwise_ch_bw[3]);
+		}
+
+		start = thread_ns();
+		for (loop = 0; loop < OVERLAP_LOOPS; loop++)
+			for (i = 0; i < STACKS; i++)
+				dpu_bts_calc_overlap_bw(stacks[i], cnt, &sweep_bw, sweep_ch_bw,
+							AXI_PORTS);
+		sweep_ns = (thread_ns() - start) / (OVERLAP_LOOPS * STACKS);
+
+		start = thread_ns();
+		for (loop = 0; loop < OVERLAP_LOOPS; loop++)
+			for (i = 0; i < STACKS; i++)
+				pairwise_overlap_bw(stacks[i], cnt, &pairwise_bw, pairwise_ch_bw,
+						    AXI_PORTS);
+		pairwise_ns = (thread_ns() - start) / (OVERLAP_LOOPS * STACKS);
+
+		printf("%2u layers: pairwise %7.1fns, sweep %7.1fns\n", cnt, pairwise_ns,
+		       sweep_ns);
+	}
+}
+
+int main(void)
+{
+	bench_incremental();
+	bench_overlap();
+
+	if (failures) {
+		fprintf(stderr, "bts_calc_bench: %d failures\n", failures);
+		return EXIT_FAILURE;
+	}
+
+	printf("bts_calc_bench: passed\n");
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,285 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Copyright (C) 2023 Google LLC
+ *
+ * Host regression test for the DPU bandwidth and clock model
+ *
+ * A corpus of panel timings and window stacks is run through the model the way
+ * dpu_bts_calc_bw() does, and the resulting bandwidth and clock votes are
+ * compared with the ones recorded in bts_calc_test.golden. Any change of the
+ * model output fails the test. If the change is intended, record the new votes
+ * with "./bts_calc_test -r > bts_calc_test.golden" and review the diff.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "exynos_drm_bts_calc.h"
+
+#define GOLDEN_PATH		"bts_calc_test.golden"
+#define AXI_PORTS		4
+
+static int failures;
+
+#define CHECK(cond, fmt, ...) do {					\
+	if (!(cond)) {							\
+		fprintf(stderr, "%s:%d: " fmt "\n", __func__, __LINE__,	\
+			##__VA_ARGS__);					\
+		failures++;						\
+	}								\
+} while (0)
+
+/* DISP DVFS levels as in the gs101 DT */
+static const u32 dfs_lv_khz[] = { 664000, 533000, 400000, 310000, 267000, 200000, 134000 };
+
+struct panel {
+	const char *name;
+	u32 w, h, fps;
+	u32 vbp, vfp, vsa, vblank_usec;
+	bool video_mode;
+	u32 dsc_count, dsc_slice_count;
+};
+
+static const struct panel panels[] = {
+	{ "fhd_cmd_60", 1080, 2400, 60, 15, 8, 1, 2000, false, 1, 2 },
+	{ "fhd_cmd_120", 1080, 2400, 120, 15, 8, 1, 700, false, 1, 2 },
+	{ "wqhd_cmd_120", 1440, 3120, 120, 12, 12, 4, 600, false, 2, 2 },
+	{ "wqhd_cmd_60_4slice", 1440, 3120, 60, 12, 12, 4, 1600, false, 2, 4 },
+	{ "fhd_video_60", 1080, 2340, 60, 10, 16, 4, 0, true, 0, 0 },
+	{ "hd_nodsc_60", 720, 1600, 60, 8, 8, 2, 1500, false, 0, 0 },
+};
+
+struct win {
+	u32 src_w, src_h;
+	int dst_x, dst_y;
+	u32 dst_w, dst_h;
+	u32 bpp;
+	bool rot, afbc, yuv;
+	u32 dpp_id;
+};
+
+#define MAX_WINS		8
+
+struct stack {
+	const char *name;
+	u32 win_cnt;
+	/* in percent of the panel size, so a stack applies to every panel */
+	struct win wins[MAX_WINS];
+};
+
+/* src and dst in 1/100 of the panel width and height */
+static const struct stack stacks[] = {
+	{ "colormap", 0, { } },
+	{ "fullscreen", 1, {
+		{ 100, 100, 0, 0, 100, 100, 32, false, false, false, 0 },
+	} },
+	{ "fullscreen_afbc", 1, {
+		{ 100, 100, 0, 0, 100, 100, 32, false, true, false, 0 },
+	} },
+	{ "launcher", 3, {
+		{ 100, 4, 0, 0, 100, 4, 32, false, false, false, 0 },
+		{ 100, 100, 0, 0, 100, 100, 32, false, true, false, 1 },
+		{ 100, 5, 0, 95, 100, 5, 32, false, false, false, 2 },
+	} },
+	{ "video_rot_nv12", 2, {
+		{ 100, 56, 0, 22, 100, 56, 12, true, false, true, 3 },
+		{ 100, 100, 0, 0, 100, 100, 32, false, false, false, 0 },
+	} },
+	{ "video_rot_afbc_down", 2, {
+		{ 150, 84, 0, 22, 100, 56, 12, true, true, true, 3 },
+		{ 100, 10, 0, 90, 100, 10, 32, false, false, false, 1 },
+	} },
+	{ "upscale_p010", 1, {
+		{ 50, 50, 0, 0, 100, 100, 24, false, false, true, 2 },
+	} },
+	{ "vertical_downscale", 1, {
+		{ 100, 250, 0, 0, 100, 100, 32, false, false, false, 0 },
+	} },
+	{ "split_halves", 2, {
+		{ 100, 50, 0, 0, 100, 50, 32, false, false, false, 0 },
+		{ 100, 50, 0, 50, 100, 50, 32, false, false, false, 0 },
+	} },
+	{ "overlap_8", 8, {
+		{ 100, 100, 0, 0, 100, 100, 32, false, true, false, 0 },
+		{ 100, 30, 0, 0, 100, 30, 32, false, false, false, 1 },
+		{ 50, 40, 25, 20, 50, 40, 32, false, false, false, 2 },
+		{ 100, 56, 0, 30, 100, 56, 12, true, false, true, 3 },
+		{ 60, 20, 20, 50, 60, 20, 32, false, true, false, 0 },
+		{ 100, 10, 0, 70, 100, 10, 32, false, false, false, 1 },
+		{ 40, 40, 60, 60, 40, 40, 32, false, false, false, 2 },
+		{ 100, 5, 0, 95, 100, 5, 32, false, false, false, 3 },
+	} },
+};
+
+static void panel_params(const struct panel *panel, struct dpu_bts_params *p)
+{
+	memset(p, 0, sizeof(*p));
+	p->lcd_w = panel->w;
+	p->lcd_h = panel->h;
+	p->fps = panel->fps;
+	p->vbp = panel->vbp;
+	p->vfp = panel->vfp;
+	p->vsa = panel->vsa;
+	p->vblank_usec = panel->vblank_usec;
+	p->video_mode = panel->video_mode;
+	p->dsc_enabled = panel->dsc_count != 0;
+	p->dsc_count = panel->dsc_count;
+	p->dsc_slice_count = panel->dsc_slice_count;
+
+	/* DT defaults of exynos_drm_decon.c */
+	p->ppc = 2;
+	p->ppc_rotator = 4;
+	p->ppc_scaler = 2;
+	p->delay_comp = 4;
+	p->delay_scaler = 2;
+	p->bus_width = 16;
+	p->bus_util_pct = 65;
+	p->rot_util_pct = 60;
+	p->afbc_rgb_util_pct = 100;
+	p->afbc_yuv_util_pct = 100;
+	p->afbc_rgb_rt_util_pct = 100;
+	p->afbc_yuv_rt_util_pct = 100;
+
+	p->dfs_lv_cnt = sizeof(dfs_lv_khz) / sizeof(dfs_lv_khz[0]);
+	p->dfs_lv_khz = dfs_lv_khz;
+}
+
+static u32 scale(u32 v, u32 pct)
+{
+	return v * pct / 100;
+}
+
+/* runs one scenario like dpu_bts_calc_bw(), and prints the votes to @buf */
+static void run_scenario(const struct panel *panel, const struct stack *stack,
+			 char *buf, size_t size)
+{
+	struct dpu_bts_win_config configs[MAX_WINS] = { 0 };
+	struct dpu_bts_layer layers[MAX_WINS];
+	struct bts_dpp_info dpp;
+	struct dpu_bts_params p;
+	u32 ch_bw[AXI_PORTS], max_overlap_bw, max_ch_bw = 0;
+	u32 vblank_us, read_bw = 0, bus_freq, op_freq;
+	u64 resol_clk;
+	size_t len;
+	u32 i;
+
+	panel_params(panel, &p);
+	resol_clk = dpu_bts_calc_resol_clock(p.lcd_w, p.lcd_h, p.fps);
+	vblank_us = dpu_bts_calc_vblank_time_ns(&p) / 1000U;
+	vblank_us = (vblank_us * p.rot_util_pct) / 100;
+
+	len = snprintf(buf, size, "%s/%s: resol %llu vblank %u dpp", panel->name,
+		       stack->name, resol_clk, vblank_us);
+
+	for (i = 0; i < stack->win_cnt; i++) {
+		const struct win *win = &stack->wins[i];
+		struct dpu_bts_win_config *config = &configs[i];
+
+		config->state = DPU_WIN_STATE_BUFFER;
+		config->src_w = scale(p.lcd_w, win->src_w);
+		config->src_h = scale(p.lcd_h, win->src_h);
+		config->dst_x = scale(p.lcd_w, win->dst_x);
+		config->dst_y = scale(p.lcd_h, win->dst_y);
+		config->dst_w = scale(p.lcd_w, win->dst_w);
+		config->dst_h = scale(p.lcd_h, win->dst_h);
+		config->is_rot = win->rot;
+		config->is_comp = win->afbc;
+		config->dpp_id = win->dpp_id;
+
+		memset(&dpp, 0, sizeof(dpp));
+		dpp.bpp = win->bpp;
+		dpp.src_w = config->src_w;
+		dpp.src_h = config->src_h;
+		dpp.dst.x1 = config->dst_x;
+		dpp.dst.x2 = config->dst_x + config->dst_w;
+		dpp.dst.y1 = config->dst_y;
+		dpp.dst.y2 = config->dst_y + config->dst_h;
+		dpp.rotation = win->rot;
+		dpp.is_afbc = win->afbc;
+		dpp.is_yuv = win->yuv;
+		dpu_bts_calc_dpp_bw(&dpp, &p, vblank_us, config->dpp_id);
+
+		layers[i].y1 = dpp.dst.y1;
+		layers[i].y2 = dpp.dst.y2;
+		layers[i].rt_bw = dpp.rt_bw;
+		layers[i].ch_num = win->dpp_id;
+		read_bw += dpp.bw;
+
+		len += snprintf(buf + len, size - len, " %u/%u", dpp.bw, dpp.rt_bw);
+	}
+
+	dpu_bts_calc_overlap_bw(layers, stack->win_cnt, &max_overlap_bw, ch_bw, AXI_PORTS);
+	for (i = 0; i < AXI_PORTS; i++)
+		max_ch_bw = max(max_ch_bw, ch_bw[i]);
+
+	bus_freq = max_ch_bw * 100 / (p.bus_width * p.bus_util_pct);
+	op_freq = dpu_bts_calc_disp_op_freq(&p, configs, stack->win_cnt, resol_clk, bus_freq);
+
+	snprintf(buf + len, size - len, " read %u overlap %u ch %u/%u/%u/%u bus %u op %u",
+		 read_bw, max_overlap_bw, ch_bw[0], ch_bw[1], ch_bw[2], ch_bw[3],
+		 bus_freq, op_freq);
+}
+
+int main(int argc, char **argv)
+{
+	const char *golden_path = GOLDEN_PATH;
+	bool record = false;
+	char line[512], expected[512];
+	FILE *golden = NULL;
+	u32 i, j, cnt = 0;
+
+	if (argc > 1 && !strcmp(argv[1], "-r"))
+		record = true;
+	else if (argc > 1)
+		golden_path = argv[1];
+
+	if (!record) {
+		golden = fopen(golden_path, "r");
+		if (!golden) {
+			fprintf(stderr, "bts_calc_test: can't open %s\n", golden_path);
+			return EXIT_FAILURE;
+		}
+	}
+
+	for (i = 0; i < sizeof(panels) / sizeof(panels[0]); i++) {
+		for (j = 0; j < sizeof(stacks) / sizeof(stacks[0]); j++) {
+			run_scenario(&panels[i], &stacks[j], line, sizeof(line));
+			cnt++;
+
+			if (record) {
+				printf("%s\n", line);
+				continue;
+			}
+
+			if (!fgets(expected, sizeof(expected), golden)) {
+				CHECK(0, "no recorded output for: %s", line);
+				continue;
+			}
+			expected[strcspn(expected, "\n")] = '\0';
+			CHECK(!strcmp(line, expected), "output changed\n  recorded: %s\n  now:      %s",
+			      expected, line);
+		}
+	}
+
+	if (golden) {
+		CHECK(!fgets(expected, sizeof(expected), golden),
+		      "%s has more scenarios than the corpus", golden_path);
+		fclose(golden);
+	}
+
+	if (record)
+		return EXIT_SUCCESS;
+
+	if (failures) {
+		fprintf(stderr, "bts_calc_test: %d failures\n", failures);
+		return EXIT_FAILURE;
+	}
+
+	printf("bts_calc_test: %u scenarios as recorded, passed\n", cnt);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,178 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Copyright (C) 2023 Google LLC
+ *
+ * Host test for the DSI clock hopping policy
+ *
+ * The harmonic check is compared with an exhaustive walk over the harmonics,
+ * and the clock picking order and the band validation are checked on a few
+ * hand written cases.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "exynos_drm_dsim_hop.h"
+
+static int failures;
+
+#define CHECK(cond, fmt, ...) do {					\
+	if (!(cond)) {							\
+		fprintf(stderr, "%s:%d: " fmt "\n", __func__, __LINE__,	\
+			##__VA_ARGS__);					\
+		failures++;						\
+	}								\
+} while (0)
+
+static u32 rand_state = 1;
+
+static u32 rand_below(u32 max)
+{
+	rand_state = rand_state * 1103515245 + 12345;
+
+	return (rand_state >> 8) % max;
+}
+
+/* reference: walk every harmonic up to the end of the band */
+static bool ref_clock_allowed(const struct dsim_hop_band *bands, u32 band_cnt, u32 mhz)
+{
+	const u64 f0_khz = (u64)mhz * 1000 / 2;
+	u32 i;
+	u64 f;
+
+	for (i = 0; i < band_cnt; i++)
+		for (f = f0_khz; f <= bands[i].hi_khz; f += f0_khz)
+			if (f >= bands[i].lo_khz)
+				return false;
+
+	return true;
+}
+
+static bool always_usable(void *priv, u32 hs_clock_mhz)
+{
+	return true;
+}
+
+static bool never_usable(void *priv, u32 hs_clock_mhz)
+{
+	return false;
+}
+
+/* clocks below *priv MHz don't fit the frame in a TE period */
+static bool min_usable(void *priv, u32 hs_clock_mhz)
+{
+	return hs_clock_mhz >= *(u32 *)priv;
+}
+
+static void test_allowed_matches_reference(void)
+{
+	struct dsim_hop_band bands[DSIM_HOP_MAX_BANDS];
+	int iter;
+
+	for (iter = 0; iter < 20000; iter++) {
+		const u32 band_cnt = 1 + rand_below(DSIM_HOP_MAX_BANDS);
+		const u32 mhz = 300 + rand_below(1700);
+		u32 i;
+
+		for (i = 0; i < band_cnt; i++) {
+			bands[i].lo_khz = 1 + rand_below(6000000);
+			bands[i].hi_khz = bands[i].lo_khz + rand_below(200000);
+		}
+
+		CHECK(dsim_hop_clock_allowed(bands, band_cnt, mhz) ==
+		      ref_clock_allowed(bands, band_cnt, mhz),
+		      "%uMHz, band %u-%ukHz", mhz, bands[0].lo_khz, bands[0].hi_khz);
+	}
+}
+
+static void test_allowed(void)
+{
+	/* 3rd harmonic of 1100MHz, 550MHz fundamental, is at 1650MHz */
+	const struct dsim_hop_band gps = { .lo_khz = 1645000, .hi_khz = 1655000 };
+	/* below the fundamental of every clock in range */
+	const struct dsim_hop_band low = { .lo_khz = 0, .hi_khz = 100000 };
+
+	CHECK(!dsim_hop_clock_allowed(&gps, 1, 1100), "1100MHz allowed");
+	CHECK(dsim_hop_clock_allowed(&gps, 1, 1090), "1090MHz forbidden");
+	CHECK(dsim_hop_clock_allowed(NULL, 0, 1100), "forbidden without bands");
+	CHECK(!dsim_hop_clock_allowed(NULL, 0, 0), "0MHz allowed");
+
+	/* a band from 0 mustn't take the DC term as a harmonic */
+	CHECK(dsim_hop_clock_allowed(&low, 1, 1100), "1100MHz forbidden by 0-100MHz");
+	CHECK(!dsim_hop_clock_allowed(&low, 1, 150), "150MHz allowed by 0-100MHz");
+}
+
+static void test_band_valid(void)
+{
+	const u32 min_mhz = dsim_hop_min_mhz(1000);
+	struct dsim_hop_band b;
+
+	CHECK(min_mhz == 900, "min clock %u", min_mhz);
+
+	b = (struct dsim_hop_band){ .lo_khz = 1575000, .hi_khz = 1576000 };
+	CHECK(dsim_hop_band_valid(&b, min_mhz), "GPS L1 rejected");
+
+	b = (struct dsim_hop_band){ .lo_khz = 0, .hi_khz = 1000 };
+	CHECK(!dsim_hop_band_valid(&b, min_mhz), "band from 0 accepted");
+
+	b = (struct dsim_hop_band){ .lo_khz = 2000, .hi_khz = 1000 };
+	CHECK(!dsim_hop_band_valid(&b, min_mhz), "reversed band accepted");
+
+	/* 900MHz has a 450MHz fundamental, a band that wide forbids every clock */
+	b = (struct dsim_hop_band){ .lo_khz = 1000000, .hi_khz = 1450000 };
+	CHECK(!dsim_hop_band_valid(&b, min_mhz), "band as wide as f0 accepted");
+	b.hi_khz--;
+	CHECK(dsim_hop_band_valid(&b, min_mhz), "band narrower than f0 rejected");
+}
+
+static void test_pick(void)
+{
+	const struct dsim_hop_band gps = { .lo_khz = 1645000, .hi_khz = 1655000 };
+	/* forbids 1100MHz and everything within 15MHz of it */
+	const struct dsim_hop_band wide = { .lo_khz = 1627500, .hi_khz = 1672500 };
+	const u32 modes[] = { 1100, 1030, 1180, 1300 };
+	u32 mhz, min;
+
+	mhz = dsim_hop_pick(NULL, 0, modes, 4, 1100, always_usable, NULL);
+	CHECK(mhz == 1100, "picked %u without bands", mhz);
+
+	/* DT mode clocks within 10% come first */
+	mhz = dsim_hop_pick(&gps, 1, modes, 4, 1100, always_usable, NULL);
+	CHECK(mhz == 1030, "picked %u, expected the 1030MHz mode", mhz);
+
+	/* otherwise the closest clock, higher one first */
+	mhz = dsim_hop_pick(&wide, 1, modes, 1, 1100, always_usable, NULL);
+	CHECK(mhz == 1116, "picked %u, expected 1116MHz", mhz);
+
+	/* ... unless the frame doesn't fit at that clock */
+	min = 1120;
+	mhz = dsim_hop_pick(&wide, 1, modes, 1, 1100, min_usable, &min);
+	CHECK(mhz == 1120, "picked %u, expected 1120MHz", mhz);
+
+	/* nothing within 10% */
+	min = 1300;
+	mhz = dsim_hop_pick(&wide, 1, modes, 1, 1100, min_usable, &min);
+	CHECK(mhz == 0, "picked %u out of range", mhz);
+	mhz = dsim_hop_pick(NULL, 0, modes, 4, 1100, never_usable, NULL);
+	CHECK(mhz == 0, "picked unusable %u", mhz);
+}
+
+int main(void)
+{
+	test_allowed_matches_reference();
+	test_allowed();
+	test_band_valid();
+	test_pick();
+
+	if (failures) {
+		fprintf(stderr, "dsim_hop_test: %d failures\n", failures);
+		return EXIT_FAILURE;
+	}
+
+	printf("dsim_hop_test: passed\n");
+	return EXIT_SUCCESS;
+}
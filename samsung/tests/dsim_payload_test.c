@@ -0,0 +1,223 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Copyright (C) 2023 Google LLC
+ *
+ * Host test for the DSIM TX payload FIFO writer
+ *
+ * Writes payloads of every length up to a few words, from every alignment,
+ * into a mock payload register and compares the FIFO words with the ones the
+ * byte by byte loop dsim_write_payload() used before produced. Then times both
+ * for a short DSC PPS sized and a long gamma table sized packet, the old loop
+ * with a separate call and barrier per word like dsim_reg_wr_tx_payload(), the
+ * new one with relaxed writes and the single barrier of the packet header.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "dsim_payload.h"
+
+#define MAX_WORDS	1024
+
+static int failures;
+
+#define CHECK(cond, fmt, ...) do {					\
+	if (!(cond)) {							\
+		fprintf(stderr, "%s:%d: " fmt "\n", __func__, __LINE__,	\
+			##__VA_ARGS__);					\
+		failures++;						\
+	}								\
+} while (0)
+
+/* mock of the DSIM_PAYLOAD register, keeps every word pushed to the FIFO */
+struct mock_fifo {
+	u32 words[MAX_WORDS];
+	u32 cnt;
+};
+
+static void mock_write(void *ctx, u32 word)
+{
+	struct mock_fifo *fifo = ctx;
+
+	if (fifo->cnt < MAX_WORDS)
+		fifo->words[fifo->cnt] = word;
+	fifo->cnt++;
+}
+
+/* words dsim_write_payload() assembled before it used dsim_payload_write() */
+static u32 legacy_pack(const u8 *buf, size_t len, u32 *words)
+{
+	const u8 *p = buf;
+	const u8 *end = buf + len;
+	u32 payload = 0, cnt = 0;
+
+	while (p < end) {
+		size_t pkt_size = end - p < 4 ? end - p : 4;
+
+		if (pkt_size >= 4)
+			payload = p[0] | p[1] << 8 | p[2] << 16 | (u32)p[3] << 24;
+		else if (pkt_size == 3)
+			payload = p[0] | p[1] << 8 | p[2] << 16;
+		else if (pkt_size == 2)
+			payload = p[0] | p[1] << 8;
+		else if (pkt_size == 1)
+			payload = p[0];
+
+		words[cnt++] = payload;
+		p += pkt_size;
+	}
+
+	return cnt;
+}
+
+static void test_pack(void)
+{
+	static u8 buf[64 + 4] __attribute__((aligned(4)));
+	u32 expected[32];
+	u32 off, len, i, cnt;
+
+	for (i = 0; i < sizeof(buf); i++)
+		buf[i] = i * 37 + 11;
+
+	for (off = 0; off < 4; off++) {
+		for (len = 0; len <= 64; len++) {
+			struct mock_fifo fifo = { 0 };
+
+			cnt = legacy_pack(buf + off, len, expected);
+			dsim_payload_write(buf + off, len, mock_write, &fifo);
+
+			CHECK(fifo.cnt == cnt, "offset %u length %u: %u words instead of %u",
+			      off, len, fifo.cnt, cnt);
+			for (i = 0; i < cnt && i < fifo.cnt; i++)
+				CHECK(fifo.words[i] == expected[i],
+				      "offset %u length %u word %u: 0x%08x instead of 0x%08x",
+				      off, len, i, fifo.words[i], expected[i]);
+		}
+	}
+}
+
+static void test_tail(void)
+{
+	static const u8 buf[7] __attribute__((aligned(4))) = {
+		0x39, 0x51, 0x0f, 0xff, 0xaa, 0xbb, 0xcc
+	};
+	struct mock_fifo fifo = { 0 };
+
+	/* the tail word is zero padded in its upper bytes */
+	dsim_payload_write(buf, sizeof(buf), mock_write, &fifo);
+	CHECK(fifo.cnt == 2, "%u words", fifo.cnt);
+	CHECK(fifo.words[0] == 0xff0f5139, "first word 0x%08x", fifo.words[0]);
+	CHECK(fifo.words[1] == 0x00ccbbaa, "tail word 0x%08x", fifo.words[1]);
+
+	fifo.cnt = 0;
+	dsim_payload_write(buf + 1, 1, mock_write, &fifo);
+	CHECK(fifo.cnt == 1 && fifo.words[0] == 0x51, "single byte %u words 0x%08x",
+	      fifo.cnt, fifo.words[0]);
+}
+
+/* benchmark, the payload register is emulated by a volatile store */
+static volatile u32 payload_reg;
+
+static void relaxed_write(void *ctx, u32 word)
+{
+	payload_reg = word;
+}
+
+/* dsim_reg_wr_tx_payload(), out of line with the barrier of writel() */
+static __attribute__((noinline)) void legacy_write(u32 id, u32 word)
+{
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	payload_reg = word;
+}
+
+static void legacy_write_payload(const u8 *buf, size_t len)
+{
+	const u8 *p = buf;
+	const u8 *end = buf + len;
+	u32 payload = 0;
+
+	while (p < end) {
+		size_t pkt_size = end - p < 4 ? end - p : 4;
+
+		if (pkt_size >= 4)
+			payload = p[0] | p[1] << 8 | p[2] << 16 | (u32)p[3] << 24;
+		else if (pkt_size == 3)
+			payload = p[0] | p[1] << 8 | p[2] << 16;
+		else if (pkt_size == 2)
+			payload = p[0] | p[1] << 8;
+		else if (pkt_size == 1)
+			payload = p[0];
+
+		legacy_write(0, payload);
+		p += pkt_size;
+	}
+}
+
+static void bulk_write_payload(const u8 *buf, u32 len)
+{
+	dsim_payload_write(buf, len, relaxed_write, NULL);
+	/* barrier of the packet header write */
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+static double now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void bench(const char *name, const u8 *buf, u32 len)
+{
+	const int loops = 200000 / (len / 64 + 1);
+	double start, legacy_ns, bulk_ns;
+	int i;
+
+	start = now_ns();
+	for (i = 0; i < loops; i++)
+		legacy_write_payload(buf, len);
+	legacy_ns = (now_ns() - start) / loops;
+
+	start = now_ns();
+	for (i = 0; i < loops; i++)
+		bulk_write_payload(buf, len);
+	bulk_ns = (now_ns() - start) / loops;
+
+	printf("%-24s %5u bytes: per word %8.1fns, bulk %8.1fns\n", name, len,
+	       legacy_ns, bulk_ns);
+}
+
+static void test_bench(void)
+{
+	static u8 buf[2048 + 1] __attribute__((aligned(4)));
+	u32 i;
+
+	for (i = 0; i < sizeof(buf); i++)
+		buf[i] = i;
+
+	bench("dsc pps", buf, 88);
+	bench("gamma table", buf, 2048);
+	bench("gamma table, unaligned", buf + 1, 2047);
+}
+
+int main(void)
+{
+	test_pack();
+	test_tail();
+	test_bench();
+
+	if (failures) {
+		fprintf(stderr, "dsim_payload_test: %d failures\n", failures);
+		return EXIT_FAILURE;
+	}
+
+	printf("dsim_payload_test: passed\n");
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,225 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Copyright (C) 2023 Google LLC
+ *
+ * Host test for the DSI PLL PMSK solver
+ *
+ * The solver is compared with dsim_calc_pmsk(), the single P, lowest S
+ * calculation it replaced, kept below as the reference. When the VCO range
+ * spans one octave there is only one S for a clock and both pick the same
+ * combination. With a wider VCO range the solver may take a higher S for more
+ * VCO margin, that must never cost clock accuracy.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "exynos_drm_dsim_pll.h"
+
+static int failures;
+
+#define CHECK(cond, fmt, ...) do {					\
+	if (!(cond)) {							\
+		fprintf(stderr, "%s:%d: " fmt "\n", __func__, __LINE__,	\
+			##__VA_ARGS__);					\
+		failures++;						\
+	}								\
+} while (0)
+
+struct pmsk {
+	u32 p, m, s, k;
+};
+
+/* dsim_calc_pmsk() as it was in exynos_drm_dsim.c, without the logging */
+static int legacy_calc_pmsk(const struct dsim_pll_features *pll_features,
+			    struct pmsk *pms, unsigned int hs_clock_mhz)
+{
+	uint64_t hs_clock;
+	uint64_t fvco, q;
+	uint32_t p, m, s, k;
+
+	p = (pll_features->finput + pll_features->foptimum / 2) / pll_features->foptimum;
+	if (p == 0)
+		p = 1;
+	if ((p < pll_features->p_min) || (p > pll_features->p_max))
+		return -1;
+
+	hs_clock = (uint64_t) hs_clock_mhz * 1000000;
+	if ((hs_clock < pll_features->fout_min) ||
+			(hs_clock > pll_features->fout_max))
+		return -1;
+
+	/* find s: vco_min <= fout * 2 ^ s <= vco_max */
+	for (s = 0, fvco = 0; fvco < pll_features->fvco_min; s++)
+		fvco = hs_clock * (1 << s);
+	--s;
+
+	if (fvco > pll_features->fvco_max)
+		return -1;
+	if ((s < pll_features->s_min) || (s > pll_features->s_max))
+		return -1;
+
+	/* (hs_clk * 2^s / 2) / (fin / p) = m + k / 2^k_bits */
+	fvco >>= 1;
+	q = fvco << (pll_features->k_bits + 1); /* 1 extra bit for roundup */
+	q /= pll_features->finput / p;
+
+	/* m is the integer part, k is the fraction part */
+	m = q >> (pll_features->k_bits + 1);
+	if ((m < pll_features->m_min) || (m > pll_features->m_max))
+		return -1;
+
+	k = q & ((1 << (pll_features->k_bits + 1)) - 1);
+	k = (k + 1) / 2;
+
+	/* k is two's complement integer */
+	if (k & (1 << (pll_features->k_bits - 1)))
+		m++;
+
+	pms->p = p;
+	pms->m = m;
+	pms->s = s;
+	pms->k = k & ((1 << pll_features->k_bits) - 1);
+
+	return 0;
+}
+
+/* clock generated by a combination, K taken as two's complement */
+static u64 pmsk_fout(const struct dsim_pll_features *f, const struct pmsk *pms)
+{
+	const s64 k_one = 1LL << f->k_bits;
+	const s64 k = pms->k & (k_one >> 1) ? (s64)pms->k - k_one : (s64)pms->k;
+	const u64 mk = (u64)((s64)pms->m * k_one + k);
+
+	return (((f->finput / pms->p) * mk) << 1) >> (f->k_bits + pms->s);
+}
+
+static u64 absdiff(u64 a, u64 b)
+{
+	return a > b ? a - b : b - a;
+}
+
+static void features_init(struct dsim_pll_features *f, u64 fvco_min, u64 fvco_max)
+{
+	*f = (struct dsim_pll_features){
+		.finput = 26000000,
+		.foptimum = 6500000,
+		.fout_min = 25000000,
+		.fout_max = 3000000000ULL,
+		.fvco_min = fvco_min,
+		.fvco_max = fvco_max,
+		.p_min = 1, .p_max = 63,
+		.m_min = 64, .m_max = 1023,
+		.s_min = 0, .s_max = 5,
+		.k_bits = 16,
+	};
+}
+
+/* returns the number of clocks the solver picked a different combination for */
+static u32 compare_legacy(const struct dsim_pll_features *f, const char *name)
+{
+	u32 mhz, valid = 0, diff = 0;
+
+	for (mhz = 25; mhz <= 3000; mhz++) {
+		struct dsim_pll_cand c;
+		struct pmsk old, new;
+		u64 fout = mhz * DSIM_PLL_HZ_PER_MHZ;
+		const int old_ret = legacy_calc_pmsk(f, &old, mhz);
+		const int new_ret = dsim_pll_solve(f, mhz, &c);
+
+		/* the solver tries every P and S, it can't miss a clock the legacy one found */
+		CHECK(old_ret || !new_ret, "%s: %uMHz solved by the legacy calculation only",
+		      name, mhz);
+		if (new_ret)
+			continue;
+
+		new = (struct pmsk){ .p = c.p, .m = c.m, .s = c.s, .k = c.k };
+		CHECK(absdiff(pmsk_fout(f, &new), fout) == c.err_hz,
+		      "%s: %uMHz reported error %u, actual %llu", name, mhz, c.err_hz,
+		      (unsigned long long)absdiff(pmsk_fout(f, &new), fout));
+		CHECK((fout << c.s) >= f->fvco_min && (fout << c.s) <= f->fvco_max,
+		      "%s: %uMHz VCO out of range with s %u", name, mhz, c.s);
+		CHECK(c.m >= f->m_min && c.m <= f->m_max, "%s: %uMHz m %u out of range",
+		      name, mhz, c.m);
+
+		if (old_ret)
+			continue;
+
+		valid++;
+		if (old.p == new.p && old.m == new.m && old.s == new.s && old.k == new.k)
+			continue;
+
+		diff++;
+		/* the only trade made is a higher S for VCO margin, at no accuracy cost */
+		CHECK(new.s > old.s, "%s: %uMHz old p%u m%u s%u k%u, new p%u m%u s%u k%u",
+		      name, mhz, old.p, old.m, old.s, old.k, new.p, new.m, new.s, new.k);
+		CHECK(c.err_hz <= absdiff(pmsk_fout(f, &old), fout),
+		      "%s: %uMHz error %u, legacy %llu", name, mhz, c.err_hz,
+		      (unsigned long long)absdiff(pmsk_fout(f, &old), fout));
+	}
+
+	printf("%s: %u of %u clocks differ from the legacy calculation\n", name, diff, valid);
+
+	return diff;
+}
+
+static void test_one_octave(void)
+{
+	struct dsim_pll_features f;
+
+	features_init(&f, 1500000000ULL, 3000000000ULL);
+	CHECK(compare_legacy(&f, "vco 1.5-3GHz") == 0, "one octave VCO range differs");
+
+	features_init(&f, 3000000000ULL, 6000000000ULL);
+	CHECK(compare_legacy(&f, "vco 3-6GHz") == 0, "one octave VCO range differs");
+}
+
+static void test_wide_vco(void)
+{
+	struct dsim_pll_features f;
+	struct dsim_pll_cand c;
+
+	features_init(&f, 2500000000ULL, 6600000000ULL);
+	compare_legacy(&f, "vco 2.5-6.6GHz");
+
+	/* legacy p4 m193 s4 runs the VCO at 2.512GHz, right above its minimum */
+	CHECK(!dsim_pll_solve(&f, 157, &c) && c.p == 4 && c.m == 386 && c.s == 5,
+	      "157MHz: p%u m%u s%u", c.p, c.m, c.s);
+}
+
+static void test_table(void)
+{
+	struct dsim_pll_cand cands[3] = {
+		{ .p = 4, .m = 100, .cand_cnt = 1 },
+		{ .cand_cnt = 0 },
+		{ .p = 4, .m = 102, .cand_cnt = 2 },
+	};
+	const struct dsim_pll_table t = { .min_mhz = 100, .num = 3, .cands = cands };
+	const struct dsim_pll_table empty = { 0 };
+
+	CHECK(dsim_pll_table_lookup(&t, 100) == &cands[0], "first entry");
+	CHECK(dsim_pll_table_lookup(&t, 101) == NULL, "unsolvable entry");
+	CHECK(dsim_pll_table_lookup(&t, 102) == &cands[2], "last entry");
+	CHECK(dsim_pll_table_lookup(&t, 99) == NULL, "below the table");
+	CHECK(dsim_pll_table_lookup(&t, 103) == NULL, "above the table");
+	CHECK(dsim_pll_table_lookup(&empty, 100) == NULL, "empty table");
+}
+
+int main(void)
+{
+	test_one_octave();
+	test_wide_vco();
+	test_table();
+
+	if (failures) {
+		fprintf(stderr, "dsim_pll_test: %d failures\n", failures);
+		return EXIT_FAILURE;
+	}
+
+	printf("dsim_pll_test: passed\n");
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,549 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Copyright (C) 2023 Google LLC
+ *
+ * Decoder of the DECON "event_raw" debugfs snapshots
+ *
+ * Turns a snapshot pulled off a device back into the text of the "event"
+ * debugfs file, following dpu_event_log_print(). Built as the event_log_decode
+ * tool, which reads a snapshot from a file or from stdin:
+ *
+ *   adb pull /sys/kernel/debug/dri/0/crtc-0/event_raw
+ *   ./event_log_decode event_raw
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "event_log_decode.h"
+
+#define ARRAY_SIZE(x)		(sizeof(x) / sizeof((x)[0]))
+
+/* MAX_WIN_PER_DECON and the resource layout of the DECON CAL in use */
+#define MAX_PLANE		6
+#define OCCUPIED_BY_DECON(id)	(id)
+
+#define AFBC_FORMAT_MOD_SOURCE_GPU	(1ULL << 52)
+#define AFBC_FORMAT_MOD_SOURCE_G2D	(2ULL << 52)
+
+#define DPU_WIN_STATE_DISABLED	0
+#define DPU_WIN_STATE_COLOR	1
+#define DPU_WIN_STATE_BUFFER	2
+
+#define LOG_BUF_SIZE	160
+
+static const char events[][32] = {
+	"NONE",
+	"DECON_ENABLED",
+	"DECON_DISABLED",
+	"DECON_FRAMEDONE",
+	"DECON_FRAMESTART",
+	"DECON_RSC_OCCUPANCY",
+	"DECON_TRIG_MASK",
+	"DECON_UPDATE_CONFIG",
+	"DSIM_ENABLED",
+	"DSIM_DISABLED",
+	"DSIM_COMMAND",
+	"DSIM_ULPS_ENTER",
+	"DSIM_ULPS_EXIT",
+	"DSIM_UNDERRUN",
+	"DSIM_FRAMEDONE",
+	"DSIM_PH_FIFO_TIMEOUT",
+	"DSIM_PL_FIFO_TIMEOUT",
+	"DPP_FRAMEDONE",
+	"DPP_SET_PROTECTION",
+	"DMA_RECOVERY",
+	"IDMA_AFBC_CONFLICT",
+	"IDMA_FBC_ERROR",
+	"IDMA_READ_SLAVE_ERROR",
+	"IDMA_DEADLOCK",
+	"IDMA_CFG_ERROR",
+	"ATOMIC_COMMIT",
+	"TE_INTERRUPT",
+	"DECON_RUNTIME_SUSPEND",
+	"DECON_RUNTIME_RESUME",
+	"DECON_SUSPEND",
+	"DECON_RESUME",
+	"DSIM_RUNTIME_SUSPEND",
+	"DSIM_RUNTIME_RESUME",
+	"DSIM_SUSPEND",
+	"DSIM_RESUME",
+	"ENTER_HIBERNATION_IN",
+	"ENTER_HIBERNATION_OUT",
+	"EXIT_HIBERNATION_IN",
+	"EXIT_HIBERNATION_OUT",
+	"ATOMIC_BEGIN",
+	"ATOMIC_FLUSH",
+	"WB_ENABLE",
+	"WB_DISABLE",
+	"WB_ATOMIC_COMMIT",
+	"WB_FRAMEDONE",
+	"WB_ENTER_HIBERNATION",
+	"WB_EXIT_HIBERNATION",
+	"PREPARE_FB",
+	"CLEANUP_FB",
+	"PLANE_UPDATE",
+	"PLANE_DISABLE",
+	"REQ_CRTC_INFO_OLD",
+	"REQ_CRTC_INFO_NEW",
+	"FRAMESTART_TIMEOUT",
+	"BTS_RELEASE_BW",
+	"BTS_CALC_BW",
+	"BTS_UPDATE_BW",
+	"PARTIAL_INIT",
+	"PARTIAL_PREPARE",
+	"PARTIAL_UPDATE",
+	"PARTIAL_PESTORE",
+	"DSIM_CRC",
+	"DSIM_ECC",
+	"VBLANK_ENABLE",
+	"VBLANK_DISABLE",
+	"DIMMING_START",
+	"DIMMING_END",
+	"CGC_FRAMEDONE",
+	"ITMON_ERROR",
+	"SYSMMU_FAULT",
+	"BTS_PREFETCH",
+	"DSIM_CMD_BATCH",
+	"PLANE_FENCE",
+};
+
+_Static_assert(ARRAY_SIZE(events) == DPU_EVT_MAX, "event name missing");
+
+#define fourcc_code(a, b, c, d)	((__u32)(a) | ((__u32)(b) << 8) | \
+				 ((__u32)(c) << 16) | ((__u32)(d) << 24))
+
+/* names of dpu_formats_list */
+static const struct {
+	__u32 fmt;
+	const char *name;
+} formats[] = {
+	{ fourcc_code('C', '8', ' ', ' '), "C8" },
+	{ fourcc_code('A', 'R', '2', '4'), "ARGB8888" },
+	{ fourcc_code('A', 'B', '2', '4'), "ABGR8888" },
+	{ fourcc_code('R', 'A', '2', '4'), "RGBA8888" },
+	{ fourcc_code('B', 'A', '2', '4'), "BGRA8888" },
+	{ fourcc_code('X', 'R', '2', '4'), "XRGB8888" },
+	{ fourcc_code('X', 'B', '2', '4'), "XBGR8888" },
+	{ fourcc_code('R', 'X', '2', '4'), "RGBX8888" },
+	{ fourcc_code('B', 'X', '2', '4'), "BGRX8888" },
+	{ fourcc_code('R', 'G', '1', '6'), "RGB565" },
+	{ fourcc_code('B', 'G', '1', '6'), "BGR565" },
+	{ fourcc_code('A', 'R', '3', '0'), "ARGB2101010" },
+	{ fourcc_code('A', 'B', '3', '0'), "ABGR2101010" },
+	{ fourcc_code('R', 'A', '3', '0'), "RGBA1010102" },
+	{ fourcc_code('B', 'A', '3', '0'), "BGRA1010102" },
+	{ fourcc_code('N', 'V', '1', '2'), "NV12" },
+	{ fourcc_code('N', 'V', '2', '1'), "NV21" },
+	{ fourcc_code('P', '0', '1', '0'), "P010" },
+	{ fourcc_code('Y', '0', '1', '0'), "Y010_8P2" },
+	{ fourcc_code('Y', 'U', '0', '8'), "NV12_AFBC" },
+	{ fourcc_code('Y', 'U', '1', '0'), "P010_AFBC" },
+};
+
+const char *dpu_event_raw_name(__u32 type)
+{
+	if (type >= DPU_EVT_MAX)
+		return "UNKNOWN";
+
+	return events[type];
+}
+
+static const char *get_fmt_name(__u32 fmt)
+{
+	size_t i;
+
+	for (i = 0; i < ARRAY_SIZE(formats); i++)
+		if (formats[i].fmt == fmt)
+			return formats[i].name;
+
+	return "Unknown";
+}
+
+static const char *get_comp_src_name(__u64 comp_src)
+{
+	if (comp_src == AFBC_FORMAT_MOD_SOURCE_GPU)
+		return "GPU";
+	else if (comp_src == AFBC_FORMAT_MOD_SOURCE_G2D)
+		return "G2D";
+	else
+		return "";
+}
+
+/* vsnprintf() returning the length actually written, like the kernel one */
+static int scnprintf(char *buf, size_t size, const char *fmt, ...)
+{
+	va_list args;
+	int len;
+
+	va_start(args, fmt);
+	len = vsnprintf(buf, size, fmt, args);
+	va_end(args);
+
+	if (len < 0)
+		return 0;
+
+	return (size_t)len < size ? len : (size ? size - 1 : 0);
+}
+
+static bool is_decon_using(__u32 id, __u64 rsc, __u32 idx)
+{
+	return ((rsc >> (idx * 4)) & 0xF) == OCCUPIED_BY_DECON(id);
+}
+
+static void print_win_config(const struct dpu_log_raw_win_config *win, bool is_rcd,
+			     FILE *out)
+{
+	static const char *const str_state[3] = { "DISABLED", "COLOR", "BUFFER" };
+	char buf[128];
+	int len = scnprintf(buf, sizeof(buf),
+			"\t\t\t\t\t%s: %s[0x%llx] CH%d SRC[%d %d %d %d] %s%s%s",
+			is_rcd ? "RCD" : "WIN", str_state[win->state], 0ULL,
+			(win->state == DPU_WIN_STATE_COLOR) ? -1 : (int)win->dpp_id,
+			win->src_x, win->src_y, win->src_w, win->src_h,
+			(win->is_comp) ? "AFBC " : "", (win->is_rot) ? "ROT " : "",
+			(win->is_secure) ? "SECURE " : "");
+	len += scnprintf(buf + len, sizeof(buf) - len, "DST[%d %d %d %d] ", win->dst_x, win->dst_y,
+			 win->dst_w, win->dst_h);
+	len += scnprintf(buf + len, sizeof(buf) - len, "ZPOS%d", win->zpos);
+	fprintf(out, "%s %s %s\n", buf, get_fmt_name(win->format),
+		get_comp_src_name(win->comp_src));
+}
+
+static void print_atomic(const struct dpu_log_raw_atomic *atomic, FILE *out)
+{
+	const struct dpu_log_raw_win_config *win;
+	int i;
+
+	for (i = 0; i < DPU_LOG_RAW_MAX_WIN; ++i) {
+		win = &atomic->win_config[i];
+
+		if (win->state == DPU_WIN_STATE_DISABLED)
+			continue;
+
+		if (win->state > DPU_WIN_STATE_BUFFER) {
+			fprintf(stderr, "%s: invalid win state %u\n", __func__, win->state);
+			continue;
+		}
+		print_win_config(win, false, out);
+	}
+
+	win = &atomic->rcd_win_config;
+	if (win->state == DPU_WIN_STATE_BUFFER)
+		print_win_config(win, true, out);
+}
+
+static void print_rsc(char *buf, int len, __u32 decon_id,
+		      const struct dpu_log_raw_rsc_occupancy *rsc)
+{
+	int i, len_chs, len_wins;
+	char str_chs[128];
+	char str_wins[128];
+
+	len_chs = sprintf(str_chs, "CHs: ");
+	len_wins = sprintf(str_wins, "WINs: ");
+
+	for (i = 0; i < MAX_PLANE; ++i) {
+		len_chs += sprintf(str_chs + len_chs, "%d[%c] ", i,
+				is_decon_using(decon_id, rsc->rsc_ch, i) ? 'O' : 'X');
+		len_wins += sprintf(str_wins + len_wins, "%d[%c] ", i,
+				is_decon_using(decon_id, rsc->rsc_win, i) ? 'O' : 'X');
+	}
+
+	scnprintf(buf + len, LOG_BUF_SIZE - len, "\t%s\t%s", str_chs, str_wins);
+}
+
+static int print_bts_update(char *buf, int len, const struct dpu_log_raw_bts_update *update)
+{
+	return scnprintf(buf + len, LOG_BUF_SIZE - len,
+			"\tmif(%llu) int(%llu) disp(%llu) peak(%u,%u) rt(%u,%u) total(%u,%u)",
+			update->freqs.mif_freq, update->freqs.int_freq, update->freqs.disp_freq,
+			update->prev_peak, update->peak, update->prev_rt_avg_bw, update->rt_avg_bw,
+			update->prev_total_bw, update->total_bw);
+}
+
+static int print_partial(char *buf, int len, const struct dpu_log_raw_partial *p)
+{
+	len += scnprintf(buf + len, LOG_BUF_SIZE - len,
+			"\treq[%d %d %d %d] adj[%d %d %d %d] prev[%d %d %d %d]",
+			p->req.x1, p->req.y1, p->req.x2 - p->req.x1, p->req.y2 - p->req.y1,
+			p->adj.x1, p->adj.y1, p->adj.x2 - p->adj.x1, p->adj.y2 - p->adj.y1,
+			p->prev.x1, p->prev.y1, p->prev.x2 - p->prev.x1, p->prev.y2 - p->prev.y1);
+	return scnprintf(buf + len, LOG_BUF_SIZE - len, " reconfig(%d)", p->reconfigure);
+}
+
+static void print_record(const struct dpu_log_raw *raw, __u32 decon_id, FILE *out)
+{
+	const void *data = raw->data;
+	const struct dpu_log_raw_dpp *dpp = data;
+	const struct dpu_log_raw_pd *pd = data;
+	const struct dpu_log_raw_partial *partial = data;
+	const __u32 value = *(const __u32 *)data;
+	char buf[LOG_BUF_SIZE];
+	int len;
+
+	len = scnprintf(buf, sizeof(buf), "[%6llu.%06llu] %20s",
+			raw->ts_nsec / 1000000000, (raw->ts_nsec % 1000000000) / 1000,
+			dpu_event_raw_name(raw->type));
+
+	switch (raw->type) {
+	case DPU_EVT_DECON_RSC_OCCUPANCY:
+		print_rsc(buf, len, decon_id, data);
+		break;
+	case DPU_EVT_DSIM_COMMAND: {
+		const struct dpu_log_raw_dsim_cmd *cmd = data;
+
+		scnprintf(buf + len, sizeof(buf) - len, "\tCMD_ID: 0x%x\tDATA[0]: 0x%x len: %d",
+			  cmd->id, cmd->d0, cmd->len);
+		break;
+	}
+	case DPU_EVT_DSIM_CMD_BATCH: {
+		const struct dpu_log_raw_dsim_batch *batch = data;
+
+		scnprintf(buf + len, sizeof(buf) - len, "\tmerged flushes(%u) ph(%u) pl(%u)",
+			  batch->merged, batch->ph, batch->pl);
+		break;
+	}
+	case DPU_EVT_DPP_FRAMEDONE:
+		scnprintf(buf + len, sizeof(buf) - len, "\tCH:%u WIN:%u", dpp->id, dpp->win_id);
+		break;
+	case DPU_EVT_DPP_SET_PROTECTION:
+		scnprintf(buf + len, sizeof(buf) - len, "\tID:%u mst_security:%#x PID: %d",
+			  dpp->id, dpp->mst_security, dpp->last_secure_pid);
+		break;
+	case DPU_EVT_DMA_RECOVERY:
+		scnprintf(buf + len, sizeof(buf) - len, "\tCH:%u WIN:%u SRC:%s COUNT:%u",
+			  dpp->id, dpp->win_id, get_comp_src_name(dpp->comp_src),
+			  dpp->recovery_cnt);
+		break;
+	case DPU_EVT_IDMA_AFBC_CONFLICT:
+	case DPU_EVT_IDMA_FBC_ERROR:
+	case DPU_EVT_IDMA_READ_SLAVE_ERROR:
+	case DPU_EVT_IDMA_DEADLOCK:
+	case DPU_EVT_IDMA_CFG_ERROR:
+		scnprintf(buf + len, sizeof(buf) - len, "\tCH:%d WIN:%d SRC:%llu",
+			  dpp->id, dpp->win_id, dpp->comp_src);
+		break;
+	case DPU_EVT_DECON_RUNTIME_SUSPEND:
+	case DPU_EVT_DECON_RUNTIME_RESUME:
+	case DPU_EVT_DECON_SUSPEND:
+	case DPU_EVT_DECON_RESUME:
+	case DPU_EVT_ENTER_HIBERNATION_IN:
+	case DPU_EVT_ENTER_HIBERNATION_OUT:
+	case DPU_EVT_EXIT_HIBERNATION_IN:
+	case DPU_EVT_EXIT_HIBERNATION_OUT:
+		scnprintf(buf + len, sizeof(buf) - len, "\tDPU POWER:%s DECON STATE:%u",
+			  pd->rpm_active ? "ON" : "OFF", pd->decon_state);
+		break;
+	case DPU_EVT_DECON_UPDATE_CONFIG: {
+		const struct dpu_log_raw_decon_cfg *cfg = data;
+
+		scnprintf(buf + len, sizeof(buf) - len,
+			  "\t%s mode, %s_trigger, out type:0x%x, dsi_mode:%d.(%dx%d@%dhz)",
+			  cfg->op_mode ? "command" : "video", cfg->trig_mode ? "sw" : "hw",
+			  cfg->out_type, cfg->dsi_mode, cfg->image_width, cfg->image_height,
+			  cfg->fps);
+		break;
+	}
+	case DPU_EVT_DSIM_RUNTIME_SUSPEND:
+	case DPU_EVT_DSIM_RUNTIME_RESUME:
+	case DPU_EVT_DSIM_SUSPEND:
+	case DPU_EVT_DSIM_RESUME:
+		scnprintf(buf + len, sizeof(buf) - len,
+			  "\tDPU POWER:%s DSIM STATE:%u DSIM POWER:%s",
+			  pd->rpm_active ? "ON" : "OFF", pd->dsim_state,
+			  pd->dsim_rpm_active ? "ON" : "OFF");
+		break;
+	case DPU_EVT_PLANE_PREPARE_FB:
+	case DPU_EVT_PLANE_CLEANUP_FB: {
+		const struct dpu_log_raw_plane_info *info = data;
+
+		scnprintf(buf + len, sizeof(buf) - len, "\tCH%u: 0x%llx, %ux%u, ZPOS%u, %s",
+			  info->index, 0ULL, info->width, info->height, info->zpos,
+			  get_fmt_name(info->format));
+		break;
+	}
+	case DPU_EVT_PLANE_UPDATE:
+	case DPU_EVT_PLANE_DISABLE: {
+		const struct dpu_log_raw_win *win = data;
+
+		scnprintf(buf + len, sizeof(buf) - len, "\tCH:%d, WIN:%d, %s",
+			  win->plane_idx, win->win_idx, win->secure ? "SECURE" : "");
+		break;
+	}
+	case DPU_EVT_PLANE_FENCE: {
+		const struct dpu_log_raw_plane_fence *fence = data;
+
+		scnprintf(buf + len, sizeof(buf) - len,
+			  "\tCH:%u ready:%uus wait:%uus %s status:%d",
+			  fence->index, fence->ready_us, fence->wait_us,
+			  fence->deferred ? "DEFERRED" : "BLOCKING", fence->status);
+		break;
+	}
+	case DPU_EVT_REQ_CRTC_INFO_OLD:
+	case DPU_EVT_REQ_CRTC_INFO_NEW: {
+		const struct dpu_log_raw_crtc_info *info = data;
+
+		scnprintf(buf + len, sizeof(buf) - len,
+			  "\tenable(%d) active(%d) sr(%d) [p:%d m:%d a:%d c:%d]",
+			  info->enable, info->active, info->self_refresh,
+			  info->planes_changed, info->mode_changed,
+			  info->active_changed, info->connectors_changed);
+		break;
+	}
+	case DPU_EVT_BTS_RELEASE_BW:
+	case DPU_EVT_BTS_UPDATE_BW:
+		print_bts_update(buf, len, data);
+		break;
+	case DPU_EVT_BTS_CALC_BW: {
+		const struct dpu_log_raw_bts_cal *cal = data;
+
+		scnprintf(buf + len, sizeof(buf) - len,
+			  "\tdisp(%u) peak(%u) rt(%u) read(%u) write(%u) %uhz",
+			  cal->disp_freq, cal->peak, cal->rt_avg_bw, cal->read_bw,
+			  cal->write_bw, cal->fps);
+		break;
+	}
+	case DPU_EVT_BTS_PREFETCH: {
+		const struct dpu_log_raw_bts_prefetch *pf = data;
+
+		scnprintf(buf + len, sizeof(buf) - len,
+			  "\tvote peak(%u) rt(%u) disp(%u) hit(%u) miss(%u) over(%u)",
+			  pf->peak, pf->rt, pf->disp_freq, pf->hit_cnt, pf->miss_cnt,
+			  pf->over_cnt);
+		break;
+	}
+	case DPU_EVT_DSIM_UNDERRUN: {
+		const struct dpu_log_raw_bts_event *event = data;
+
+		scnprintf(buf + len, sizeof(buf) - len, "\tunderrun count(%u)", event->value);
+		break;
+	}
+	case DPU_EVT_PARTIAL_INIT:
+		scnprintf(buf + len, sizeof(buf) - len, "\tminimum rect size[%dx%d]",
+			  partial->min_w, partial->min_h);
+		break;
+	case DPU_EVT_PARTIAL_PREPARE:
+		print_partial(buf, len, partial);
+		break;
+	case DPU_EVT_PARTIAL_RESTORE:
+	case DPU_EVT_PARTIAL_UPDATE:
+		scnprintf(buf + len, sizeof(buf) - len, "\t[%d %d %d %d]",
+			  partial->prev.x1, partial->prev.y1,
+			  partial->prev.x2 - partial->prev.x1,
+			  partial->prev.y2 - partial->prev.y1);
+		break;
+	case DPU_EVT_DSIM_CRC:
+		scnprintf(buf + len, sizeof(buf) - len, "\tcrc count(%u)", value);
+		break;
+	case DPU_EVT_DSIM_ECC:
+		scnprintf(buf + len, sizeof(buf) - len, "\tecc count(%u)", value);
+		break;
+	case DPU_EVT_TE_INTERRUPT:
+		scnprintf(buf + len, sizeof(buf) - len, "\tte cnt(%u)", value);
+		break;
+	default:
+		break;
+	}
+
+	fprintf(out, "%s\n", buf);
+
+	if (raw->type == DPU_EVT_ATOMIC_COMMIT)
+		print_atomic(data, out);
+}
+
+int dpu_event_raw_decode(const void *buf, size_t size, FILE *out)
+{
+	const struct dpu_log_raw_header *hdr = buf;
+	const char *records;
+	__u32 i;
+
+	if (size < sizeof(*hdr) || hdr->magic != DPU_EVENT_LOG_RAW_MAGIC) {
+		fprintf(stderr, "not an event log snapshot\n");
+		return -EINVAL;
+	}
+
+	if (hdr->version != DPU_EVENT_LOG_RAW_VERSION ||
+	    hdr->header_size < sizeof(*hdr) ||
+	    hdr->record_size != sizeof(struct dpu_log_raw)) {
+		fprintf(stderr, "unsupported snapshot version %u (record size %u)\n",
+			hdr->version, hdr->record_size);
+		return -EINVAL;
+	}
+
+	if (size < hdr->header_size + (size_t)hdr->record_cnt * hdr->record_size) {
+		fprintf(stderr, "snapshot of %u records truncated to %zu bytes\n",
+			hdr->record_cnt, size);
+		return -EINVAL;
+	}
+
+	fprintf(out, "----------------------------------------------------\n");
+	fprintf(out, "%14s  %20s  %20s\n", "Time", "Event ID", "Remarks");
+	fprintf(out, "----------------------------------------------------\n");
+
+	records = (const char *)buf + hdr->header_size;
+	for (i = 0; i < hdr->record_cnt; i++) {
+		const struct dpu_log_raw *raw =
+			(const struct dpu_log_raw *)(records + i * hdr->record_size);
+
+		/* never written, or caught mid-write by the snapshot */
+		if (!raw->ts_nsec)
+			continue;
+
+		print_record(raw, hdr->decon_id, out);
+	}
+
+	fprintf(out, "----------------------------------------------------\n");
+
+	return 0;
+}
+
+#ifdef EVENT_LOG_DECODE_MAIN
+int main(int argc, char **argv)
+{
+	FILE *in = stdin;
+	char *buf = NULL;
+	size_t size = 0, n;
+	int ret;
+
+	if (argc > 2) {
+		fprintf(stderr, "usage: %s [event_raw]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	if (argc == 2) {
+		in = fopen(argv[1], "rb");
+		if (!in) {
+			perror(argv[1]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	do {
+		char *next = realloc(buf, size + 65536);
+
+		if (!next) {
+			free(buf);
+			return EXIT_FAILURE;
+		}
+		buf = next;
+		n = fread(buf + size, 1, 65536, in);
+		size += n;
+	} while (n);
+
+	if (in != stdin)
+		fclose(in);
+
+	ret = dpu_event_raw_decode(buf, size, stdout);
+	free(buf);
+
+	return ret ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+#endif
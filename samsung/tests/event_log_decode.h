@@ -0,0 +1,30 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ *
+ * Copyright (C) 2023 Google LLC
+ *
+ * Decoder of the DECON "event_raw" debugfs snapshots.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef __EVENT_LOG_DECODE_H__
+#define __EVENT_LOG_DECODE_H__
+
+#include <stddef.h>
+#include <stdio.h>
+
+#include "exynos_drm_event_log_raw.h"
+
+const char *dpu_event_raw_name(__u32 type);
+
+/*
+ * Prints the snapshot in @buf the way the "event" debugfs file of the same
+ * DECON prints its log, except for the DMA addresses which aren't exported and
+ * are printed as 0. Returns 0, or -EINVAL if @buf isn't a snapshot of a
+ * supported version.
+ */
+int dpu_event_raw_decode(const void *buf, size_t size, FILE *out);
+
+#endif /* __EVENT_LOG_DECODE_H__ */
@@ -0,0 +1,269 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Copyright (C) 2023 Google LLC
+ *
+ * Host test for the event_raw snapshot decoder
+ *
+ * Builds a snapshot the way dpu_event_log_snapshot() does, with a few empty
+ * entries ahead of the oldest event, and checks that the decoder prints it as
+ * dpu_event_log_print() prints the same events. Malformed snapshots have to be
+ * rejected.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "event_log_decode.h"
+
+static int failures;
+
+#define CHECK(cond, fmt, ...) do {					\
+	if (!(cond)) {							\
+		fprintf(stderr, "%s:%d: " fmt "\n", __func__, __LINE__,	\
+			##__VA_ARGS__);					\
+		failures++;						\
+	}								\
+} while (0)
+
+#define RECORDS		13
+#define EMPTY		3
+
+#define fourcc_code(a, b, c, d)	((__u32)(a) | ((__u32)(b) << 8) | \
+				 ((__u32)(c) << 16) | ((__u32)(d) << 24))
+
+struct snapshot {
+	struct dpu_log_raw_header hdr;
+	struct dpu_log_raw records[RECORDS];
+};
+
+static const char *const expected =
+	"----------------------------------------------------\n"
+	"          Time              Event ID               Remarks\n"
+	"----------------------------------------------------\n"
+	"[    12.000345]         TE_INTERRUPT\tte cnt(77)\n"
+	"[    12.001000]        ATOMIC_COMMIT\n"
+	"\t\t\t\t\tWIN: BUFFER[0x0] CH2 SRC[0 0 1080 2400] AFBC DST[0 0 1080 2400] ZPOS0 ARGB8888 GPU\n"
+	"\t\t\t\t\tWIN: COLOR[0x0] CH-1 SRC[0 0 0 0] DST[10 -20 100 50] ZPOS1 Unknown \n"
+	"\t\t\t\t\tRCD: BUFFER[0x0] CH6 SRC[0 0 1080 2400] DST[0 0 1080 2400] ZPOS7 C8 \n"
+	"[    12.002000]  DECON_RSC_OCCUPANCY\tCHs: 0[O] 1[X] 2[O] 3[X] 4[X] 5[X] \t"
+	"WINs: 0[X] 1[O] 2[X] 3[X] 4[X] 5[X] \n"
+	"[    12.003000]         DSIM_COMMAND\tCMD_ID: 0x39\tDATA[0]: 0x51 len: 3\n"
+	"[    12.004000]        BTS_UPDATE_BW\tmif(1539000) int(533000) disp(400000) "
+	"peak(100,200) rt(300,400) total(500,600)\n"
+	"[    12.005000]      PARTIAL_PREPARE\treq[0 100 1080 200] adj[0 96 1080 208] "
+	"prev[0 0 1080 2400] reconfig(1)\n"
+	"[    12.006000]          PLANE_FENCE\tCH:3 ready:1500us wait:250us DEFERRED status:0\n"
+	"[    12.007000]  DECON_UPDATE_CONFIG\tcommand mode, sw_trigger, out type:0x1, "
+	"dsi_mode:0.(1080x2400@120hz)\n"
+	"[    13.000000]           PREPARE_FB\tCH1: 0x0, 1080x2400, ZPOS2, NV12_AFBC\n"
+	"----------------------------------------------------\n";
+
+static void fill_snapshot(struct snapshot *s)
+{
+	struct dpu_log_raw *raw = &s->records[EMPTY];
+	struct dpu_log_raw_atomic *atomic;
+	struct dpu_log_raw_rsc_occupancy *rsc;
+	struct dpu_log_raw_dsim_cmd *cmd;
+	struct dpu_log_raw_bts_update *update;
+	struct dpu_log_raw_partial *partial;
+	struct dpu_log_raw_plane_fence *fence;
+	struct dpu_log_raw_decon_cfg *cfg;
+	struct dpu_log_raw_plane_info *info;
+	__u32 *value;
+
+	memset(s, 0, sizeof(*s));
+	s->hdr.magic = DPU_EVENT_LOG_RAW_MAGIC;
+	s->hdr.version = DPU_EVENT_LOG_RAW_VERSION;
+	s->hdr.header_size = sizeof(s->hdr);
+	s->hdr.record_size = sizeof(struct dpu_log_raw);
+	s->hdr.record_cnt = RECORDS;
+	s->hdr.decon_id = 0;
+	s->hdr.ts_nsec = 14000000000ULL;
+
+	raw->ts_nsec = 12000345678ULL;
+	raw->type = DPU_EVT_TE_INTERRUPT;
+	value = (void *)raw->data;
+	*value = 77;
+	raw++;
+
+	raw->ts_nsec = 12001000000ULL;
+	raw->type = DPU_EVT_ATOMIC_COMMIT;
+	atomic = (void *)raw->data;
+	atomic->win_config[0] = (struct dpu_log_raw_win_config) {
+		.state = 2, .src_w = 1080, .src_h = 2400, .dst_w = 1080, .dst_h = 2400,
+		.is_comp = 1, .dpp_id = 2, .format = fourcc_code('A', 'R', '2', '4'),
+		.comp_src = 1ULL << 52,
+	};
+	atomic->win_config[3] = (struct dpu_log_raw_win_config) {
+		.state = 1, .dst_x = 10, .dst_y = -20, .dst_w = 100, .dst_h = 50,
+		.dpp_id = 4, .zpos = 1,
+	};
+	atomic->rcd_win_config = (struct dpu_log_raw_win_config) {
+		.state = 2, .src_w = 1080, .src_h = 2400, .dst_w = 1080, .dst_h = 2400,
+		.dpp_id = 6, .zpos = 7, .format = fourcc_code('C', '8', ' ', ' '),
+	};
+	raw++;
+
+	raw->ts_nsec = 12002000000ULL;
+	raw->type = DPU_EVT_DECON_RSC_OCCUPANCY;
+	rsc = (void *)raw->data;
+	/* channels 0 and 2, window 1 belong to DECON0, the rest to DECON1 */
+	rsc->rsc_ch = 0x111010;
+	rsc->rsc_win = 0x111101;
+	raw++;
+
+	raw->ts_nsec = 12003000000ULL;
+	raw->type = DPU_EVT_DSIM_COMMAND;
+	cmd = (void *)raw->data;
+	cmd->id = 0x39;
+	cmd->d0 = 0x51;
+	cmd->len = 3;
+	raw++;
+
+	/* caught mid-write, zeroed by the snapshot */
+	raw++;
+
+	raw->ts_nsec = 12004000000ULL;
+	raw->type = DPU_EVT_BTS_UPDATE_BW;
+	update = (void *)raw->data;
+	update->freqs.mif_freq = 1539000;
+	update->freqs.int_freq = 533000;
+	update->freqs.disp_freq = 400000;
+	update->prev_peak = 100;
+	update->peak = 200;
+	update->prev_rt_avg_bw = 300;
+	update->rt_avg_bw = 400;
+	update->prev_total_bw = 500;
+	update->total_bw = 600;
+	raw++;
+
+	raw->ts_nsec = 12005000000ULL;
+	raw->type = DPU_EVT_PARTIAL_PREPARE;
+	partial = (void *)raw->data;
+	partial->req = (struct dpu_log_raw_rect) { 0, 100, 1080, 300 };
+	partial->adj = (struct dpu_log_raw_rect) { 0, 96, 1080, 304 };
+	partial->prev = (struct dpu_log_raw_rect) { 0, 0, 1080, 2400 };
+	partial->reconfigure = 1;
+	raw++;
+
+	raw->ts_nsec = 12006000000ULL;
+	raw->type = DPU_EVT_PLANE_FENCE;
+	fence = (void *)raw->data;
+	fence->index = 3;
+	fence->ready_us = 1500;
+	fence->wait_us = 250;
+	fence->deferred = 1;
+	raw++;
+
+	raw->ts_nsec = 12007000000ULL;
+	raw->type = DPU_EVT_DECON_UPDATE_CONFIG;
+	cfg = (void *)raw->data;
+	cfg->fps = 120;
+	cfg->image_width = 1080;
+	cfg->image_height = 2400;
+	cfg->out_type = 1;
+	cfg->op_mode = 1;
+	cfg->trig_mode = 1;
+	raw++;
+
+	raw->ts_nsec = 13000000000ULL;
+	raw->type = DPU_EVT_PLANE_PREPARE_FB;
+	info = (void *)raw->data;
+	info->index = 1;
+	info->width = 1080;
+	info->height = 2400;
+	info->zpos = 2;
+	info->format = fourcc_code('Y', 'U', '0', '8');
+}
+
+static int decode(const void *buf, size_t size, char **text)
+{
+	size_t len;
+	FILE *out = open_memstream(text, &len);
+	int ret;
+
+	if (!out)
+		return -ENOMEM;
+
+	ret = dpu_event_raw_decode(buf, size, out);
+	fclose(out);
+
+	return ret;
+}
+
+static void test_decode(void)
+{
+	struct snapshot s;
+	char *text = NULL;
+	int ret;
+
+	fill_snapshot(&s);
+	ret = decode(&s, sizeof(s), &text);
+	CHECK(!ret, "decode failed %d", ret);
+	CHECK(text && !strcmp(text, expected), "decoded:\n%s\nexpected:\n%s", text, expected);
+	free(text);
+}
+
+static void test_names(void)
+{
+	CHECK(!strcmp(dpu_event_raw_name(DPU_EVT_NONE), "NONE"), "first name %s",
+	      dpu_event_raw_name(DPU_EVT_NONE));
+	CHECK(!strcmp(dpu_event_raw_name(DPU_EVT_PLANE_FENCE), "PLANE_FENCE"), "last name %s",
+	      dpu_event_raw_name(DPU_EVT_PLANE_FENCE));
+	CHECK(!strcmp(dpu_event_raw_name(DPU_EVT_MAX), "UNKNOWN"), "name past the end %s",
+	      dpu_event_raw_name(DPU_EVT_MAX));
+}
+
+static void test_invalid(void)
+{
+	struct snapshot s;
+	char *text = NULL;
+
+	fill_snapshot(&s);
+	s.hdr.magic = 0;
+	CHECK(decode(&s, sizeof(s), &text) == -EINVAL, "bad magic accepted");
+	free(text);
+
+	fill_snapshot(&s);
+	s.hdr.version = DPU_EVENT_LOG_RAW_VERSION - 1;
+	text = NULL;
+	CHECK(decode(&s, sizeof(s), &text) == -EINVAL, "old version accepted");
+	free(text);
+
+	fill_snapshot(&s);
+	s.hdr.record_size = sizeof(struct dpu_log_raw) - 8;
+	text = NULL;
+	CHECK(decode(&s, sizeof(s), &text) == -EINVAL, "bad record size accepted");
+	free(text);
+
+	fill_snapshot(&s);
+	text = NULL;
+	CHECK(decode(&s, sizeof(s) - 1, &text) == -EINVAL, "truncated snapshot accepted");
+	free(text);
+
+	text = NULL;
+	CHECK(decode(&s, sizeof(s.hdr) - 1, &text) == -EINVAL, "truncated header accepted");
+	free(text);
+}
+
+int main(void)
+{
+	test_names();
+	test_decode();
+	test_invalid();
+
+	if (failures) {
+		fprintf(stderr, "event_log_decode_test: %d failures\n", failures);
+		return EXIT_FAILURE;
+	}
+
+	printf("event_log_decode_test: passed\n");
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,343 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Copyright (C) 2023 Google LLC
+ *
+ * Stress test for the lock-free event log ring
+ *
+ * Several producer threads log events into one ring while a reader keeps
+ * copying entries out of it, the way DPU_EVENT_LOG() is called from the DECON,
+ * DSIM and DPP interrupts and the commit thread while the event log is dumped.
+ * Every entry carries a payload derived from its producer and sequence, so the
+ * reader can tell a torn copy from a consistent one. The producers run in
+ * rounds of fewer events than the ring holds, after each round all of its
+ * events have to be found intact.
+ *
+ * The same load is then run through the spinlocked reservation the ring
+ * replaced, and the time spent with the lock held or waiting for it, which is
+ * time with interrupts disabled in the driver, is printed next to the time the
+ * lock-free reservation takes.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "exynos_drm_event_log_raw.h"
+
+#define PAYLOAD_WORDS	128
+
+struct dpu_log {
+	uint64_t ts_nsec;
+	uint32_t seq;
+	enum dpu_event_type type;
+	union {
+		uint32_t words[PAYLOAD_WORDS];
+	} data;
+};
+
+#include "exynos_drm_event_ring.h"
+
+#define PRODUCERS	4
+#define RING_SIZE	256
+/* events per producer and round, all producers together stay below RING_SIZE */
+#define ROUND_EVENTS	48
+#define ROUNDS		2000
+
+static int failures;
+
+#define CHECK(cond, fmt, ...) do {					\
+	if (!(cond)) {							\
+		fprintf(stderr, "%s:%d: " fmt "\n", __func__, __LINE__,	\
+			##__VA_ARGS__);					\
+		__atomic_add_fetch(&failures, 1, __ATOMIC_RELAXED);	\
+	}								\
+} while (0)
+
+struct ring {
+	struct dpu_log log[RING_SIZE];
+	atomic_t idx;
+	/* only used by the spinlocked reservation */
+	pthread_spinlock_t lock;
+	bool locked;
+};
+
+struct producer {
+	struct ring *ring;
+	pthread_t thread;
+	u32 id;
+	u32 rand_state;
+	/* time spent reserving entries */
+	uint64_t reserve_ns;
+	uint64_t reserve_max_ns;
+};
+
+static struct ring ring;
+static struct producer producers[PRODUCERS];
+static pthread_barrier_t round_start, round_end;
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static u32 rand_next(u32 *state)
+{
+	*state = *state * 1103515245 + 12345;
+
+	return *state >> 8;
+}
+
+static uint32_t payload_word(uint64_t tag, u32 i)
+{
+	return (uint32_t)(tag ^ (tag >> 32)) ^ (i * 0x9e3779b9);
+}
+
+/* the producer and its event count are kept in ts_nsec */
+static uint64_t event_tag(u32 producer, u32 event)
+{
+	return ((uint64_t)producer << 32) | event;
+}
+
+/* reservation of the driver before the ring was made lock-free */
+static struct dpu_log *legacy_reserve(struct ring *r)
+{
+	struct dpu_log *log;
+	int idx;
+
+	pthread_spin_lock(&r->lock);
+	idx = atomic_inc_return(&r->idx) % RING_SIZE;
+	log = &r->log[idx];
+	log->type = DPU_EVT_NONE;
+	pthread_spin_unlock(&r->lock);
+
+	return log;
+}
+
+static bool legacy_read(struct ring *r, const struct dpu_log *src, struct dpu_log *dst)
+{
+	pthread_spin_lock(&r->lock);
+	memcpy(dst, src, sizeof(*dst));
+	pthread_spin_unlock(&r->lock);
+
+	return dst->type != DPU_EVT_NONE;
+}
+
+static void produce(struct producer *p, u32 event)
+{
+	const uint64_t tag = event_tag(p->id, event);
+	struct dpu_log *log;
+	uint64_t start, ns;
+	u32 i;
+
+	start = now_ns();
+	if (p->ring->locked)
+		log = legacy_reserve(p->ring);
+	else
+		log = dpu_event_reserve(p->ring->log, RING_SIZE, &p->ring->idx);
+	ns = now_ns() - start;
+	p->reserve_ns += ns;
+	if (ns > p->reserve_max_ns)
+		p->reserve_max_ns = ns;
+
+	log->ts_nsec = tag;
+	for (i = 0; i < PAYLOAD_WORDS; i++) {
+		log->data.words[i] = payload_word(tag, i);
+		/* get preempted in the middle of an entry now and then */
+		if (i == PAYLOAD_WORDS / 2 && !(rand_next(&p->rand_state) % 8))
+			sched_yield();
+	}
+
+	if (p->ring->locked)
+		WRITE_ONCE(log->type, DPU_EVT_DECON_FRAMEDONE + p->id);
+	else
+		dpu_event_commit(log, DPU_EVT_DECON_FRAMEDONE + p->id);
+}
+
+static void *producer_thread(void *arg)
+{
+	struct producer *p = arg;
+	u32 round, i;
+
+	for (round = 0; round < ROUNDS; round++) {
+		pthread_barrier_wait(&round_start);
+		for (i = 0; i < ROUND_EVENTS; i++)
+			produce(p, round * ROUND_EVENTS + i);
+		pthread_barrier_wait(&round_end);
+	}
+
+	return NULL;
+}
+
+/* returns false if @log is torn */
+static bool check_entry(const struct dpu_log *log)
+{
+	const u32 producer = log->ts_nsec >> 32;
+	u32 i;
+
+	if (producer >= PRODUCERS || log->type != DPU_EVT_DECON_FRAMEDONE + producer)
+		return false;
+
+	for (i = 0; i < PAYLOAD_WORDS; i++)
+		if (log->data.words[i] != payload_word(log->ts_nsec, i))
+			return false;
+
+	return true;
+}
+
+struct read_stats {
+	u32 copied;
+	u32 skipped;
+	u32 torn;
+};
+
+static bool read_entry(const struct dpu_log *src, struct dpu_log *dst)
+{
+	if (ring.locked)
+		return legacy_read(&ring, src, dst);
+
+	return dpu_event_read(src, dst);
+}
+
+/* the reader, copies entries while the producers run and checks each round */
+static void run(bool locked, struct read_stats *stats)
+{
+	const struct dpu_log *log;
+	struct dpu_log copy;
+	u32 round, i, slot = 0;
+	int p;
+
+	memset(&ring, 0, sizeof(ring));
+	atomic_set(&ring.idx, -1);
+	pthread_spin_init(&ring.lock, PTHREAD_PROCESS_PRIVATE);
+	ring.locked = locked;
+	memset(stats, 0, sizeof(*stats));
+
+	pthread_barrier_init(&round_start, NULL, PRODUCERS + 1);
+	pthread_barrier_init(&round_end, NULL, PRODUCERS + 1);
+
+	for (p = 0; p < PRODUCERS; p++) {
+		producers[p] = (struct producer) {
+			.ring = &ring, .id = p, .rand_state = p + 1,
+		};
+		pthread_create(&producers[p].thread, NULL, producer_thread, &producers[p]);
+	}
+
+	for (round = 0; round < ROUNDS; round++) {
+		const int first = atomic_read(&ring.idx) + 1;
+		u32 seen[PRODUCERS] = { 0 };
+
+		pthread_barrier_wait(&round_start);
+
+		/*
+		 * keep copying entries out while the producers run, every other
+		 * one is the newest entry which is the most likely to be in flight
+		 */
+		for (i = 0; i < 4 * ROUND_EVENTS; i++) {
+			if (i & 1) {
+				slot = (slot + 1) % RING_SIZE;
+				log = &ring.log[slot];
+			} else {
+				log = &ring.log[(u32)atomic_read(&ring.idx) % RING_SIZE];
+			}
+
+			if (!read_entry(log, &copy)) {
+				stats->skipped++;
+			} else {
+				stats->copied++;
+				if (!check_entry(&copy))
+					stats->torn++;
+			}
+			if (!(i % 16))
+				sched_yield();
+		}
+
+		pthread_barrier_wait(&round_end);
+
+		/* nothing of the round may be lost */
+		CHECK(atomic_read(&ring.idx) + 1 - first == PRODUCERS * ROUND_EVENTS,
+		      "round %u reserved %d entries", round, atomic_read(&ring.idx) + 1 - first);
+		for (i = 0; i < PRODUCERS * ROUND_EVENTS; i++) {
+			u32 producer, event;
+
+			log = &ring.log[(first + i) % RING_SIZE];
+			if (!read_entry(log, &copy) || !check_entry(&copy)) {
+				CHECK(0, "round %u entry %u lost or torn", round, first + i);
+				continue;
+			}
+			CHECK(locked || copy.seq == first + i, "entry %u has sequence %u",
+			      first + i, copy.seq);
+
+			producer = copy.ts_nsec >> 32;
+			event = (u32)copy.ts_nsec;
+			CHECK(event / ROUND_EVENTS == round, "round %u holds event %u of round %u",
+			      round, event, event / ROUND_EVENTS);
+			seen[producer]++;
+		}
+		for (p = 0; p < PRODUCERS; p++)
+			CHECK(seen[p] == ROUND_EVENTS, "round %u has %u events of producer %d",
+			      round, seen[p], p);
+	}
+
+	for (p = 0; p < PRODUCERS; p++)
+		pthread_join(producers[p].thread, NULL);
+
+	pthread_barrier_destroy(&round_start);
+	pthread_barrier_destroy(&round_end);
+	pthread_spin_destroy(&ring.lock);
+}
+
+static void reserve_stats(uint64_t *avg_ns, uint64_t *max_ns)
+{
+	uint64_t total = 0;
+	int p;
+
+	*max_ns = 0;
+	for (p = 0; p < PRODUCERS; p++) {
+		total += producers[p].reserve_ns;
+		if (producers[p].reserve_max_ns > *max_ns)
+			*max_ns = producers[p].reserve_max_ns;
+	}
+	*avg_ns = total / (PRODUCERS * ROUNDS * ROUND_EVENTS);
+}
+
+int main(void)
+{
+	struct read_stats lockless, locked;
+	uint64_t lockless_avg, lockless_max, locked_avg, locked_max;
+
+	run(false, &lockless);
+	reserve_stats(&lockless_avg, &lockless_max);
+
+	printf("lock-free: %u producers, %u events, reader copied %u and skipped %u in flight\n",
+	       PRODUCERS, PRODUCERS * ROUNDS * ROUND_EVENTS, lockless.copied, lockless.skipped);
+	CHECK(!lockless.torn, "reader copied %u torn entries", lockless.torn);
+	CHECK(lockless.copied, "reader copied nothing");
+
+	run(true, &locked);
+	reserve_stats(&locked_avg, &locked_max);
+
+	printf("spinlocked: reader copied %u and skipped %u in flight, %u of the copies torn\n",
+	       locked.copied, locked.skipped, locked.torn);
+	printf("reservation: spinlocked avg %lluns max %lluns with irqs off, lock-free avg %lluns max %lluns with irqs on\n",
+	       (unsigned long long)locked_avg, (unsigned long long)locked_max,
+	       (unsigned long long)lockless_avg, (unsigned long long)lockless_max);
+
+	if (failures) {
+		fprintf(stderr, "event_ring_test: %d failures\n", failures);
+		return EXIT_FAILURE;
+	}
+
+	printf("event_ring_test: passed\n");
+	return EXIT_SUCCESS;
+}
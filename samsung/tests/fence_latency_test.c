@@ -0,0 +1,162 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Copyright (C) 2023 Google LLC
+ *
+ * Host test for the plane fence to trigger latency statistics
+ *
+ * Checks the histogram buckets and counters, then replays a synthetic stream of
+ * commits whose plane fences signal at random times through both commit tail
+ * paths: blocking, where the planes are programmed only once all fences have
+ * signaled, and deferred, where they are programmed while the GPU still renders
+ * and only the trigger waits for the fences. The fence to trigger latency of
+ * both is printed, and the deferred one is expected to be lower.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "exynos_drm_fence_latency.h"
+
+#define NSEC_PER_MSEC		1000000LL
+
+static int failures;
+
+#define CHECK(cond, fmt, ...) do {					\
+	if (!(cond)) {							\
+		fprintf(stderr, "%s:%d: " fmt "\n", __func__, __LINE__,	\
+			##__VA_ARGS__);					\
+		failures++;						\
+	}								\
+} while (0)
+
+static u32 rand_state = 1;
+
+/* deterministic value in [0, max) */
+static s64 rand_ns(s64 max)
+{
+	rand_state = rand_state * 1103515245 + 12345;
+
+	return max ? ((rand_state >> 8) % max) : 0;
+}
+
+static void test_buckets(void)
+{
+	CHECK(fence_latency_bucket(0) == 0, "0us in bucket %d", fence_latency_bucket(0));
+	CHECK(fence_latency_bucket(124) == 0, "124us in bucket %d", fence_latency_bucket(124));
+	CHECK(fence_latency_bucket(125) == 1, "125us in bucket %d", fence_latency_bucket(125));
+	CHECK(fence_latency_bucket(249) == 1, "249us in bucket %d", fence_latency_bucket(249));
+	CHECK(fence_latency_bucket(250) == 2, "250us in bucket %d", fence_latency_bucket(250));
+	CHECK(fence_latency_bucket(1000) == 4, "1ms in bucket %d", fence_latency_bucket(1000));
+	CHECK(fence_latency_bucket(31999) == FENCE_LATENCY_HIST_BUCKETS - 2,
+	      "<32ms in bucket %d", fence_latency_bucket(31999));
+	CHECK(fence_latency_bucket(32000) == FENCE_LATENCY_HIST_BUCKETS - 1,
+	      "32ms in bucket %d", fence_latency_bucket(32000));
+	CHECK(fence_latency_bucket(~0ULL) == FENCE_LATENCY_HIST_BUCKETS - 1,
+	      "max in bucket %d", fence_latency_bucket(~0ULL));
+}
+
+static void test_record(void)
+{
+	struct fence_latency fl = { 0 };
+	u64 us;
+
+	CHECK(fence_latency_avg_us(&fl, FENCE_LATENCY_BLOCKING) == 0, "avg without frames");
+
+	us = fence_latency_record(&fl, FENCE_LATENCY_BLOCKING, 1000000, 1300000);
+	CHECK(us == 300, "recorded %lluus instead of 300us", (unsigned long long)us);
+	us = fence_latency_record(&fl, FENCE_LATENCY_BLOCKING, 1000000, 1100999);
+	CHECK(us == 100, "recorded %lluus instead of 100us", (unsigned long long)us);
+
+	/* a fence timestamp after the trigger counts as no latency */
+	us = fence_latency_record(&fl, FENCE_LATENCY_DEFERRED, 2000000, 1000000);
+	CHECK(us == 0, "recorded %lluus for a late fence", (unsigned long long)us);
+
+	CHECK(fl.cnt[FENCE_LATENCY_BLOCKING] == 2, "blocking count %u",
+	      fl.cnt[FENCE_LATENCY_BLOCKING]);
+	CHECK(fl.cnt[FENCE_LATENCY_DEFERRED] == 1, "deferred count %u",
+	      fl.cnt[FENCE_LATENCY_DEFERRED]);
+	CHECK(fl.max_us[FENCE_LATENCY_BLOCKING] == 300, "blocking max %uus",
+	      fl.max_us[FENCE_LATENCY_BLOCKING]);
+	CHECK(fence_latency_avg_us(&fl, FENCE_LATENCY_BLOCKING) == 200, "blocking avg %uus",
+	      fence_latency_avg_us(&fl, FENCE_LATENCY_BLOCKING));
+	CHECK(fl.hist[FENCE_LATENCY_BLOCKING][0] == 1 && fl.hist[FENCE_LATENCY_BLOCKING][2] == 1,
+	      "blocking histogram %u/%u/%u", fl.hist[FENCE_LATENCY_BLOCKING][0],
+	      fl.hist[FENCE_LATENCY_BLOCKING][1], fl.hist[FENCE_LATENCY_BLOCKING][2]);
+	CHECK(fl.hist[FENCE_LATENCY_DEFERRED][0] == 1, "deferred histogram %u",
+	      fl.hist[FENCE_LATENCY_DEFERRED][0]);
+}
+
+#define PLANES			4
+#define COMMITS			1000
+/* time the commit tail needs to program the planes, DQE, BTS etc. */
+#define PROGRAM_NS		(1500 * 1000LL)
+/* wake up of the thread blocked on a fence after it signaled */
+#define WAKE_NS			(50 * 1000LL)
+
+static void test_paths(void)
+{
+	struct fence_latency fl = { 0 };
+	s64 commit_ns = 0;
+	int i, j;
+
+	for (i = 0; i < COMMITS; i++) {
+		s64 ready_ns = commit_ns, trigger_ns;
+
+		/* fences of the layers signal within 4ms of the commit */
+		for (j = 0; j < PLANES; j++) {
+			const s64 fence_ns = commit_ns + rand_ns(4 * NSEC_PER_MSEC);
+
+			if (fence_ns > ready_ns)
+				ready_ns = fence_ns;
+		}
+
+		/* blocking: everything is programmed after the last fence */
+		trigger_ns = ready_ns + WAKE_NS + PROGRAM_NS;
+		fence_latency_record(&fl, FENCE_LATENCY_BLOCKING, ready_ns, trigger_ns);
+
+		/* deferred: programmed right away, the trigger waits for the last fence */
+		trigger_ns = commit_ns + PROGRAM_NS;
+		if (trigger_ns < ready_ns + WAKE_NS)
+			trigger_ns = ready_ns + WAKE_NS;
+		fence_latency_record(&fl, FENCE_LATENCY_DEFERRED, ready_ns, trigger_ns);
+
+		commit_ns += 16 * NSEC_PER_MSEC;
+	}
+
+	printf("fence to trigger: blocking avg %uus max %uus, deferred avg %uus max %uus\n",
+	       fence_latency_avg_us(&fl, FENCE_LATENCY_BLOCKING),
+	       fl.max_us[FENCE_LATENCY_BLOCKING],
+	       fence_latency_avg_us(&fl, FENCE_LATENCY_DEFERRED),
+	       fl.max_us[FENCE_LATENCY_DEFERRED]);
+
+	CHECK(fl.cnt[FENCE_LATENCY_BLOCKING] == COMMITS &&
+	      fl.cnt[FENCE_LATENCY_DEFERRED] == COMMITS, "frames %u/%u",
+	      fl.cnt[FENCE_LATENCY_BLOCKING], fl.cnt[FENCE_LATENCY_DEFERRED]);
+	CHECK(fence_latency_avg_us(&fl, FENCE_LATENCY_DEFERRED) <
+	      fence_latency_avg_us(&fl, FENCE_LATENCY_BLOCKING),
+	      "deferred avg %uus not below blocking avg %uus",
+	      fence_latency_avg_us(&fl, FENCE_LATENCY_DEFERRED),
+	      fence_latency_avg_us(&fl, FENCE_LATENCY_BLOCKING));
+	CHECK(fl.max_us[FENCE_LATENCY_DEFERRED] <= fl.max_us[FENCE_LATENCY_BLOCKING],
+	      "deferred max %uus above blocking max %uus",
+	      fl.max_us[FENCE_LATENCY_DEFERRED], fl.max_us[FENCE_LATENCY_BLOCKING]);
+}
+
+int main(void)
+{
+	test_buckets();
+	test_record();
+	test_paths();
+
+	if (failures) {
+		fprintf(stderr, "fence_latency_test: %d failures\n", failures);
+		return EXIT_FAILURE;
+	}
+
+	printf("fence_latency_test: passed\n");
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,219 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Copyright (C) 2023 Google LLC
+ *
+ * Host replay test for the panel TE timing model
+ *
+ * Synthetic TE streams with interrupt latency jitter, oscillator drift, refresh
+ * rate switches and stopped TE are fed to the model, and its predictions are
+ * checked against the TE timestamps that generated the stream.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "exynos_drm_te_model.h"
+
+#define NSEC_PER_USEC		1000ULL
+
+static int failures;
+
+#define CHECK(cond, fmt, ...) do {					\
+	if (!(cond)) {							\
+		fprintf(stderr, "%s:%d: " fmt "\n", __func__, __LINE__,	\
+			##__VA_ARGS__);					\
+		failures++;						\
+	}								\
+} while (0)
+
+static u32 rand_state = 1;
+
+/* deterministic jitter in [0, max_ns) */
+static u64 jitter_ns(u64 max_ns)
+{
+	rand_state = rand_state * 1103515245 + 12345;
+
+	return max_ns ? ((rand_state >> 8) % max_ns) : 0;
+}
+
+struct te_stream {
+	u64 te_ns;		/* timestamp of the last real TE */
+	u64 period_ns;		/* real TE period */
+	u64 jitter_ns;		/* max interrupt latency */
+};
+
+/* feeds the next TE to the model, returns the real TE timestamp */
+static u64 te_stream_next(struct te_stream *s, struct te_model *m)
+{
+	s->te_ns += s->period_ns;
+	te_model_update(m, s->te_ns + jitter_ns(s->jitter_ns));
+
+	return s->te_ns;
+}
+
+static u64 absdiff(u64 a, u64 b)
+{
+	return a > b ? a - b : b - a;
+}
+
+/* model prediction in the middle of the frame must match the real TE */
+static void check_predict(const struct te_model *m, const struct te_stream *s,
+			  u64 max_err_ns, const char *what)
+{
+	const u64 now_ns = s->te_ns + s->period_ns / 2;
+	u64 last_te_ns;
+	u32 period_ns;
+
+	if (!te_model_predict(m, now_ns, &last_te_ns, &period_ns)) {
+		CHECK(0, "%s: no prediction", what);
+		return;
+	}
+
+	CHECK(absdiff(last_te_ns, s->te_ns) <= max_err_ns,
+	      "%s: predicted TE off by %llu ns", what,
+	      (unsigned long long)absdiff(last_te_ns, s->te_ns));
+	CHECK(absdiff(period_ns, s->period_ns) <= max_err_ns / 4,
+	      "%s: period %u ns, real %llu ns", what, period_ns,
+	      (unsigned long long)s->period_ns);
+}
+
+static void test_lock(void)
+{
+	struct te_model m;
+	struct te_stream s = { .te_ns = NSEC_PER_SEC, .period_ns = 8333333,
+			       .jitter_ns = 50 * NSEC_PER_USEC };
+	u64 last_te_ns;
+	u32 period_ns;
+	int i;
+
+	te_model_reset(&m);
+	te_model_update(&m, s.te_ns);
+	te_stream_next(&s, &m);
+	CHECK(!te_model_predict(&m, s.te_ns + 1000, &last_te_ns, &period_ns),
+	      "predicted before the estimate is locked");
+
+	for (i = 0; i < 200; i++)
+		te_stream_next(&s, &m);
+	check_predict(&m, &s, 60 * NSEC_PER_USEC, "120Hz");
+}
+
+static void test_drift(void)
+{
+	struct te_model m;
+	struct te_stream s = { .te_ns = NSEC_PER_SEC, .period_ns = 16666666,
+			       .jitter_ns = 20 * NSEC_PER_USEC };
+	int i;
+
+	te_model_reset(&m);
+	te_model_update(&m, s.te_ns);
+	for (i = 0; i < 100; i++)
+		te_stream_next(&s, &m);
+
+	/* the panel oscillator is 0.5% slower than nominal */
+	s.period_ns = 16750000;
+	for (i = 0; i < 300; i++)
+		te_stream_next(&s, &m);
+	check_predict(&m, &s, 40 * NSEC_PER_USEC, "drift");
+}
+
+static void test_rate_switch(void)
+{
+	struct te_model m;
+	struct te_stream s = { .te_ns = NSEC_PER_SEC, .period_ns = 16666666,
+			       .jitter_ns = 20 * NSEC_PER_USEC };
+	u32 relocks;
+	int i;
+
+	te_model_reset(&m);
+	te_model_update(&m, s.te_ns);
+	for (i = 0; i < 100; i++)
+		te_stream_next(&s, &m);
+
+	s.period_ns = 8333333;
+	for (i = 0; i < 100; i++)
+		te_stream_next(&s, &m);
+	check_predict(&m, &s, 40 * NSEC_PER_USEC, "60->120Hz");
+
+	/* switching back reuses the learned period */
+	relocks = m.relocks;
+	s.period_ns = 16666666;
+	for (i = 0; i < 8; i++)
+		te_stream_next(&s, &m);
+	CHECK(m.relocks == relocks + 1, "relocks %u, expected %u", m.relocks, relocks + 1);
+	check_predict(&m, &s, 40 * NSEC_PER_USEC, "120->60Hz");
+}
+
+static void test_outlier(void)
+{
+	struct te_model m;
+	struct te_stream s = { .te_ns = NSEC_PER_SEC, .period_ns = 8333333,
+			       .jitter_ns = 20 * NSEC_PER_USEC };
+	int i;
+
+	te_model_reset(&m);
+	te_model_update(&m, s.te_ns);
+	for (i = 0; i < 100; i++)
+		te_stream_next(&s, &m);
+
+	/* one late interrupt mustn't move the learned period */
+	s.te_ns += s.period_ns;
+	te_model_update(&m, s.te_ns + 3 * NSEC_PER_MSEC);
+	for (i = 0; i < 10; i++)
+		te_stream_next(&s, &m);
+	check_predict(&m, &s, 40 * NSEC_PER_USEC, "outlier");
+}
+
+static void test_stopped(void)
+{
+	struct te_model m;
+	struct te_stream s = { .te_ns = NSEC_PER_SEC, .period_ns = 8333333,
+			       .jitter_ns = 20 * NSEC_PER_USEC };
+	u64 last_te_ns;
+	u32 period_ns;
+	int i;
+
+	te_model_reset(&m);
+	te_model_update(&m, s.te_ns);
+	for (i = 0; i < 100; i++)
+		te_stream_next(&s, &m);
+
+	/* one missed TE is still extrapolated */
+	CHECK(te_model_predict(&m, s.te_ns + 3 * s.period_ns / 2, &last_te_ns, &period_ns),
+	      "no prediction after one missed TE");
+
+	/* TE irq disabled, e.g. by hibernation: no prediction from the old phase */
+	CHECK(!te_model_predict(&m, s.te_ns + 5 * s.period_ns / 2, &last_te_ns, &period_ns),
+	      "predicted after TE stopped for two periods");
+	CHECK(!te_model_predict(&m, s.te_ns + 500 * NSEC_PER_MSEC, &last_te_ns, &period_ns),
+	      "predicted after TE stopped for 500ms");
+
+	/* TE restarts with a different phase */
+	s.te_ns += 500 * NSEC_PER_MSEC + s.period_ns / 3;
+	te_model_update(&m, s.te_ns);
+	CHECK(!te_model_predict(&m, s.te_ns + 1000, &last_te_ns, &period_ns),
+	      "predicted right after TE restarted");
+	for (i = 0; i < 10; i++)
+		te_stream_next(&s, &m);
+	check_predict(&m, &s, 40 * NSEC_PER_USEC, "restart");
+}
+
+int main(void)
+{
+	test_lock();
+	test_drift();
+	test_rate_switch();
+	test_outlier();
+	test_stopped();
+
+	if (failures) {
+		fprintf(stderr, "te_model_test: %d failures\n", failures);
+		return EXIT_FAILURE;
+	}
+
+	printf("te_model_test: passed\n");
+	return EXIT_SUCCESS;
+}